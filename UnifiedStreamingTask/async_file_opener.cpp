@@ -0,0 +1,189 @@
+#include "async_file_opener.hpp"
+#include "error.hpp"
+#include "tracing.hpp"
+
+#include <cstdio>
+#include <sstream>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif // __linux__
+
+
+AsyncFileOpener::AsyncFileOpener()
+    : thread_(&AsyncFileOpener::run, this)
+{
+}
+
+AsyncFileOpener::~AsyncFileOpener()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+
+    // thread is done with all tasks, prepared files are not needed anymore
+    for (auto& pair : prepared_)
+    {
+        if (!pair.second.stream)
+            continue;
+        pair.second.stream->close();
+        std::remove(pair.first.c_str());
+    }
+}
+
+void AsyncFileOpener::prepare(const std::string& file, uint64_t preallocation)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (prepared_.count(file))
+            return;
+        prepared_[file] = Prepared{ false, nullptr };
+        tasks_.push_back(Task{ file, nullptr, preallocation });
+    }
+    condition_.notify_all();
+}
+
+AsyncFileOpener::Stream AsyncFileOpener::take(const std::string& file)
+{
+    Stream stream;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = prepared_.find(file);
+        if (it != prepared_.end())
+        {
+            condition_.wait(lock, [&it]() { return it->second.ready; });
+            stream = std::move(it->second.stream);
+            prepared_.erase(it);
+        }
+        else
+        {
+            lock.unlock();
+            stream = openFile(file, 0);
+        }
+    }
+
+    if (!stream)
+        throw Error(Error::CORRUPTED_OUTPUT, "AsyncFileOpener, failed to open file '" + file + "' for writing");
+    return stream;
+}
+
+void AsyncFileOpener::close(const std::string& file, Stream stream, uint64_t size)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        tasks_.push_back(Task{ file, std::move(stream), size });
+    }
+    condition_.notify_all();
+}
+
+void AsyncFileOpener::finish()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this]() { return tasks_.empty() && !busy_; });
+    checkFailures();
+}
+
+std::vector<std::string> AsyncFileOpener::closedFiles()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    checkFailures();
+
+    std::vector<std::string> result;
+    result.swap(closed_);
+    return result;
+}
+
+void AsyncFileOpener::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+        if (tasks_.empty())
+            break;
+
+        Task task = std::move(tasks_.front());
+        tasks_.pop_front();
+        busy_ = true;
+
+        // file system is accessed without lock
+        lock.unlock();
+        const bool opening = !task.stream;
+        Stream stream;
+        bool closed = false;
+        if (opening)
+            stream = openFile(task.file, task.size);
+        else
+            closed = closeFile(std::move(task.stream), task.file, task.size);
+        lock.lock();
+
+        if (opening)
+            prepared_[task.file] = Prepared{ true, std::move(stream) };
+        else
+            (closed ? closed_ : failed_).push_back(task.file);
+        busy_ = false;
+        condition_.notify_all();
+    }
+}
+
+AsyncFileOpener::Stream AsyncFileOpener::openFile(const std::string& file, uint64_t preallocation)
+{
+    TRACE_SPAN("open file in background");
+    Stream stream(new std::ofstream(file, std::fstream::out | std::fstream::binary));
+    if (!stream->good())
+        return nullptr;
+
+#ifdef __linux__
+    // preallocation is an optimization only, so its failure is ignored
+    if (preallocation)
+    {
+        const int descriptor = ::open(file.c_str(), O_WRONLY | O_CLOEXEC);
+        if (descriptor >= 0)
+        {
+            ::fallocate(descriptor, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(preallocation));
+            ::close(descriptor);
+        }
+    }
+#else
+    (void)preallocation;
+#endif // __linux__
+
+    return stream;
+}
+
+bool AsyncFileOpener::closeFile(Stream stream, const std::string& file, uint64_t size)
+{
+    TRACE_SPAN("close file in background");
+    stream->close();
+    if (!stream->good())
+        return false;
+
+#ifdef __linux__
+    // truncating to the same size releases blocks preallocated beyond it
+    if (::truncate(file.c_str(), static_cast<off_t>(size)) != 0)
+        return false;
+#else
+    (void)file;
+    (void)size;
+#endif // __linux__
+
+    return true;
+}
+
+void AsyncFileOpener::checkFailures()
+{
+    if (failed_.empty())
+        return;
+
+    std::ostringstream msg;
+    msg << "AsyncFileOpener, failed to close file(s) ";
+    for (size_t i = 0; i < failed_.size(); ++i)
+        msg << (i ? ",'" : "'") << failed_[i] << "'";
+    failed_.clear();
+
+    throw Error(Error::CORRUPTED_OUTPUT, msg.str());
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/// @class AsyncFileOpener.
+/// @brief Opens and closes output files in background thread.
+/// @details Files are opened ahead of time and preallocated, so taking an opened file and handing
+///          a written one over for closing never waits for file system. Preallocated space beyond
+///          written data is released when file is closed.
+class AsyncFileOpener
+{
+public:
+    /// @brief Type of opened file stream.
+    using Stream = std::unique_ptr<std::ofstream>;
+
+    /// @brief Constructor, starts background thread.
+    AsyncFileOpener();
+
+    /// @brief Destructor, closes all handed over files, removes prepared but not taken ones
+    ///        and stops background thread.
+    ~AsyncFileOpener();
+
+    AsyncFileOpener(const AsyncFileOpener&) = delete;
+    AsyncFileOpener& operator=(const AsyncFileOpener&) = delete;
+
+    /// @brief Request opening file in background.
+    /// @param[in] file - File name.
+    /// @param[in] preallocation - Number of bytes to preallocate, 0 for none.
+    void prepare(const std::string& file, uint64_t preallocation);
+
+    /// @brief Take opened file, it's opened right away if it was not prepared.
+    /// @param[in] file - File name.
+    /// @returns Opened file stream.
+    /// @throws Error if failed to open file.
+    Stream take(const std::string& file);
+
+    /// @brief Hand written file over for closing in background.
+    /// @param[in] file - File name.
+    /// @param[in] stream - File stream.
+    /// @param[in] size - Size of written data, file is truncated to it.
+    void close(const std::string& file, Stream stream, uint64_t size);
+
+    /// @brief Wait till all handed over files are closed.
+    /// @throws Error if failed to close some file.
+    void finish();
+
+    /// @brief Get names of files closed since the previous call.
+    /// @throws Error if failed to close some file.
+    std::vector<std::string> closedFiles();
+
+private:
+    /// @brief Background task.
+    struct Task
+    {
+        /// @brief File name.
+        std::string file;
+
+        /// @brief File stream to close or nullptr to open file.
+        Stream stream;
+
+        /// @brief Number of bytes to preallocate or size to truncate to.
+        uint64_t size;
+    };
+
+    /// @brief File opened in background.
+    struct Prepared
+    {
+        /// @brief Set if opening is done.
+        bool ready;
+
+        /// @brief File stream, nullptr if failed to open.
+        Stream stream;
+    };
+
+    /// @brief Background thread function.
+    void run();
+
+    /// @brief Open file and preallocate space.
+    /// @returns Opened file stream or nullptr.
+    static Stream openFile(const std::string& file, uint64_t preallocation);
+
+    /// @brief Close file and truncate it to the size of data.
+    /// @returns true if succeeded, false otherwise.
+    static bool closeFile(Stream stream, const std::string& file, uint64_t size);
+
+    /// @brief Throw error if failed to close some file.
+    /// @details Must be called with mutex locked.
+    void checkFailures();
+
+private:
+    /// @brief Guards all data below.
+    std::mutex mutex_;
+
+    /// @brief Signals new tasks and done tasks.
+    std::condition_variable condition_;
+
+    /// @brief Tasks queue.
+    std::deque<Task> tasks_;
+
+    /// @brief Set if a task is being executed.
+    bool busy_ = false;
+
+    /// @brief Set if background thread should stop.
+    bool stopping_ = false;
+
+    /// @brief Files opened in background by name.
+    std::map<std::string, Prepared> prepared_;
+
+    /// @brief Files closed since the last request.
+    std::vector<std::string> closed_;
+
+    /// @brief Files failed to close.
+    std::vector<std::string> failed_;
+
+    /// @brief Background thread.
+    std::thread thread_;
+};
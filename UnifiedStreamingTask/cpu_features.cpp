@@ -0,0 +1,210 @@
+#include "cpu_features.hpp"
+#include "crc32.hpp"
+#include "start_code.hpp"
+#include "ts_headers.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(SIMD_AVX2) && defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(SIMD_AVX2)
+#include <cpuid.h>
+#endif
+
+
+namespace
+{
+    /// @brief Environment variable lowering level of kernels.
+    const char* const simdEnvironmentVariable = "TS_SPLITTER_SIMD";
+
+#ifdef SIMD_AVX2
+    /// @brief Get registers EAX, EBX, ECX and EDX for cpuid leaf and subleaf.
+    void cpuid(unsigned leaf, unsigned subleaf, unsigned registers[4])
+    {
+#ifdef _MSC_VER
+        int result[4];
+        __cpuidex(result, static_cast<int>(leaf), static_cast<int>(subleaf));
+        std::memcpy(registers, result, sizeof(result));
+#else
+        __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+    }
+
+    /// @brief Get register XCR0 with states of registers saved by OS.
+    uint64_t xcr0()
+    {
+#ifdef _MSC_VER
+        return _xgetbv(0);
+#else
+        unsigned low, high;
+        __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+        return (uint64_t(high) << 32) | low;
+#endif
+    }
+#endif
+
+    /// @brief Parse level of kernels, e.g. 'avx2'.
+    /// @param[in] name - Name of level.
+    /// @param[out] level - Parsed level.
+    /// @returns true if level is known, false otherwise.
+    bool parseSimdLevel(const char* name, SimdLevel& level)
+    {
+        for (SimdLevel candidate : { SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2 })
+        {
+            if (strcmp(name, simdLevelName(candidate)) == 0)
+            {
+                level = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// @brief Choose kernels by CPU features and environment.
+    Kernels chooseKernels()
+    {
+        const CpuFeatures features = detectCpuFeatures();
+        SimdLevel level = supportedSimdLevel(features);
+
+        SimdLevel requested = level;
+        const char* value = std::getenv(simdEnvironmentVariable);
+        if (value && parseSimdLevel(value, requested))
+            level = std::min(level, requested);
+
+        return kernelsFor(level, features.sse42, features.pclmul && features.sse42);
+    }
+}
+
+CpuFeatures detectCpuFeatures()
+{
+    CpuFeatures features;
+
+#ifdef SIMD_AVX2
+    unsigned registers[4] = { 0, 0, 0, 0 };
+    cpuid(0, 0, registers);
+    const unsigned maxLeaf = registers[0];
+    if (maxLeaf < 1)
+        return features;
+
+    cpuid(1, 0, registers);
+    features.sse2 = registers[3] & (1u << 26);
+    features.sse42 = registers[2] & (1u << 20);
+    features.pclmul = registers[2] & (1u << 1);
+
+    // AVX registers should be saved by OS
+    const bool osxsave = registers[2] & (1u << 27);
+    const uint64_t savedStates = osxsave ? xcr0() : 0;
+    const bool avxSaved = (savedStates & 0x06) == 0x06;
+
+    if (maxLeaf >= 7)
+    {
+        cpuid(7, 0, registers);
+        features.avx2 = avxSaved && (registers[1] & (1u << 5));
+    }
+#endif
+
+    return features;
+}
+
+SimdLevel supportedSimdLevel(const CpuFeatures& features)
+{
+#ifdef SIMD_AVX2
+    if (features.avx2 && features.sse42)
+        return SimdLevel::AVX2;
+#endif
+#ifdef SIMD_SSE2
+    if (features.sse2)
+        return SimdLevel::SSE2;
+#endif
+    (void)features;
+    return SimdLevel::SCALAR;
+}
+
+Kernels kernelsFor(SimdLevel level, bool hardwareCrc, bool carrylessCrc)
+{
+    Kernels result;
+
+    // CRC32 instruction is a part of SSE4.2 and PCLMUL is a separate extension, so CRC kernels
+    // don't depend on the level
+#ifndef SIMD_AVX2
+    hardwareCrc = false;
+    carrylessCrc = false;
+#endif
+    result.crc32c = crc32cScalar;
+    result.hardwareCrc = hardwareCrc;
+    result.crc32 = crc32Scalar;
+    result.carrylessCrc = carrylessCrc;
+#ifdef SIMD_AVX2
+    if (hardwareCrc)
+        result.crc32c = crc32cSse42;
+    if (carrylessCrc)
+        result.crc32 = crc32Pclmul;
+#endif
+
+    result.level = SimdLevel::SCALAR;
+    result.findStartCode = findStartCodeScalar;
+    result.decodeTsHeaders = [](const uint8_t* data, size_t count, TsHeaders& headers) { return decodeTsHeadersScalar(data, count, headers); };
+#ifdef SIMD_SSE2
+    if (level >= SimdLevel::SSE2)
+    {
+        result.level = SimdLevel::SSE2;
+        result.findStartCode = findStartCodeSse2;
+        result.decodeTsHeaders = decodeTsHeadersSse2;
+    }
+#endif
+#ifdef SIMD_AVX2
+    if (level >= SimdLevel::AVX2)
+    {
+        result.level = SimdLevel::AVX2;
+        result.findStartCode = findStartCodeAvx2;
+        result.decodeTsHeaders = decodeTsHeadersAvx2;
+    }
+#endif
+    (void)level;
+    return result;
+}
+
+const Kernels& kernels()
+{
+    static const Kernels chosen = chooseKernels();
+    return chosen;
+}
+
+const char* simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::SSE2:
+        return "sse2";
+    case SimdLevel::AVX2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
+
+void reportCpuFeatures(std::ostream& output)
+{
+    const CpuFeatures features = detectCpuFeatures();
+    const Kernels& chosen = kernels();
+
+    output << "CPU features:";
+    if (features.sse2)
+        output << " sse2";
+    if (features.sse42)
+        output << " sse4.2";
+    if (features.pclmul)
+        output << " pclmul";
+    if (features.avx2)
+        output << " avx2";
+    output << "\n";
+
+    const char* level = simdLevelName(chosen.level);
+    output << "Kernels: findStartCode - " << level << ", decodeTsHeaders - " << level << ", crc32c - "
+           << (chosen.hardwareCrc ? "sse4.2" : "scalar") << ", crc32 - " << (chosen.carrylessCrc ? "pclmul" : "scalar") << "\n";
+    if (chosen.level < supportedSimdLevel(features))
+        output << "Kernels level is lowered by " << simdEnvironmentVariable << "\n";
+}
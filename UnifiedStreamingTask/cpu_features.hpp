@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#if (defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))) || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+/// @brief Set if AVX2 kernels are built, they are used only if CPU supports AVX2.
+#define SIMD_AVX2
+#ifdef _MSC_VER
+#define SIMD_TARGET_AVX2
+#define SIMD_TARGET_SSE42
+#define SIMD_TARGET_PCLMUL
+#else
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#define SIMD_TARGET_SSE42 __attribute__((target("sse4.2")))
+#define SIMD_TARGET_PCLMUL __attribute__((target("pclmul,ssse3")))
+#endif
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+/// @brief Set if SSE2 kernels are built, SSE2 is a part of target architecture then.
+#define SIMD_SSE2
+#endif
+
+
+struct TsHeaders;
+
+/// @brief Levels of SIMD kernels, every one includes the previous ones.
+/// @details CRC kernels don't depend on the level, they're chosen by SSE4.2 and PCLMUL support alone.
+enum class SimdLevel
+{
+    SCALAR,
+    SSE2,
+    AVX2,
+};
+
+/// @struct CpuFeatures.
+/// @brief Instruction set extensions supported by CPU and OS.
+struct CpuFeatures
+{
+    bool sse2 = false;
+    bool sse42 = false;
+    bool pclmul = false;
+    bool avx2 = false;
+};
+
+/// @struct Kernels.
+/// @brief Implementations of SIMD kernels of one level.
+struct Kernels
+{
+    /// @brief Level of kernels.
+    SimdLevel level;
+
+    /// @brief Implementation of findStartCode().
+    size_t (*findStartCode)(const uint8_t* data, size_t size);
+
+    /// @brief Implementation of decodeTsHeaders().
+    size_t (*decodeTsHeaders)(const uint8_t* data, size_t count, TsHeaders& headers);
+
+    /// @brief Implementation of crc32c().
+    uint32_t (*crc32c)(const uint8_t* data, size_t size, uint32_t crc);
+
+    /// @brief Set if crc32c() uses CRC32 instruction.
+    bool hardwareCrc;
+
+    /// @brief Implementation of crc32().
+    uint32_t (*crc32)(const uint8_t* data, size_t size);
+
+    /// @brief Set if crc32() uses carry-less multiplication.
+    bool carrylessCrc;
+};
+
+/// @brief Detect features of CPU the process runs on.
+CpuFeatures detectCpuFeatures();
+
+/// @brief Get the highest level of kernels, which are built and supported by CPU.
+/// @param[in] features - Features of CPU.
+SimdLevel supportedSimdLevel(const CpuFeatures& features);
+
+/// @brief Get kernels of given level.
+/// @param[in] level - Level of kernels, it's lowered to the highest built one if needed.
+/// @param[in] hardwareCrc - Use CRC32 instruction for crc32c(), CPU should support SSE4.2. Ignored if
+///                          the instruction is not built for target architecture.
+/// @param[in] carrylessCrc - Use carry-less multiplication for crc32(), CPU should support PCLMUL and
+///                           SSSE3. Ignored if the instruction is not built for target architecture.
+Kernels kernelsFor(SimdLevel level, bool hardwareCrc = false, bool carrylessCrc = false);
+
+/// @brief Get kernels used by the process.
+/// @details Kernels are chosen once, on the first call, by detected CPU features. The level may be
+///          lowered by environment variable TS_SPLITTER_SIMD set to 'scalar', 'sse2' or 'avx2', CRC
+///          instruction is used whenever CPU supports SSE4.2 and carry-less multiplication whenever
+///          it supports PCLMUL, regardless of the level.
+const Kernels& kernels();
+
+/// @brief Get name of kernels level, e.g. 'avx2'.
+const char* simdLevelName(SimdLevel level);
+
+/// @brief Write detected CPU features and chosen kernels.
+/// @param[out] output - Stream for the report.
+void reportCpuFeatures(std::ostream& output);
@@ -0,0 +1,155 @@
+#include "crc32.hpp"
+
+#include <cstring>
+
+#ifdef SIMD_AVX2
+#include <nmmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+
+namespace
+{
+    /// @brief CRC-32/MPEG-2 polynomial.
+    const uint32_t crc32Polynomial = 0x04C11DB7u;
+
+    /// @brief Table of CRC-32/MPEG-2 of every byte.
+    struct Crc32Table
+    {
+        uint32_t values[256];
+
+        Crc32Table()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t value = i << 24;
+                for (int bit = 0; bit < 8; ++bit)
+                    value = (value << 1) ^ ((value >> 31) * crc32Polynomial);
+                values[i] = value;
+            }
+        }
+    };
+
+    /// @brief Continue CRC-32/MPEG-2 calculation.
+    /// @param[in] crc - CRC register after preceding data, initial value if none.
+    uint32_t updateCrc32(uint32_t crc, const uint8_t* data, size_t size)
+    {
+        static const Crc32Table table;
+        for (; size; --size)
+            crc = (crc << 8) ^ table.values[(crc >> 24) ^ *data++];
+        return crc;
+    }
+
+    /// @brief Reversed CRC-32C polynomial.
+    const uint32_t crc32cPolynomial = 0x82F63B78u;
+
+    /// @brief Tables of CRC-32C for slicing by 8 bytes, table k gives CRC of byte followed by k zero bytes.
+    struct Crc32cTables
+    {
+        uint32_t values[8][256];
+
+        Crc32cTables()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; ++bit)
+                    value = (value >> 1) ^ ((value & 1) * crc32cPolynomial);
+                values[0][i] = value;
+            }
+            for (int k = 1; k < 8; ++k)
+            {
+                for (int i = 0; i < 256; ++i)
+                    values[k][i] = (values[k - 1][i] >> 8) ^ values[0][values[k - 1][i] & 0xFF];
+            }
+        }
+    };
+}
+
+uint32_t crc32(const uint8_t* data, size_t size)
+{
+    return kernels().crc32(data, size);
+}
+
+uint32_t crc32Scalar(const uint8_t* data, size_t size)
+{
+    return updateCrc32(0xFFFFFFFFu, data, size);
+}
+
+uint32_t crc32c(const uint8_t* data, size_t size, uint32_t crc)
+{
+    return kernels().crc32c(data, size, crc);
+}
+
+uint32_t crc32cScalar(const uint8_t* data, size_t size, uint32_t crc)
+{
+    static const Crc32cTables tables;
+    const auto& t = tables.values;
+
+    crc = ~crc;
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        const uint32_t low = crc ^ (uint32_t(data[0]) | uint32_t(data[1]) << 8 | uint32_t(data[2]) << 16 | uint32_t(data[3]) << 24);
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+    }
+    for (; size; --size)
+        crc = t[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+#ifdef SIMD_AVX2
+SIMD_TARGET_SSE42 uint32_t crc32cSse42(const uint8_t* data, size_t size, uint32_t crc)
+{
+    crc = ~crc;
+#if defined(__x86_64__) || defined(_M_X64)
+    uint64_t crc64 = crc;
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        crc64 = _mm_crc32_u64(crc64, value);
+    }
+    crc = static_cast<uint32_t>(crc64);
+#endif
+    for (; size >= 4; data += 4, size -= 4)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        crc = _mm_crc32_u32(crc, value);
+    }
+    for (; size; --size)
+        crc = _mm_crc32_u8(crc, *data++);
+    return ~crc;
+}
+
+SIMD_TARGET_PCLMUL uint32_t crc32Pclmul(const uint8_t* data, size_t size)
+{
+    // short sections, as most of PSI ones, are not worth folding
+    if (size < 32)
+        return crc32Scalar(data, size);
+
+    // bytes are reversed, so bit i of register is coefficient of x^i, as in MSB-first CRC;
+    // x^192 mod P and x^128 mod P fold high and low halves of the remainder over the next block
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i constants = _mm_set_epi64x(0xC5B9CD4C, 0xE8A45605);
+
+    // initial value is added to the first 32 bits of data
+    __m128i remainder = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), reverse);
+    remainder = _mm_xor_si128(remainder, _mm_set_epi32(-1, 0, 0, 0));
+    for (data += 16, size -= 16; size >= 16; data += 16, size -= 16)
+    {
+        const __m128i block = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), reverse);
+        remainder = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(remainder, constants, 0x11),
+                                                _mm_clmulepi64_si128(remainder, constants, 0x00)),
+                                  block);
+    }
+
+    // remainder congruent to data so far is followed by the tail, CRC of both is taken without initial value
+    uint8_t rest[32];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(rest), _mm_shuffle_epi8(remainder, reverse));
+    std::memcpy(rest + 16, data, size);
+    return updateCrc32(0, rest, 16 + size);
+}
+#endif
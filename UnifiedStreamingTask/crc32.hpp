@@ -0,0 +1,38 @@
+#pragma once
+
+#include "cpu_features.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+/// @brief Calculate CRC-32/MPEG-2.
+/// @details Uses kernel chosen by CPU features, see kernels().
+/// @param[in] data - Start of data.
+/// @param[in] size - Size of data.
+/// @returns CRC value.
+uint32_t crc32(const uint8_t* data, size_t size);
+
+/// @brief Calculate CRC-32C (Castagnoli) incrementally.
+/// @details Uses kernel chosen by CPU features, see kernels(). CRC of concatenated data is
+///          crc32c(second, secondSize, crc32c(first, firstSize)).
+/// @param[in] data - Start of data.
+/// @param[in] size - Size of data.
+/// @param[in] crc - CRC of preceding data, 0 if none.
+/// @returns CRC value.
+uint32_t crc32c(const uint8_t* data, size_t size, uint32_t crc = 0);
+
+/// @brief Portable implementation of crc32(), table-driven.
+uint32_t crc32Scalar(const uint8_t* data, size_t size);
+
+/// @brief Portable implementation of crc32c(), slicing by 8 bytes.
+uint32_t crc32cScalar(const uint8_t* data, size_t size, uint32_t crc);
+
+#ifdef SIMD_AVX2
+/// @brief Implementation of crc32c() by CRC32 instruction, CPU should support SSE4.2.
+uint32_t crc32cSse42(const uint8_t* data, size_t size, uint32_t crc);
+
+/// @brief Implementation of crc32() folding 16-byte blocks by carry-less multiplication,
+///        CPU should support PCLMUL and SSSE3.
+uint32_t crc32Pclmul(const uint8_t* data, size_t size);
+#endif
@@ -50,6 +50,12 @@ std::string Error::codeDescription(uint16_t code)
     case CORRUPTED_OUTPUT:
         result = "Output stream is corrupted";
         break;
+    case WRONG_OPTION_ARGUMENT:
+        result = "Wrong command line option's argument";
+        break;
+    case INVALID_CALL:
+        result = "Invalid library call";
+        break;
     default:
         result = "Unknown error";
         break;
@@ -18,6 +18,8 @@ public:
         CONSTRUCTION_ERROR = 4,			///< Error creating some object.
         CORRUPTED_INPUT = 5,   		    ///< Input stream is corrupted.
         CORRUPTED_OUTPUT = 6,			///< Output stream is corrupted.
+        WRONG_OPTION_ARGUMENT = 7,		///< Wrong command line option's argument.
+        INVALID_CALL = 8,				///< Library function called with wrong arguments or out of order.
     };
 
     /// @brief Constructor.
@@ -0,0 +1,332 @@
+#include "error.hpp"
+#include "es_framer.hpp"
+#include "start_code.hpp"
+
+#include <algorithm>
+
+
+namespace
+{
+    /// @brief Number of ADTS header bytes needed to get frame length.
+    const uint8_t adtsHeaderSize = 6;
+
+    /// @brief Minimal size of ADTS frame, its header without CRC.
+    const uint64_t minAdtsFrameSize = 7;
+
+    /// @brief Check if header starts with ADTS sync word and layer 0.
+    inline bool isAdtsSync(uint8_t first, uint8_t second)
+    {
+        return first == 0xFF && (second & 0xF6) == 0xF0;
+    }
+}
+
+EsFramer::EsFramer(std::ostream& log,
+                   const std::map<uint16_t, PayloadParser::StreamInfo>& streams,
+                   OnAccessUnit handler,
+                   OnAccessUnit pictureHandler)
+    : log_(log)
+    , streamInfos_(streams)
+    , handler_(handler)
+    , pictureHandler_(pictureHandler)
+{
+    if (!log_.good())
+        throw Error(Error::CONSTRUCTION_ERROR, "EsFramer, bad log output");
+}
+
+void EsFramer::write(const EsRawData& rawData)
+{
+    if (rawData.type == EsType::OTHER)
+        return;
+
+    auto& stream = chooseStream(rawData);
+    if (stream.codec == NONE)
+        return;
+
+    if (stream.codec == ADTS)
+        scanAdts(stream, rawData);
+    else
+        scanNalUnits(stream, rawData);
+
+    stream.esBytes += rawData.size;
+}
+
+void EsFramer::flush()
+{
+    for (auto& pair : streams_)
+    {
+        auto& stream = pair.second;
+        if (!stream.auStarted)
+            continue;
+        reportAccessUnit(stream, stream.esBytes);
+        stream.auStarted = false;
+    }
+
+    for (const auto& pair : statistics_)
+    {
+        log_ << "Notice: EsFramer, pid " << pair.first << ": " << pair.second.accessUnits << " access units, "
+             << pair.second.keyframes << " keyframes";
+        if (pair.second.syncErrors)
+            log_ << ", " << pair.second.syncErrors << " sync errors";
+        log_ << std::endl;
+    }
+}
+
+const std::map<uint16_t, EsFramer::Statistics>& EsFramer::statistics() const
+{
+    return statistics_;
+}
+
+bool EsFramer::supports(uint8_t streamType)
+{
+    return streamType == 0x1B || streamType == 0x24 || streamType == 0x0F;
+}
+
+EsFramer::Stream& EsFramer::chooseStream(const EsRawData& rawData)
+{
+    auto it = streams_.find(rawData.pid);
+    if (it != streams_.end())
+        return it->second;
+
+    Stream stream{};
+    stream.pid = rawData.pid;
+    stream.type = rawData.type;
+    stream.esNumber = rawData.esNumber;
+    stream.pendingPts = noTimestamp;
+    stream.auPts = noTimestamp;
+    stream.codec = NONE;
+
+    const auto info = streamInfos_.find(rawData.pid);
+    if (info != streamInfos_.end())
+    {
+        switch (info->second.streamType)
+        {
+        case 0x1B:
+            stream.codec = H264;
+            break;
+        case 0x24:
+            stream.codec = HEVC;
+            break;
+        case 0x0F:
+            stream.codec = ADTS;
+            break;
+        }
+    }
+
+    if (stream.codec != NONE)
+        statistics_[rawData.pid];
+    return streams_.insert({ rawData.pid, stream }).first->second;
+}
+
+void EsFramer::scanNalUnits(Stream& stream, const EsRawData& rawData)
+{
+    const uint8_t* data = rawData.data;
+    const size_t size = rawData.size;
+    const uint64_t base = stream.esBytes;
+
+    // NAL unit header split from its start code belongs to previous PES packet, other ones to this one
+    size_t position = 0;
+    if (stream.collecting)
+        position = collectNalHeader(stream, rawData, 0);
+    if (rawData.newEsPacket && rawData.pts != noTimestamp)
+        stream.pendingPts = rawData.pts;
+
+    // start code split between previous and this raw data, NAL unit includes leading zero byte of 4-byte start code
+    if (position == 0 && stream.zeros >= 2 && size >= 1 && data[0] == 1)
+        position = beginNalUnit(stream, rawData, base - (stream.zeros >= 3 ? 3 : 2), 1);
+    else if (position == 0 && stream.zeros >= 1 && size >= 2 && data[0] == 0 && data[1] == 1)
+        position = beginNalUnit(stream, rawData, base - (stream.zeros >= 2 ? 2 : 1), 2);
+
+    while (position < size)
+    {
+        const size_t found = position + findStartCode(data + position, size - position);
+        if (found == size)
+            break;
+        const bool zeroByte = found > 0 ? data[found - 1] == 0 : stream.zeros >= 1;
+        position = beginNalUnit(stream, rawData, base + found - (zeroByte ? 1 : 0), found + 3);
+    }
+
+    // remember trailing zeros for start code split between this and next raw data
+    uint8_t zeros = 0;
+    while (zeros < 3 && zeros < size && data[size - 1 - zeros] == 0)
+        ++zeros;
+    if (zeros == size)
+        zeros = static_cast<uint8_t>(std::min(stream.zeros + zeros, 3));
+    stream.zeros = zeros;
+}
+
+size_t EsFramer::beginNalUnit(Stream& stream, const EsRawData& rawData, uint64_t nalOffset, size_t position)
+{
+    stream.collecting = true;
+    stream.headerOffset = nalOffset;
+    stream.headerSize = 0;
+    return collectNalHeader(stream, rawData, position);
+}
+
+size_t EsFramer::collectNalHeader(Stream& stream, const EsRawData& rawData, size_t position)
+{
+    // H.264 needs first_mb_in_slice after 1-byte header, HEVC first_slice_segment_in_pic_flag after 2-byte one
+    const uint8_t needed = stream.codec == H264 ? 2 : 3;
+    while (stream.headerSize < needed && position < rawData.size)
+        stream.header[stream.headerSize++] = rawData.data[position++];
+
+    if (stream.headerSize == needed)
+    {
+        stream.collecting = false;
+        onNalUnit(stream);
+    }
+    return position;
+}
+
+void EsFramer::onNalUnit(Stream& stream)
+{
+    const uint8_t* header = stream.header;
+
+    bool vcl = false;
+    bool keyframe = false;
+    bool parameterSet = false;
+    bool firstSlice = false;
+    bool startsAccessUnit = false;
+
+    if (stream.codec == H264)
+    {
+        const uint8_t type = header[0] & 0x1F;
+        vcl = type >= 1 && type <= 5;
+        keyframe = type == 5;
+        parameterSet = type == 7 || type == 8;
+        firstSlice = (header[1] & 0x80) != 0;
+        // AUD, SPS, PPS, SEI and reserved types 14..18
+        startsAccessUnit = type == 6 || type == 7 || type == 8 || type == 9 || (type >= 14 && type <= 18);
+    }
+    else
+    {
+        const uint8_t type = (header[0] >> 1) & 0x3F;
+        vcl = type < 32;
+        keyframe = type >= 16 && type <= 23;
+        parameterSet = type >= 32 && type <= 34;
+        firstSlice = (header[2] & 0x80) != 0;
+        // VPS, SPS, PPS, AUD, prefix SEI and reserved types
+        startsAccessUnit = (type >= 32 && type <= 35) || type == 39 || (type >= 41 && type <= 44) || (type >= 48 && type <= 55);
+    }
+
+    // new access unit starts with the first NAL unit of listed types after VCL NAL unit of previous one
+    if ((vcl ? firstSlice : startsAccessUnit) && (stream.auHasVcl || !stream.auStarted))
+        startAccessUnit(stream, stream.headerOffset);
+
+    if (!stream.auStarted)
+        return;
+
+    // parameter set ends where the next NAL unit starts
+    if (stream.auPsOpen)
+    {
+        stream.auPsEnd = stream.headerOffset;
+        stream.auPsOpen = false;
+    }
+    if (parameterSet)
+    {
+        if (!stream.auHasPs)
+            stream.auPsOffset = stream.headerOffset;
+        stream.auHasPs = true;
+        stream.auPsOpen = true;
+    }
+
+    if (vcl)
+    {
+        // parameter sets precede the first VCL NAL unit, so they are already closed
+        if (!stream.auHasVcl && pictureHandler_)
+            pictureHandler_(AccessUnit{ stream.pid, stream.type, stream.esNumber, stream.auOffset,
+                                        stream.headerOffset - stream.auOffset, stream.auPts, keyframe,
+                                        stream.auHasPs ? stream.auPsOffset : 0,
+                                        stream.auHasPs ? stream.auPsEnd - stream.auPsOffset : 0 });
+        stream.auHasVcl = true;
+        stream.auKeyframe = stream.auKeyframe || keyframe;
+    }
+}
+
+void EsFramer::scanAdts(Stream& stream, const EsRawData& rawData)
+{
+    const uint8_t* data = rawData.data;
+    const size_t size = rawData.size;
+    const uint64_t base = stream.esBytes;
+    const uint64_t end = base + size;
+
+    // ADTS header split between PES packets belongs to previous one
+    bool hasPts = rawData.newEsPacket && rawData.pts != noTimestamp;
+
+    while (true)
+    {
+        if (hasPts && stream.headerSize == 0)
+        {
+            stream.pendingPts = rawData.pts;
+            hasPts = false;
+        }
+
+        // search for sync word if sync chain is lost
+        if (!stream.synced && stream.headerSize == 0)
+        {
+            size_t position = stream.headerOffset > base ? size_t(stream.headerOffset - base) : 0;
+            while (position < size && !isAdtsSync(data[position], position + 1 < size ? data[position + 1] : 0xF0))
+                ++position;
+            stream.headerOffset = base + position;
+        }
+
+        if (stream.headerOffset + stream.headerSize >= end)
+            break;
+
+        size_t position = size_t(stream.headerOffset + stream.headerSize - base);
+        while (stream.headerSize < adtsHeaderSize && position < size)
+            stream.header[stream.headerSize++] = data[position++];
+        if (stream.headerSize < adtsHeaderSize)
+            break;
+        stream.headerSize = 0;
+
+        const uint8_t* header = stream.header;
+        const uint64_t frameSize = (uint64_t(header[3] & 0x03) << 11) + (uint64_t(header[4]) << 3) + (header[5] >> 5);
+        if (isAdtsSync(header[0], header[1]) && frameSize >= minAdtsFrameSize)
+        {
+            startAccessUnit(stream, stream.headerOffset);
+            stream.auKeyframe = true;
+            stream.headerOffset += frameSize;
+            stream.synced = true;
+        }
+        else
+        {
+            if (stream.synced)
+                ++statistics_[stream.pid].syncErrors;
+            stream.synced = false;
+            ++stream.headerOffset;
+        }
+    }
+
+    if (hasPts)
+        stream.pendingPts = rawData.pts;
+}
+
+void EsFramer::startAccessUnit(Stream& stream, uint64_t offset)
+{
+    if (stream.auStarted)
+        reportAccessUnit(stream, offset);
+
+    stream.auStarted = true;
+    stream.auOffset = offset;
+    stream.auPts = stream.pendingPts;
+    stream.auKeyframe = false;
+    stream.auHasVcl = false;
+    stream.auHasPs = false;
+    stream.auPsOpen = false;
+    stream.pendingPts = noTimestamp;
+}
+
+void EsFramer::reportAccessUnit(Stream& stream, uint64_t end)
+{
+    if (stream.auPsOpen)
+        stream.auPsEnd = end;
+
+    auto& statistics = statistics_[stream.pid];
+    ++statistics.accessUnits;
+    statistics.keyframes += stream.auKeyframe;
+
+    if (handler_)
+        handler_(AccessUnit{ stream.pid, stream.type, stream.esNumber, stream.auOffset, end - stream.auOffset,
+                             stream.auPts, stream.auKeyframe,
+                             stream.auHasPs ? stream.auPsOffset : 0, stream.auHasPs ? stream.auPsEnd - stream.auPsOffset : 0 });
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "message_types.hpp"
+#include "payload_parser.hpp"
+
+#include <functional>
+#include <map>
+#include <ostream>
+
+
+/// @class EsFramer.
+/// @brief Detect access units and keyframes in ES raw data.
+/// @details H.264 and HEVC access units are found by NAL start codes and NAL types, AAC ones
+///          by ADTS sync chain. Codec is taken from stream type of PMT, ES of other types or
+///          without PMT are not framed. Raw data is not modified, so framer observes it along
+///          with outputs. Start codes and ADTS headers may be split between TS packets.
+class EsFramer
+{
+public:
+    /// @brief Access unit information.
+    struct AccessUnit
+    {
+        /// @brief PID of ES.
+        uint16_t pid;
+
+        /// @brief Type of ES.
+        EsType type;
+
+        /// @brief ES sequence number in the set of ES of the same type.
+        uint16_t esNumber;
+
+        /// @brief Offset of access unit within ES.
+        uint64_t esOffset;
+
+        /// @brief Size of access unit.
+        uint64_t size;
+
+        /// @brief PTS of PES packet the access unit starts in, noTimestamp if absent or used by previous access unit.
+        int64_t pts;
+
+        /// @brief Set for IDR (H.264), IRAP (HEVC) and all ADTS access units.
+        bool keyframe;
+
+        /// @brief Offset of parameter sets (VPS, SPS, PPS) of access unit within ES.
+        uint64_t parameterSetsOffset;
+
+        /// @brief Size of parameter sets including NAL units between them, 0 if access unit has none.
+        uint64_t parameterSetsSize;
+    };
+
+    /// @brief Type of access unit handler.
+    using OnAccessUnit = std::function<void(const AccessUnit&)>;
+
+    /// @brief Statistics of framed ES.
+    struct Statistics
+    {
+        /// @brief Number of access units.
+        uint64_t accessUnits = 0;
+
+        /// @brief Number of keyframes.
+        uint64_t keyframes = 0;
+
+        /// @brief Number of ADTS sync losses.
+        uint64_t syncErrors = 0;
+    };
+
+    /// @brief Constructor.
+    /// @param[out] log - Stream for log messages.
+    /// @param[in] streams - Detected streams by PID, see PayloadParser::streams().
+    /// @param[in] handler - Access unit handler, may be empty.
+    /// @param[in] pictureHandler - Handler of H.264 or HEVC access unit at its first VCL NAL unit, may be empty.
+    ///                             Access unit size is given up to the NAL unit, so keyframe flag and parameter
+    ///                             sets are known before the rest of access unit data.
+    /// @throws Error.
+    EsFramer(std::ostream& log, const std::map<uint16_t, PayloadParser::StreamInfo>& streams, OnAccessUnit handler,
+             OnAccessUnit pictureHandler = OnAccessUnit());
+
+    /// @brief Scan raw data for access unit boundaries.
+    /// @details Access unit is reported as soon as the next one starts, so handler is
+    ///          called only for access units which data is already passed to this method.
+    ///          Calls handler, which may throws exceptions.
+    /// @param[in] rawData - ES raw data.
+    void write(const EsRawData& rawData);
+
+    /// @brief Report the last access unit of every ES and log statistics.
+    /// @details Calls handler, which may throws exceptions.
+    void flush();
+
+    /// @brief Get statistics of framed ES by PID.
+    const std::map<uint16_t, Statistics>& statistics() const;
+
+    /// @brief Check if ES of stream type is framed.
+    /// @param[in] streamType - Stream type from PMT.
+    static bool supports(uint8_t streamType);
+
+private:
+    /// @brief Supported codecs.
+    enum Codec
+    {
+        NONE,
+        H264,
+        HEVC,
+        ADTS,
+    };
+
+    /// @brief Framing state of ES.
+    struct Stream
+    {
+        /// @brief PID of ES.
+        uint16_t pid;
+
+        /// @brief Type of ES.
+        EsType type;
+
+        /// @brief ES sequence number.
+        uint16_t esNumber;
+
+        /// @brief Codec of ES.
+        Codec codec;
+
+        /// @brief Number of ES bytes already scanned.
+        uint64_t esBytes;
+
+        /// @brief PTS of the last PES packet, not yet used by any access unit.
+        int64_t pendingPts;
+
+        /// @brief Set if current access unit is started.
+        bool auStarted;
+
+        /// @brief Offset of current access unit.
+        uint64_t auOffset;
+
+        /// @brief PTS of current access unit.
+        int64_t auPts;
+
+        /// @brief Set if current access unit is keyframe.
+        bool auKeyframe;
+
+        /// @brief Set if current access unit contains VCL NAL unit.
+        bool auHasVcl;
+
+        /// @brief Offset of the first parameter set of current access unit.
+        uint64_t auPsOffset;
+
+        /// @brief End of the last parameter set of current access unit.
+        uint64_t auPsEnd;
+
+        /// @brief Set if current access unit contains parameter sets.
+        bool auHasPs;
+
+        /// @brief Set if the last NAL unit of current access unit is parameter set, so its end is unknown.
+        bool auPsOpen;
+
+        /// @brief Number of trailing zero bytes of scanned data, up to 3.
+        uint8_t zeros;
+
+        /// @brief Set if NAL unit header after start code is being collected.
+        bool collecting;
+
+        /// @brief Offset of NAL unit start code or of the next ADTS header.
+        uint64_t headerOffset;
+
+        /// @brief Collected bytes of NAL unit or ADTS header.
+        uint8_t header[6];
+
+        /// @brief Number of collected header bytes.
+        uint8_t headerSize;
+
+        /// @brief Set if ADTS sync chain is followed.
+        bool synced;
+    };
+
+    /// @brief Find or add state of ES.
+    /// @param[in] rawData - ES raw data.
+    Stream& chooseStream(const EsRawData& rawData);
+
+    /// @brief Scan H.264 or HEVC raw data.
+    /// @param[in] stream - ES state.
+    /// @param[in] rawData - ES raw data.
+    void scanNalUnits(Stream& stream, const EsRawData& rawData);
+
+    /// @brief Start collecting header of NAL unit.
+    /// @param[in] stream - ES state.
+    /// @param[in] rawData - ES raw data.
+    /// @param[in] nalOffset - Offset of NAL unit start code within ES.
+    /// @param[in] position - Position of NAL unit header within raw data.
+    /// @returns Position of the first raw data byte after collected header bytes.
+    size_t beginNalUnit(Stream& stream, const EsRawData& rawData, uint64_t nalOffset, size_t position);
+
+    /// @brief Collect NAL unit header and handle NAL unit if header is complete.
+    /// @param[in] stream - ES state.
+    /// @param[in] rawData - ES raw data.
+    /// @param[in] position - Position of the next header byte within raw data.
+    /// @returns Position of the first raw data byte after collected header bytes.
+    size_t collectNalHeader(Stream& stream, const EsRawData& rawData, size_t position);
+
+    /// @brief Handle NAL unit with collected header.
+    /// @param[in] stream - ES state.
+    void onNalUnit(Stream& stream);
+
+    /// @brief Scan ADTS raw data.
+    /// @param[in] stream - ES state.
+    /// @param[in] rawData - ES raw data.
+    void scanAdts(Stream& stream, const EsRawData& rawData);
+
+    /// @brief Report current access unit and start new one.
+    /// @param[in] stream - ES state.
+    /// @param[in] offset - Offset of new access unit within ES.
+    void startAccessUnit(Stream& stream, uint64_t offset);
+
+    /// @brief Report current access unit.
+    /// @param[in] stream - ES state.
+    /// @param[in] end - Offset of the end of access unit within ES.
+    void reportAccessUnit(Stream& stream, uint64_t end);
+
+private:
+    /// @brief Log output stream.
+    std::ostream& log_;
+
+    /// @brief Detected streams by PID.
+    const std::map<uint16_t, PayloadParser::StreamInfo>& streamInfos_;
+
+    /// @brief Access unit handler.
+    OnAccessUnit handler_;
+
+    /// @brief Handler of access unit at its first VCL NAL unit.
+    OnAccessUnit pictureHandler_;
+
+    /// @brief Framing states of ES by PID.
+    std::map<uint16_t, Stream> streams_;
+
+    /// @brief Statistics of framed ES by PID.
+    std::map<uint16_t, Statistics> statistics_;
+};
@@ -0,0 +1,575 @@
+#include "error.hpp"
+#include "es_verifier.hpp"
+#include "start_code.hpp"
+#include "tracing.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+
+
+namespace
+{
+    /// @brief Size of blocks files are read by.
+    const size_t blockSize = 1024 * 1024;
+
+    /// @brief Size of start code 00 00 01.
+    const uint64_t startCodeSize = 3;
+
+    /// @brief Minimal size of ADTS frame, its header without CRC.
+    const size_t minAdtsFrameSize = 7;
+
+    /// @brief Number of AC-3 and E-AC-3 header bytes needed to get frame size.
+    const size_t ac3HeaderSize = 6;
+
+    /// @brief AC-3 bitrates in kbit/s by frmsizecod / 2.
+    const uint16_t ac3Bitrates[] = { 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512, 576, 640 };
+
+    /// @brief Kinds of NAL units required for decoding.
+    enum NalKind : uint8_t
+    {
+        VPS = 1,
+        SPS = 2,
+        PPS = 4,
+        SLICE = 8,
+    };
+
+    /// @brief Sequential reader of file by blocks, which keeps requested bytes in one buffer.
+    class FileBlocks
+    {
+    public:
+        /// @brief Constructor.
+        /// @param[in] fileName - File name.
+        explicit FileBlocks(const std::string& fileName)
+            : file_(fileName, std::ifstream::in | std::ifstream::binary)
+            , buffer_(blockSize)
+        {
+            if (!file_.good())
+                return;
+            file_.seekg(0, std::ios::end);
+            fileSize_ = static_cast<uint64_t>(file_.tellg());
+            file_.seekg(0);
+        }
+
+        /// @brief Check if file is open.
+        bool good() const
+        {
+            return file_.is_open() && !file_.bad();
+        }
+
+        /// @brief Get file size.
+        uint64_t size() const
+        {
+            return fileSize_;
+        }
+
+        /// @brief Get bytes from position till the end of buffer, reading the next block if needed.
+        /// @param[in] position - Offset of the first byte within the file.
+        /// @param[in] count - Number of bytes needed, not more than block size.
+        /// @returns Pointer to the byte at position, nullptr if the file ends earlier.
+        const uint8_t* get(uint64_t position, size_t count)
+        {
+            if (position >= offset_ && position + count <= offset_ + size_)
+                return buffer_.data() + (position - offset_);
+            if (position + count > fileSize_)
+                return nullptr;
+
+            // keep buffered bytes starting from position, if any
+            size_t kept = 0;
+            if (position >= offset_ && position < offset_ + size_)
+            {
+                kept = static_cast<size_t>(offset_ + size_ - position);
+                memmove(buffer_.data(), buffer_.data() + (position - offset_), kept);
+            }
+            else
+            {
+                file_.clear();
+                file_.seekg(static_cast<std::streamoff>(position));
+            }
+
+            file_.read(reinterpret_cast<char*>(buffer_.data() + kept), static_cast<std::streamsize>(buffer_.size() - kept));
+            offset_ = position;
+            size_ = kept + static_cast<size_t>(file_.gcount());
+            return count <= size_ ? buffer_.data() : nullptr;
+        }
+
+        /// @brief Get number of buffered bytes from position, which is returned by get().
+        size_t available(uint64_t position) const
+        {
+            return static_cast<size_t>(offset_ + size_ - position);
+        }
+
+    private:
+        /// @brief File stream.
+        std::ifstream file_;
+
+        /// @brief File size.
+        uint64_t fileSize_ = 0;
+
+        /// @brief Buffered bytes.
+        std::vector<uint8_t> buffer_;
+
+        /// @brief Offset of buffered bytes within the file.
+        uint64_t offset_ = 0;
+
+        /// @brief Number of buffered bytes.
+        size_t size_ = 0;
+    };
+
+    /// @brief Type of frame size getter.
+    /// @param[in] header - Frame header.
+    /// @param[out] error - Description of header error.
+    /// @returns Frame size, 0 if header is invalid.
+    using FrameSize = uint64_t (*)(const uint8_t* header, const char*& error);
+
+    /// @brief Count error, the first one is described.
+    void addError(EsVerifier::Result& result, uint64_t offset, const char* error)
+    {
+        if (!result.errors++)
+        {
+            result.firstError = error;
+            result.firstErrorOffset = offset;
+        }
+    }
+
+    /// @brief Get size of ADTS frame by its header.
+    uint64_t adtsFrameSize(const uint8_t* header, const char*& error)
+    {
+        if (header[0] != 0xFF || (header[1] & 0xF6) != 0xF0)
+        {
+            error = "ADTS sync word is lost";
+            return 0;
+        }
+        if (((header[2] >> 2) & 0x0F) > 12)
+        {
+            error = "ADTS sampling frequency index is reserved";
+            return 0;
+        }
+
+        // header is followed by CRC if protection is not absent
+        const uint64_t size = (uint64_t(header[3] & 0x03) << 11) | (uint64_t(header[4]) << 3) | (header[5] >> 5);
+        if (size < ((header[1] & 0x01) ? minAdtsFrameSize : minAdtsFrameSize + 2))
+        {
+            error = "ADTS frame length is less than its header";
+            return 0;
+        }
+        return size;
+    }
+
+    /// @brief Get size of AC-3 or E-AC-3 sync frame by its header.
+    uint64_t ac3FrameSize(const uint8_t* header, const char*& error)
+    {
+        if (header[0] != 0x0B || header[1] != 0x77)
+        {
+            error = "AC-3 sync word is lost";
+            return 0;
+        }
+
+        const uint8_t bsid = header[5] >> 3;
+        if (bsid > 16)
+        {
+            error = "AC-3 bitstream id is unsupported";
+            return 0;
+        }
+
+        // E-AC-3 signals frame size in 16-bit words
+        if (bsid > 10)
+            return ((uint64_t(header[2] & 0x07) << 8 | header[3]) + 1) * 2;
+
+        const uint8_t fscod = header[4] >> 6;
+        const uint8_t frmsizecod = header[4] & 0x3F;
+        if (fscod == 3 || frmsizecod >= 2 * sizeof(ac3Bitrates) / sizeof(ac3Bitrates[0]))
+        {
+            error = "AC-3 sample rate or frame size code is reserved";
+            return 0;
+        }
+
+        // frame size in 16-bit words for 48, 44.1 and 32 kHz
+        const uint64_t bitrate = ac3Bitrates[frmsizecod / 2];
+        const uint64_t words = fscod == 0 ? 2 * bitrate : fscod == 1 ? bitrate * 320 / 147 + (frmsizecod & 1) : 3 * bitrate;
+        return words * 2;
+    }
+
+    /// @brief Verify that the file is unbroken chain of frames, resynchronize after errors.
+    /// @param[in] blocks - File reader.
+    /// @param[in,out] result - Result of verification.
+    /// @param[in] headerSize - Size of header needed to get frame size.
+    /// @param[in] frameSize - Frame size getter.
+    void verifyFrames(FileBlocks& blocks, EsVerifier::Result& result, size_t headerSize, FrameSize frameSize)
+    {
+        const uint64_t fileSize = blocks.size();
+        bool synced = true;
+        uint64_t position = 0;
+        while (position < fileSize)
+        {
+            const uint8_t* header = blocks.get(position, headerSize);
+            if (!header)
+            {
+                if (synced)
+                    addError(result, position, "file ends with truncated frame header");
+                break;
+            }
+
+            const char* error = nullptr;
+            const uint64_t size = frameSize(header, error);
+            if (!size)
+            {
+                // the loss is counted once, then sync is searched byte by byte
+                if (synced)
+                    addError(result, position, error);
+                synced = false;
+                ++position;
+                continue;
+            }
+            if (position + size > fileSize)
+            {
+                addError(result, position, "file ends with truncated frame");
+                break;
+            }
+
+            synced = true;
+            ++result.units;
+            position += size;
+        }
+    }
+
+    /// @brief Check H.264 NAL unit header.
+    /// @param[in] header - NAL unit header, 1 byte.
+    /// @param[out] kind - Kind of NAL unit, 0 if it's not required for decoding.
+    /// @returns Description of error, nullptr if header is valid.
+    const char* checkH264Header(const uint8_t* header, uint8_t& kind)
+    {
+        const uint8_t type = header[0] & 0x1F;
+        const uint8_t refIdc = (header[0] >> 5) & 0x03;
+        kind = type == 7 ? SPS : type == 8 ? PPS : type >= 1 && type <= 5 ? SLICE : 0;
+
+        if (header[0] & 0x80)
+            return "forbidden bit of NAL unit header is set";
+        if ((type >= 16 && type <= 18) || type == 22 || type == 23)
+            return "NAL unit type is reserved";
+        if ((type == 5 || type == 7 || type == 8) && !refIdc)
+            return "IDR slice or parameter set has zero nal_ref_idc";
+        return nullptr;
+    }
+
+    /// @brief Check HEVC NAL unit header.
+    /// @param[in] header - NAL unit header, 2 bytes.
+    /// @param[out] kind - Kind of NAL unit, 0 if it's not required for decoding.
+    /// @returns Description of error, nullptr if header is valid.
+    const char* checkHevcHeader(const uint8_t* header, uint8_t& kind)
+    {
+        const uint8_t type = (header[0] >> 1) & 0x3F;
+        const uint8_t temporalIdPlus1 = header[1] & 0x07;
+        kind = type == 32 ? VPS : type == 33 ? SPS : type == 34 ? PPS : type < 32 ? SLICE : 0;
+
+        if (header[0] & 0x80)
+            return "forbidden bit of NAL unit header is set";
+        if (!temporalIdPlus1)
+            return "NAL unit temporal id is invalid";
+        if ((type >= 10 && type <= 15) || (type >= 22 && type <= 31) || (type >= 41 && type <= 47))
+            return "NAL unit type is reserved";
+
+        // IRAP slices, VPS, SPS, end of sequence and end of bitstream belong to the lowest sub-layer
+        const bool baseLayerOnly = (type >= 16 && type <= 21) || type == 32 || type == 33 || type == 36 || type == 37;
+        if (baseLayerOnly && temporalIdPlus1 != 1)
+            return "IRAP slice or parameter set has nonzero temporal id";
+        return nullptr;
+    }
+
+    /// @brief Verify H.264 or HEVC byte stream: start codes, NAL unit headers and parameter sets.
+    /// @param[in] blocks - File reader.
+    /// @param[in,out] result - Result of verification.
+    /// @param[in] hevc - Set for HEVC, unset for H.264.
+    void verifyNalUnits(FileBlocks& blocks, EsVerifier::Result& result, bool hevc)
+    {
+        const uint64_t fileSize = blocks.size();
+        const size_t headerSize = hevc ? 2 : 1;
+        const uint8_t required = hevc ? VPS | SPS | PPS : SPS | PPS;
+        uint8_t found = 0;
+
+        // NAL unit is checked once the next start code is found, so its size is known
+        bool nalStarted = false;
+        uint64_t nalStart = 0;
+        uint8_t header[2] = {};
+        uint64_t position = 0;
+        while (true)
+        {
+            uint64_t startCode = fileSize;
+            while (position + startCodeSize <= fileSize)
+            {
+                const uint8_t* data = blocks.get(position, startCodeSize);
+                const size_t available = blocks.available(position);
+                const size_t offset = findStartCode(data, available);
+                if (offset < available)
+                {
+                    startCode = position + offset;
+                    break;
+                }
+                // start code may be split between blocks
+                position += available - (startCodeSize - 1);
+            }
+
+            if (nalStarted)
+            {
+                const uint64_t size = startCode - nalStart;
+                const bool zeros = std::all_of(header, header + std::min<uint64_t>(size, headerSize), [](uint8_t b) { return b == 0; });
+                uint8_t kind = 0;
+                const char* error = nullptr;
+                if (size <= headerSize && zeros)
+                    error = "NAL unit is empty";
+                else if (size < headerSize)
+                    error = "NAL unit header is truncated";
+                else
+                    error = hevc ? checkHevcHeader(header, kind) : checkH264Header(header, kind);
+                if (error)
+                    addError(result, nalStart, error);
+
+                ++result.units;
+                found |= kind & required;
+                if ((kind & SLICE) && found != required)
+                    ++result.slicesBeforeParameterSets;
+            }
+            else
+            {
+                // only zero bytes may precede the first start code
+                const uint8_t* data = startCode < fileSize && startCode <= blockSize ? blocks.get(0, static_cast<size_t>(startCode)) : nullptr;
+                if (!data || !std::all_of(data, data + startCode, [](uint8_t b) { return b == 0; }))
+                {
+                    addError(result, 0, "byte stream does not start with start code");
+                    if (startCode == fileSize)
+                        return;
+                }
+            }
+
+            if (startCode == fileSize)
+                break;
+
+            nalStarted = true;
+            nalStart = startCode + startCodeSize;
+            position = nalStart;
+            const size_t headerBytes = static_cast<size_t>(std::min<uint64_t>(headerSize, fileSize - nalStart));
+            if (headerBytes)
+                std::copy_n(blocks.get(nalStart, headerBytes), headerBytes, header);
+        }
+
+        if (result.slicesBeforeParameterSets && found != required)
+            addError(result, 0, hevc ? "VPS, SPS or PPS is missing" : "SPS or PPS is missing");
+    }
+
+    /// @brief Detect codec by the head of the file.
+    EsVerifier::Codec detectCodec(FileBlocks& blocks)
+    {
+        const size_t size = static_cast<size_t>(std::min<uint64_t>(blocks.size(), blockSize));
+        const uint8_t* data = blocks.get(0, size);
+        if (!data)
+            return EsVerifier::Codec::UNKNOWN;
+
+        const char* error = nullptr;
+        if (size >= minAdtsFrameSize && adtsFrameSize(data, error))
+            return EsVerifier::Codec::ADTS;
+        if (size >= ac3HeaderSize && ac3FrameSize(data, error))
+            return EsVerifier::Codec::AC3;
+
+        // the first NAL unit is usually access unit delimiter or parameter set
+        const size_t offset = findStartCode(data, size);
+        if (offset + startCodeSize + 2 > size)
+            return EsVerifier::Codec::UNKNOWN;
+        const uint8_t first = data[offset + startCodeSize];
+        const uint8_t second = data[offset + startCodeSize + 1];
+
+        const uint8_t hevcType = (first >> 1) & 0x3F;
+        if ((first & 0x81) == 0 && second == 0x01 && ((hevcType >= 32 && hevcType <= 35) || hevcType == 39))
+            return EsVerifier::Codec::HEVC;
+
+        const uint8_t h264Type = first & 0x1F;
+        if ((first & 0x80) == 0 && ((h264Type >= 5 && h264Type <= 9) || h264Type == 1))
+            return EsVerifier::Codec::H264;
+        return EsVerifier::Codec::UNKNOWN;
+    }
+
+    /// @brief Write string as JSON string literal.
+    void writeJsonString(std::ostream& output, const std::string& value)
+    {
+        output << '"';
+        for (const char c : value)
+        {
+            if (c == '"' || c == '\\')
+                output << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20)
+                output << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec << std::setfill(' ');
+            else
+                output << c;
+        }
+        output << '"';
+    }
+}
+
+EsVerifier::EsVerifier(std::ostream& log, size_t threads)
+    : log_(log)
+    , threads_(threads ? threads : std::max(1u, std::thread::hardware_concurrency()))
+{
+    if (!log_.good())
+        throw Error(Error::CONSTRUCTION_ERROR, "EsVerifier, bad log output");
+}
+
+void EsVerifier::add(const std::string& file, Codec codec)
+{
+    files_.emplace_back(file, codec);
+}
+
+void EsVerifier::verifyAll()
+{
+    results_.assign(files_.size(), Result());
+
+    // every thread takes the next file until all are verified
+    std::atomic<size_t> next(0);
+    auto worker = [this, &next]()
+    {
+        for (size_t i = next++; i < files_.size(); i = next++)
+            results_[i] = verify(files_[i].first, files_[i].second);
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min(threads_, files_.size()); ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+
+    for (const auto& result : results_)
+    {
+        if (result.errors)
+            log_ << "Warning: EsVerifier, '" << result.file << "': " << result.firstError << " at offset "
+                 << result.firstErrorOffset << ", " << result.errors << " errors" << std::endl;
+    }
+}
+
+const std::vector<EsVerifier::Result>& EsVerifier::results() const
+{
+    return results_;
+}
+
+bool EsVerifier::passed() const
+{
+    return std::none_of(results_.begin(), results_.end(), [](const Result& result) { return result.errors != 0; });
+}
+
+void EsVerifier::report(std::ostream& output) const
+{
+    size_t unsupported = 0;
+    size_t failed = 0;
+
+    output << "{\n"
+           << "  \"files\": [";
+    bool first = true;
+    for (const auto& result : results_)
+    {
+        unsupported += result.codec == Codec::UNKNOWN && !result.errors;
+        failed += result.errors != 0;
+
+        output << (first ? "\n" : ",\n")
+               << "    {\n"
+               << "      \"file\": ";
+        writeJsonString(output, result.file);
+        output << ",\n"
+               << "      \"codec\": \"" << codecName(result.codec) << "\",\n"
+               << "      \"bytes\": " << result.bytes << ",\n"
+               << "      \"units\": " << result.units << ",\n";
+        if (result.codec == Codec::H264 || result.codec == Codec::HEVC)
+            output << "      \"slicesBeforeParameterSets\": " << result.slicesBeforeParameterSets << ",\n";
+        output << "      \"errors\": " << result.errors << ",\n";
+        if (result.errors)
+        {
+            output << "      \"firstError\": ";
+            writeJsonString(output, result.firstError);
+            output << ",\n"
+                   << "      \"firstErrorOffset\": " << result.firstErrorOffset << ",\n";
+        }
+        output << "      \"passed\": " << (result.errors ? "false" : "true") << "\n"
+               << "    }";
+        first = false;
+    }
+    output << (first ? "],\n" : "\n  ],\n")
+           << "  \"unsupportedFiles\": " << unsupported << ",\n"
+           << "  \"failedFiles\": " << failed << "\n"
+           << "}" << std::endl;
+}
+
+EsVerifier::Codec EsVerifier::codecOf(const PayloadParser::StreamInfo& info)
+{
+    switch (info.streamType)
+    {
+    case 0x0F:
+        return Codec::ADTS;
+    case 0x1B:
+        return Codec::H264;
+    case 0x24:
+        return Codec::HEVC;
+    case 0x81:
+    case 0x87:
+        return Codec::AC3;
+    default:
+        // AC-3 and E-AC-3 of DVB are signalled by descriptors of private PES
+        return info.codec == "AC-3" || info.codec == "E-AC-3" ? Codec::AC3 : Codec::UNKNOWN;
+    }
+}
+
+const char* EsVerifier::codecName(Codec codec)
+{
+    switch (codec)
+    {
+    case Codec::ADTS:
+        return "ADTS";
+    case Codec::AC3:
+        return "AC-3";
+    case Codec::H264:
+        return "H.264";
+    case Codec::HEVC:
+        return "HEVC";
+    default:
+        return "unknown";
+    }
+}
+
+EsVerifier::Result EsVerifier::verify(const std::string& file, Codec codec)
+{
+    TRACE_SPAN("verify file");
+    Result result;
+    result.file = file;
+    result.codec = codec;
+
+    FileBlocks blocks(file);
+    if (!blocks.good())
+    {
+        addError(result, 0, "failed to open file");
+        return result;
+    }
+    result.bytes = blocks.size();
+    if (!result.bytes)
+        return result;
+
+    if (result.codec == Codec::UNKNOWN)
+        result.codec = detectCodec(blocks);
+
+    switch (result.codec)
+    {
+    case Codec::ADTS:
+        verifyFrames(blocks, result, minAdtsFrameSize, adtsFrameSize);
+        break;
+    case Codec::AC3:
+        verifyFrames(blocks, result, ac3HeaderSize, ac3FrameSize);
+        break;
+    case Codec::H264:
+        verifyNalUnits(blocks, result, false);
+        break;
+    case Codec::HEVC:
+        verifyNalUnits(blocks, result, true);
+        break;
+    default:
+        break;
+    }
+    return result;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "payload_parser.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/// @class EsVerifier.
+/// @brief Verify structure of ES output files without decoding them.
+/// @details ADTS and AC-3 (E-AC-3) files are checked to be unbroken chains of sync frames with valid
+///          headers, H.264 and HEVC ones to be byte streams of valid NAL unit headers with parameter
+///          sets present. Files are read sequentially by large blocks and verified in parallel, so
+///          verification runs at disk speed.
+class EsVerifier
+{
+public:
+    /// @brief Codecs of verified files.
+    enum class Codec
+    {
+        /// @brief Codec is unknown, it's detected by file content.
+        UNKNOWN,
+
+        /// @brief AAC in ADTS frames.
+        ADTS,
+
+        /// @brief AC-3 or E-AC-3 sync frames.
+        AC3,
+
+        /// @brief H.264 byte stream.
+        H264,
+
+        /// @brief HEVC byte stream.
+        HEVC,
+    };
+
+    /// @brief Result of verification of one file.
+    struct Result
+    {
+        /// @brief File name.
+        std::string file;
+
+        /// @brief Codec the file is verified as, UNKNOWN if it's not supported.
+        Codec codec = Codec::UNKNOWN;
+
+        /// @brief File size.
+        uint64_t bytes = 0;
+
+        /// @brief Number of frames (ADTS, AC-3) or NAL units (H.264, HEVC).
+        uint64_t units = 0;
+
+        /// @brief Number of errors.
+        uint64_t errors = 0;
+
+        /// @brief Description of the first error, empty if none.
+        std::string firstError;
+
+        /// @brief Offset of the first error within the file.
+        uint64_t firstErrorOffset = 0;
+
+        /// @brief Number of H.264 and HEVC slices before parameter sets, e.g. if output starts at time
+        ///        range start. They are not errors, but decoders drop them.
+        uint64_t slicesBeforeParameterSets = 0;
+    };
+
+    /// @brief Constructor.
+    /// @param[out] log - Stream for log messages.
+    /// @param[in] threads - Maximum number of threads verifying files, 0 to use all CPU cores.
+    /// @throws Error.
+    EsVerifier(std::ostream& log, size_t threads = 0);
+
+    /// @brief Add file to verify.
+    /// @param[in] file - File name.
+    /// @param[in] codec - Codec of the file, UNKNOWN to detect it by content.
+    void add(const std::string& file, Codec codec);
+
+    /// @brief Verify all added files in parallel.
+    void verifyAll();
+
+    /// @brief Get results of verification in the order files are added.
+    const std::vector<Result>& results() const;
+
+    /// @brief Check if no verified file has errors.
+    bool passed() const;
+
+    /// @brief Write results in JSON format.
+    /// @param[out] output - Stream for the report.
+    void report(std::ostream& output) const;
+
+    /// @brief Get codec of ES by its stream information.
+    /// @param[in] info - Stream information from PMT.
+    /// @returns Codec, UNKNOWN if stream type is not supported or stream is not described by PMT.
+    static Codec codecOf(const PayloadParser::StreamInfo& info);
+
+    /// @brief Get codec name.
+    static const char* codecName(Codec codec);
+
+    /// @brief Verify one file.
+    /// @param[in] file - File name.
+    /// @param[in] codec - Codec of the file, UNKNOWN to detect it by content.
+    /// @returns Result of verification, failure to read the file is an error.
+    static Result verify(const std::string& file, Codec codec);
+
+private:
+    /// @brief Log output stream.
+    std::ostream& log_;
+
+    /// @brief Maximum number of threads.
+    size_t threads_;
+
+    /// @brief Added files and their codecs.
+    std::vector<std::pair<std::string, Codec>> files_;
+
+    /// @brief Results of verification.
+    std::vector<Result> results_;
+};
@@ -0,0 +1,103 @@
+#include "error.hpp"
+#include "file_watcher.hpp"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif // __linux__
+
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher(std::ostream& log, const std::string& fileName, int idleTimeout)
+    : log_(log)
+    , fileName_(fileName)
+    , idleTimeout_(idleTimeout)
+{
+    if (!log_.good())
+        throw Error(Error::CONSTRUCTION_ERROR, "FileWatcher, bad log output");
+
+    inotify_ = inotify_init1(IN_CLOEXEC);
+    if (inotify_ < 0)
+        throw Error(Error::CONSTRUCTION_ERROR, "FileWatcher, failed to init inotify: " + std::string(std::strerror(errno)));
+
+    const uint32_t mask = IN_MODIFY | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF;
+    if (inotify_add_watch(inotify_, fileName_.c_str(), mask) < 0)
+    {
+        const std::string reason = std::strerror(errno);
+        ::close(inotify_);
+        throw Error(Error::CONSTRUCTION_ERROR, "FileWatcher, failed to watch file '" + fileName_ + "': " + reason);
+    }
+}
+
+FileWatcher::~FileWatcher()
+{
+    ::close(inotify_);
+}
+
+bool FileWatcher::wait()
+{
+    // data written before completion is read after the previous call
+    if (complete_)
+        return false;
+
+    pollfd descriptor{ inotify_, POLLIN, 0 };
+    int ready = 0;
+    do
+        ready = ::poll(&descriptor, 1, idleTimeout_);
+    while (ready < 0 && errno == EINTR);
+
+    if (ready < 0)
+        throw Error(Error::CORRUPTED_INPUT, "FileWatcher, failed to poll inotify: " + std::string(std::strerror(errno)));
+    if (ready == 0)
+    {
+        log_ << "Notice: FileWatcher, nothing appended to '" << fileName_ << "' for " << idleTimeout_
+             << " ms, file is complete" << std::endl;
+        return false;
+    }
+
+    // all pending events are read at once, only the fact of modification matters
+    alignas(inotify_event) char events[4096];
+    const ssize_t size = ::read(inotify_, events, sizeof(events));
+    if (size < 0)
+        throw Error(Error::CORRUPTED_INPUT, "FileWatcher, failed to read inotify: " + std::string(std::strerror(errno)));
+
+    for (ssize_t offset = 0; offset < size;)
+    {
+        inotify_event event;
+        std::memcpy(&event, events + offset, sizeof(event));
+        offset += sizeof(inotify_event) + event.len;
+
+        if (complete_ || !(event.mask & (IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)))
+            continue;
+        log_ << "Notice: FileWatcher, '" << fileName_ << "' is "
+             << ((event.mask & IN_CLOSE_WRITE) ? "closed by writer" : "moved or deleted") << std::endl;
+        complete_ = true;
+    }
+
+    return true;
+}
+
+#else
+
+FileWatcher::FileWatcher(std::ostream& log, const std::string& fileName, int idleTimeout)
+    : log_(log)
+    , fileName_(fileName)
+    , idleTimeout_(idleTimeout)
+{
+    throw Error(Error::CONSTRUCTION_ERROR, "FileWatcher, following input is supported on Linux only");
+}
+
+FileWatcher::~FileWatcher()
+{
+}
+
+bool FileWatcher::wait()
+{
+    return false;
+}
+
+#endif // __linux__
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+
+
+/// @class FileWatcher.
+/// @brief Waits for growing file to be appended by its writer.
+/// @details File changes are watched by inotify, so waiting costs no I/O. The file is considered
+///          complete once its writer closes it, it is deleted or moved, or nothing is appended
+///          within idle timeout. Supported on Linux only.
+class FileWatcher
+{
+public:
+    /// @brief Constructor, starts watching, so changes made after it are not missed.
+    /// @param[out] log - Stream for log messages.
+    /// @param[in] fileName - Name of watched file.
+    /// @param[in] idleTimeout - Time in milliseconds without changes to consider file complete after.
+    /// @throws Error.
+    FileWatcher(std::ostream& log, const std::string& fileName, int idleTimeout);
+
+    /// @brief Destructor, stops watching.
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /// @brief Wait till file is changed.
+    /// @returns true if file may have more data, false if it is complete.
+    /// @throws Error.
+    bool wait();
+
+private:
+    /// @brief Log output stream.
+    std::ostream& log_;
+
+    /// @brief Name of watched file.
+    std::string fileName_;
+
+    /// @brief Time in milliseconds without changes to consider file complete after.
+    int idleTimeout_;
+
+    /// @brief Inotify descriptor.
+    int inotify_ = -1;
+
+    /// @brief Set if file is complete, but its data written before may be not read yet.
+    bool complete_ = false;
+};
@@ -0,0 +1,142 @@
+#include "error.hpp"
+#include "frame_writer.hpp"
+#include "ts_index.hpp"
+
+#include <cstring>
+#include <list>
+#include <sstream>
+
+
+FrameWriter::FrameWriter(std::ostream& log,
+                         const OutputNameGenerator& audioNameGenerator,
+                         const OutputNameGenerator& videoNameGenerator)
+    : log_(log)
+    , audioNameGenerator_(audioNameGenerator)
+    , videoNameGenerator_(videoNameGenerator)
+    , dummyOutput_{ "", nullptr }
+{
+    if (!log_.good())
+        throw Error(Error::CONSTRUCTION_ERROR, "FrameWriter, bad log output");
+}
+
+FrameWriter::~FrameWriter()
+{
+    try
+    {
+        closeOutputs();
+    }
+    catch (const Error& err)
+    {
+        log_ << "Error: FrameWriter, failed to close frame files, " << err.message() << std::endl;
+    }
+}
+
+void FrameWriter::write(const EsFramer::AccessUnit& accessUnit)
+{
+    auto& output = chooseOutput(accessUnit.type, accessUnit.esNumber);
+    if (!output.stream)
+        return;
+
+    TsFramesRecord record{ accessUnit.esOffset, accessUnit.size, accessUnit.pts, 0, 0 };
+    if (accessUnit.keyframe)
+        record.flags |= FRAME_KEYFRAME;
+    if (accessUnit.parameterSetsSize)
+        record.flags |= FRAME_PARAMETER_SETS;
+    output.stream->write(reinterpret_cast<const char*>(&record), sizeof(record));
+    if (!output.stream->good())
+        throw Error(Error::CORRUPTED_OUTPUT, "FrameWriter, failed to write into file '" + output.file + "'");
+}
+
+void FrameWriter::flushOutputs()
+{
+    auto flushOutput = [](Output& output)
+    {
+        if (output.stream && !output.stream->flush().good())
+            throw Error(Error::CORRUPTED_OUTPUT, "FrameWriter, failed to flush file '" + output.file + "'");
+    };
+
+    for (auto& pair : audioOutputs_)
+        flushOutput(pair.second);
+    for (auto& pair : videoOutputs_)
+        flushOutput(pair.second);
+}
+
+void FrameWriter::closeOutputs()
+{
+    // to collect names of failed files
+    std::list<std::string> failedFiles;
+    auto closeOutput = [&failedFiles](Output& output)
+    {
+        if (!output.stream)
+            return;
+        output.stream->close();
+        if (!output.stream->good())
+            failedFiles.push_back(output.file);
+        output.stream.reset();
+    };
+
+    for (auto& pair : audioOutputs_)
+        closeOutput(pair.second);
+    for (auto& pair : videoOutputs_)
+        closeOutput(pair.second);
+
+    if (!failedFiles.empty())
+    {
+        std::ostringstream msg;
+        msg << "FrameWriter, failed to close file(s) ";
+
+        auto end = --failedFiles.cend();
+        for (auto it = failedFiles.cbegin(); it != end; ++it)
+            msg << "'" << *it << "',";
+        msg << "'" << *end << "'";
+
+        throw Error(Error::CORRUPTED_OUTPUT, msg.str());
+    }
+}
+
+FrameWriter::Output& FrameWriter::chooseOutput(EsType type, uint16_t number)
+{
+    std::map<uint16_t, Output>* outputs = nullptr;
+    const OutputNameGenerator* generator = nullptr;
+
+    if (type == EsType::AUDIO)
+    {
+        outputs = &audioOutputs_;
+        generator = &audioNameGenerator_;
+    }
+    else if (type == EsType::VIDEO)
+    {
+        outputs = &videoOutputs_;
+        generator = &videoNameGenerator_;
+    }
+    else
+        return dummyOutput_;
+
+    // ES already detected
+    const auto it = outputs->find(number);
+    if (it != outputs->end())
+        return it->second;
+
+    // no frame file if no output file for this ES
+    const std::string name = generator->name(number);
+    auto& output = (*outputs)[number];
+    if (name.empty())
+        return output;
+
+    // try to open new file for write
+    output.file = name + ".frames";
+    output.stream.reset(new std::ofstream(output.file, std::fstream::out | std::fstream::binary));
+    if (!output.stream->good())
+    {
+        output.stream.reset();
+        throw Error(Error::CORRUPTED_OUTPUT, "FrameWriter, failed to open file '" + output.file + "' for writing");
+    }
+
+    TsFramesHeader header;
+    std::memcpy(header.magic, tsFramesMagic, sizeof(header.magic));
+    header.version = tsFramesVersion;
+    header.recordSize = sizeof(TsFramesRecord);
+    output.stream->write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    return output;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "es_framer.hpp"
+#include "message_types.hpp"
+#include "output_name_generator.hpp"
+
+#include <fstream>
+#include <map>
+#include <memory>
+
+
+/// @class FrameWriter.
+/// @brief Write access units detected by EsFramer in output ES into frame files.
+/// @details Frame file of ES is named after its output file with '.frames' suffix,
+///          its format is described in ts_index.hpp.
+class FrameWriter
+{
+public:
+    /// @brief Constructor.
+    /// @param[out] log - Stream for log messages.
+    /// @param[in] audioNameGenerator - Generator for audio output file names.
+    /// @param[in] videoNameGenerator - Generator for video output file names.
+    /// @throws Error.
+    FrameWriter(std::ostream& log,
+                const OutputNameGenerator& audioNameGenerator,
+                const OutputNameGenerator& videoNameGenerator);
+
+    /// @brief Desctructor.
+    ~FrameWriter();
+
+    /// @brief Add access unit of output ES.
+    /// @param[in] accessUnit - Access unit, see EsFramer.
+    /// @throws Error in case of corrupted output streams.
+    void write(const EsFramer::AccessUnit& accessUnit);
+
+    /// @brief Flush buffered records into frame files.
+    /// @throws Error in case of corrupted output streams.
+    void flushOutputs();
+
+    /// @brief Close frame files.
+    /// @throws Error in case of corrupted output streams.
+    void closeOutputs();
+
+private:
+    /// @brief Frame file of ES.
+    struct Output
+    {
+        /// @brief Frame file name.
+        std::string file;
+
+        /// @brief Frame file stream.
+        std::unique_ptr<std::ofstream> stream;
+    };
+
+    /// @brief Choose or open frame file for ES.
+    /// @param[in] type - Type of ES.
+    /// @param[in] number - Sequence number of ES.
+    /// @throws Error if fails to open file stream.
+    Output& chooseOutput(EsType type, uint16_t number);
+
+private:
+    /// @brief Log output stream.
+    std::ostream& log_;
+
+    /// @brief Generator for audio output file names.
+    const OutputNameGenerator& audioNameGenerator_;
+
+    /// @brief Generator for video output file names.
+    const OutputNameGenerator& videoNameGenerator_;
+
+    /// @brief Frame files of detected audio ES.
+    std::map<uint16_t, Output> audioOutputs_;
+
+    /// @brief Frame files of detected video ES.
+    std::map<uint16_t, Output> videoOutputs_;
+
+    /// @brief Dummy output for ES without output file.
+    Output dummyOutput_;
+};
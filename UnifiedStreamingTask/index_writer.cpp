@@ -0,0 +1,92 @@
+#include "error.hpp"
+#include "index_writer.hpp"
+
+#include <cstring>
+
+
+namespace
+{
+    /// @brief Write array of index records.
+    template <typename T>
+    void writeRecords(std::ostream& output, const T* records, size_t number)
+    {
+        output.write(reinterpret_cast<const char*>(records), sizeof(T) * number);
+    }
+}
+
+IndexWriter::IndexWriter(std::ostream& log, const std::string& file)
+    : log_(log)
+    , file_(file)
+{
+    if (!log_.good())
+        throw Error(Error::CONSTRUCTION_ERROR, "IndexWriter, bad log output");
+
+    output_.open(file_, std::fstream::out | std::fstream::binary);
+    if (!output_.good())
+        throw Error(Error::CORRUPTED_OUTPUT, "IndexWriter, failed to open file '" + file_ + "' for writing");
+}
+
+void IndexWriter::write(const EsRawData& rawData, const OutputWriter::Position* position)
+{
+    if (rawData.type == EsType::OTHER)
+        return;
+
+    auto& stream = streams_.insert({ rawData.pid, Stream{ rawData.type, rawData.esNumber, 0, {} } }).first->second;
+    if (rawData.newEsPacket)
+    {
+        stream.entries.push_back(position ? TsIndexEntry{ rawData.tsOffset, position->offset, rawData.pts, position->segment, 0 }
+                                          : TsIndexEntry{ rawData.tsOffset, stream.esBytes, rawData.pts, 0, 0 });
+    }
+    stream.esBytes += rawData.size;
+}
+
+void IndexWriter::writeTable(const PayloadParser::TableInfo& table)
+{
+    tables_.push_back(TsIndexTable{ table.tsOffset, table.pid, table.number, table.tableId, table.version, 0 });
+}
+
+void IndexWriter::close(const std::map<uint16_t, PayloadParser::StreamInfo>& streams)
+{
+    if (!output_.is_open())
+        return;
+
+    TsIndexHeader header;
+    std::memcpy(header.magic, tsIndexMagic, sizeof(header.magic));
+    header.version = tsIndexVersion;
+    header.headerSize = sizeof(TsIndexHeader);
+    header.streams = static_cast<uint32_t>(streams_.size());
+    header.tables = static_cast<uint32_t>(tables_.size());
+    header.entries = 0;
+
+    std::vector<TsIndexStream> records;
+    records.reserve(streams_.size());
+    for (const auto& pair : streams_)
+    {
+        const auto it = streams.find(pair.first);
+        const auto& stream = pair.second;
+
+        TsIndexStream record;
+        record.pid = pair.first;
+        record.program = it != streams.end() ? it->second.program : 0;
+        record.esNumber = stream.esNumber;
+        record.type = stream.type == EsType::AUDIO ? INDEX_AUDIO : INDEX_VIDEO;
+        record.streamType = it != streams.end() ? it->second.streamType : 0;
+        record.firstEntry = header.entries;
+        record.entries = stream.entries.size();
+        records.push_back(record);
+
+        header.entries += stream.entries.size();
+    }
+
+    writeRecords(output_, &header, 1);
+    writeRecords(output_, records.data(), records.size());
+    writeRecords(output_, tables_.data(), tables_.size());
+    for (const auto& pair : streams_)
+        writeRecords(output_, pair.second.entries.data(), pair.second.entries.size());
+
+    output_.close();
+    if (!output_.good())
+        throw Error(Error::CORRUPTED_OUTPUT, "IndexWriter, failed to write into file '" + file_ + "'");
+
+    log_ << "Notice: IndexWriter, " << header.entries << " entries written into '" << file_ << "'" << std::endl;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "message_types.hpp"
+#include "output_writer.hpp"
+#include "payload_parser.hpp"
+#include "ts_index.hpp"
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+
+/// @class IndexWriter.
+/// @brief Collects PES starts and PSI versions of TS input and writes them into sidecar index file.
+/// @details Entries are kept in memory and written at once when index is closed, see ts_index.hpp.
+class IndexWriter
+{
+public:
+    /// @brief Constructor.
+    /// @param[out] log - Stream for log messages.
+    /// @param[in] file - Index file name.
+    /// @throws Error.
+    IndexWriter(std::ostream& log, const std::string& file);
+
+    /// @brief Add ES raw data, which is written into output ES.
+    /// @param[in] rawData - ES raw data.
+    /// @param[in] position - Position of the data in output files of ES, nullptr if ES has no output,
+    ///                       then offset of the data in the whole ES is indexed.
+    void write(const EsRawData& rawData, const OutputWriter::Position* position = nullptr);
+
+    /// @brief Add new version of PSI table.
+    /// @param[in] table - PSI table information.
+    void writeTable(const PayloadParser::TableInfo& table);
+
+    /// @brief Write collected index into file and close it.
+    /// @param[in] streams - All detected streams by PID.
+    /// @throws Error in case of corrupted output stream.
+    void close(const std::map<uint16_t, PayloadParser::StreamInfo>& streams);
+
+private:
+    /// @brief Indexed elementary stream.
+    struct Stream
+    {
+        /// @brief Type of the stream.
+        EsType type;
+
+        /// @brief Stream number in the set of all streams of same type.
+        uint16_t esNumber;
+
+        /// @brief Number of ES bytes already written.
+        uint64_t esBytes;
+
+        /// @brief Entries of the stream.
+        std::vector<TsIndexEntry> entries;
+    };
+
+private:
+    /// @brief Log output stream.
+    std::ostream& log_;
+
+    /// @brief Index file name.
+    const std::string file_;
+
+    /// @brief Index file stream.
+    std::ofstream output_;
+
+    /// @brief Indexed streams by PID.
+    std::map<uint16_t, Stream> streams_;
+
+    /// @brief Seen PSI table versions.
+    std::vector<TsIndexTable> tables_;
+};
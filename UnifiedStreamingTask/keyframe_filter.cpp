@@ -0,0 +1,262 @@
+#include "error.hpp"
+#include "keyframe_filter.hpp"
+
+#include <algorithm>
+#include <limits>
+
+
+namespace
+{
+    /// @brief Number of trailing bytes which may start NAL unit not yet detected by framer:
+    ///        zero byte and start code with up to 3 header bytes, but the last one.
+    ///        Such NAL unit starts with zero byte.
+    const uint64_t undetectedBytes = 6;
+}
+
+KeyframeFilter::KeyframeFilter(std::ostream& log,
+                               const std::map<uint16_t, PayloadParser::StreamInfo>& streams,
+                               OnEsRawData handler)
+    : log_(log)
+    , streamInfos_(streams)
+    , handler_(handler)
+    , framer_(log, streams, std::bind(&KeyframeFilter::onAccessUnit, this, std::placeholders::_1),
+              std::bind(&KeyframeFilter::onPicture, this, std::placeholders::_1))
+    , rawData_(nullptr)
+{
+    if (!log_.good())
+        throw Error(Error::CONSTRUCTION_ERROR, "KeyframeFilter, bad log output");
+    if (!handler_)
+        throw Error(Error::CONSTRUCTION_ERROR, "KeyframeFilter, empty handler");
+}
+
+void KeyframeFilter::write(const EsRawData& rawData)
+{
+    if (rawData.type != EsType::VIDEO)
+    {
+        handler_(rawData);
+        return;
+    }
+
+    auto& stream = chooseStream(rawData);
+    if (rawData.newEsPacket)
+    {
+        stream.usesRandomAccess = stream.usesRandomAccess || rawData.randomAccess;
+        stream.dropping = (stream.usesRandomAccess || !stream.framed) && !rawData.randomAccess;
+    }
+
+    if (!stream.framed)
+    {
+        if (!stream.dropping)
+            handler_(rawData);
+        stream.esBytes += rawData.size;
+        return;
+    }
+
+    if (rawData.newEsPacket && !stream.dropping)
+        stream.pesStarts.push_back(PesStart{ stream.esBytes, rawData.tsOffset, rawData.pts, rawData.dts, rawData.readTime });
+    stream.dataOffset = stream.esBytes;
+    stream.esBytes += rawData.size;
+
+    // framer decides on access units while scanning, data is passed or dropped by handlers
+    rawData_ = &rawData;
+    framer_.write(rawData);
+
+    if (stream.dropping)
+        resolve(stream, stream.esBytes, stream.decision == PASS);
+    else
+    {
+        // bytes which may start the next access unit wait till framer detects it
+        if (stream.decision != UNDECIDED)
+        {
+            uint64_t end = stream.esBytes - std::min(stream.esBytes - stream.bufferOffset, undetectedBytes);
+            while (end < stream.esBytes)
+            {
+                const uint8_t byte = end >= stream.dataOffset ? rawData.data[end - stream.dataOffset]
+                                                              : stream.buffer[end - stream.bufferOffset];
+                if (!byte)
+                    break;
+                ++end;
+            }
+            resolve(stream, end, stream.decision == PASS);
+        }
+
+        if (stream.bufferOffset < stream.esBytes)
+        {
+            if (stream.buffer.empty())
+                stream.bufferReadTime = rawData.readTime;
+            const uint64_t position = std::max(stream.bufferOffset, stream.dataOffset) - stream.dataOffset;
+            stream.buffer.insert(stream.buffer.end(), rawData.data + position, rawData.data + rawData.size);
+        }
+    }
+    rawData_ = nullptr;
+}
+
+void KeyframeFilter::flush()
+{
+    rawData_ = nullptr;
+    framer_.flush();
+
+    // data of ES without access units
+    for (auto& pair : streams_)
+        resolve(pair.second, pair.second.esBytes, false);
+
+    for (const auto& pair : statistics_)
+    {
+        log_ << "Notice: KeyframeFilter, pid " << pair.first << ": " << pair.second.keyframes << " keyframes passed, "
+             << pair.second.dropped << " access units dropped" << std::endl;
+    }
+}
+
+const std::map<uint16_t, KeyframeFilter::Statistics>& KeyframeFilter::statistics() const
+{
+    return statistics_;
+}
+
+KeyframeFilter::Stream& KeyframeFilter::chooseStream(const EsRawData& rawData)
+{
+    auto it = streams_.find(rawData.pid);
+    if (it != streams_.end())
+        return it->second;
+
+    const auto info = streamInfos_.find(rawData.pid);
+    Stream stream{};
+    stream.framed = info != streamInfos_.end() && EsFramer::supports(info->second.streamType);
+    stream.dropping = true;
+    stream.decision = UNDECIDED;
+
+    statistics_[rawData.pid];
+    return streams_.insert({ rawData.pid, stream }).first->second;
+}
+
+void KeyframeFilter::onPicture(const EsFramer::AccessUnit& accessUnit)
+{
+    auto& stream = streams_[accessUnit.pid];
+    auto& statistics = statistics_[accessUnit.pid];
+    const uint64_t pictureOffset = accessUnit.esOffset + accessUnit.size;
+
+    // data preceding the first access unit
+    resolve(stream, accessUnit.esOffset, false);
+
+    // parameter sets precede picture, so they are buffered or in current raw data
+    if (accessUnit.parameterSetsSize && accessUnit.parameterSetsOffset >= stream.bufferOffset)
+    {
+        const uint64_t bufferEnd = stream.bufferOffset + stream.buffer.size();
+        const uint64_t end = accessUnit.parameterSetsOffset + accessUnit.parameterSetsSize;
+        stream.parameterSets.clear();
+        if (accessUnit.parameterSetsOffset < bufferEnd)
+        {
+            stream.parameterSets.insert(stream.parameterSets.end(),
+                                        stream.buffer.begin() + (accessUnit.parameterSetsOffset - stream.bufferOffset),
+                                        stream.buffer.begin() + (std::min(end, bufferEnd) - stream.bufferOffset));
+        }
+        if (end > bufferEnd)
+        {
+            const uint8_t* data = rawData_->data - stream.dataOffset;
+            stream.parameterSets.insert(stream.parameterSets.end(),
+                                        data + std::max(accessUnit.parameterSetsOffset, bufferEnd), data + end);
+        }
+    }
+
+    // keyframe in PES packet without random access indicator, ES doesn't use it properly
+    const bool dropped = stream.dropping && pictureOffset >= stream.dataOffset;
+    if (accessUnit.keyframe && dropped && stream.usesRandomAccess)
+    {
+        log_ << "Warning: KeyframeFilter, keyframe without random access indicator in pid " << accessUnit.pid
+             << ", the indicator is ignored" << std::endl;
+        stream.usesRandomAccess = false;
+    }
+
+    if (accessUnit.keyframe && !dropped)
+    {
+        // the last PES packet started not later than access unit
+        auto pes = stream.pesStarts.rbegin();
+        while (pes != stream.pesStarts.rend() && pes->esOffset > accessUnit.esOffset)
+            ++pes;
+        const bool hasPes = pes != stream.pesStarts.rend();
+
+        EsRawData& rawData = stream.accessUnit;
+        rawData.data = nullptr;
+        rawData.size = 0;
+        rawData.type = accessUnit.type;
+        rawData.esNumber = accessUnit.esNumber;
+        rawData.pid = accessUnit.pid;
+        rawData.pts = accessUnit.pts;
+        rawData.newEsPacket = true;
+        rawData.tsOffset = hasPes ? pes->tsOffset : 0;
+        rawData.dts = accessUnit.pts != noTimestamp && hasPes ? pes->dts : accessUnit.pts;
+        rawData.randomAccess = true;
+        rawData.broken = false;
+        rawData.readTime = hasPes ? pes->readTime : 0;
+        if (!accessUnit.parameterSetsSize && !stream.parameterSets.empty())
+            pass(stream, stream.parameterSets.data(), stream.parameterSets.size(), hasPes ? pes->readTime : 0);
+
+        stream.decision = PASS;
+        ++statistics.keyframes;
+    }
+    else
+    {
+        stream.decision = DROP;
+        ++statistics.dropped;
+    }
+
+    resolve(stream, pictureOffset, stream.decision == PASS);
+}
+
+void KeyframeFilter::onAccessUnit(const EsFramer::AccessUnit& accessUnit)
+{
+    auto& stream = streams_[accessUnit.pid];
+    const uint64_t end = accessUnit.esOffset + accessUnit.size;
+
+    // access unit without picture
+    if (stream.decision == UNDECIDED)
+        ++statistics_[accessUnit.pid].dropped;
+
+    resolve(stream, end, stream.decision == PASS);
+    stream.decision = UNDECIDED;
+
+    while (stream.pesStarts.size() > 1 && stream.pesStarts[1].esOffset <= end)
+        stream.pesStarts.pop_front();
+}
+
+void KeyframeFilter::resolve(Stream& stream, uint64_t end, bool passed)
+{
+    if (end <= stream.bufferOffset)
+        return;
+
+    const size_t buffered = static_cast<size_t>(std::min<uint64_t>(end - stream.bufferOffset, stream.buffer.size()));
+    if (buffered)
+    {
+        if (passed)
+            pass(stream, stream.buffer.data(), buffered, stream.bufferReadTime);
+        stream.buffer.erase(stream.buffer.begin(), stream.buffer.begin() + buffered);
+        stream.bufferOffset += buffered;
+    }
+
+    // the rest is in current raw data, which is dropped as a whole with its PES packet
+    if (end > stream.bufferOffset && rawData_)
+    {
+        if (passed && !stream.dropping)
+            pass(stream, rawData_->data + (stream.bufferOffset - stream.dataOffset), end - stream.bufferOffset, rawData_->readTime);
+        stream.bufferOffset = end;
+    }
+}
+
+void KeyframeFilter::pass(Stream& stream, const uint8_t* data, size_t size, uint64_t readTime)
+{
+    auto& rawData = stream.accessUnit;
+    const size_t maxChunk = std::numeric_limits<uint32_t>::max();
+    while (size)
+    {
+        const size_t chunk = std::min(size, maxChunk);
+        rawData.data = data;
+        rawData.size = static_cast<uint32_t>(chunk);
+        rawData.readTime = readTime;
+        handler_(rawData);
+
+        rawData.newEsPacket = false;
+        rawData.pts = noTimestamp;
+        rawData.dts = noTimestamp;
+        data += chunk;
+        size -= chunk;
+    }
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "es_framer.hpp"
+#include "message_types.hpp"
+#include "payload_parser.hpp"
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <vector>
+
+
+/// @class KeyframeFilter.
+/// @brief Pass only keyframe access units of video ES.
+/// @details H.264 and HEVC access units are detected by EsFramer, keyframe ones are passed along
+///          with the last seen parameter sets if they have none. Access unit is decided on at its
+///          first VCL NAL unit, data after it is passed or dropped in place, only data preceding it
+///          and a few bytes which may start the next access unit are buffered. If ES signals keyframes
+///          with random access indicator, PES packets without it are dropped. Other video ES are
+///          filtered by random access indicator only. Non-video ES are passed as is.
+class KeyframeFilter
+{
+public:
+    /// @brief Type of raw data handler.
+    using OnEsRawData = std::function<void(const EsRawData&)>;
+
+    /// @brief Statistics of filtered ES.
+    struct Statistics
+    {
+        /// @brief Number of passed keyframes.
+        uint64_t keyframes = 0;
+
+        /// @brief Number of dropped access units.
+        uint64_t dropped = 0;
+    };
+
+    /// @brief Constructor.
+    /// @param[out] log - Stream for log messages.
+    /// @param[in] streams - Detected streams by PID, see PayloadParser::streams().
+    /// @param[in] handler - Raw data handler.
+    /// @throws Error.
+    KeyframeFilter(std::ostream& log, const std::map<uint16_t, PayloadParser::StreamInfo>& streams, OnEsRawData handler);
+
+    /// @brief Filter raw data.
+    /// @details Calls handler, which may throws exceptions.
+    /// @param[in] rawData - ES raw data.
+    void write(const EsRawData& rawData);
+
+    /// @brief Pass the last access units if they are keyframes and log statistics.
+    /// @details Calls handler, which may throws exceptions.
+    void flush();
+
+    /// @brief Get statistics of filtered video ES by PID.
+    const std::map<uint16_t, Statistics>& statistics() const;
+
+private:
+    /// @brief Start of PES packet within ES.
+    struct PesStart
+    {
+        /// @brief Offset of PES packet data within ES.
+        uint64_t esOffset;
+
+        /// @brief Offset of TS packet with PES header within input.
+        uint64_t tsOffset;
+
+        /// @brief PTS of PES packet.
+        int64_t pts;
+
+        /// @brief DTS of PES packet.
+        int64_t dts;
+
+        /// @brief Time the first TS packet of PES packet is read at.
+        uint64_t readTime;
+    };
+
+    /// @brief Decision on current access unit.
+    enum Decision
+    {
+        UNDECIDED,
+        PASS,
+        DROP,
+    };
+
+    /// @brief Filtering state of video ES.
+    struct Stream
+    {
+        /// @brief Set if access units are detected by framer, otherwise by random access indicator only.
+        bool framed;
+
+        /// @brief Set if ES signals keyframes with random access indicator.
+        bool usesRandomAccess;
+
+        /// @brief Set if current PES packet is dropped.
+        bool dropping;
+
+        /// @brief Number of ES bytes already filtered.
+        uint64_t esBytes;
+
+        /// @brief Offset of current raw data within ES.
+        uint64_t dataOffset;
+
+        /// @brief Decision on current access unit.
+        Decision decision;
+
+        /// @brief Offset of the first byte not yet passed or dropped within ES.
+        uint64_t bufferOffset;
+
+        /// @brief Data not yet passed or dropped preceding current raw data.
+        std::vector<uint8_t> buffer;
+
+        /// @brief Time the first buffered byte is read at.
+        uint64_t bufferReadTime;
+
+        /// @brief Starts of PES packets, the first one may precede current access unit.
+        std::deque<PesStart> pesStarts;
+
+        /// @brief The last seen parameter sets.
+        std::vector<uint8_t> parameterSets;
+
+        /// @brief Template of passed access unit data, its newEsPacket is reset after the first chunk.
+        EsRawData accessUnit;
+    };
+
+    /// @brief Find or add state of video ES.
+    /// @param[in] rawData - ES raw data.
+    Stream& chooseStream(const EsRawData& rawData);
+
+    /// @brief Decide on access unit at its first VCL NAL unit.
+    /// @param[in] accessUnit - Access unit information up to the NAL unit.
+    void onPicture(const EsFramer::AccessUnit& accessUnit);
+
+    /// @brief Handle access unit reported by framer.
+    /// @param[in] accessUnit - Access unit information.
+    void onAccessUnit(const EsFramer::AccessUnit& accessUnit);
+
+    /// @brief Pass or drop buffered data and then data of current raw data up to offset.
+    /// @param[in] stream - ES state.
+    /// @param[in] end - Offset within ES to pass or drop data up to.
+    /// @param[in] passed - Set if data is passed, otherwise it's dropped.
+    void resolve(Stream& stream, uint64_t end, bool passed);
+
+    /// @brief Pass data of access unit to handler in chunks fitting raw data.
+    /// @param[in] stream - ES state.
+    /// @param[in] data - Start of data.
+    /// @param[in] size - Size of data.
+    /// @param[in] readTime - Time the data is read at.
+    void pass(Stream& stream, const uint8_t* data, size_t size, uint64_t readTime);
+
+private:
+    /// @brief Log output stream.
+    std::ostream& log_;
+
+    /// @brief Detected streams by PID.
+    const std::map<uint16_t, PayloadParser::StreamInfo>& streamInfos_;
+
+    /// @brief Raw data handler.
+    OnEsRawData handler_;
+
+    /// @brief Access unit detector.
+    EsFramer framer_;
+
+    /// @brief Raw data being scanned by framer, nullptr if none.
+    const EsRawData* rawData_;
+
+    /// @brief Filtering states of video ES by PID.
+    std::map<uint16_t, Stream> streams_;
+
+    /// @brief Statistics of filtered video ES by PID.
+    std::map<uint16_t, Statistics> statistics_;
+};
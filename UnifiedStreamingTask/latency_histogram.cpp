@@ -0,0 +1,106 @@
+#include "latency_histogram.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+
+
+namespace
+{
+    /// @brief Number of values counted exactly, also twice the number of sub-buckets of every power of 2.
+    const uint64_t exactValues = 256;
+
+    /// @brief Number of sub-buckets of every power of 2.
+    const uint64_t subBuckets = exactValues / 2;
+
+    /// @brief Number of bits in sub-bucket number and its leading bit.
+    const unsigned subBucketBits = 8;
+
+    /// @brief Number of buckets covering all 64-bit values.
+    const size_t bucketCount = exactValues + (64 - subBucketBits) * subBuckets;
+}
+
+uint64_t LatencyHistogram::now()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+LatencyHistogram::LatencyHistogram()
+    : buckets_(bucketCount, 0)
+{
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+    ++buckets_[bucketIndex(value)];
+    ++count_;
+    max_ = std::max(max_, value);
+}
+
+uint64_t LatencyHistogram::count() const
+{
+    return count_;
+}
+
+uint64_t LatencyHistogram::max() const
+{
+    return max_;
+}
+
+uint64_t LatencyHistogram::percentile(double percent) const
+{
+    if (!count_)
+        return 0;
+
+    // rank is rounded up, but not for floating point error of exact ranks like 99.9% of 1000
+    const double rank = std::ceil(std::min(std::max(percent, 0.0), 100.0) * count_ / 100 - 1e-9);
+    const uint64_t target = std::max<uint64_t>(static_cast<uint64_t>(rank), 1);
+    uint64_t counted = 0;
+    for (size_t i = 0; i < buckets_.size(); ++i)
+    {
+        counted += buckets_[i];
+        if (counted >= target)
+            return std::min(bucketMax(i), max_);
+    }
+    return max_;
+}
+
+void LatencyHistogram::reset()
+{
+    std::fill(buckets_.begin(), buckets_.end(), 0);
+    count_ = 0;
+    max_ = 0;
+}
+
+void LatencyHistogram::writeSummary(std::ostream& output) const
+{
+    const auto flags = output.flags();
+    const auto precision = output.precision();
+    output << count_ << " samples, p50 " << std::fixed << std::setprecision(3) << percentile(50) / 1e6 << " ms, p99 "
+           << percentile(99) / 1e6 << " ms, p99.9 " << percentile(99.9) / 1e6 << " ms, max " << max_ / 1e6 << " ms";
+    output.flags(flags);
+    output.precision(precision);
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t value)
+{
+    if (value < exactValues)
+        return static_cast<size_t>(value);
+
+    // bigger values are counted by their leading bits
+    unsigned shift = 1;
+    while ((value >> shift) >= exactValues)
+        ++shift;
+    return static_cast<size_t>(exactValues + (shift - 1) * subBuckets + ((value >> shift) - subBuckets));
+}
+
+uint64_t LatencyHistogram::bucketMax(size_t index)
+{
+    if (index < exactValues)
+        return index;
+
+    const unsigned shift = static_cast<unsigned>((index - exactValues) / subBuckets + 1);
+    const uint64_t leadingBits = subBuckets + (index - exactValues) % subBuckets;
+    return ((leadingBits + 1) << shift) - 1;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+
+/// @class LatencyHistogram.
+/// @brief Histogram of latencies in nanoseconds with bounded relative error, HDR histogram style.
+/// @details Values below 256 are counted exactly, bigger ones in 128 linear sub-buckets of every
+///          power of 2, so percentiles are precise within 1%. Recording is constant time and memory
+///          doesn't depend on number of samples.
+class LatencyHistogram
+{
+public:
+    /// @brief Get monotonic time in nanoseconds, the clock read times of TS packets are taken by.
+    static uint64_t now();
+
+    /// @brief Constructor.
+    LatencyHistogram();
+
+    /// @brief Record latency.
+    /// @param[in] value - Latency in nanoseconds.
+    void record(uint64_t value);
+
+    /// @brief Get number of recorded latencies.
+    uint64_t count() const;
+
+    /// @brief Get maximum recorded latency.
+    uint64_t max() const;
+
+    /// @brief Get latency not exceeded by given percent of recorded ones.
+    /// @param[in] percent - Percent, from 0 to 100.
+    /// @returns The highest latency equivalent to the found one within precision, 0 if nothing is recorded.
+    uint64_t percentile(double percent) const;
+
+    /// @brief Drop recorded latencies.
+    void reset();
+
+    /// @brief Write number of samples, p50, p99, p99.9 and maximum in milliseconds.
+    /// @param[out] output - Stream for the summary.
+    void writeSummary(std::ostream& output) const;
+
+private:
+    /// @brief Get index of bucket counting value.
+    static size_t bucketIndex(uint64_t value);
+
+    /// @brief Get the highest value counted by bucket.
+    static uint64_t bucketMax(size_t index);
+
+    /// @brief Counters of buckets.
+    std::vector<uint64_t> buckets_;
+
+    /// @brief Number of recorded latencies.
+    uint64_t count_ = 0;
+
+    /// @brief Maximum recorded latency.
+    uint64_t max_ = 0;
+};
@@ -0,0 +1,320 @@
+#include "error.hpp"
+#include "libts_splitter.h"
+#include "program_options.hpp"
+#include "split_pipeline.hpp"
+#include "ts_reader.hpp"
+
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif // _WIN32
+
+
+namespace
+{
+    /// @brief Executable name options are parsed with.
+    const char* const programName = "libts_splitter";
+
+    /// @brief Size of block read from file descriptor.
+    const size_t fdBlockSize = 188 * 1024;
+
+    /// @class LogBuffer.
+    /// @brief Stream buffer passing complete lines to log callback, or to standard log if it's not set.
+    class LogBuffer : public std::streambuf
+    {
+    public:
+        /// @brief Set log callback, nullptr to write into standard log.
+        void setCallback(ts_splitter_log_callback callback, void* context)
+        {
+            callback_ = callback;
+            context_ = context;
+        }
+
+    protected:
+        int_type overflow(int_type ch) override
+        {
+            if (traits_type::eq_int_type(ch, traits_type::eof()))
+                return traits_type::not_eof(ch);
+
+            if (traits_type::to_char_type(ch) == '\n')
+                writeLine();
+            else
+                line_ += traits_type::to_char_type(ch);
+            return ch;
+        }
+
+    private:
+        /// @brief Pass buffered line to callback or standard log.
+        void writeLine()
+        {
+            // whole line is written at once, so lines of parallel splitters are not mixed
+            if (callback_)
+                callback_(context_, line_.c_str());
+            else
+                std::clog << line_ + '\n' << std::flush;
+            line_.clear();
+        }
+
+        /// @brief Log callback, nullptr if not set.
+        ts_splitter_log_callback callback_ = nullptr;
+
+        /// @brief Context of log callback.
+        void* context_ = nullptr;
+
+        /// @brief Incomplete line.
+        std::string line_;
+    };
+}
+
+/// @struct ts_splitter.
+/// @brief Splitter of pushed TS: its options, pipeline of jobs and the reader feeding it.
+struct ts_splitter
+{
+    /// @brief Buffer of log stream.
+    LogBuffer logBuffer;
+
+    /// @brief Log stream of the pipeline.
+    std::ostream log{ &logBuffer };
+
+    /// @brief Options, null until set or input is pushed.
+    std::unique_ptr<ProgramOptions> options;
+
+    /// @brief Output callback, nullptr if not set.
+    ts_splitter_output_callback outputCallback = nullptr;
+
+    /// @brief Context of output callback.
+    void* outputContext = nullptr;
+
+    /// @brief Jobs of the options, null until input is pushed.
+    std::unique_ptr<SplitPipeline> pipeline;
+
+    /// @brief Reader of pushed input, null until input is pushed.
+    std::unique_ptr<TsReader> reader;
+
+    /// @brief Set once splitting is complete.
+    bool finished = false;
+
+    /// @brief Inventory and verification reports.
+    std::string report;
+
+    /// @brief Description of the last error.
+    std::string lastError;
+};
+
+namespace
+{
+    /// @brief Call action on splitter, converting its exceptions into status codes.
+    template <typename Action>
+    int guarded(ts_splitter* splitter, Action action)
+    {
+        if (!splitter)
+            return TS_SPLITTER_INVALID_CALL;
+
+        splitter->lastError.clear();
+        try
+        {
+            action(*splitter);
+            return TS_SPLITTER_OK;
+        }
+        catch (const Error& e)
+        {
+            splitter->lastError = e.what();
+            return e.code();
+        }
+        catch (const std::exception& e)
+        {
+            splitter->lastError = e.what();
+            return TS_SPLITTER_CONSTRUCTION_ERROR;
+        }
+    }
+
+    /// @brief Throw if input is already pushed into splitter, so its configuration can't change.
+    void checkNotStarted(const ts_splitter& splitter, const std::string& function)
+    {
+        if (splitter.pipeline || splitter.finished)
+            throw Error(Error::INVALID_CALL, "libts_splitter, " + function + " should be called before input is pushed");
+    }
+
+    /// @brief Parse options given without executable name.
+    void setOptions(ts_splitter& splitter, int argc, const char* const* argv)
+    {
+        std::vector<const char*> args{ programName };
+        args.insert(args.end(), argv, argv + argc);
+
+        std::unique_ptr<ProgramOptions> options(new ProgramOptions(programName));
+        options->init(static_cast<int>(args.size()), args.data());
+
+        // input is pushed by host application, so options reading input by themselves are rejected
+        if (options->helpRequested() || options->cpuFeaturesRequested() || !options->inputName().empty() ||
+            options->followRequested() || options->quickProbeRequested() || options->perfReportRequested())
+        {
+            throw Error(Error::WRONG_OPTION_ARGUMENT,
+                        "libts_splitter, -h, --cpu-features, -i, --follow, --quick-probe and --perf-report are not supported");
+        }
+        splitter.options = std::move(options);
+    }
+
+    /// @brief Create pipeline and reader on the first pushed input.
+    void start(ts_splitter& splitter)
+    {
+        if (splitter.finished)
+            throw Error(Error::INVALID_CALL, "libts_splitter, splitter is already finished");
+        if (splitter.pipeline)
+            return;
+
+        if (!splitter.options)
+            setOptions(splitter, 0, nullptr);
+
+        SplitPipeline::OnJobRawData handler;
+        if (splitter.outputCallback)
+        {
+            const ts_splitter_output_callback callback = splitter.outputCallback;
+            void* context = splitter.outputContext;
+            handler = [callback, context](size_t job, const EsRawData& rawData)
+            {
+                ts_splitter_es_data data;
+                data.job = job;
+                data.type = rawData.type == EsType::AUDIO ? TS_SPLITTER_AUDIO : TS_SPLITTER_VIDEO;
+                data.es_number = rawData.esNumber;
+                data.pid = rawData.pid;
+                data.data = rawData.data;
+                data.size = rawData.size;
+                data.pts = rawData.pts;
+                data.dts = rawData.dts;
+                data.new_es_packet = rawData.newEsPacket;
+                data.random_access = rawData.randomAccess;
+                data.ts_offset = rawData.tsOffset;
+                callback(context, &data);
+            };
+        }
+
+        // packets are never copied from input file, as there is none
+        splitter.pipeline.reset(new SplitPipeline(splitter.log, *splitter.options, std::string(), handler));
+        splitter.reader.reset(new TsReader(splitter.log, splitter.pipeline->payloadHandler(
+            [&splitter]() { splitter.reader->stop(); })));
+        splitter.pipeline->configure(*splitter.reader);
+    }
+}
+
+ts_splitter* ts_splitter_create(void)
+{
+    return new (std::nothrow) ts_splitter();
+}
+
+void ts_splitter_destroy(ts_splitter* splitter)
+{
+    delete splitter;
+}
+
+int ts_splitter_set_options(ts_splitter* splitter, int argc, const char* const* argv)
+{
+    return guarded(splitter, [argc, argv](ts_splitter& s)
+    {
+        checkNotStarted(s, "ts_splitter_set_options()");
+        if (argc < 0 || (argc && !argv))
+            throw Error(Error::INVALID_CALL, "libts_splitter, no options");
+        setOptions(s, argc, argv);
+    });
+}
+
+int ts_splitter_set_output_callback(ts_splitter* splitter, ts_splitter_output_callback callback, void* context)
+{
+    return guarded(splitter, [callback, context](ts_splitter& s)
+    {
+        checkNotStarted(s, "ts_splitter_set_output_callback()");
+        s.outputCallback = callback;
+        s.outputContext = context;
+    });
+}
+
+int ts_splitter_set_log_callback(ts_splitter* splitter, ts_splitter_log_callback callback, void* context)
+{
+    return guarded(splitter, [callback, context](ts_splitter& s)
+    {
+        s.logBuffer.setCallback(callback, context);
+    });
+}
+
+int ts_splitter_push(ts_splitter* splitter, const uint8_t* data, size_t size)
+{
+    return guarded(splitter, [data, size](ts_splitter& s)
+    {
+        if (!data && size)
+            throw Error(Error::INVALID_CALL, "libts_splitter, no data");
+        start(s);
+        if (size)
+        {
+            s.reader->push(data, size);
+            s.pipeline->checkDeadlines();
+        }
+    });
+}
+
+int ts_splitter_attach_fd(ts_splitter* splitter, int fd)
+{
+    return guarded(splitter, [fd](ts_splitter& s)
+    {
+        start(s);
+        std::vector<uint8_t> buffer(fdBlockSize);
+        while (!s.pipeline->finished())
+        {
+#ifdef _WIN32
+            const int size = _read(fd, buffer.data(), static_cast<unsigned>(buffer.size()));
+#else
+            const ssize_t size = ::read(fd, buffer.data(), buffer.size());
+            if (size < 0 && errno == EINTR)
+                continue;
+#endif // _WIN32
+            if (size < 0)
+                throw Error(Error::CORRUPTED_INPUT, "libts_splitter, failed to read file descriptor " + std::to_string(fd));
+            if (size == 0)
+                break;
+            s.reader->push(buffer.data(), static_cast<size_t>(size));
+            s.pipeline->checkDeadlines();
+        }
+    });
+}
+
+int ts_splitter_done(const ts_splitter* splitter)
+{
+    return splitter && (splitter->finished || (splitter->pipeline && splitter->pipeline->finished()));
+}
+
+int ts_splitter_finish(ts_splitter* splitter)
+{
+    return guarded(splitter, [](ts_splitter& s)
+    {
+        start(s);
+
+        // splitter is finished even if closing fails, so outputs are never closed twice
+        std::unique_ptr<TsReader> reader = std::move(s.reader);
+        std::unique_ptr<SplitPipeline> pipeline = std::move(s.pipeline);
+        s.finished = true;
+
+        std::ostringstream report;
+        const bool verified = pipeline->close(reader->statistics(), report);
+        s.report = report.str();
+        if (!verified)
+            throw Error(Error::CORRUPTED_OUTPUT, "libts_splitter, some outputs failed verification");
+    });
+}
+
+const char* ts_splitter_report(const ts_splitter* splitter)
+{
+    return splitter ? splitter->report.c_str() : "";
+}
+
+const char* ts_splitter_last_error(const ts_splitter* splitter)
+{
+    return splitter ? splitter->lastError.c_str() : "Invalid library call: no splitter";
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+/// @file libts_splitter.h
+/// @brief C API of libts_splitter, splitting TS pushed by the host application.
+/// @details Every splitter is independent, so many of them may run in parallel threads of one process.
+///          Calls on one splitter must not be made concurrently. Functions return TS_SPLITTER_OK or error code,
+///          the description of the last error is returned by ts_splitter_last_error().
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(TS_SPLITTER_EXPORTS)
+#define TS_SPLITTER_API __declspec(dllexport)
+#elif defined(_WIN32) && defined(TS_SPLITTER_DLL)
+#define TS_SPLITTER_API __declspec(dllimport)
+#elif defined(__GNUC__)
+#define TS_SPLITTER_API __attribute__((visibility("default")))
+#else
+#define TS_SPLITTER_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief Status codes, equal to codes of Error.
+enum ts_splitter_status
+{
+    TS_SPLITTER_OK = 0,                     ///< No error.
+    TS_SPLITTER_NO_OPTION_ARGUMENT = 1,     ///< Option argument missing.
+    TS_SPLITTER_ARGUMENT_WITHOUT_OPTION = 2,///< Argument without option.
+    TS_SPLITTER_UNKNOWN_OPTION = 3,         ///< Unknown option.
+    TS_SPLITTER_CONSTRUCTION_ERROR = 4,     ///< Error creating splitter or its outputs.
+    TS_SPLITTER_CORRUPTED_INPUT = 5,        ///< Input can't be read.
+    TS_SPLITTER_CORRUPTED_OUTPUT = 6,       ///< Output can't be written or failed verification.
+    TS_SPLITTER_WRONG_OPTION_ARGUMENT = 7,  ///< Wrong option argument, or option not supported by library.
+    TS_SPLITTER_INVALID_CALL = 8,           ///< Function called with wrong arguments or out of order.
+};
+
+/// @brief Types of ES data.
+enum ts_splitter_es_type
+{
+    TS_SPLITTER_AUDIO = 0,
+    TS_SPLITTER_VIDEO = 1,
+};
+
+/// @brief Timestamp value meaning the timestamp is absent.
+#define TS_SPLITTER_NO_TIMESTAMP (-1)
+
+/// @brief ES raw data passed to output callback.
+typedef struct ts_splitter_es_data
+{
+    size_t job;              ///< Index of job the data is split by, 0 unless jobs are given.
+    int type;                ///< Type of ES, see ts_splitter_es_type.
+    unsigned es_number;      ///< Number of ES among all ES of the same type, starting from 1.
+    unsigned pid;            ///< PID of ES.
+    const uint8_t* data;     ///< Start of data, valid only during the callback.
+    size_t size;             ///< Size of data.
+    int64_t pts;             ///< PTS of ES packet started with this data, TS_SPLITTER_NO_TIMESTAMP if absent.
+    int64_t dts;             ///< DTS of ES packet started with this data, equals to PTS if absent.
+    int new_es_packet;       ///< Non-zero if data starts ES packet.
+    int random_access;       ///< Non-zero if random access indicator of TS packet is set.
+    uint64_t ts_offset;      ///< Offset of TS packet carrying this data within input.
+} ts_splitter_es_data;
+
+/// @brief Callback getting ES raw data, called from the thread pushing input.
+typedef void (*ts_splitter_output_callback)(void* context, const ts_splitter_es_data* data);
+
+/// @brief Callback getting log lines without line end, called from the thread pushing input.
+typedef void (*ts_splitter_log_callback)(void* context, const char* line);
+
+/// @brief Opaque splitter.
+typedef struct ts_splitter ts_splitter;
+
+/// @brief Create splitter with default options, see ts_splitter_set_options().
+/// @returns Splitter, NULL if out of memory.
+TS_SPLITTER_API ts_splitter* ts_splitter_create(void);
+
+/// @brief Destroy splitter, unfinished outputs are closed without reports.
+TS_SPLITTER_API void ts_splitter_destroy(ts_splitter* splitter);
+
+/// @brief Set options, should be called before input is pushed.
+/// @details Options are given as command line arguments without executable name, e.g. "-oa", "audio.es".
+///          If no ES output names are given and output callback is set, ES are passed to the callback only,
+///          otherwise they are written into default files as by ts_splitter executable. Options reading input
+///          by themselves: -i, --follow, --quick-probe, --perf-report, as well as -h and --cpu-features,
+///          are not supported.
+TS_SPLITTER_API int ts_splitter_set_options(ts_splitter* splitter, int argc, const char* const* argv);
+
+/// @brief Set callback getting ES raw data of all jobs, should be called before input is pushed.
+TS_SPLITTER_API int ts_splitter_set_output_callback(ts_splitter* splitter, ts_splitter_output_callback callback, void* context);
+
+/// @brief Set callback getting log lines, by default they are written into standard log.
+TS_SPLITTER_API int ts_splitter_set_log_callback(ts_splitter* splitter, ts_splitter_log_callback callback, void* context);
+
+/// @brief Split block of TS, blocks may be of any size and not aligned with TS packets.
+TS_SPLITTER_API int ts_splitter_push(ts_splitter* splitter, const uint8_t* data, size_t size);
+
+/// @brief Read and split TS from file descriptor till its end, the descriptor is not closed.
+TS_SPLITTER_API int ts_splitter_attach_fd(ts_splitter* splitter, int fd);
+
+/// @brief Check if no more input is needed, as all jobs passed the end of their time ranges.
+TS_SPLITTER_API int ts_splitter_done(const ts_splitter* splitter);
+
+/// @brief Complete splitting: flush and close outputs, write index, manifest and reports, verify outputs.
+/// @details No input can be pushed after that.
+TS_SPLITTER_API int ts_splitter_finish(ts_splitter* splitter);
+
+/// @brief Get inventory and verification reports written by ts_splitter_finish(), empty string if none.
+/// @returns Text valid till the splitter is destroyed.
+TS_SPLITTER_API const char* ts_splitter_report(const ts_splitter* splitter);
+
+/// @brief Get description of the last error, empty string if the last call succeeded.
+/// @returns Text valid till the next call on the splitter.
+TS_SPLITTER_API const char* ts_splitter_last_error(const ts_splitter* splitter);
+
+#ifdef __cplusplus
+}
+#endif
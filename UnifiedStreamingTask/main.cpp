@@ -1,3 +1,4 @@
+#include "tracing.hpp"
 #include "ts_splitter.hpp"
 
 #include <cstdlib>
@@ -5,9 +6,15 @@
 
 int main(int argc, char** argv)
 {
-    TsSplitter splitter;
-    splitter.init(argc, argv);
-    const bool result = splitter.run();
+    bool result = false;
+    {
+        TsSplitter splitter;
+        splitter.init(argc, argv);
+        result = splitter.run();
+    }
+
+    // spans are written once all threads of splitter are finished
+    TRACE_DUMP();
 
     return result ? EXIT_SUCCESS : EXIT_FAILURE;
 }
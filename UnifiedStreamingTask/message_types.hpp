@@ -3,6 +3,9 @@
 #include <cstdint>
 
 
+/// @brief Value of absent PTS.
+const int64_t noTimestamp = -1;
+
 /// @struct TsPayload.
 /// @brief Paylod of TS packet.
 struct TsPayload
@@ -18,6 +21,21 @@ struct TsPayload
 
     /// @brief Flag for ES packet start.
     bool newEsPacket;
+
+    /// @brief Offset of TS packet within input.
+    uint64_t offset;
+
+    /// @brief PCR of TS packet in 27 MHz ticks, noTimestamp if absent.
+    int64_t pcr;
+
+    /// @brief Random access indicator of TS packet.
+    bool randomAccess;
+
+    /// @brief Set if TS packets of this PID were lost right before this one.
+    bool discontinuity;
+
+    /// @brief Time the TS packet is read at, in nanoseconds of LatencyHistogram::now().
+    uint64_t readTime;
 };
 
 /// @brief Type of raw data output.
@@ -35,12 +53,37 @@ struct EsRawData
     /// @brief Start of raw data.
     const uint8_t* data;
 
-    /// @brief Size of raw data.
-    uint16_t size;
+    /// @brief Size of raw data, up to a whole ES packet if PES packets are assembled.
+    uint32_t size;
 
     /// @brief Type of data.
     EsType type;
 
     /// @brief Stream number in the set of all streams of same type.
     uint16_t esNumber;
+
+    /// @brief Corresponding PID.
+    uint16_t pid;
+
+    /// @brief PTS of ES packet started with this data, noTimestamp if absent.
+    int64_t pts;
+
+    /// @brief Flag for ES packet start.
+    bool newEsPacket;
+
+    /// @brief Offset of TS packet carrying this data within input.
+    uint64_t tsOffset;
+
+    /// @brief DTS of ES packet started with this data, equals to PTS if absent.
+    int64_t dts;
+
+    /// @brief Random access indicator of TS packet carrying this data.
+    bool randomAccess;
+
+    /// @brief Set if data is an assembled ES packet with lost TS packets or wrong length.
+    bool broken;
+
+    /// @brief Time the TS packet carrying this data is read at, the first one of assembled ES packet,
+    ///        0 if unknown.
+    uint64_t readTime;
 };
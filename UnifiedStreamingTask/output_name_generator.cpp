@@ -1,5 +1,6 @@
 #include "output_name_generator.hpp"
 
+#include <iomanip>
 #include <sstream>
 
 
@@ -17,6 +18,24 @@ OutputNameGenerator::OutputNameGenerator(const std::string& nameExample)
         extension_ = nameExample.substr(pos + 1, nameExample.size() - pos - 1);
     }
 
+    // check if name template has segment pattern like '%05d' at the end of base name
+    const auto percent = baseName_.rfind('%');
+    if (percent != std::string::npos && baseName_.back() == 'd' &&
+        baseName_.find_first_not_of("0123456789", percent + 1) == baseName_.size() - 1)
+    {
+        const std::string width = baseName_.substr(percent + 1, baseName_.size() - percent - 2);
+        segmented_ = true;
+        segmentZeroPadded_ = !width.empty() && width[0] == '0';
+        segmentWidth_ = width.empty() ? 0 : std::stoi(width);
+
+        // separator like '_' belongs to segment number
+        baseName_.resize(percent);
+        const auto end = baseName_.find_last_not_of("_-.");
+        const auto separatorStart = end == std::string::npos ? 0 : end + 1;
+        segmentSeparator_ = baseName_.substr(separatorStart);
+        baseName_.resize(separatorStart);
+    }
+
     // check if name template requires first file name with number, i.e. ends with '_1'
     const auto size = baseName_.size();
     if (size > 2 &&
@@ -42,4 +61,26 @@ std::string OutputNameGenerator::name(uint16_t fileNumber) const
         buffer << '.' << extension_;
 
     return buffer.str();
+}
+
+std::string OutputNameGenerator::name(uint16_t fileNumber, uint32_t segmentNumber) const
+{
+    if (baseName_.empty() || !segmented_)
+        return name(fileNumber);
+
+    std::ostringstream buffer;
+
+    buffer << baseName_;
+    if (fileNumber != 1 || firstFileWithNumber_)
+        buffer << '_' << fileNumber;
+    buffer << segmentSeparator_ << std::setfill(segmentZeroPadded_ ? '0' : ' ') << std::setw(segmentWidth_) << segmentNumber;
+    if (!extension_.empty())
+        buffer << '.' << extension_;
+
+    return buffer.str();
+}
+
+bool OutputNameGenerator::segmented() const
+{
+    return segmented_;
 }
\ No newline at end of file
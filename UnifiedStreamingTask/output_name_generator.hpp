@@ -8,6 +8,9 @@
 /// @details File names are generated is the form "<example>_<seq.number>.<extension>".
 ///          First file will not has suffix "_1", if given example has no this suffix.
 ///          If given example is empty, generator is uninitialized and will always generate empty names.
+///          If base name of example ends with printf-like pattern "%d" or "%05d", e.g. "video_1_%05d.h264",
+///          generator is segmented: names of file segments are generated in the form
+///          "<example>_<seq.number>_<segment>.<extension>", and name of the whole file omits pattern.
 class OutputNameGenerator
 {
 public:
@@ -20,6 +23,15 @@ public:
     /// @returns File name.
     std::string name(uint16_t fileNumber) const;
 
+    /// @brief Generate name for file segment.
+    /// @param[in] fileNumber - File sequence number.
+    /// @param[in] segmentNumber - Segment sequence number.
+    /// @returns Segment file name, the same as file name if generator is not segmented.
+    std::string name(uint16_t fileNumber, uint32_t segmentNumber) const;
+
+    /// @brief Check if generator has segment pattern.
+    bool segmented() const;
+
 private:
     /// @brief Base name for all generated file names.
     std::string baseName_;
@@ -29,4 +41,16 @@ private:
 
     /// @brief If set, first file name has suffix "_1".
     bool firstFileWithNumber_ = false;
+
+    /// @brief If set, segment number is added to file names.
+    bool segmented_ = false;
+
+    /// @brief Separator between base name and segment number.
+    std::string segmentSeparator_;
+
+    /// @brief Width of segment number, 0 if not limited.
+    int segmentWidth_ = 0;
+
+    /// @brief If set, segment number is padded with zeros, otherwise with spaces.
+    bool segmentZeroPadded_ = false;
 };
\ No newline at end of file
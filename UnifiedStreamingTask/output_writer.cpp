@@ -1,21 +1,46 @@
+#include "crc32.hpp"
 #include "error.hpp"
 #include "output_writer.hpp"
+#include "timestamp.hpp"
+#include "tracing.hpp"
 
+#include <algorithm>
+#include <iomanip>
 #include <list>
 #include <sstream>
 
 
+namespace
+{
+    /// @brief Size of data collected for output before it's handed to file system, output closed by
+    ///        the limit of open files is reopened once this size is collected.
+    const size_t maxPendingSize = 64 * 1024;
+
+    /// @brief Read time of disabled deadline.
+    const uint64_t noDeadline = ~0ULL;
+}
+
+
 OutputWriter::OutputWriter(std::ostream& log,
                            const OutputNameGenerator& audioNameGenerator,
-                           const OutputNameGenerator& videoNameGenerator)
+                           const OutputNameGenerator& videoNameGenerator,
+                           const SegmentPolicy& segmentPolicy,
+                           size_t maxOpenFiles)
     : log_(log)
     , audioNameGenerator_(audioNameGenerator)
     , videoNameGenerator_(videoNameGenerator)
+    , segmentPolicy_(segmentPolicy)
+    , maxOpenFiles_(maxOpenFiles)
+    , nextFlush_(noDeadline)
+    , nextLatencyReport_(noDeadline)
 {
     if (!log_.good())
         throw Error(Error::CONSTRUCTION_ERROR, "OutputWriter, bad log output");
     if (audioNameGenerator_.name(0).empty() && videoNameGenerator_.name(0).empty())
         throw Error(Error::CONSTRUCTION_ERROR, "OutputWriter, both name generators are uninitialized");
+
+    if (audioNameGenerator_.segmented() || videoNameGenerator_.segmented())
+        opener_.reset(new AsyncFileOpener());
 }
 
 OutputWriter::~OutputWriter()
@@ -30,35 +55,170 @@ OutputWriter::~OutputWriter()
     }
 }
 
+void OutputWriter::setHashing(bool enabled)
+{
+    hashing_ = enabled;
+}
+
+void OutputWriter::setFlushInterval(uint64_t interval)
+{
+    flushInterval_ = interval;
+}
+
+void OutputWriter::setLatencyReport(uint64_t interval)
+{
+    latencyReportInterval_ = interval;
+    nextLatencyReport_ = interval ? LatencyHistogram::now() + interval : noDeadline;
+}
+
+const LatencyHistogram& OutputWriter::latency() const
+{
+    return latency_;
+}
+
 void OutputWriter::write(const EsRawData& rawData)
 {
+    // read times of data are the clock of deadlines, so no time is taken per write
+    checkDeadlines(rawData.readTime);
+
     auto& output = chooseOutput(rawData.type, rawData.esNumber);
-    if (!output.stream)
+    if (!output.stream && !output.evicted)
         return;
 
-    output.stream->write(reinterpret_cast<const char*>(rawData.data), rawData.size);
-    if (!output.stream->good())
-        throw Error(Error::CORRUPTED_OUTPUT, "OutputWriter, failed to write into file '" + output.file + "'");
+    if (output.segmentNames && rawData.newEsPacket && segmentEnds(output, rawData))
+    {
+        restoreOutput(output);
+        startSegment(output, rawData);
+    }
+    output.lastOffset = output.segmentBytes;
+    output.segmentBytes += rawData.size;
+
+    // data is hashed while it's hot in cache, instead of reading output file again
+    auto& file = files_[output.fileIndex];
+    file.size += rawData.size;
+    if (hashing_)
+        file.crc32c = crc32c(rawData.data, rawData.size, file.crc32c);
+
+    if (!output.unflushedSince && rawData.readTime && (flushInterval_ || latencyReportInterval_))
+    {
+        output.unflushedSince = rawData.readTime;
+        if (flushInterval_)
+            nextFlush_ = std::min(nextFlush_, rawData.readTime + flushInterval_);
+    }
+
+    if (maxOpenFiles_ && !output.evicted)
+        openOutputs_.splice(openOutputs_.begin(), openOutputs_, output.openPosition);
+
+    // data is handed to file system in large blocks by flushes only, so every hand-off is sampled,
+    // data of closed output is collected in the same way till it's worth reopening the file
+    if (output.pending.size() + rawData.size < maxPendingSize)
+    {
+        output.pending.insert(output.pending.end(), rawData.data, rawData.data + rawData.size);
+        return;
+    }
+    flushOutput(output, rawData.data, rawData.size);
+}
+
+void OutputWriter::checkDeadlines(uint64_t time)
+{
+    if (time >= nextFlush_)
+        flushExpiredOutputs(time);
+    if (time >= nextLatencyReport_)
+        reportLatency(time);
+}
+
+bool OutputWriter::lastPosition(EsType type, uint16_t number, Position& position) const
+{
+    const auto& outputs = type == EsType::AUDIO ? audioOutputs_ : videoOutputs_;
+    const auto it = outputs.find(number);
+    if (type == EsType::OTHER || it == outputs.end() || it->second.file.empty())
+        return false;
+
+    position.segment = it->second.segment;
+    position.offset = it->second.lastOffset;
+    return true;
+}
+
+void OutputWriter::flushOutputs()
+{
+    TRACE_SPAN("flush outputs");
+    for (auto& pair : audioOutputs_)
+        flushOutput(pair.second);
+    for (auto& pair : videoOutputs_)
+        flushOutput(pair.second);
 }
 
 void OutputWriter::closeOutputs()
 {
     // to collect names of failed files
     std::list<std::string> failedFiles;
-    auto closeOutput = [&failedFiles](Output& output)
+    auto closeOutput = [this, &failedFiles](Output& output)
     {
+        try
+        {
+            restoreOutput(output);
+            flushOutput(output);
+        }
+        catch (const Error&)
+        {
+            failedFiles.push_back(output.file);
+            output.evicted = false;
+            if (output.stream)
+            {
+                openOutputs_.erase(output.openPosition);
+                output.stream.reset();
+            }
+            return;
+        }
         if (!output.stream)
             return;
+        openOutputs_.erase(output.openPosition);
+        if (output.segmentNames)
+        {
+            opener_->close(output.file, std::move(output.stream), output.segmentBytes);
+            return;
+        }
         output.stream->close();
         if (!output.stream->good())
             failedFiles.push_back(output.file);
         output.stream.reset();
     };
 
-    for (auto& pair : audioOutputs_)
-        closeOutput(pair.second);
-    for (auto& pair : videoOutputs_)
-        closeOutput(pair.second);
+    // open outputs are closed first, so closed ones are reopened without closing others
+    for (bool evicted : { false, true })
+    {
+        for (auto& pair : audioOutputs_)
+        {
+            if (pair.second.evicted == evicted)
+                closeOutput(pair.second);
+        }
+        for (auto& pair : videoOutputs_)
+        {
+            if (pair.second.evicted == evicted)
+                closeOutput(pair.second);
+        }
+    }
+    openOutputs_.clear();
+
+    if (latencyReportInterval_ && latency_.count() && !latencyReported_)
+    {
+        log_ << "Notice: OutputWriter, latency of outputs: ";
+        latency_.writeSummary(log_);
+        log_ << std::endl;
+        latencyReported_ = true;
+    }
+
+    if (maxOpenFiles_ && statistics_.opens)
+    {
+        log_ << "Notice: OutputWriter, " << statistics_.opens << " files opened, " << statistics_.reopens
+             << " reopened with limit of " << maxOpenFiles_ << " open files" << std::endl;
+    }
+
+    if (opener_)
+    {
+        opener_->finish();
+        logClosedSegments();
+    }
 
     if (!failedFiles.empty())
     {
@@ -74,11 +234,27 @@ void OutputWriter::closeOutputs()
     }
 }
 
-OutputWriter::Output& OutputWriter::chooseOutput(EsType type, uint16_t number)
+OutputWriter::Statistics OutputWriter::statistics() const
+{
+    return statistics_;
+}
+
+const std::vector<OutputWriter::File>& OutputWriter::files() const
 {
-    // dummy output for non-audio and non-video ES
-    static Output dummyOutput{ "", nullptr };
+    return files_;
+}
 
+void OutputWriter::writeManifest(std::ostream& output, const std::vector<File>& files)
+{
+    for (const auto& file : files)
+    {
+        output << std::hex << std::setw(8) << std::setfill('0') << file.crc32c << std::dec << std::setfill(' ')
+               << ' ' << file.size << ' ' << file.name << '\n';
+    }
+}
+
+OutputWriter::Output& OutputWriter::chooseOutput(EsType type, uint16_t number)
+{
     std::map<uint16_t, Output>* outputs = nullptr;
     const OutputNameGenerator* generator = nullptr;
 
@@ -93,23 +269,203 @@ OutputWriter::Output& OutputWriter::chooseOutput(EsType type, uint16_t number)
         generator = &videoNameGenerator_;
     }
     else
-        return dummyOutput;
+        return dummyOutput_;
 
     // try insert new output
-    const auto insertionResult = outputs->insert(std::make_pair(number, Output{ generator->name(number), nullptr }));
+    const auto insertionResult = outputs->insert(std::make_pair(number, Output{ generator->name(number, 0), nullptr }));
     auto& output = insertionResult.first->second;
 
     // ES already detected or no output needed for this ES
     if (!insertionResult.second || output.file.empty())
         return insertionResult.first->second;
+    output.fileIndex = files_.size();
+    files_.push_back(File{ output.file, type, number, 0, 0 });
+
+    // segment files are opened in background, the next one is requested ahead unless open files are limited
+    if (generator->segmented())
+    {
+        output.segmentNames = generator;
+        output.type = type;
+        output.number = number;
+        output.segmentPts = noTimestamp;
+        addOpenOutput(output);
+        output.stream = opener_->take(output.file);
+        if (!maxOpenFiles_)
+            opener_->prepare(generator->name(number, 1), segmentPolicy_.size);
+        return output;
+    }
 
     // try to open new file for write
+    TRACE_SPAN("open file");
+    addOpenOutput(output);
     output.stream.reset(new std::ofstream(output.file, std::fstream::out | std::fstream::binary));
     if (!output.stream->good())
     {
         output.stream.reset();
+        openOutputs_.erase(output.openPosition);
         throw Error(Error::CORRUPTED_OUTPUT, "OutputWriter, failed to open file '" + output.file + "' for writing");
     }
 
     return output;
 }
+
+bool OutputWriter::segmentEnds(Output& output, const EsRawData& rawData)
+{
+    output.usesRandomAccess = output.usesRandomAccess || rawData.randomAccess;
+    if (output.segmentPts == noTimestamp)
+        output.segmentPts = rawData.pts;
+    if (!output.segmentBytes)
+        return false;
+
+    const bool bySize = segmentPolicy_.size && output.segmentBytes >= segmentPolicy_.size;
+    const bool byDuration = segmentPolicy_.duration && rawData.pts != noTimestamp && output.segmentPts != noTimestamp &&
+                            ptsDelta(output.segmentPts, rawData.pts) >= segmentPolicy_.duration;
+    if (!bySize && !byDuration)
+        return false;
+
+    if (!segmentPolicy_.atKeyframes || rawData.type != EsType::VIDEO)
+        return true;
+
+    // without random access indicator keyframes are unknown, so segment starts at any PES packet
+    if (!output.usesRandomAccess && !randomAccessWarned_)
+    {
+        log_ << "Warning: OutputWriter, no random access indicator in '" << output.file
+             << "', segments may start not at keyframes" << std::endl;
+        randomAccessWarned_ = true;
+    }
+    return rawData.randomAccess || !output.usesRandomAccess;
+}
+
+void OutputWriter::startSegment(Output& output, const EsRawData& rawData)
+{
+    TRACE_SPAN("start segment");
+    // the next segment is likely of the same size as current one
+    const uint64_t preallocation = output.segmentBytes;
+    flushOutput(output);
+    opener_->close(output.file, std::move(output.stream), output.segmentBytes);
+
+    ++output.segment;
+    output.file = output.segmentNames->name(output.number, output.segment);
+    output.fileIndex = files_.size();
+    files_.push_back(File{ output.file, output.type, output.number, 0, 0 });
+    output.stream = opener_->take(output.file);
+    ++statistics_.opens;
+    if (!maxOpenFiles_)
+        opener_->prepare(output.segmentNames->name(output.number, output.segment + 1), preallocation);
+
+    output.segmentBytes = 0;
+    output.segmentPts = rawData.pts;
+
+    logClosedSegments();
+}
+
+void OutputWriter::addOpenOutput(Output& output)
+{
+    if (maxOpenFiles_ && openOutputs_.size() >= maxOpenFiles_)
+        evictOutput(*openOutputs_.back());
+
+    openOutputs_.push_front(&output);
+    output.openPosition = openOutputs_.begin();
+    output.evicted = false;
+    ++statistics_.opens;
+    statistics_.maxOpenFiles = std::max(statistics_.maxOpenFiles, openOutputs_.size());
+}
+
+void OutputWriter::evictOutput(Output& output)
+{
+    TRACE_SPAN("close evicted file");
+    // preallocated space of segment is kept till segment is complete
+    flushOutput(output);
+    output.stream->close();
+    if (!output.stream->good())
+        throw Error(Error::CORRUPTED_OUTPUT, "OutputWriter, failed to close file '" + output.file + "'");
+    output.stream.reset();
+    openOutputs_.erase(output.openPosition);
+    output.evicted = true;
+    ++statistics_.evictions;
+}
+
+void OutputWriter::flushOutput(Output& output, const uint8_t* data, size_t size)
+{
+    if (output.evicted && output.pending.empty() && !size)
+        return;
+    restoreOutput(output);
+    if (!output.stream)
+        return;
+
+    output.stream->write(reinterpret_cast<const char*>(output.pending.data()), output.pending.size());
+    output.stream->write(reinterpret_cast<const char*>(data), size);
+    if (!output.stream->good())
+        throw Error(Error::CORRUPTED_OUTPUT, "OutputWriter, failed to write into file '" + output.file + "'");
+    output.pending.clear();
+
+    // stream buffer is empty after flush, so it doesn't write any data on its own
+    if (!output.stream->flush().good())
+        throw Error(Error::CORRUPTED_OUTPUT, "OutputWriter, failed to flush file '" + output.file + "'");
+    recordLatency(output);
+}
+
+void OutputWriter::flushExpiredOutputs(uint64_t time)
+{
+    TRACE_SPAN("flush expired outputs");
+    nextFlush_ = noDeadline;
+    for (auto* outputs : { &audioOutputs_, &videoOutputs_ })
+    {
+        for (auto& pair : *outputs)
+        {
+            Output& output = pair.second;
+            if (!output.unflushedSince)
+                continue;
+            if (output.unflushedSince + flushInterval_ <= time)
+                flushOutput(output);
+            else
+                nextFlush_ = std::min(nextFlush_, output.unflushedSince + flushInterval_);
+        }
+    }
+}
+
+void OutputWriter::recordLatency(Output& output)
+{
+    if (!output.unflushedSince)
+        return;
+
+    const uint64_t now = LatencyHistogram::now();
+    const uint64_t latency = now > output.unflushedSince ? now - output.unflushedSince : 0;
+    latency_.record(latency);
+    latencyWindow_.record(latency);
+    output.unflushedSince = 0;
+}
+
+void OutputWriter::reportLatency(uint64_t time)
+{
+    log_ << "Notice: OutputWriter, latency of outputs for the last " << latencyReportInterval_ / 1000000 << " ms: ";
+    latencyWindow_.writeSummary(log_);
+    log_ << std::endl;
+    latencyWindow_.reset();
+    nextLatencyReport_ = time + latencyReportInterval_;
+}
+
+void OutputWriter::restoreOutput(Output& output)
+{
+    if (!output.evicted)
+        return;
+
+    TRACE_SPAN("reopen file");
+    addOpenOutput(output);
+    --statistics_.opens;
+    ++statistics_.reopens;
+    output.stream.reset(new std::ofstream(output.file, std::fstream::out | std::fstream::binary | std::fstream::app));
+    if (!output.stream->good())
+    {
+        output.stream.reset();
+        openOutputs_.erase(output.openPosition);
+        output.evicted = true;
+        throw Error(Error::CORRUPTED_OUTPUT, "OutputWriter, failed to reopen file '" + output.file + "'");
+    }
+}
+
+void OutputWriter::logClosedSegments()
+{
+    for (const auto& file : opener_->closedFiles())
+        log_ << "Notice: OutputWriter, segment '" << file << "' is complete" << std::endl;
+}
@@ -1,39 +1,170 @@
 #pragma once
 
+#include "async_file_opener.hpp"
+#include "latency_histogram.hpp"
 #include "message_types.hpp"
 #include "output_name_generator.hpp"
 
 #include <fstream>
+#include <list>
 #include <map>
 #include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
 
 
+/// @brief Rules of splitting outputs into segments.
+/// @details Segments start at PES packets only, so their concatenation is the whole output.
+struct SegmentPolicy
+{
+    /// @brief Segment ends once it's at least this size in bytes, 0 if not limited.
+    uint64_t size = 0;
+
+    /// @brief Segment ends once its PTS duration reaches this value in 90 kHz ticks, 0 if not limited.
+    int64_t duration = 0;
+
+    /// @brief If set, video segments start at PES packets with random access indicator only.
+    bool atKeyframes = false;
+};
+
 /// @class OutputWriter.
 /// @brief Write ES raw data into files.
+/// @details If name generator is segmented, outputs are split into segments according to segment policy.
+///          Segment files are opened ahead and closed in background, every complete segment is logged.
+///          Data of every output is collected in memory and handed to file system in large blocks,
+///          each followed by stream flush. Number of open output files may be limited, then least
+///          recently written output is closed to open another one. Data of closed output is collected
+///          the same way, the file is reopened in append mode once enough data is collected, or when
+///          outputs are flushed or closed. Latency from reading of TS packet till its data is handed
+///          to file system may be measured at every hand-off, and every output may be flushed once
+///          its oldest collected data is older than an interval.
 class OutputWriter
 {
 public:
+    /// @brief Statistics of output files.
+    struct Statistics
+    {
+        /// @brief Number of opened output files, including segments.
+        uint64_t opens = 0;
+
+        /// @brief Number of output files reopened after being closed by the limit.
+        uint64_t reopens = 0;
+
+        /// @brief Number of output files closed by the limit.
+        uint64_t evictions = 0;
+
+        /// @brief Maximum number of simultaneously open output files.
+        size_t maxOpenFiles = 0;
+    };
+
+    /// @brief Output file information.
+    struct File
+    {
+        /// @brief File name.
+        std::string name;
+
+        /// @brief Type of ES written into the file.
+        EsType type;
+
+        /// @brief Sequence number of ES.
+        uint16_t number;
+
+        /// @brief Number of bytes written into the file.
+        uint64_t size;
+
+        /// @brief CRC-32C of the file content, 0 unless hashing is enabled.
+        uint32_t crc32c;
+    };
+
+    /// @brief Position of ES data in output files.
+    struct Position
+    {
+        /// @brief Sequence number of segment file, 0 if output is not segmented.
+        uint32_t segment;
+
+        /// @brief Offset within the file.
+        uint64_t offset;
+    };
+
     /// @brief Constructor.
     /// @param[out] log - Stream for log messages.
     /// @param[in] audioNameGenerator - Generator for audio output file names.
     /// @param[in] videoNameGenerator - Generator for video output file names.
+    /// @param[in] segmentPolicy - Rules of splitting outputs of segmented name generators.
+    /// @param[in] maxOpenFiles - Maximum number of open output files, 0 if not limited. If limited,
+    ///                           segment files are not opened ahead.
     /// @throws Error.
     OutputWriter(std::ostream& log,
                  const OutputNameGenerator& audioNameGenerator,
-                 const OutputNameGenerator& videoNameGenerator);
+                 const OutputNameGenerator& videoNameGenerator,
+                 const SegmentPolicy& segmentPolicy = SegmentPolicy(),
+                 size_t maxOpenFiles = 0);
 
     /// @brief Desctructor.
     ~OutputWriter();
 
+    /// @brief Enable hashing of output files, disabled by default.
+    /// @details CRC-32C of every file is calculated while its data is written, see files().
+    /// @param[in] enabled - If set, output files are hashed.
+    void setHashing(bool enabled);
+
+    /// @brief Set interval to flush every output at least once per, disabled by default.
+    /// @details Output is flushed by the first write or check of deadlines after its oldest unflushed
+    ///          data is older than the interval, so batching is traded for latency.
+    /// @param[in] interval - Interval in nanoseconds, 0 to flush by stream buffers only.
+    void setFlushInterval(uint64_t interval);
+
+    /// @brief Set interval of logging latency percentiles, disabled by default.
+    /// @details Latency is sampled whenever output data is handed to file system, i.e. written into
+    ///          file by operating system call, not synchronized with disk, as time since read of its
+    ///          oldest TS packet. Percentiles of the last interval are logged
+    ///          periodically, percentiles of all samples are logged when outputs are closed.
+    /// @param[in] interval - Interval in nanoseconds, 0 not to log latency.
+    void setLatencyReport(uint64_t interval);
+
+    /// @brief Get latencies of all hand-offs, sampled if flush interval or latency report is set.
+    const LatencyHistogram& latency() const;
+
     /// @brief Write raw data.
     /// @param[in] rawData - ES raw data.
     /// @throws Error in case of corrupted output streams.
     void write(const EsRawData& rawData);
 
+    /// @brief Flush outputs with data older than flush interval and log latency percentiles if
+    ///        their interval has passed.
+    /// @details write() checks deadlines by read times of raw data, this method is for checks by
+    ///          wall clock, so data of ES without new raw data doesn't wait for it.
+    /// @param[in] time - Current time in nanoseconds of LatencyHistogram::now().
+    /// @throws Error in case of corrupted output streams.
+    void checkDeadlines(uint64_t time);
+
+    /// @brief Get position of the last raw data written into ES output.
+    /// @param[in] type - Type of ES.
+    /// @param[in] number - Sequence number of ES.
+    /// @param[out] position - Segment and offset the data starts at.
+    /// @returns false if ES has no output.
+    bool lastPosition(EsType type, uint16_t number, Position& position) const;
+
+    /// @brief Flush buffered data of output streams into files.
+    /// @throws Error in case of corrupted output streams.
+    void flushOutputs();
+
     /// @brief Close output streams.
     /// @throws Error in case of corrupted output streams.
     void closeOutputs();
 
+    /// @brief Get statistics of output files.
+    Statistics statistics() const;
+
+    /// @brief Get all output files in the order they are opened, including segments.
+    const std::vector<File>& files() const;
+
+    /// @brief Write manifest of output files, one line with hexadecimal CRC-32C, size and name per file.
+    /// @param[out] output - Stream for the manifest.
+    /// @param[in] files - Output files, see files().
+    static void writeManifest(std::ostream& output, const std::vector<File>& files);
+
 private:
     /// @brief Output for every ES.
     struct Output
@@ -43,6 +174,45 @@ private:
 
         /// @brief Output file stream.
         std::unique_ptr<std::ofstream> stream;
+
+        /// @brief Generator of segment names, nullptr if output is not segmented.
+        const OutputNameGenerator* segmentNames;
+
+        /// @brief Type of ES, set for segmented output only.
+        EsType type;
+
+        /// @brief Sequence number of ES.
+        uint16_t number;
+
+        /// @brief Index of current output file in the list of all files.
+        size_t fileIndex;
+
+        /// @brief Sequence number of current segment.
+        uint32_t segment;
+
+        /// @brief Number of bytes written into current segment.
+        uint64_t segmentBytes;
+
+        /// @brief Offset of the last written data within current file.
+        uint64_t lastOffset;
+
+        /// @brief The first PTS of current segment.
+        int64_t segmentPts;
+
+        /// @brief Set if ES signals keyframes with random access indicator.
+        bool usesRandomAccess;
+
+        /// @brief Set if file is closed by the limit of open files.
+        bool evicted;
+
+        /// @brief Data not yet handed to file system, also written while file is closed by the limit.
+        std::vector<uint8_t> pending;
+
+        /// @brief Position in the list of open outputs.
+        std::list<Output*>::iterator openPosition;
+
+        /// @brief Read time of the oldest data not handed to file system, 0 if none or not tracked.
+        uint64_t unflushedSince;
     };
 
     /// @brief Choose or open output stream for ES.
@@ -51,6 +221,54 @@ private:
     /// @throws Error if fails to open file stream.
     Output& chooseOutput(EsType type, uint16_t number);
 
+    /// @brief Check if current segment ends before raw data starting new PES packet.
+    /// @param[in] output - Segmented output.
+    /// @param[in] rawData - ES raw data.
+    bool segmentEnds(Output& output, const EsRawData& rawData);
+
+    /// @brief Hand current segment over for closing and start the next one.
+    /// @param[in] output - Segmented output.
+    /// @param[in] rawData - ES raw data starting the segment.
+    /// @throws Error if fails to open or close segment file.
+    void startSegment(Output& output, const EsRawData& rawData);
+
+    /// @brief Register newly opened output file, the least recently written one is closed if
+    ///        the limit of open files is reached.
+    /// @throws Error if fails to close output file.
+    void addOpenOutput(Output& output);
+
+    /// @brief Close output file by the limit of open files.
+    /// @throws Error if fails to close output file.
+    void evictOutput(Output& output);
+
+    /// @brief Hand collected data and given data over to file system and flush output, reopen it
+    ///        if it's closed by the limit and has data.
+    /// @param[in] output - Output.
+    /// @param[in] data - Data written after collected one.
+    /// @param[in] size - Size of data.
+    /// @throws Error if fails to open, write or flush output file.
+    void flushOutput(Output& output, const uint8_t* data = nullptr, size_t size = 0);
+
+    /// @brief Flush outputs with data older than flush interval, set deadline of the next flush.
+    /// @param[in] time - Current read time.
+    /// @throws Error if fails to flush output file.
+    void flushExpiredOutputs(uint64_t time);
+
+    /// @brief Sample latency of output data handed to file system.
+    void recordLatency(Output& output);
+
+    /// @brief Log latency percentiles of the last interval.
+    /// @param[in] time - Current read time.
+    void reportLatency(uint64_t time);
+
+    /// @brief Reopen output file closed by the limit.
+    /// @throws Error if fails to open output file.
+    void restoreOutput(Output& output);
+
+    /// @brief Log segments closed in background.
+    /// @throws Error if failed to close some segment file.
+    void logClosedSegments();
+
 private:
     /// @brief Log output stream.
     std::ostream& log_;
@@ -61,9 +279,57 @@ private:
     /// @brief Generator for video output file names.
     const OutputNameGenerator& videoNameGenerator_;
 
+    /// @brief Dummy output for non-audio and non-video ES.
+    Output dummyOutput_{ "", nullptr };
+
     /// @brief Outputs for detected audio ES.
     std::map<uint16_t, Output> audioOutputs_;
 
     /// @brief Outputs for detected video ES.
     std::map<uint16_t, Output> videoOutputs_;
+
+    /// @brief Rules of splitting outputs into segments.
+    SegmentPolicy segmentPolicy_;
+
+    /// @brief Background opener of segment files, nullptr if outputs are not segmented.
+    std::unique_ptr<AsyncFileOpener> opener_;
+
+    /// @brief Set if missing random access indicator in video ES is already reported.
+    bool randomAccessWarned_ = false;
+
+    /// @brief Maximum number of open output files, 0 if not limited.
+    const size_t maxOpenFiles_;
+
+    /// @brief Open outputs, the most recently written one first.
+    std::list<Output*> openOutputs_;
+
+    /// @brief Statistics of output files.
+    Statistics statistics_;
+
+    /// @brief All opened output files.
+    std::vector<File> files_;
+
+    /// @brief Set if output files are hashed.
+    bool hashing_ = false;
+
+    /// @brief Interval to flush every output at least once per, 0 if disabled.
+    uint64_t flushInterval_ = 0;
+
+    /// @brief Read time to flush expired outputs at.
+    uint64_t nextFlush_;
+
+    /// @brief Interval of logging latency percentiles, 0 if disabled.
+    uint64_t latencyReportInterval_ = 0;
+
+    /// @brief Read time to log latency percentiles at.
+    uint64_t nextLatencyReport_;
+
+    /// @brief Latencies of all hand-offs.
+    LatencyHistogram latency_;
+
+    /// @brief Latencies of hand-offs since the last report.
+    LatencyHistogram latencyWindow_;
+
+    /// @brief Set if latencies of all hand-offs are logged.
+    bool latencyReported_ = false;
 };
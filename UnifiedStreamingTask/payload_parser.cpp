@@ -1,5 +1,13 @@
+#include "crc32.hpp"
 #include "error.hpp"
 #include "payload_parser.hpp"
+#include "timestamp.hpp"
+#include "tracing.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <string>
 
 
 namespace
@@ -7,9 +15,15 @@ namespace
     /// @brief Minimum size of PES header.
     const uint16_t minPesHeaderSize = 6;
 
+    /// @brief Initial capacity of buffers of assembled PES packets.
+    const size_t minPesBufferSize = 4096;
+
     /// @brief Program association table pid.
     const uint16_t paTablePid = 0;
 
+    /// @brief Null packets pid, also used as PCR pid of programs without PCR.
+    const uint16_t nullPacketPid = 8191;
+
     /// @brief PAT id.
     const uint8_t paTableId = 0;
 
@@ -19,6 +33,9 @@ namespace
     /// @brief Program map table id.
     const uint8_t pmTableId = 2;
 
+    /// @brief PIDs below this one are reserved for PSI tables.
+    const uint16_t minStreamPid = 0x10;
+
     /// @brief Table name by id.
     const std::string& tableName(uint8_t id)
     {
@@ -40,9 +57,9 @@ namespace
     EsType streamTypeByPmt(uint8_t typeId)
     {
         // According https://en.wikipedia.org/wiki/Program-specific_information#Elementary_stream_types
-        static std::set<uint8_t> audioStreams{ 0x03, 0x04, 0x0F, 0x11, 0x1C, 0x80, 0x81, 0x82, 0x83,
+        static const std::set<uint8_t> audioStreams{ 0x03, 0x04, 0x0F, 0x11, 0x1C, 0x80, 0x81, 0x82, 0x83,
                                                0x84, 0x85, 0x86, 0x87, 0x91, 0xC1, 0xC2, 0xCF };
-        static std::set<uint8_t> videoStreams{ 0x01, 0x02, 0x10, 0x1B, 0x24, 0x42, 0xD1, 0xDB, 0xEA };
+        static const std::set<uint8_t> videoStreams{ 0x01, 0x02, 0x10, 0x1B, 0x24, 0x42, 0xD1, 0xDB, 0xEA };
 
         if (audioStreams.count(typeId))
             return EsType::AUDIO;
@@ -51,6 +68,72 @@ namespace
         return EsType::OTHER;
     }
 
+    /// @brief Information from ES info descriptors of PMT.
+    struct EsDescriptors
+    {
+        /// @brief Lowercase ISO 639 language code, empty if absent.
+        std::string language;
+
+        /// @brief Audio type from ISO 639 language descriptor.
+        uint8_t audioType = 0;
+
+        /// @brief Audio codec signalled by descriptors, empty if none.
+        std::string codec;
+    };
+
+    /// @brief Parse ES info descriptors of PMT.
+    /// @param[in] data - Start of descriptors.
+    /// @param[in] size - Size of descriptors.
+    EsDescriptors parseEsDescriptors(const uint8_t* data, size_t size)
+    {
+        // registration descriptor format identifiers of audio codecs
+        static const std::map<std::string, std::string> registeredCodecs{
+            { "AC-3", "AC-3" }, { "EAC3", "E-AC-3" }, { "DTS1", "DTS" }, { "DTS2", "DTS" }, { "DTS3", "DTS" }, { "Opus", "Opus" } };
+
+        EsDescriptors result;
+        for (size_t i = 0; i + 2 <= size && i + 2 + data[i + 1] <= size; i += 2 + data[i + 1])
+        {
+            const uint8_t tag = data[i];
+            const uint8_t length = data[i + 1];
+            const uint8_t* body = data + i + 2;
+
+            switch (tag)
+            {
+            case 0x05: // registration descriptor
+                if (length >= 4)
+                {
+                    const auto it = registeredCodecs.find(std::string(reinterpret_cast<const char*>(body), 4));
+                    if (it != registeredCodecs.end())
+                        result.codec = it->second;
+                }
+                break;
+            case 0x0A: // ISO 639 language descriptor, only the first language is used
+                if (length >= 4)
+                {
+                    result.language.clear();
+                    for (int j = 0; j < 3; ++j)
+                        result.language += static_cast<char>(std::tolower(body[j]));
+                    result.audioType = body[3];
+                }
+                break;
+            case 0x6A: // DVB AC-3 descriptor
+            case 0x81: // ATSC AC-3 audio descriptor
+                result.codec = "AC-3";
+                break;
+            case 0x7A: // DVB enhanced AC-3 descriptor
+                result.codec = "E-AC-3";
+                break;
+            case 0x7B: // DVB DTS descriptor
+                result.codec = "DTS";
+                break;
+            case 0x7C: // DVB AAC descriptor
+                result.codec = "AAC";
+                break;
+            }
+        }
+        return result;
+    }
+
     /// @brief ES type by stream id from PES header.
     EsType streamTypeByPes(uint8_t streamId)
     {
@@ -69,23 +152,6 @@ namespace
                payload.data[1] == 0x00 &&
                payload.data[2] == 0x01;
     }
-
-    /// @brief Calculate CRC-32/MPEG-2.
-    uint32_t crc32(const uint8_t* data, size_t size)
-    {
-        const uint8_t* const end = data + size;
-        uint32_t result = 0xFFFFFFFFu;
-        while (data != end)
-        {
-            result ^= uint32_t(*data++) << 24;
-            for (int i = 0; i < 8; ++i)
-            {
-                const auto xorArg = ((result & 0x80000000u) >> 31) * 0x04C11DB7u;
-                result = (result << 1) ^ xorArg;
-            }
-        }
-        return result;
-    }
 }
 
 PayloadParser::PayloadParser(std::ostream& log, OnEsRawData handler)
@@ -98,67 +164,217 @@ PayloadParser::PayloadParser(std::ostream& log, OnEsRawData handler)
         throw Error(Error::CONSTRUCTION_ERROR, "PayloadParser, empty handler");
 }
 
+void PayloadParser::setTableHandler(OnTable handler)
+{
+    tableHandler_ = handler;
+}
+
+void PayloadParser::setPesAssembly(PesAssembly mode)
+{
+    pesAssembly_ = mode;
+}
+
+void PayloadParser::setValidation(Validation validation)
+{
+    validation_ = validation;
+}
+
 void PayloadParser::parse(const TsPayload& payload)
+{
+    // policy is chosen once per payload, so checks are resolved at compile time
+    switch (validation_)
+    {
+    case Validation::TRUSTED:
+        parseWith<TrustedValidation>(payload);
+        break;
+    case Validation::PARANOID:
+        parseWith<ParanoidValidation>(payload);
+        break;
+    default:
+        parseWith<DefaultValidation>(payload);
+        break;
+    }
+}
+
+void PayloadParser::flush()
+{
+    switch (validation_)
+    {
+    case Validation::TRUSTED:
+        flushWith<TrustedValidation>();
+        break;
+    case Validation::PARANOID:
+        flushWith<ParanoidValidation>();
+        break;
+    default:
+        flushWith<DefaultValidation>();
+        break;
+    }
+}
+
+const std::map<uint16_t, PayloadParser::StreamInfo>& PayloadParser::streams() const
+{
+    return streams_;
+}
+
+const std::map<uint16_t, PayloadParser::ProgramInfo>& PayloadParser::programs() const
+{
+    return programs_;
+}
+
+bool PayloadParser::psiComplete() const
+{
+    if (!patDetected_)
+        return false;
+    for (const auto& pair : programs_)
+    {
+        // program 0 refers to network information table
+        if (pair.first && !pair.second.pmtDetected)
+            return false;
+    }
+    return true;
+}
+
+const PayloadParser::Statistics& PayloadParser::statistics() const
+{
+    return statistics_;
+}
+
+template <typename Policy>
+void PayloadParser::parseWith(const TsPayload& payload)
 {
     if (payload.pid == paTablePid)
-        parsePat(payload);
+        parsePat<Policy>(payload);
     else if (pmTablePids_.count(payload.pid))
-        parsePmt(payload);
+        parsePmt<Policy>(payload);
     else
-        parseDataPayload(payload);
+        parseDataPayload<Policy>(payload);
+}
+
+template <typename Policy>
+void PayloadParser::flushWith()
+{
+    for (auto& pair : pesBuffers_)
+    {
+        if (pair.second.open)
+            passPes<Policy>(pair.first);
+    }
 }
 
+template <typename Policy>
 void PayloadParser::parsePat(const TsPayload& payload)
 {
+    TRACE_SPAN("parse PAT");
     uint16_t offset = 0, sectionSize = 0;
-    if (!checkTablePayload(payload, paTableId, offset, sectionSize))
+    if (!checkTablePayload<Policy>(payload, paTableId, offset, sectionSize))
         return;
 
+    const uint8_t version = (payload.data[offset + 5] >> 1) & 0x1F;
+    const bool changed = !patDetected_ || patVersion_ != version;
+    patDetected_ = true;
+    patVersion_ = version;
+
     // section starts 4 bytes from payload start, 4 bytes for CRC
     for (auto i = offset + 8; i < sectionSize + 4 - 4; i += 4)
     {
         const uint16_t program = (payload.data[i] << 8) + payload.data[i + 1];
-        if (!detectedPrograms_.count(program))
+        const uint16_t pmtPid = ((payload.data[i + 2] & 0x1F) << 8) + payload.data[i + 3];
+        if (Policy::strict && program && !checkPsiPid(pmtPid, paTableId, 0))
+            continue;
+        if (!programs_.count(program))
         {
             log_ << "Notice: PayloadParser, detected program " << program << std::endl;
-            detectedPrograms_.insert(program);
+            programs_[program] = ProgramInfo{ pmtPid, false, 0, nullPacketPid };
             if (program)
-                pmTablePids_.insert(((payload.data[i + 2] & 0x1F) << 8) + payload.data[i + 3]);
+                pmTablePids_.insert(pmtPid);
         }
     }
+
+    // handler is called once programs are updated, so it may use them
+    if (changed && tableHandler_)
+    {
+        const uint16_t streamId = (payload.data[offset + 3] << 8) + payload.data[offset + 4];
+        tableHandler_(TableInfo{ paTableId, payload.pid, streamId, version, payload.offset });
+    }
 }
 
+template <typename Policy>
 void PayloadParser::parsePmt(const TsPayload& payload)
 {
+    TRACE_SPAN("parse PMT");
     uint16_t offset = 0, sectionSize = 0;
-    if (!checkTablePayload(payload, pmTableId, offset, sectionSize))
+    if (!checkTablePayload<Policy>(payload, pmTableId, offset, sectionSize))
         return;
 
+    const uint16_t program = (payload.data[offset + 3] << 8) + payload.data[offset + 4];
+    const uint8_t version = (payload.data[offset + 5] >> 1) & 0x1F;
+    auto& programInfo = programs_[program];
+    if (programInfo.pmtDetected && programInfo.pmtVersion != version)
+    {
+        log_ << "Notice: PayloadParser, PMT of program " << program << " changed to version " << int(version) << std::endl;
+        ++statistics_.pmtChanges;
+    }
+    const bool changed = !programInfo.pmtDetected || programInfo.pmtVersion != version;
+    programInfo.pmtPid = payload.pid;
+    programInfo.pmtDetected = true;
+    programInfo.pmtVersion = version;
+    programInfo.pcrPid = ((payload.data[offset + 8] & 0x1F) << 8) + payload.data[offset + 9];
+
     const uint16_t programInfoLength = ((payload.data[offset + 10] & 0x0F) << 8) + payload.data[offset + 11];
     auto i = offset + 12 + programInfoLength;
 
     // section starts 4 bytes from payload start, 4 bytes for CRC
-    while (i < sectionSize + 4 - 4)
+    while (i + 5 <= sectionSize + 4 - 4)
     {
-        const EsType type = streamTypeByPmt(payload.data[i]);
         const uint16_t pid = ((payload.data[i + 1] & 0x1F) << 8) + payload.data[i + 2];
-        updateStreams(pid, type);
-        i += 5 + ((payload.data[i + 3] & 0x0F) << 8) + payload.data[i + 4];
+        const uint16_t esInfoLength = ((payload.data[i + 3] & 0x0F) << 8) + payload.data[i + 4];
+        const size_t descriptorsSize = std::min<size_t>(esInfoLength, sectionSize + 4 - 4 - (i + 5));
+        if (Policy::strict && !checkPsiPid(pid, pmTableId, program))
+        {
+            i += 5 + esInfoLength;
+            continue;
+        }
+        const EsDescriptors descriptors = parseEsDescriptors(payload.data + i + 5, descriptorsSize);
+
+        // private data is audio if descriptors signal audio codec
+        EsType type = streamTypeByPmt(payload.data[i]);
+        if (type == EsType::OTHER && payload.data[i] == 0x06 && !descriptors.codec.empty())
+            type = EsType::AUDIO;
+
+        if (updateStreams(pid, type))
+        {
+            auto& streamInfo = streams_.at(pid);
+            streamInfo.program = program;
+            streamInfo.streamType = payload.data[i];
+            streamInfo.language = descriptors.language;
+            streamInfo.audioType = descriptors.audioType;
+            streamInfo.codec = descriptors.codec;
+        }
+        i += 5 + esInfoLength;
     }
+
+    // handler is called once streams are updated, so it may use them
+    if (changed && tableHandler_)
+        tableHandler_(TableInfo{ pmTableId, payload.pid, program, version, payload.offset });
 }
 
+template <typename Policy>
 bool PayloadParser::checkTablePayload(const TsPayload& payload, uint8_t tableId, uint16_t& offset, uint16_t& sectionSize)
 {
     // offset within payload
     offset = 1 + payload.data[0];
     if (payload.size < offset)
     {
-        log_ << "Warning: PayloadParser, corrupted " << tableName(tableId) << std::endl;
+        if (Policy::logging)
+            log_ << "Warning: PayloadParser, corrupted " << tableName(tableId) << std::endl;
+        ++statistics_.psiErrors;
         return false;
     }
     if (payload.data[offset] != tableId)
     {
-        log_ << "Warning: PayloadParser, " << tableName(tableId) << " has wrong table id" << std::endl;
+        if (Policy::logging)
+            log_ << "Warning: PayloadParser, " << tableName(tableId) << " has wrong table id" << std::endl;
+        ++statistics_.psiErrors;
         return false;
     }
 
@@ -166,17 +382,24 @@ bool PayloadParser::checkTablePayload(const TsPayload& payload, uint8_t tableId,
     sectionSize = ((payload.data[offset + 1] & 0x0F) << 8) + payload.data[offset + 2];
     if (payload.size < sectionSize + 4)
     {
-        log_ << "Warning: PayloadParser, corrupted " << tableName(tableId) << std::endl;
+        if (Policy::logging)
+            log_ << "Warning: PayloadParser, corrupted " << tableName(tableId) << std::endl;
+        ++statistics_.psiErrors;
         return false;
     }
 
-    // check CRC
-    const uint8_t* crcData = payload.data + 4 + sectionSize - 4;
-    const uint32_t crc = (((((uint32_t(crcData[0]) << 8) + crcData[1]) << 8) + crcData[2]) << 8) + crcData[3];
-    if (crc32(payload.data + 1, crcData - payload.data - 1) != crc)
+    // check CRC, trusted input is not checked
+    if (Policy::crc)
     {
-        log_ << "Warning: PayloadParser, corrupted " << tableName(tableId) << std::endl;
-        return false;
+        const uint8_t* crcData = payload.data + 4 + sectionSize - 4;
+        const uint32_t crc = (((((uint32_t(crcData[0]) << 8) + crcData[1]) << 8) + crcData[2]) << 8) + crcData[3];
+        if (crc32(payload.data + 1, crcData - payload.data - 1) != crc)
+        {
+            if (Policy::logging)
+                log_ << "Warning: PayloadParser, corrupted " << tableName(tableId) << std::endl;
+            ++statistics_.psiErrors;
+            return false;
+        }
     }
 
     // this table is not applicable
@@ -186,23 +409,41 @@ bool PayloadParser::checkTablePayload(const TsPayload& payload, uint8_t tableId,
     return true;
 }
 
+template <typename Policy>
 void PayloadParser::parseDataPayload(const TsPayload& payload)
 {
+    // PES packet being assembled is broken by lost packets or ends where next one starts
+    if (pesAssembly_ != PesAssembly::NONE)
+    {
+        auto buffer = pesBuffers_.find(payload.pid);
+        if (buffer != pesBuffers_.end() && buffer->second.open)
+        {
+            buffer->second.broken |= payload.discontinuity;
+            if (payload.newEsPacket)
+                passPes<Policy>(payload.pid);
+        }
+    }
+
     // check PES header only if payload has corresponding flag
     const bool isPesHeader = payload.newEsPacket && hasPesHeader(payload);
 
     // packet of unknown stream
     if (!isPesHeader && streams_.count(payload.pid) == 0)
     {
-        log_ << "Warning: PayloadParser, incomplete PES packet with pid " << payload.pid << std::endl;
+        if (Policy::logging)
+            log_ << "Warning: PayloadParser, incomplete PES packet with pid " << payload.pid << std::endl;
         return;
     }
 
     // parse header of new ES packet - check for new stream and raw data offset
     uint16_t offset = 0;
-    if (isPesHeader && !parseHeader(payload, offset))
+    int64_t pts = noTimestamp;
+    int64_t dts = noTimestamp;
+    if (isPesHeader && !parseHeader(payload, offset, pts, dts))
     {
-        log_ << "Warning: PayloadParser, failed to parse PES packet header" << std::endl;
+        if (Policy::logging)
+            log_ << "Warning: PayloadParser, failed to parse PES packet header" << std::endl;
+        ++statistics_.pesErrors;
         return;
     }
 
@@ -211,15 +452,145 @@ void PayloadParser::parseDataPayload(const TsPayload& payload)
     if (streamInfo.type == EsType::OTHER)
         return;
 
-    static EsRawData rawData;
+    EsRawData& rawData = rawData_;
     rawData.type = streamInfo.type;
     rawData.esNumber = streamInfo.seqNumber;
     rawData.data = payload.data + offset;
     rawData.size = payload.size - offset;
-    handler_(rawData);
+    rawData.pid = payload.pid;
+    rawData.pts = pts;
+    rawData.newEsPacket = isPesHeader;
+    rawData.tsOffset = payload.offset;
+    rawData.dts = dts;
+    rawData.randomAccess = payload.randomAccess;
+    rawData.broken = false;
+    rawData.readTime = payload.readTime;
+
+    if (Policy::strict)
+        checkPes(payload, rawData, offset);
+
+    if (pesAssembly_ == PesAssembly::NONE)
+        handler_(rawData);
+    else
+        assemblePes<Policy>(payload, rawData, offset);
+}
+
+template <typename Policy>
+void PayloadParser::assemblePes(const TsPayload& payload, const EsRawData& rawData, uint16_t headerSize)
+{
+    PesBuffer& buffer = pesBuffers_[payload.pid];
+    if (rawData.newEsPacket)
+    {
+        buffer.rawData = rawData;
+        buffer.data.clear();
+        buffer.open = true;
+
+        // PES packet length counts bytes following it
+        const size_t pesSize = (payload.data[4] << 8) + payload.data[5];
+        buffer.expectedSize = pesSize && pesSize + minPesHeaderSize > headerSize ? pesSize + minPesHeaderSize - headerSize : 0;
+        buffer.broken = pesSize && pesSize + minPesHeaderSize < headerSize;
+    }
+    // the rest of already passed or dropped PES packet
+    else if (!buffer.open)
+    {
+        return;
+    }
+
+    // buffer grows geometrically and is reused by next PES packets of the PID
+    const size_t size = buffer.data.size() + rawData.size;
+    if (size > buffer.data.capacity())
+        buffer.data.reserve(std::max(std::max(size, minPesBufferSize), 2 * buffer.data.capacity()));
+    buffer.data.insert(buffer.data.end(), rawData.data, rawData.data + rawData.size);
+
+    if (buffer.expectedSize && size >= buffer.expectedSize)
+        passPes<Policy>(payload.pid);
 }
 
-bool PayloadParser::parseHeader(const TsPayload& payload, uint16_t& offset)
+template <typename Policy>
+void PayloadParser::passPes(uint16_t pid)
+{
+    TRACE_SPAN("handle PES packet");
+    PesBuffer& buffer = pesBuffers_.at(pid);
+    buffer.open = false;
+
+    if (buffer.expectedSize && buffer.data.size() != buffer.expectedSize)
+        buffer.broken = true;
+    if (buffer.broken)
+    {
+        if (Policy::logging)
+            log_ << "Warning: PayloadParser, broken PES packet with pid " << pid << std::endl;
+        ++statistics_.brokenPes;
+        if (pesAssembly_ == PesAssembly::DROP)
+            return;
+    }
+
+    buffer.rawData.data = buffer.data.data();
+    buffer.rawData.size = static_cast<uint32_t>(buffer.data.size());
+    buffer.rawData.broken = buffer.broken;
+    handler_(buffer.rawData);
+}
+
+void PayloadParser::checkPes(const TsPayload& payload, const EsRawData& rawData, uint16_t headerSize)
+{
+    PesCheck& check = pesChecks_[payload.pid];
+
+    // lost packets make length of PES packet unknown
+    if (payload.discontinuity)
+        check.expectedSize = 0;
+
+    if (!rawData.newEsPacket)
+    {
+        check.size += rawData.size;
+        return;
+    }
+
+    // previous PES packet ends where this one starts
+    if (check.expectedSize && check.size != check.expectedSize)
+    {
+        log_ << "Warning: PayloadParser, PES packet with pid " << payload.pid << " has wrong length" << std::endl;
+        ++statistics_.pesErrors;
+    }
+
+    // PES packet length counts bytes following it
+    const size_t pesSize = (payload.data[4] << 8) + payload.data[5];
+    check.expectedSize = pesSize && pesSize + minPesHeaderSize > headerSize ? pesSize + minPesHeaderSize - headerSize : 0;
+    check.size = rawData.size;
+    if (pesSize && pesSize + minPesHeaderSize < headerSize)
+    {
+        log_ << "Warning: PayloadParser, PES packet with pid " << payload.pid << " has wrong length" << std::endl;
+        ++statistics_.pesErrors;
+    }
+
+    // DTS goes forward in decoding order, PTS is never earlier than DTS
+    if (rawData.dts == noTimestamp)
+        return;
+    if ((check.dts != noTimestamp && ptsDelta(check.dts, rawData.dts) < 0) || ptsDelta(rawData.dts, rawData.pts) < 0)
+    {
+        log_ << "Warning: PayloadParser, timestamps of PES packet with pid " << payload.pid << " go backwards" << std::endl;
+        ++statistics_.timestampErrors;
+    }
+    check.dts = rawData.dts;
+}
+
+bool PayloadParser::checkPsiPid(uint16_t pid, uint8_t tableId, uint16_t program)
+{
+    bool valid = pid >= minStreamPid && pid != nullPacketPid;
+    if (valid && tableId == pmTableId)
+    {
+        const auto stream = streams_.find(pid);
+        valid = !pmTablePids_.count(pid) &&
+                (stream == streams_.end() || !stream->second.program || stream->second.program == program);
+    }
+
+    if (!valid)
+    {
+        log_ << "Warning: PayloadParser, " << tableName(tableId) << " refers to wrong pid " << pid << std::endl;
+        ++statistics_.psiErrors;
+    }
+    return valid;
+}
+
+bool PayloadParser::parseHeader(const TsPayload& payload, uint16_t& offset, int64_t& pts, int64_t& dts)
 {
     // if there was no PAT and PMT - try to detect and update streams
     if (!updateStreams(payload.pid, streamTypeByPes(payload.data[3])))
@@ -232,7 +603,8 @@ bool PayloadParser::parseHeader(const TsPayload& payload, uint16_t& offset)
         return true;
     }
 
-    const bool isOptionalHeader = (payload.data[minPesHeaderSize + 1] & 0xC0) == 0x80;
+    // optional header starts with '10' marker bits
+    const bool isOptionalHeader = (payload.data[minPesHeaderSize] & 0xC0) == 0x80;
     if (!isOptionalHeader)
     {
         offset = minPesHeaderSize;
@@ -243,13 +615,26 @@ bool PayloadParser::parseHeader(const TsPayload& payload, uint16_t& offset)
     if (payload.size < minPesHeaderSize + 3)
         return false;
 
-    offset = minPesHeaderSize + 3 + payload.data[minPesHeaderSize + 2];
-    return payload.size >= offset;
+    const uint8_t headerLength = payload.data[minPesHeaderSize + 2];
+    offset = minPesHeaderSize + 3 + headerLength;
+    if (payload.size < offset)
+        return false;
+
+    // PTS_DTS_flags: '10' - only PTS, '11' - PTS and DTS, both should fit into optional header
+    const uint8_t timestampFlags = payload.data[minPesHeaderSize + 1] >> 6;
+    const uint8_t* timestamps = payload.data + minPesHeaderSize + 3;
+    if ((timestampFlags & 0x02) && headerLength >= 5)
+    {
+        pts = readTimestamp(timestamps);
+        dts = timestampFlags == 0x03 && headerLength >= 10 ? readTimestamp(timestamps + 5) : pts;
+    }
+
+    return true;
 }
 
 bool PayloadParser::updateStreams(uint16_t pid, EsType type)
 {
-    const auto insertionResult = streams_.insert({ pid, StreamInfo{type, 0} });
+    const auto insertionResult = streams_.insert({ pid, StreamInfo{type, 0, 0, 0} });
 
     // playload from some known stream
     if (!insertionResult.second)
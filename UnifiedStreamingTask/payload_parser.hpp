@@ -1,11 +1,14 @@
 #pragma once
 
 #include "message_types.hpp"
+#include "validation.hpp"
 
 #include <functional>
 #include <map>
 #include <ostream>
 #include <set>
+#include <string>
+#include <vector>
 
 
 /// @class PayloadParser.
@@ -16,32 +19,177 @@ public:
     /// @brief Type of raw data handler.
     using OnEsRawData = std::function<void(const EsRawData&)>;
 
+    /// @brief ES stream information.
+    struct StreamInfo
+    {
+        /// @brief Type of ES stream.
+        EsType type;
+
+        /// @brief Stream number in the set of all streams of same type.
+        uint16_t seqNumber;
+
+        /// @brief Program number, 0 if stream is not described by PMT.
+        uint16_t program;
+
+        /// @brief Stream type from PMT, 0 if stream is not described by PMT.
+        uint8_t streamType;
+
+        /// @brief Lowercase ISO 639 language code from PMT, empty if absent.
+        std::string language;
+
+        /// @brief Audio type from ISO 639 language descriptor: 0 - undefined, 1 - clean effects,
+        ///        2 - hearing impaired, 3 - visual impaired commentary.
+        uint8_t audioType;
+
+        /// @brief Codec signalled by PMT descriptors, e.g. 'AC-3' or 'E-AC-3', empty if none.
+        std::string codec;
+    };
+
+    /// @brief Program information.
+    struct ProgramInfo
+    {
+        /// @brief PID of program map table.
+        uint16_t pmtPid;
+
+        /// @brief Set if program map table is parsed.
+        bool pmtDetected;
+
+        /// @brief Version of program map table.
+        uint8_t pmtVersion;
+
+        /// @brief PID of packets with PCR, 0x1FFF if none or program map table is not parsed.
+        uint16_t pcrPid;
+    };
+
+    /// @brief PSI table information.
+    struct TableInfo
+    {
+        /// @brief Table id.
+        uint8_t tableId;
+
+        /// @brief PID of the table.
+        uint16_t pid;
+
+        /// @brief Transport stream id for PAT, program number for PMT.
+        uint16_t number;
+
+        /// @brief Table version.
+        uint8_t version;
+
+        /// @brief Offset of TS packet with the table within input.
+        uint64_t tsOffset;
+    };
+
+    /// @brief Type of PSI table handler.
+    using OnTable = std::function<void(const TableInfo&)>;
+
+    /// @brief Modes of passing raw data of PES packets.
+    enum class PesAssembly
+    {
+        /// @brief Raw data of every TS payload is passed as soon as it's parsed.
+        NONE,
+
+        /// @brief Raw data of whole PES packet is passed at once, broken packets are flagged.
+        FLAG,
+
+        /// @brief Raw data of whole PES packet is passed at once, broken packets are dropped.
+        DROP,
+    };
+
+    /// @brief Statistics of parsed payloads.
+    struct Statistics
+    {
+        /// @brief Number of corrupted PSI tables.
+        uint64_t psiErrors = 0;
+
+        /// @brief Number of PES packets with corrupted header.
+        uint64_t pesErrors = 0;
+
+        /// @brief Number of detected changes of program map tables versions.
+        uint64_t pmtChanges = 0;
+
+        /// @brief Number of assembled PES packets with lost TS packets or wrong length.
+        uint64_t brokenPes = 0;
+
+        /// @brief Number of PES packets with DTS going backwards, checked by Validation::PARANOID only.
+        uint64_t timestampErrors = 0;
+    };
+
     /// @brief Constructor.
     /// @param[out] log - Stream for log messages.
     /// @param[in] handler - Raw data handler.
     /// @throws Error.
     PayloadParser(std::ostream& log, OnEsRawData handler);
 
+    /// @brief Set handler called for every new version of PAT or PMT.
+    /// @details Handler is called after programs and streams described by the table are updated.
+    /// @param[in] handler - PSI table handler, may be empty.
+    void setTableHandler(OnTable handler);
+
+    /// @brief Set mode of passing raw data of PES packets, NONE by default.
+    /// @details PES packet is assembled until PES packet length is reached or next PES packet starts.
+    /// @param[in] mode - Mode of passing raw data.
+    void setPesAssembly(PesAssembly mode);
+
+    /// @brief Set level of payloads validation, Validation::DEFAULT by default.
+    /// @details Validation::TRUSTED skips CRC check of PSI tables and does not log incomplete PES packets.
+    ///          Validation::PARANOID also counts PES packets with wrong length as PES errors, checks that
+    ///          DTS of every PID goes forward and counts PSI tables referring to reserved or foreign PIDs as PSI errors.
+    /// @param[in] validation - Level of validation.
+    void setValidation(Validation validation);
+
     /// @brief Parse one TS payload.
     /// @details Calls handler, which may throws exceptions.
     /// @param[in] payload - TS payload.
     void parse(const TsPayload& payload);
 
+    /// @brief Pass raw data of PES packets being assembled, should be called at the end of input.
+    /// @details Calls handler, which may throws exceptions.
+    void flush();
+
+    /// @brief Get all detected streams by PID.
+    const std::map<uint16_t, StreamInfo>& streams() const;
+
+    /// @brief Get all detected programs by program number.
+    const std::map<uint16_t, ProgramInfo>& programs() const;
+
+    /// @brief Check if PAT and program map tables of all its programs are parsed.
+    bool psiComplete() const;
+
+    /// @brief Get statistics of already parsed payloads.
+    const Statistics& statistics() const;
+
 private:
+    /// @brief Parse one TS payload with given validation policy.
+    /// @details Same as parse(), Policy is one of TrustedValidation, DefaultValidation or ParanoidValidation.
+    template <typename Policy>
+    void parseWith(const TsPayload& payload);
+
+    /// @brief Pass PES packets being assembled with given validation policy.
+    /// @details Same as flush(), Policy is one of TrustedValidation, DefaultValidation or ParanoidValidation.
+    template <typename Policy>
+    void flushWith();
+
     /// @brief Parse payload with program association table.
+    /// @tparam Policy - Validation policy.
     /// @param[in] payload - TS payload.
+    template <typename Policy>
     void parsePat(const TsPayload& payload);
 
     /// @brief Parse payload with program map table.
+    /// @tparam Policy - Validation policy.
     /// @param[in] payload - TS payload.
+    template <typename Policy>
     void parsePmt(const TsPayload& payload);
 
     /// @brief Check table's payload for id and size.
+    /// @tparam Policy - Validation policy, CRC is checked only if Policy::crc is set.
     /// @param[in] payload - TS payload.
     /// @param[in] tableId - Expected table id.
     /// @param[out] offset - Table offset within payload.
     /// @param[out] sectionSize - Table section size.
     /// @returns true is check succeeded, false otherwise.
+    template <typename Policy>
     bool checkTablePayload(const TsPayload& payload,
                            uint8_t tableId,
                            uint16_t& offset,
@@ -49,14 +197,49 @@ private:
 
     /// @brief Parse payload with raw data.
     /// @details Calls handler, which may throws exceptions.
+    /// @tparam Policy - Validation policy.
     /// @param[in] payload - TS payload.
+    template <typename Policy>
     void parseDataPayload(const TsPayload& payload);
 
+    /// @brief Check length and timestamps of PES packets, used by Validation::PARANOID.
+    /// @details Length of PES packet is checked when the next one starts, so the last one is not checked.
+    /// @param[in] payload - TS payload.
+    /// @param[in] rawData - Raw data of the payload.
+    /// @param[in] headerSize - Size of PES header within the payload, if the payload starts PES packet.
+    void checkPes(const TsPayload& payload, const EsRawData& rawData, uint16_t headerSize);
+
+    /// @brief Check PID referred by PSI table, used by Validation::PARANOID.
+    /// @details PID should not be reserved, ES PID also should not be PMT PID or ES PID of another program.
+    /// @param[in] pid - PID of PMT or ES.
+    /// @param[in] tableId - Id of the table referring the PID.
+    /// @param[in] program - Program number, if the table is PMT.
+    /// @returns true if PID is valid, false otherwise.
+    bool checkPsiPid(uint16_t pid, uint8_t tableId, uint16_t program);
+
     /// @brief Parse PES header.
     /// @param[in] payload - TS payload.
     /// @param[out] offset - Raw data offset within payload.
+    /// @param[out] pts - PTS of PES packet, noTimestamp if absent.
+    /// @param[out] dts - DTS of PES packet, equals to PTS if absent.
     /// @returns true is header is successfully parsed, false otherwise.
-    bool parseHeader(const TsPayload& payload, uint16_t& offset);
+    bool parseHeader(const TsPayload& payload, uint16_t& offset, int64_t& pts, int64_t& dts);
+
+    /// @brief Add raw data of TS payload to PES packet being assembled.
+    /// @details Calls handler, which may throws exceptions.
+    /// @tparam Policy - Validation policy.
+    /// @param[in] payload - TS payload.
+    /// @param[in] rawData - Raw data of the payload.
+    /// @param[in] headerSize - Size of PES header within the payload, if the payload starts PES packet.
+    template <typename Policy>
+    void assemblePes(const TsPayload& payload, const EsRawData& rawData, uint16_t headerSize);
+
+    /// @brief Pass assembled PES packet into handler or drop it.
+    /// @details Calls handler, which may throws exceptions.
+    /// @tparam Policy - Validation policy, broken PES packets are logged only if Policy::logging is set.
+    /// @param[in] pid - PID of PES packet.
+    template <typename Policy>
+    void passPes(uint16_t pid);
 
     /// @brief Add new stream to the set of known ones if needed.
     /// @param[in] pid - Corresponding pid in TS stream.
@@ -71,16 +254,6 @@ private:
     /// @brief Raw data handler.
     OnEsRawData handler_;
 
-    /// @brief ES stream information.
-    struct StreamInfo
-    {
-        /// @brief Type of ES stream.
-        EsType type;
-
-        /// @brief Stream number in the set of all streams of same type.
-        uint16_t seqNumber;
-    };
-
     /// @brief Set of known streams.
     std::map<uint16_t, StreamInfo> streams_;
 
@@ -90,9 +263,68 @@ private:
     /// @brief Number of detected video streams.
     uint16_t videoSeqNumber_ = 0;
 
+    /// @brief PSI table handler.
+    OnTable tableHandler_;
+
+    /// @brief Set if program association table is parsed.
+    bool patDetected_ = false;
+
+    /// @brief Version of program association table.
+    uint8_t patVersion_ = 0;
+
     /// @brief All detected programs.
-    std::set<uint16_t> detectedPrograms_;
+    std::map<uint16_t, ProgramInfo> programs_;
 
     /// @brief Set of pids with program map tables.
     std::set<uint16_t> pmTablePids_;
+
+    /// @brief Statistics of parsed payloads.
+    Statistics statistics_;
+
+    /// @brief PES packet being assembled.
+    struct PesBuffer
+    {
+        /// @brief Raw data of the first payload, its data and size are replaced by assembled ones.
+        EsRawData rawData;
+
+        /// @brief Assembled raw data, its capacity is kept for next PES packets.
+        std::vector<uint8_t> data;
+
+        /// @brief Expected size of raw data by PES packet length, 0 if length is not set.
+        size_t expectedSize = 0;
+
+        /// @brief Set if PES packet is being assembled.
+        bool open = false;
+
+        /// @brief Set if TS packets of PES packet were lost or its length is wrong.
+        bool broken = false;
+    };
+
+    /// @brief Raw data passed to handler, reused for every payload.
+    EsRawData rawData_;
+
+    /// @brief Mode of passing raw data of PES packets.
+    PesAssembly pesAssembly_ = PesAssembly::NONE;
+
+    /// @brief PES packets being assembled by PID.
+    std::map<uint16_t, PesBuffer> pesBuffers_;
+
+    /// @brief Level of payloads validation.
+    Validation validation_ = Validation::DEFAULT;
+
+    /// @brief State of PES packets checked by Validation::PARANOID.
+    struct PesCheck
+    {
+        /// @brief Expected size of raw data by PES packet length, 0 if length is not set or unknown.
+        size_t expectedSize = 0;
+
+        /// @brief Size of raw data of current PES packet.
+        size_t size = 0;
+
+        /// @brief DTS of the last PES packet, noTimestamp if none.
+        int64_t dts = noTimestamp;
+    };
+
+    /// @brief PES packets checked by Validation::PARANOID by PID.
+    std::map<uint16_t, PesCheck> pesChecks_;
 };
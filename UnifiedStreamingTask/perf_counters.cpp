@@ -0,0 +1,220 @@
+#include "error.hpp"
+#include "perf_counters.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <initializer_list>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif // __linux__
+
+
+namespace
+{
+    /// @brief Bytes in megabyte of throughput and miss rates.
+    const double megabyte = 1024.0 * 1024.0;
+
+    /// @brief Width of report columns.
+    const int columnWidth = 17;
+
+    /// @brief Get monotonic time in nanoseconds.
+    uint64_t now()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /// @brief Write one report column, "n/a" if value is unavailable.
+    void writeColumn(std::ostream& output, bool available, double value, int precision)
+    {
+        std::ostringstream text;
+        if (available)
+            text << std::fixed << std::setprecision(precision) << value;
+        else
+            text << "n/a";
+        output << std::setw(columnWidth) << text.str();
+    }
+
+    /// @brief Write report row of one stage.
+    void writeRow(std::ostream& output, const PerfCounters& counters, const char* name, const PerfCounters::Counts& counts, uint64_t bytes, uint64_t packets)
+    {
+        const double seconds = counts.nanoseconds / 1e9;
+        const double megabytes = bytes / megabyte;
+        const auto* events = counts.events;
+
+        output << std::left << std::setw(8) << name << std::right;
+        writeColumn(output, true, seconds * 1000, 1);
+        writeColumn(output, seconds > 0, megabytes / seconds, 1);
+        writeColumn(output, counters.available(PerfCounters::CYCLES) && packets, double(events[PerfCounters::CYCLES]) / packets, 1);
+        writeColumn(output, counters.available(PerfCounters::CYCLES) && counters.available(PerfCounters::INSTRUCTIONS) && events[PerfCounters::CYCLES],
+                    double(events[PerfCounters::INSTRUCTIONS]) / events[PerfCounters::CYCLES], 2);
+        writeColumn(output, counters.available(PerfCounters::CACHE_MISSES) && bytes, events[PerfCounters::CACHE_MISSES] / megabytes, 1);
+        writeColumn(output, counters.available(PerfCounters::BRANCH_MISSES) && bytes, events[PerfCounters::BRANCH_MISSES] / megabytes, 1);
+        writeColumn(output, counters.available(PerfCounters::PAGE_FAULTS), double(events[PerfCounters::PAGE_FAULTS]), 0);
+        output << "\n";
+    }
+}
+
+#ifdef __linux__
+
+PerfCounters::PerfCounters()
+{
+    std::memset(stages_, 0, sizeof(stages_));
+    std::memset(&last_, 0, sizeof(last_));
+
+    const struct
+    {
+        uint32_t type;
+        uint64_t config;
+    } events[EVENT_COUNT] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+    };
+
+    // counters are opened one by one, so unsupported ones don't disable others;
+    // user space only counting is allowed by default kernel settings
+    bool opened = false;
+    for (size_t i = 0; i < EVENT_COUNT; ++i)
+    {
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = events[i].type;
+        attributes.config = events[i].config;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        descriptors_[i] = static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+        opened = opened || descriptors_[i] >= 0;
+    }
+
+    if (!opened)
+        throw Error(Error::CONSTRUCTION_ERROR, "PerfCounters, no performance counter is available, check kernel.perf_event_paranoid");
+}
+
+PerfCounters::~PerfCounters()
+{
+    for (int descriptor : descriptors_)
+    {
+        if (descriptor >= 0)
+            ::close(descriptor);
+    }
+}
+
+PerfCounters::Counts PerfCounters::read() const
+{
+    Counts result;
+    for (size_t i = 0; i < EVENT_COUNT; ++i)
+    {
+        uint64_t value = 0;
+        if (descriptors_[i] >= 0 && ::read(descriptors_[i], &value, sizeof(value)) != sizeof(value))
+            value = 0;
+        result.events[i] = value;
+    }
+    result.nanoseconds = now();
+    return result;
+}
+
+#else
+
+PerfCounters::PerfCounters()
+{
+    for (int& descriptor : descriptors_)
+        descriptor = -1;
+    throw Error(Error::CONSTRUCTION_ERROR, "PerfCounters, performance counters are supported on Linux only");
+}
+
+PerfCounters::~PerfCounters()
+{
+}
+
+PerfCounters::Counts PerfCounters::read() const
+{
+    Counts result;
+    std::memset(&result, 0, sizeof(result));
+    result.nanoseconds = now();
+    return result;
+}
+
+#endif // __linux__
+
+bool PerfCounters::available(Event event) const
+{
+    return descriptors_[event] >= 0;
+}
+
+void PerfCounters::enter(PerfStage stage)
+{
+    stop();
+    stage_ = stage;
+    running_ = true;
+}
+
+void PerfCounters::stop()
+{
+    const Counts current = read();
+    if (running_)
+    {
+        Counts& counts = stages_[static_cast<size_t>(stage_)];
+        for (size_t i = 0; i < EVENT_COUNT; ++i)
+            counts.events[i] += current.events[i] - last_.events[i];
+        counts.nanoseconds += current.nanoseconds - last_.nanoseconds;
+    }
+    last_ = current;
+    running_ = false;
+}
+
+const PerfCounters::Counts& PerfCounters::counts(PerfStage stage) const
+{
+    return stages_[static_cast<size_t>(stage)];
+}
+
+void PerfCounters::report(std::ostream& output, uint64_t bytes, uint64_t packets) const
+{
+    Counts total;
+    std::memset(&total, 0, sizeof(total));
+    for (const auto& counts : stages_)
+    {
+        for (size_t i = 0; i < EVENT_COUNT; ++i)
+            total.events[i] += counts.events[i];
+        total.nanoseconds += counts.nanoseconds;
+    }
+
+    // rates of every stage are per input byte and packet, so stages add up to total
+    output << "Performance counters of splitting thread, " << bytes << " bytes, " << packets << " packets:\n"
+           << std::left << std::setw(8) << "stage" << std::right;
+    for (const char* column : { "time, ms", "MB/s", "cycles/packet", "IPC", "cache misses/MB", "branch misses/MB", "page faults" })
+        output << std::setw(columnWidth) << column;
+    output << "\n";
+
+    for (size_t i = 0; i < stageCount; ++i)
+    {
+        if (stages_[i].nanoseconds)
+            writeRow(output, *this, stageName(static_cast<PerfStage>(i)), stages_[i], bytes, packets);
+    }
+    writeRow(output, *this, "total", total, bytes, packets);
+    output.flush();
+}
+
+const char* PerfCounters::stageName(PerfStage stage)
+{
+    switch (stage)
+    {
+    case PerfStage::READ:
+        return "read";
+    case PerfStage::SPLIT:
+        return "split";
+    case PerfStage::CLOSE:
+        return "close";
+    case PerfStage::VERIFY:
+        return "verify";
+    }
+    return "unknown";
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+
+/// @brief Stages of splitting measured by performance counters.
+enum class PerfStage
+{
+    /// @brief Reading input blocks, including seeking for range start.
+    READ,
+
+    /// @brief Parsing TS packets, PSI tables and PES packets and writing outputs.
+    SPLIT,
+
+    /// @brief Flushing and closing outputs, writing reports.
+    CLOSE,
+
+    /// @brief Verification of outputs.
+    VERIFY,
+};
+
+/// @class PerfCounters.
+/// @brief Counts CPU cycles, instructions, cache misses, branch misses and page faults of the calling
+///        thread per stage of splitting, by perf_event_open(), so no perf tool is needed.
+/// @details Counters are read when stage changes, i.e. twice per input block. Counters not supported
+///          by CPU, hypervisor or kernel settings are reported as unavailable. Supported on Linux only.
+class PerfCounters
+{
+public:
+    /// @brief Counted events.
+    enum Event
+    {
+        CYCLES,
+        INSTRUCTIONS,
+        CACHE_MISSES,
+        BRANCH_MISSES,
+        PAGE_FAULTS,
+        EVENT_COUNT,
+    };
+
+    /// @brief Number of stages.
+    static const size_t stageCount = static_cast<size_t>(PerfStage::VERIFY) + 1;
+
+    /// @brief Counted events and time of one stage.
+    struct Counts
+    {
+        /// @brief Values of events, 0 for unavailable ones.
+        uint64_t events[EVENT_COUNT];
+
+        /// @brief Time in nanoseconds.
+        uint64_t nanoseconds;
+    };
+
+    /// @brief Constructor, opens counters of the calling thread, they are stopped.
+    /// @throws Error if no counter is available.
+    PerfCounters();
+
+    /// @brief Destructor, closes counters.
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /// @brief Check if event is counted.
+    bool available(Event event) const;
+
+    /// @brief Start counting stage, counts since the previous call are added to the previous stage.
+    /// @details Must be called by the thread the counters are opened by.
+    void enter(PerfStage stage);
+
+    /// @brief Stop counting, counts since the previous enter() are added to its stage.
+    void stop();
+
+    /// @brief Get counts of stage.
+    const Counts& counts(PerfStage stage) const;
+
+    /// @brief Write table of per-stage cycles per packet, IPC, misses per MB and throughput.
+    /// @param[out] output - Stream for the report.
+    /// @param[in] bytes - Number of input bytes.
+    /// @param[in] packets - Number of input TS packets.
+    void report(std::ostream& output, uint64_t bytes, uint64_t packets) const;
+
+    /// @brief Get stage name.
+    static const char* stageName(PerfStage stage);
+
+private:
+    /// @brief Read all counters and clock.
+    Counts read() const;
+
+    /// @brief Descriptors of counters, -1 for unavailable ones.
+    int descriptors_[EVENT_COUNT];
+
+    /// @brief Counts of stages.
+    Counts stages_[stageCount];
+
+    /// @brief Counts read by the last enter().
+    Counts last_;
+
+    /// @brief Current stage.
+    PerfStage stage_ = PerfStage::READ;
+
+    /// @brief Set if a stage is counted.
+    bool running_ = false;
+};
@@ -0,0 +1,108 @@
+#include "error.hpp"
+#include "pid_filter.hpp"
+
+#include <cstring>
+#include <string>
+
+
+namespace
+{
+    /// @brief Program association table pid.
+    const uint16_t paTablePid = 0;
+
+    /// @brief PID of null packets, also means no PCR PID in PMT.
+    const uint16_t nullPacketPid = 0x1FFF;
+}
+
+PidFilter::PidFilter(std::ostream& log,
+                     const PidSelection& selection,
+                     const std::map<uint16_t, PayloadParser::StreamInfo>& streams,
+                     const std::map<uint16_t, PayloadParser::ProgramInfo>& programs)
+    : log_(log)
+    , selection_(selection)
+    , streams_(streams)
+    , programs_(programs)
+{
+    if (!log_.good())
+        throw Error(Error::CONSTRUCTION_ERROR, "PidFilter, bad log output");
+    for (const auto* pids : { &selection_.pids, &selection_.excludedPids })
+    {
+        if (!pids->empty() && *pids->rbegin() > maxPid)
+            throw Error(Error::CONSTRUCTION_ERROR, "PidFilter, wrong PID " + std::to_string(*pids->rbegin()));
+    }
+
+    update();
+}
+
+void PidFilter::update()
+{
+    // unknown PIDs are read only if nothing is selected explicitly
+    const bool selectAll = selection_.pids.empty() && selection_.programs.empty();
+    std::memset(bits_, selectAll ? 0xFF : 0x00, sizeof(bits_));
+
+    for (uint16_t pid : selection_.pids)
+        set(pid, true);
+
+    for (const auto& pair : programs_)
+    {
+        // program 0 refers to network information table
+        if (!pair.first)
+            continue;
+        if (selection_.programs.empty() || selection_.programs.count(pair.first))
+            set(pair.second.pmtPid, true);
+    }
+
+    for (const auto& pair : streams_)
+    {
+        if (selection_.programs.count(pair.second.program))
+            set(pair.first, true);
+        if (selection_.excludedTypes.count(pair.second.type))
+            set(pair.first, false);
+        if (pair.second.type == EsType::AUDIO && !selection_.audioLanguages.empty() &&
+            !selection_.audioLanguages.count(pair.second.language))
+            set(pair.first, false);
+    }
+
+    // PCR of selected program may be carried by PID without ES, its SPTS needs it too
+    for (const auto& pair : programs_)
+    {
+        const uint16_t pcrPid = pair.second.pcrPid;
+        if (pair.first && pcrPid != nullPacketPid && !streams_.count(pcrPid) && selected(pair.first))
+            set(pcrPid, true);
+    }
+
+    for (uint16_t pid : selection_.excludedPids)
+        set(pid, false);
+
+    set(paTablePid, true);
+
+    // selected programs are searched for in PAT only once it's parsed
+    if (programs_.empty())
+        return;
+    for (uint16_t program : selection_.programs)
+    {
+        if (!programs_.count(program) && missingPrograms_.insert(program).second)
+            log_ << "Warning: PidFilter, program " << program << " is not found in PAT" << std::endl;
+    }
+}
+
+bool PidFilter::selected(uint16_t program) const
+{
+    if (selection_.programs.count(program))
+        return true;
+    for (const auto& pair : streams_)
+    {
+        if (pair.second.program == program && selection_.pids.count(pair.first))
+            return true;
+    }
+    return false;
+}
+
+void PidFilter::set(uint16_t pid, bool passed)
+{
+    const uint64_t bit = uint64_t(1) << (pid & 0x3F);
+    if (passed)
+        bits_[(pid & maxPid) >> 6] |= bit;
+    else
+        bits_[(pid & maxPid) >> 6] &= ~bit;
+}
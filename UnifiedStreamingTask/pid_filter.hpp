@@ -0,0 +1,97 @@
+#pragma once
+
+#include "message_types.hpp"
+#include "payload_parser.hpp"
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+
+
+/// @struct PidSelection.
+/// @brief Rules of selecting PIDs to read from input.
+struct PidSelection
+{
+    /// @brief PIDs to read, if neither PIDs nor programs are given, all PIDs are read.
+    std::set<uint16_t> pids;
+
+    /// @brief Programs to read all ES of.
+    std::set<uint16_t> programs;
+
+    /// @brief PIDs not to read.
+    std::set<uint16_t> excludedPids;
+
+    /// @brief Types of ES not to read.
+    std::set<EsType> excludedTypes;
+
+    /// @brief Lowercase ISO 639 language codes of audio ES to read, if empty audio ES are not
+    ///        filtered by language.
+    std::set<std::string> audioLanguages;
+};
+
+/// @class PidFilter.
+/// @brief Bitmap of PIDs to read from input.
+/// @details PAT is always passed. PMTs of selected programs, or of all programs if no program is
+///          selected, are passed too, so ES are detected and numbered by them. PIDs of ES are
+///          passed according to selection once they are described by PMT or detected by PES header,
+///          all unknown PIDs are passed too if neither PIDs nor programs are selected. PCR PID of a
+///          program is passed if the program or some of its ES is selected. Audio ES are
+///          also filtered by language from PMT, if languages are selected, audio ES without
+///          language are dropped.
+class PidFilter
+{
+public:
+    /// @brief Constructor.
+    /// @param[out] log - Stream for log messages.
+    /// @param[in] selection - Rules of selecting PIDs.
+    /// @param[in] streams - Detected streams by PID, see PayloadParser::streams().
+    /// @param[in] programs - Detected programs by number, see PayloadParser::programs().
+    /// @throws Error.
+    PidFilter(std::ostream& log,
+              const PidSelection& selection,
+              const std::map<uint16_t, PayloadParser::StreamInfo>& streams,
+              const std::map<uint16_t, PayloadParser::ProgramInfo>& programs);
+
+    /// @brief Check if packets of PID should be read.
+    /// @param[in] pid - PID of TS packet.
+    bool passes(uint16_t pid) const
+    {
+        return (bits_[(pid & maxPid) >> 6] >> (pid & 0x3F)) & 1;
+    }
+
+    /// @brief Update passed PIDs according to detected programs and streams.
+    /// @details Should be called for every new version of PAT or PMT.
+    void update();
+
+private:
+    /// @brief Check if program or some of its ES is selected explicitly.
+    /// @param[in] program - Program number.
+    bool selected(uint16_t program) const;
+
+    /// @brief Pass or drop packets of PID.
+    void set(uint16_t pid, bool passed);
+
+private:
+    /// @brief Maximum value of PID.
+    static const uint16_t maxPid = 0x1FFF;
+
+    /// @brief Log output stream.
+    std::ostream& log_;
+
+    /// @brief Rules of selecting PIDs.
+    const PidSelection selection_;
+
+    /// @brief Detected streams.
+    const std::map<uint16_t, PayloadParser::StreamInfo>& streams_;
+
+    /// @brief Detected programs.
+    const std::map<uint16_t, PayloadParser::ProgramInfo>& programs_;
+
+    /// @brief Bit for every PID, set if its packets are passed.
+    uint64_t bits_[(maxPid + 1) / 64];
+
+    /// @brief Selected programs already reported as missing.
+    std::set<uint16_t> missingPrograms_;
+};
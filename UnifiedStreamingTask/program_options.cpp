@@ -1,7 +1,15 @@
 #include "error.hpp"
+#include "output_name_generator.hpp"
 #include "program_options.hpp"
+#include "udp_receiver.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
+#include <set>
 #include <sstream>
 
 
@@ -13,11 +21,158 @@ namespace
     /// @brief Default video output name.
     const std::string videoDefaultOutput = "video_1.out";
 
+    /// @brief Maximum value of PID.
+    const unsigned long maxPid = 0x1FFF;
+
     /// @brief Check if argument is an option (key).
     bool isOption(const char* arg)
     {
         return arg[0] == '-';
     }
+
+    /// @brief Parse time point, either seconds or PTS with 'pts' suffix.
+    /// @param[in] option - Option name.
+    /// @param[in] value - Option argument.
+    /// @throws Error.
+    TimePoint parseTime(const char* option, const char* value)
+    {
+        const Error error(Error::WRONG_OPTION_ARGUMENT, std::string(option) + " " + value);
+        const size_t length = strlen(value);
+        char* end = nullptr;
+
+        // PTS in 90 kHz ticks
+        if (length > 3 && strcmp(value + length - 3, "pts") == 0)
+        {
+            const long long pts = strtoll(value, &end, 10);
+            if (end != value + length - 3 || pts < 0 || pts >= (1LL << 33))
+                throw error;
+            return TimePoint{ true, pts, true };
+        }
+
+        // seconds, possibly fractional
+        const double seconds = strtod(value, &end);
+        if (!length || end != value + length || !std::isfinite(seconds) || seconds < 0)
+            throw error;
+        return TimePoint{ true, std::llround(seconds * 90000), false };
+    }
+
+    /// @brief Parse positive size in bytes, possibly with 'K', 'M' or 'G' suffix.
+    /// @param[in] option - Option name.
+    /// @param[in] value - Option argument.
+    /// @throws Error.
+    uint64_t parseSize(const char* option, const char* value)
+    {
+        const Error error(Error::WRONG_OPTION_ARGUMENT, std::string(option) + " " + value);
+        char* end = nullptr;
+
+        const unsigned long long size = strtoull(value, &end, 10);
+        if (end == value || value[0] == '-' || size == 0)
+            throw error;
+
+        unsigned shift = 0;
+        if (*end == 'K')
+            shift = 10;
+        else if (*end == 'M')
+            shift = 20;
+        else if (*end == 'G')
+            shift = 30;
+        if ((shift && *++end) || (!shift && *end) || size > (~0ULL >> shift))
+            throw error;
+        return static_cast<uint64_t>(size) << shift;
+    }
+
+    /// @brief Parse positive decimal number.
+    /// @param[in] option - Option name.
+    /// @param[in] value - Option argument.
+    /// @throws Error.
+    size_t parseCount(const char* option, const char* value)
+    {
+        char* end = nullptr;
+        const unsigned long count = strtoul(value, &end, 10);
+        if (end == value || *end || value[0] == '-' || count == 0)
+            throw Error(Error::WRONG_OPTION_ARGUMENT, std::string(option) + " " + value);
+        return static_cast<size_t>(count);
+    }
+
+    /// @brief Parse mode of passing raw data of PES packets, 'flag' or 'drop'.
+    /// @param[in] option - Option name.
+    /// @param[in] value - Option argument.
+    /// @throws Error.
+    PayloadParser::PesAssembly parsePesAssembly(const char* option, const char* value)
+    {
+        if (strcmp(value, "flag") == 0)
+            return PayloadParser::PesAssembly::FLAG;
+        if (strcmp(value, "drop") == 0)
+            return PayloadParser::PesAssembly::DROP;
+        throw Error(Error::WRONG_OPTION_ARGUMENT, std::string(option) + " " + value);
+    }
+
+    /// @brief Parse level of input validation, 'trusted', 'default' or 'paranoid'.
+    /// @param[in] option - Option name.
+    /// @param[in] value - Option argument.
+    /// @throws Error.
+    Validation parseValidation(const char* option, const char* value)
+    {
+        if (strcmp(value, "trusted") == 0)
+            return Validation::TRUSTED;
+        if (strcmp(value, "default") == 0)
+            return Validation::DEFAULT;
+        if (strcmp(value, "paranoid") == 0)
+            return Validation::PARANOID;
+        throw Error(Error::WRONG_OPTION_ARGUMENT, std::string(option) + " " + value);
+    }
+
+    /// @brief Parse comma separated list of ISO 639 language codes, e.g. 'eng,deu'.
+    /// @param[in] option - Option name.
+    /// @param[in] value - Option argument.
+    /// @param[in,out] languages - Set to add parsed lowercase codes to.
+    /// @throws Error.
+    void parseLanguages(const char* option, const char* value, std::set<std::string>& languages)
+    {
+        std::set<std::string> parsed;
+        std::istringstream list(value);
+        std::string language;
+        while (std::getline(list, language, ','))
+        {
+            if (language.size() != 3 || !std::all_of(language.begin(), language.end(), [](char c) { return std::isalpha(c); }))
+                throw Error(Error::WRONG_OPTION_ARGUMENT, std::string(option) + " " + value);
+            std::transform(language.begin(), language.end(), language.begin(), [](char c) { return char(std::tolower(c)); });
+            parsed.insert(language);
+        }
+        if (parsed.empty() || value[strlen(value) - 1] == ',')
+            throw Error(Error::WRONG_OPTION_ARGUMENT, std::string(option) + " " + value);
+        languages.insert(parsed.begin(), parsed.end());
+    }
+
+    /// @brief Parse comma separated list of decimal or hexadecimal numbers, e.g. '256,0x101'.
+    /// @param[in] option - Option name.
+    /// @param[in] value - Option argument.
+    /// @param[in] minNumber - Minimum allowed number.
+    /// @param[in] maxNumber - Maximum allowed number.
+    /// @param[in,out] numbers - Set to add parsed numbers to.
+    /// @throws Error.
+    void parseNumbers(const char* option, const char* value, unsigned long minNumber, unsigned long maxNumber,
+                      std::set<uint16_t>& numbers)
+    {
+        const Error error(Error::WRONG_OPTION_ARGUMENT, std::string(option) + " " + value);
+        std::set<uint16_t> parsed;
+        const char* start = value;
+        while (true)
+        {
+            char* end = nullptr;
+            const unsigned long number = strtoul(start, &end, 0);
+            if (end == start || *start == '-' || number < minNumber || number > maxNumber)
+                throw error;
+            parsed.insert(static_cast<uint16_t>(number));
+
+            if (!*end)
+                break;
+            if (*end != ',')
+                throw error;
+            start = end + 1;
+        }
+        numbers.insert(parsed.begin(), parsed.end());
+    }
 }
 
 ProgramOptions::ProgramOptions(const std::string& executableName)
@@ -26,6 +181,10 @@ ProgramOptions::ProgramOptions(const std::string& executableName)
 
 void ProgramOptions::init(int argc, const char* const * argv)
 {
+    // job file name and options, which are not allowed with it
+    std::string jobsName;
+    bool jobOptionsGiven = false;
+
     int i = 1;
     while (i < argc)
     {
@@ -35,6 +194,11 @@ void ProgramOptions::init(int argc, const char* const * argv)
             helpRequested_ = true;
             break;
         }
+        if (strcmp(arg, "--cpu-features") == 0)
+        {
+            cpuFeaturesRequested_ = true;
+            break;
+        }
 
         if (!isOption(arg))
         {
@@ -42,6 +206,79 @@ void ProgramOptions::init(int argc, const char* const * argv)
             throw Error(Error::ARGUMENT_WITHOUT_OPTION, arg);
         }
 
+        if (strcmp(arg, "-i") != 0 && strcmp(arg, "--follow") != 0 && strcmp(arg, "--validation") != 0 &&
+            strcmp(arg, "--verify") != 0 && strcmp(arg, "--perf-report") != 0 && strcmp(arg, "--jobs") != 0)
+            jobOptionsGiven = true;
+
+        // options without argument
+        if (strcmp(arg, "--timestamps") == 0)
+        {
+            timestampsRequested_ = true;
+            ++i;
+            continue;
+        }
+        if (strcmp(arg, "--no-index") == 0)
+        {
+            indexDisabled_ = true;
+            ++i;
+            continue;
+        }
+        if (strcmp(arg, "--frames") == 0)
+        {
+            framesRequested_ = true;
+            ++i;
+            continue;
+        }
+        if (strcmp(arg, "--keyframes-only") == 0)
+        {
+            keyframesOnlyRequested_ = true;
+            ++i;
+            continue;
+        }
+        if (strcmp(arg, "--segment-keyframes") == 0)
+        {
+            segmentPolicy_.atKeyframes = true;
+            ++i;
+            continue;
+        }
+        if (strcmp(arg, "--ts-per-program") == 0)
+        {
+            tsPerProgramRequested_ = true;
+            ++i;
+            continue;
+        }
+        if (strcmp(arg, "--follow") == 0)
+        {
+            followRequested_ = true;
+            ++i;
+            continue;
+        }
+        if (strcmp(arg, "--verify") == 0)
+        {
+            verifyRequested_ = true;
+            ++i;
+            continue;
+        }
+        if (strcmp(arg, "--perf-report") == 0)
+        {
+            perfReportRequested_ = true;
+            ++i;
+            continue;
+        }
+        if (strcmp(arg, "--probe") == 0)
+        {
+            probeRequested_ = true;
+            ++i;
+            continue;
+        }
+        if (strcmp(arg, "--quick-probe") == 0)
+        {
+            probeRequested_ = true;
+            quickProbeRequested_ = true;
+            ++i;
+            continue;
+        }
+
         if (i + 1 >= argc || isOption(argv[i + 1]))
         {
             helpRequested_ = true;
@@ -54,6 +291,44 @@ void ProgramOptions::init(int argc, const char* const * argv)
             audioOutputName_ = argv[i + 1];
         else if (strcmp(arg, "-ov") == 0)
             videoOutputName_ = argv[i + 1];
+        else if (strcmp(arg, "-ots") == 0)
+            tsOutputName_ = argv[i + 1];
+        else if (strcmp(arg, "--index") == 0)
+            indexName_ = argv[i + 1];
+        else if (strcmp(arg, "--manifest") == 0)
+            manifestName_ = argv[i + 1];
+        else if (strcmp(arg, "--start") == 0)
+            startTime_ = parseTime(arg, argv[i + 1]);
+        else if (strcmp(arg, "--end") == 0)
+            endTime_ = parseTime(arg, argv[i + 1]);
+        else if (strcmp(arg, "--segment-size") == 0)
+            segmentPolicy_.size = parseSize(arg, argv[i + 1]);
+        else if (strcmp(arg, "--segment-duration") == 0)
+        {
+            segmentPolicy_.duration = parseTime(arg, argv[i + 1]).ticks;
+            if (segmentPolicy_.duration <= 0)
+                throw Error(Error::WRONG_OPTION_ARGUMENT, std::string(arg) + " " + argv[i + 1]);
+        }
+        else if (strcmp(arg, "--max-open-files") == 0)
+            maxOpenFiles_ = parseCount(arg, argv[i + 1]);
+        else if (strcmp(arg, "--flush-interval") == 0)
+            flushInterval_ = parseCount(arg, argv[i + 1]);
+        else if (strcmp(arg, "--latency-report") == 0)
+            latencyReportInterval_ = parseCount(arg, argv[i + 1]);
+        else if (strcmp(arg, "--assemble-pes") == 0)
+            pesAssembly_ = parsePesAssembly(arg, argv[i + 1]);
+        else if (strcmp(arg, "--validation") == 0)
+            validation_ = parseValidation(arg, argv[i + 1]);
+        else if (strcmp(arg, "--pids") == 0)
+            parseNumbers(arg, argv[i + 1], 0, maxPid, pidSelection_.pids);
+        else if (strcmp(arg, "--program") == 0)
+            parseNumbers(arg, argv[i + 1], 1, 0xFFFF, pidSelection_.programs);
+        else if (strcmp(arg, "--exclude-pids") == 0)
+            parseNumbers(arg, argv[i + 1], 0, maxPid, pidSelection_.excludedPids);
+        else if (strcmp(arg, "--audio-lang") == 0)
+            parseLanguages(arg, argv[i + 1], pidSelection_.audioLanguages);
+        else if (strcmp(arg, "--jobs") == 0)
+            jobsName = argv[i + 1];
         else
         {
             helpRequested_ = true;
@@ -63,26 +338,202 @@ void ProgramOptions::init(int argc, const char* const * argv)
         i += 2;
     }
 
-    if (!helpRequested_ && audioOutputName_.empty() && videoOutputName_.empty())
+    if (startTime_.isSet && endTime_.isSet && startTime_.isPts == endTime_.isPts && startTime_.ticks >= endTime_.ticks)
+    {
+        helpRequested_ = true;
+        throw Error(Error::WRONG_OPTION_ARGUMENT, "--end should be later than --start");
+    }
+
+    if (followRequested_ && (inputName_.empty() || probeRequested_))
+    {
+        helpRequested_ = true;
+        throw Error(Error::WRONG_OPTION_ARGUMENT, "--follow requires input file and can't be used with --probe");
+    }
+
+    const bool pidsSelected = !pidSelection_.pids.empty() || !pidSelection_.programs.empty() ||
+                              !pidSelection_.excludedPids.empty() || !pidSelection_.audioLanguages.empty();
+    if (pidsSelected && probeRequested_)
+    {
+        helpRequested_ = true;
+        throw Error(Error::WRONG_OPTION_ARGUMENT, "--pids, --program, --exclude-pids and --audio-lang can't be used with --probe");
+    }
+
+    if (tsPerProgramRequested_ && tsOutputName_.empty())
+    {
+        helpRequested_ = true;
+        throw Error(Error::WRONG_OPTION_ARGUMENT, "--ts-per-program requires -ots");
+    }
+
+    if (!tsOutputName_.empty() && probeRequested_)
+    {
+        helpRequested_ = true;
+        throw Error(Error::WRONG_OPTION_ARGUMENT, "-ots can't be used with --probe");
+    }
+
+    if (!manifestName_.empty() && probeRequested_)
+    {
+        helpRequested_ = true;
+        throw Error(Error::WRONG_OPTION_ARGUMENT, "--manifest can't be used with --probe");
+    }
+
+    if ((flushInterval_ || latencyReportInterval_) && probeRequested_)
+    {
+        helpRequested_ = true;
+        throw Error(Error::WRONG_OPTION_ARGUMENT, "--flush-interval and --latency-report can't be used with --probe");
+    }
+
+    if (verifyRequested_ && probeRequested_)
+    {
+        helpRequested_ = true;
+        throw Error(Error::WRONG_OPTION_ARGUMENT, "--verify can't be used with --probe");
+    }
+
+    if (perfReportRequested_ && probeRequested_)
+    {
+        helpRequested_ = true;
+        throw Error(Error::WRONG_OPTION_ARGUMENT, "--perf-report can't be used with --probe");
+    }
+
+    if (!jobsName.empty())
+    {
+        if (jobOptionsGiven)
+        {
+            helpRequested_ = true;
+            throw Error(Error::WRONG_OPTION_ARGUMENT, "--jobs can be used only with -i, --follow, --validation, --verify and --perf-report");
+        }
+        parseJobs(jobsName);
+        return;
+    }
+
+    if (!helpRequested_ && audioOutputName_.empty() && videoOutputName_.empty() && tsOutputName_.empty())
     {
         audioOutputName_ = audioDefaultOutput;
         videoOutputName_ = videoDefaultOutput;
+        defaultOutputNames_ = true;
+    }
+
+    // index of input file is cheap to build, so it's written along with ES outputs unless disabled,
+    // inputs of unknown length are not indexed by default, as index is kept in memory till their end
+    const bool hasEsOutput = !audioOutputName_.empty() || !videoOutputName_.empty();
+    if (!helpRequested_ && indexName_.empty() && !indexDisabled_ && hasEsOutput && !inputName_.empty() &&
+        !UdpReceiver::isUrl(inputName_) && !followRequested_ && !probeRequested_ && !quickProbeRequested_)
+    {
+        indexName_ = OutputNameGenerator(videoOutputName_.empty() ? audioOutputName_ : videoOutputName_).name(1) + ".idx";
+        defaultIndexName_ = true;
+    }
+    if (indexDisabled_)
+        indexName_.clear();
+
+    const bool segmentationRequested = segmentPolicy_.size || segmentPolicy_.duration || segmentPolicy_.atKeyframes;
+    if (segmentationRequested && !OutputNameGenerator(audioOutputName_).segmented() &&
+        !OutputNameGenerator(videoOutputName_).segmented())
+    {
+        helpRequested_ = true;
+        throw Error(Error::WRONG_OPTION_ARGUMENT, "segment options require '%d' pattern in output names");
     }
 }
 
+void ProgramOptions::parseJobs(const std::string& fileName)
+{
+    std::ifstream file(fileName);
+    if (!file.good())
+    {
+        helpRequested_ = true;
+        throw Error(Error::WRONG_OPTION_ARGUMENT, "--jobs " + fileName + ", failed to open file");
+    }
+
+    // output files of all jobs, they must differ
+    std::set<std::string> outputs;
+    std::vector<std::unique_ptr<ProgramOptions>> jobs;
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+        const std::string prefix = "--jobs " + fileName + ", line " + std::to_string(lineNumber) + ": ";
+
+        // options are separated by whitespaces, lines starting with '#' are comments
+        std::istringstream lineStream(line);
+        std::vector<std::string> args{ executableName_ };
+        std::string arg;
+        while (lineStream >> arg)
+            args.push_back(arg);
+        if (args.size() == 1 || args[1][0] == '#')
+            continue;
+
+        std::vector<const char*> jobArgv;
+        for (const auto& jobArg : args)
+            jobArgv.push_back(jobArg.c_str());
+
+        std::unique_ptr<ProgramOptions> job(new ProgramOptions(executableName_));
+        try
+        {
+            job->init(static_cast<int>(jobArgv.size()), jobArgv.data());
+        }
+        catch (const Error& err)
+        {
+            helpRequested_ = true;
+            throw Error(err.code(), prefix + err.message());
+        }
+
+        // input is read once for all jobs
+        if (job->helpRequested() || !job->inputName().empty() || job->followRequested() ||
+            job->quickProbeRequested() || job->validation() != Validation::DEFAULT || job->verifyRequested() ||
+            job->perfReportRequested() || !job->jobs().empty())
+        {
+            helpRequested_ = true;
+            throw Error(Error::WRONG_OPTION_ARGUMENT,
+                        prefix + "-h, -i, --follow, --quick-probe, --validation, --verify, --perf-report and --jobs can't be used in jobs");
+        }
+        job->validation_ = validation_;
+
+        if (!job->probeRequested())
+        {
+            for (const auto* output : { &job->audioOutputName(), &job->videoOutputName(), &job->tsOutputName(), &job->indexName(), &job->manifestName() })
+            {
+                if (!output->empty() && !outputs.insert(*output).second)
+                {
+                    helpRequested_ = true;
+                    throw Error(Error::WRONG_OPTION_ARGUMENT, prefix + "output '" + *output + "' is written by another job");
+                }
+            }
+        }
+        jobs.push_back(std::move(job));
+    }
+
+    if (jobs.empty())
+    {
+        helpRequested_ = true;
+        throw Error(Error::WRONG_OPTION_ARGUMENT, "--jobs " + fileName + ", no jobs found");
+    }
+    jobs_ = std::move(jobs);
+}
+
 bool ProgramOptions::helpRequested() const
 {
     return helpRequested_;
 }
 
+bool ProgramOptions::cpuFeaturesRequested() const
+{
+    return cpuFeaturesRequested_;
+}
+
 std::string ProgramOptions::usage() const
 {
     std::ostringstream buffer;
 
-    buffer << "Usage: " << executableName_ << " [-i <input_file>] [-oa <audio_output>] [-ov <video_output>]\n"
+    buffer << "Usage: " << executableName_ << " [-i <input_file>] [-oa <audio_output>] [-ov <video_output>] [-ots <ts_output>]\n"
+           << "\t[--ts-per-program] [--index <index_file> | --no-index] [--manifest <manifest_file>]\n\t[--start <time>] [--end <time>] [--timestamps] [--frames] [--keyframes-only]\n\t[--segment-size <size>] [--segment-duration <time>] [--segment-keyframes]\n\t[--max-open-files <number>] [--flush-interval <ms>] [--latency-report <seconds>]\n\t[--assemble-pes <policy>] [--validation <level>]\n\t[--pids <pids>] [--program <programs>] [--exclude-pids <pids>]\n\t[--audio-lang <languages>] [--follow] [--verify]\n\t[--perf-report] [--probe | --quick-probe]\n"
+           << "   or: " << executableName_ << " [-i <input_file>] [--follow] [--validation <level>]\n\t[--verify] [--perf-report] --jobs <job_file>\n"
+           << "   or: " << executableName_ << " --cpu-features\n"
            << "\nSplit TS file into raw audio and/or video tracks.\n\n"
 
-           << "  -i\t\tInput file to split. If omitted, STDIN is used.\n\n"
+           << "  -i\t\tInput file to split. If omitted, STDIN is used. UDP or RTP stream is received\n"
+           << "\t\tif URL 'udp://[@]address:port' is given, multicast group is joined if the\n"
+           << "\t\taddress is multicast one. Reception ends if no datagrams arrive for 5 seconds.\n"
+           << "\t\tSupported on Linux only.\n\n"
 
            << "  -oa\t\tOutput file for 1st audio track. All other audio tracks are saved into files \n"
            << "\t\twith the save name and suffix:\n"
@@ -98,6 +549,132 @@ std::string ProgramOptions::usage() const
            << "\t\tIf omitted but audio output file is set, no video output is written. \n"
            << "\t\tIf both omitted, '" << videoDefaultOutput << "' is used by default.\n\n"
 
+           << "  -ots\t\tOutput file for transport stream with all read PIDs, i.e. ones passed by\n"
+           << "\t\t'--pids', '--program', '--exclude-pids' and '--audio-lang'. TS packets are\n"
+           << "\t\tcopied as is, PAT is regenerated to list only programs with read PMTs.\n"
+           << "\t\tIf set without '-oa' and '-ov', no ES output is written.\n\n"
+
+           << "  --ts-per-program\n\t\tWrite SPTS per program instead of one TS, named by program numbers:\n"
+           << "\t\t-ots out.ts will produce files 'out.ts' for program 1, 'out_2.ts', etc.\n"
+           << "\t\tEvery SPTS has its PMT, PCR PID and ES. Requires '-ots'.\n\n"
+
+           << "  --index\tIndex file to write along with outputs. For every audio and video PID it\n"
+           << "\t\tcontains offsets of PES packets in the input and in the output ES files and\n"
+           << "\t\ttheir PTS, and versions of PAT and PMTs. See 'ts_index.hpp' for the format.\n"
+           << "\t\tIf input file is given without '--follow', index of ES with outputs is written\n"
+           << "\t\tby default into '<output>.idx', named after the first video or audio output.\n\n"
+
+           << "  --no-index\tDon't write index by default.\n\n"
+
+           << "  --manifest\tManifest file to write along with outputs. It contains a line with\n"
+           << "\t\thexadecimal CRC-32C, size and name of every ES output file, including\n"
+           << "\t\tsegments. Outputs are hashed while they are written.\n\n"
+
+           << "  --start\tStart of time range to write. Every ES starts with the first PES packet with\n"
+           << "\t\tPTS not less than this time. Time is either seconds from the first PTS of\n"
+           << "\t\tthe input, e.g. '90.5', or absolute PTS in 90 kHz ticks with suffix, e.g.\n"
+           << "\t\t'8145000pts'. Input file is searched for the start by PTS without reading it whole.\n\n"
+
+           << "  --end\t\tEnd of time range to write, in the same format as '--start'. Every ES ends\n"
+           << "\t\tbefore the first PES packet with PTS not less than this time, reading stops\n"
+           << "\t\tas soon as all ES reach it.\n\n"
+
+           << "  --timestamps\tWrite timestamp file '<output>.pts' along with every output. It contains\n"
+           << "\t\toffset in the output, PTS and DTS of every PES packet with PTS.\n"
+           << "\t\tSee 'ts_index.hpp' for the format.\n\n"
+
+           << "  --frames\tDetect access units and keyframes of H.264, HEVC and ADTS outputs and\n"
+           << "\t\twrite frame file '<output>.frames' along with every output. It contains\n"
+           << "\t\toffset in the output, size, PTS and keyframe flag of every access unit.\n"
+           << "\t\tSee 'ts_index.hpp' for the format. Numbers are logged per PID.\n\n"
+
+           << "  --keyframes-only\n\t\tWrite only keyframes (H.264 IDR, HEVC IRAP) with their parameter\n"
+           << "\t\tsets into video outputs. Keyframes are detected by NAL unit types and\n"
+           << "\t\trandom access indicator, other video is dropped. Audio is not affected.\n\n"
+
+           << "  --segment-size\n\t\tSplit outputs with '%d' or '%05d' pattern at the end of their base names,\n"
+           << "\t\te.g. 'video_1_%05d.h264', into segments of at least this size in bytes.\n"
+           << "\t\tSuffixes 'K', 'M' and 'G' are supported. Segments start at PES packets.\n\n"
+
+           << "  --segment-duration\n\t\tSplit outputs with segment pattern into segments of this PTS duration,\n"
+           << "\t\tin seconds or in 90 kHz ticks with 'pts' suffix.\n\n"
+
+           << "  --segment-keyframes\n\t\tStart video segments at keyframes only, i.e. at PES packets with random\n"
+           << "\t\taccess indicator, the first one after size or duration is reached.\n\n"
+
+           << "  --max-open-files\n\t\tMaximum number of open ES output files. The least recently written output\n"
+           << "\t\tis closed to open another one, its data is buffered and the file is reopened\n"
+           << "\t\tin append mode once 64 KB is collected. Segment files are not opened ahead.\n"
+           << "\t\tNumbers of opened and reopened files are logged. Not limited by default.\n\n"
+
+           << "  --flush-interval\n\t\tFlush every ES output at least once per this number of milliseconds,\n"
+           << "\t\tcounted from read of its oldest buffered data, e.g. '--flush-interval 20'.\n"
+           << "\t\tTrades batching for latency of live inputs, outputs of idle ES are flushed\n"
+           << "\t\tin time too. By default outputs are flushed when 64 KB of them is collected.\n\n"
+
+           << "  --latency-report\n\t\tLog p50, p99 and p99.9 of latency from read of TS packet till its data\n"
+           << "\t\tis handed to file system every this number of seconds, and for the whole\n"
+           << "\t\trun when outputs are closed. Latency is sampled by every write of ES output\n"
+           << "\t\tdata into file, which is not synchronized with disk.\n\n"
+
+           << "  --assemble-pes\n\t\tPass raw data of whole PES packets at once, not of every TS packet. PES\n"
+           << "\t\tpacket with lost TS packets or length differing from PES packet length is\n"
+           << "\t\tflagged as broken with 'flag' policy or dropped with 'drop' one.\n\n"
+
+           << "  --validation\tLevel of input checks: 'trusted', 'default' or 'paranoid'. Trusted\n"
+           << "\t\tinput is not checked for continuity counters and PSI CRC, its corrupted\n"
+           << "\t\tpackets are not logged. Paranoid level also checks PES packet length,\n"
+           << "\t\torder of timestamps and PIDs referred by PAT and PMTs. Common for jobs.\n\n"
+
+           << "  --pids\tRead only these PIDs, comma separated list of decimal or hexadecimal\n"
+           << "\t\tnumbers, e.g. '256,0x101'. Packets of other PIDs are dropped right after\n"
+           << "\t\ttheir header is read. PAT and PMTs are always read.\n\n"
+
+           << "  --program\tRead only ES of these programs, comma separated list of program numbers.\n"
+           << "\t\tPMTs of other programs are dropped too, so their ES are not numbered.\n"
+           << "\t\tCan be combined with '--pids' to read some other PIDs as well.\n\n"
+
+           << "  --exclude-pids\n\t\tDo not read these PIDs, in the same format as '--pids'.\n\n"
+
+           << "  --audio-lang\tRead only audio ES with these languages in PMT, comma separated list\n"
+           << "\t\tof ISO 639 codes, e.g. 'eng,deu'. Audio ES without language are dropped.\n"
+           << "\t\tES keep their numbers, as if all audio is read.\n\n"
+
+           << "  --follow\tFollow input file while it grows, like 'tail -f'. At the end of the\n"
+           << "\t\tfile wait for more data instead of finishing. The file is complete once\n"
+           << "\t\tits writer closes it or nothing is appended for 10 seconds. Outputs are\n"
+           << "\t\tflushed while waiting. Requires input file. Supported on Linux only.\n\n"
+
+           << "  --verify\tVerify ES outputs once they are written, in parallel and without decoding:\n"
+           << "\t\tADTS and AC-3 frame chains, H.264 and HEVC NAL unit headers and presence\n"
+           << "\t\tof parameter sets. JSON report of all files is printed into STDOUT, exit\n"
+           << "\t\tcode is 1 if any file fails. Common for jobs.\n\n"
+
+           << "  --perf-report\tCount CPU cycles, instructions, cache misses, branch misses and page\n"
+           << "\t\tfaults of splitting thread by hardware performance counters and print\n"
+           << "\t\ttheir rates per stage (read, split, close, verify) and throughput into\n"
+           << "\t\tSTDOUT. Unavailable counters are reported as 'n/a'. Common for jobs.\n"
+           << "\t\tSupported on Linux only.\n\n"
+
+           << "  --probe\tDo not write any output, print JSON inventory of programs and streams\n"
+           << "\t\tof the input with their bitrates and error counters into STDOUT.\n"
+           << "\t\tOutput names in the inventory are generated according to '-oa' and '-ov'.\n\n"
+
+           << "  --quick-probe\tThe same as '--probe', but read only the head of the input till all\n"
+           << "\t\tstreams are found and sample windows across the rest of it. Bitrates are\n"
+           << "\t\testimated, the report contains estimation confidence. Requires input file.\n\n"
+
+           << "  --jobs\tRun several jobs in one pass over the input. Every line of the job file\n"
+           << "\t\tcontains options of one job, e.g. '-oa audio.out --program 1' or '--probe',\n"
+           << "\t\tlines starting with '#' are skipped. Jobs have their own outputs, PID\n"
+           << "\t\tselections, segments, indexes and time ranges, '-i', '--follow',\n"
+           << "\t\t'--validation', '--verify' and '--perf-report' are common for all jobs.\n"
+           << "\t\tInput is not searched for '--start' of jobs.\n\n"
+
+           << "  --cpu-features\n\t\tPrint instruction set extensions of CPU and SIMD kernels chosen for them,\n"
+           << "\t\tthen exit. Level of kernels may be lowered by TS_SPLITTER_SIMD environment\n"
+           << "\t\tvariable set to 'scalar', 'sse2' or 'avx2'.\n\n"
+
            << "-h, --help\tShow this message and exit.";
 
     return buffer.str();
@@ -117,3 +694,123 @@ const std::string& ProgramOptions::videoOutputName() const
 {
     return videoOutputName_;
 }
+
+const std::string& ProgramOptions::tsOutputName() const
+{
+    return tsOutputName_;
+}
+
+bool ProgramOptions::defaultOutputNames() const
+{
+    return defaultOutputNames_;
+}
+
+bool ProgramOptions::defaultIndexName() const
+{
+    return defaultIndexName_;
+}
+
+bool ProgramOptions::tsPerProgramRequested() const
+{
+    return tsPerProgramRequested_;
+}
+
+const std::string& ProgramOptions::indexName() const
+{
+    return indexName_;
+}
+
+const std::string& ProgramOptions::manifestName() const
+{
+    return manifestName_;
+}
+
+const TimePoint& ProgramOptions::startTime() const
+{
+    return startTime_;
+}
+
+const TimePoint& ProgramOptions::endTime() const
+{
+    return endTime_;
+}
+
+bool ProgramOptions::timestampsRequested() const
+{
+    return timestampsRequested_;
+}
+
+bool ProgramOptions::framesRequested() const
+{
+    return framesRequested_;
+}
+
+bool ProgramOptions::keyframesOnlyRequested() const
+{
+    return keyframesOnlyRequested_;
+}
+
+const SegmentPolicy& ProgramOptions::segmentPolicy() const
+{
+    return segmentPolicy_;
+}
+
+size_t ProgramOptions::maxOpenFiles() const
+{
+    return maxOpenFiles_;
+}
+
+size_t ProgramOptions::flushInterval() const
+{
+    return flushInterval_;
+}
+
+size_t ProgramOptions::latencyReportInterval() const
+{
+    return latencyReportInterval_;
+}
+
+PayloadParser::PesAssembly ProgramOptions::pesAssembly() const
+{
+    return pesAssembly_;
+}
+
+const PidSelection& ProgramOptions::pidSelection() const
+{
+    return pidSelection_;
+}
+
+Validation ProgramOptions::validation() const
+{
+    return validation_;
+}
+
+bool ProgramOptions::followRequested() const
+{
+    return followRequested_;
+}
+
+const std::vector<std::unique_ptr<ProgramOptions>>& ProgramOptions::jobs() const
+{
+    return jobs_;
+}
+
+bool ProgramOptions::verifyRequested() const
+{
+    return verifyRequested_;
+}
+
+bool ProgramOptions::perfReportRequested() const
+{
+    return perfReportRequested_;
+}
+
+bool ProgramOptions::probeRequested() const
+{
+    return probeRequested_;
+}
+
+bool ProgramOptions::quickProbeRequested() const
+{
+    return quickProbeRequested_;
+}
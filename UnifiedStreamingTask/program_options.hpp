@@ -1,11 +1,18 @@
 #pragma once
 
+#include "output_writer.hpp"
+#include "payload_parser.hpp"
+#include "pid_filter.hpp"
+#include "time_range_filter.hpp"
+
+#include <memory>
 #include <string>
+#include <vector>
 
 
 /// @class ProgramOptions.
 /// @brief Parse command line options and values.
-/// @details Supports options '-i', '-oa', '-ov' - with argument and '-h', '--help' - without one.
+/// @details Supports options '-i', '-oa', '-ov', '-ots', '--index', '--manifest', '--start', '--end', '--segment-size', '--segment-duration', '--max-open-files', '--flush-interval', '--latency-report', '--assemble-pes', '--validation', '--pids', '--program', '--exclude-pids', '--audio-lang', '--jobs' - with argument and '-h', '--help', '--timestamps', '--no-index', '--frames', '--keyframes-only', '--segment-keyframes', '--ts-per-program', '--follow', '--verify', '--perf-report', '--probe', '--quick-probe', '--cpu-features' - without one.
 class ProgramOptions
 {
 public:
@@ -23,6 +30,9 @@ public:
     /// @details Help can required either explicitly, or implicitly - when error occures.
     bool helpRequested() const;
 
+    /// @brief Check if report of CPU features and chosen SIMD kernels is requested.
+    bool cpuFeaturesRequested() const;
+
     /// @brief Get usage text;
     std::string usage() const;
 
@@ -35,6 +45,85 @@ public:
     /// @brief Get video output name, can be empty.
     const std::string& videoOutputName() const;
 
+    /// @brief Get TS output name, can be empty.
+    const std::string& tsOutputName() const;
+
+    /// @brief Check if audio and video output names are defaults, as no output is given.
+    bool defaultOutputNames() const;
+
+    /// @brief Check if SPTS per program should be written instead of one TS output.
+    bool tsPerProgramRequested() const;
+
+    /// @brief Get index file name, can be empty.
+    const std::string& indexName() const;
+
+    /// @brief Check if index is written by default, as it's not requested nor disabled.
+    bool defaultIndexName() const;
+
+    /// @brief Get manifest file name, can be empty.
+    const std::string& manifestName() const;
+
+    /// @brief Get start of time range to extract, may be unset.
+    const TimePoint& startTime() const;
+
+    /// @brief Get end of time range to extract, may be unset.
+    const TimePoint& endTime() const;
+
+    /// @brief Check if timestamp files should be written along with outputs.
+    bool timestampsRequested() const;
+
+    /// @brief Check if access units of outputs should be detected.
+    bool framesRequested() const;
+
+    /// @brief Check if only keyframes should be written into video outputs.
+    bool keyframesOnlyRequested() const;
+
+    /// @brief Get rules of splitting outputs into segments.
+    const SegmentPolicy& segmentPolicy() const;
+
+    /// @brief Get maximum number of open ES output files, 0 if not limited.
+    size_t maxOpenFiles() const;
+
+    /// @brief Get interval in milliseconds to flush every ES output at least once per, 0 if not set.
+    size_t flushInterval() const;
+
+    /// @brief Get interval in seconds of logging latency percentiles, 0 if not set.
+    size_t latencyReportInterval() const;
+
+    /// @brief Get mode of passing raw data of PES packets.
+    PayloadParser::PesAssembly pesAssembly() const;
+
+    /// @brief Get level of input validation.
+    Validation validation() const;
+
+    /// @brief Get rules of selecting PIDs to read.
+    const PidSelection& pidSelection() const;
+
+    /// @brief Check if growing input file should be followed till its writer completes it.
+    bool followRequested() const;
+
+    /// @brief Get jobs parsed from job file, empty if no job file is given.
+    /// @details Every job has its own outputs and options, except input ones.
+    const std::vector<std::unique_ptr<ProgramOptions>>& jobs() const;
+
+    /// @brief Check if ES outputs should be verified once they are written.
+    bool verifyRequested() const;
+
+    /// @brief Check if performance counters of splitting should be reported.
+    bool perfReportRequested() const;
+
+    /// @brief Check if only stream inventory is requested, without writing outputs.
+    bool probeRequested() const;
+
+    /// @brief Check if stream inventory should be estimated by sampling the input.
+    bool quickProbeRequested() const;
+
+private:
+    /// @brief Parse job file, one line of options per job.
+    /// @param[in] fileName - Job file name.
+    /// @throws Error.
+    void parseJobs(const std::string& fileName);
+
 private:
     /// @brief Executable file name.
     const std::string executableName_;
@@ -42,6 +131,9 @@ private:
     /// @If set - help is required.
     bool helpRequested_ = false;
 
+    /// @brief Request for report of CPU features.
+    bool cpuFeaturesRequested_ = false;
+
     /// @brief Parsed input name.
     std::string inputName_;
 
@@ -50,4 +142,79 @@ private:
 
     /// @brief Parsed video output name.
     std::string videoOutputName_;
+
+    /// @brief Parsed TS output name.
+    std::string tsOutputName_;
+
+    /// @brief If set - audio and video output names are defaults.
+    bool defaultOutputNames_ = false;
+
+    /// @brief If set - SPTS per program is required.
+    bool tsPerProgramRequested_ = false;
+
+    /// @brief Parsed index file name.
+    std::string indexName_;
+
+    /// @brief If set - index file name is default.
+    bool defaultIndexName_ = false;
+
+    /// @brief If set - index is not required.
+    bool indexDisabled_ = false;
+
+    /// @brief Parsed manifest file name.
+    std::string manifestName_;
+
+    /// @brief Parsed start of time range.
+    TimePoint startTime_{ false, 0, false };
+
+    /// @brief Parsed end of time range.
+    TimePoint endTime_{ false, 0, false };
+
+    /// @brief If set - timestamp files are required.
+    bool timestampsRequested_ = false;
+
+    /// @brief If set - access units detection is required.
+    bool framesRequested_ = false;
+
+    /// @brief If set - only keyframes of video ES are required.
+    bool keyframesOnlyRequested_ = false;
+
+    /// @brief Parsed rules of splitting outputs into segments.
+    SegmentPolicy segmentPolicy_;
+
+    /// @brief Parsed maximum number of open ES output files.
+    size_t maxOpenFiles_ = 0;
+
+    /// @brief Parsed interval in milliseconds of flushing ES outputs.
+    size_t flushInterval_ = 0;
+
+    /// @brief Parsed interval in seconds of logging latency percentiles.
+    size_t latencyReportInterval_ = 0;
+
+    /// @brief Parsed mode of passing raw data of PES packets.
+    PayloadParser::PesAssembly pesAssembly_ = PayloadParser::PesAssembly::NONE;
+
+    /// @brief Parsed level of input validation.
+    Validation validation_ = Validation::DEFAULT;
+
+    /// @brief Parsed rules of selecting PIDs to read.
+    PidSelection pidSelection_;
+
+    /// @brief If set - input file is followed while it grows.
+    bool followRequested_ = false;
+
+    /// @brief Jobs parsed from job file.
+    std::vector<std::unique_ptr<ProgramOptions>> jobs_;
+
+    /// @brief If set - ES outputs are verified.
+    bool verifyRequested_ = false;
+
+    /// @brief If set - performance counters are reported.
+    bool perfReportRequested_ = false;
+
+    /// @brief If set - only stream inventory is required.
+    bool probeRequested_ = false;
+
+    /// @brief If set - stream inventory is estimated by sampling.
+    bool quickProbeRequested_ = false;
 };
@@ -0,0 +1,121 @@
+#include "error.hpp"
+#include "message_types.hpp"
+#include "pts_seeker.hpp"
+#include "timestamp.hpp"
+#include "ts_reader.hpp"
+
+
+namespace
+{
+    const size_t tsPacketSize = 188;
+
+    /// @brief Size of window read by every probe.
+    const size_t windowSize = 188 * 1024;
+
+    /// @brief Maximum number of windows in the head of the input to search the first PTS in.
+    const size_t maxHeadWindows = 16;
+
+    /// @brief Minimum size of PES header with PTS.
+    const uint16_t minPesHeaderSize = 14;
+
+    /// @brief Check if PES stream id is one of audio, video or private streams, which have PTS.
+    bool hasTimestamp(uint8_t streamId)
+    {
+        return streamId == 0xBD || streamId == 0xFD || (0xC0 <= streamId && streamId <= 0xEF);
+    }
+
+    /// @brief Get PTS of PES packet started in payload.
+    /// @returns PTS or noTimestamp if payload doesn't start PES packet with PTS.
+    int64_t payloadPts(const TsPayload& payload)
+    {
+        const uint8_t* data = payload.data;
+        if (!payload.newEsPacket || payload.size < minPesHeaderSize)
+            return noTimestamp;
+        if (data[0] != 0x00 || data[1] != 0x00 || data[2] != 0x01 || !hasTimestamp(data[3]))
+            return noTimestamp;
+        if ((data[6] & 0xC0) != 0x80 || !(data[7] & 0x80) || data[8] < 5)
+            return noTimestamp;
+        return readTimestamp(data + 9);
+    }
+}
+
+PtsSeeker::PtsSeeker(std::istream& input, std::ostream& log)
+    : input_(input)
+    , log_(log)
+    , buffer_(windowSize, 0)
+{
+    if (!log_.good())
+        throw Error(Error::CONSTRUCTION_ERROR, "PtsSeeker, bad log output");
+
+    input_.seekg(0, std::ios::end);
+    const std::streamoff size = input_.tellg();
+    input_.seekg(0, std::ios::beg);
+    if (size < 0 || !input_.good())
+    {
+        input_.clear();
+        throw Error(Error::CONSTRUCTION_ERROR, "PtsSeeker, input is not seekable");
+    }
+    size_ = static_cast<uint64_t>(size);
+}
+
+int64_t PtsSeeker::firstPts()
+{
+    for (size_t i = 0; i < maxHeadWindows && i * windowSize < size_; ++i)
+    {
+        const int64_t pts = ptsAt(i * windowSize);
+        if (pts != noTimestamp)
+            return pts;
+    }
+    return noTimestamp;
+}
+
+uint64_t PtsSeeker::find(int64_t pts)
+{
+    // the first window is the lower bound, it's ok to start from it even if its PTS is later
+    uint64_t low = 0;
+    uint64_t high = size_ / tsPacketSize * tsPacketSize;
+    size_t probes = 0;
+
+    while (high - low > windowSize)
+    {
+        const uint64_t middle = (low + (high - low) / 2) / tsPacketSize * tsPacketSize;
+        const int64_t found = ptsAt(middle);
+        ++probes;
+
+        // window without PTS is treated as a late one, so the result can only move towards the start
+        if (found != noTimestamp && ptsDelta(found, pts) > 0)
+            low = middle;
+        else
+            high = middle;
+    }
+
+    log_ << "Notice: PtsSeeker, PTS " << pts << " found at offset " << low << " after " << probes << " probes" << std::endl;
+    return low;
+}
+
+uint64_t PtsSeeker::size() const
+{
+    return size_;
+}
+
+int64_t PtsSeeker::ptsAt(uint64_t offset)
+{
+    input_.clear();
+    input_.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+    input_.read(reinterpret_cast<char*>(buffer_.data()), buffer_.size());
+    if (input_.bad())
+        throw Error(Error::CORRUPTED_INPUT, "PtsSeeker, failed to read");
+    const size_t read = static_cast<size_t>(input_.gcount());
+    input_.clear();
+
+    int64_t result = noTimestamp;
+    TsReader reader(log_, [&result, &reader](const TsPayload& payload)
+    {
+        result = payloadPts(payload);
+        if (result != noTimestamp)
+            reader.stop();
+    });
+    reader.push(buffer_.data(), read);
+
+    return result;
+}
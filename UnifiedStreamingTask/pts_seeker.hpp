@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+
+/// @class PtsSeeker.
+/// @brief Finds position within seekable TS input by PTS using binary search.
+/// @details Every probe reads a window of the input, resynchronizes with TS packets and takes
+///          PTS of the first PES packet found in it.
+class PtsSeeker
+{
+public:
+    /// @brief Constructor.
+    /// @param[in] input - Seekable TS input.
+    /// @param[out] log - Stream for log messages.
+    /// @throws Error if input is not seekable.
+    PtsSeeker(std::istream& input, std::ostream& log);
+
+    /// @brief Get PTS of the first PES packet of the input, noTimestamp if not found in its head.
+    /// @throws Error.
+    int64_t firstPts();
+
+    /// @brief Find offset of the input, all PES packets after which have PTS not less than given one.
+    /// @details PTS values are compared taking wrap around into account.
+    /// @param[in] pts - PTS to search for.
+    /// @returns Offset aligned to TS packet size.
+    /// @throws Error.
+    uint64_t find(int64_t pts);
+
+    /// @brief Get size of the input.
+    uint64_t size() const;
+
+private:
+    /// @brief Get PTS of the first PES packet within window.
+    /// @param[in] offset - Offset of the window.
+    /// @returns PTS or noTimestamp if not found.
+    /// @throws Error.
+    int64_t ptsAt(uint64_t offset);
+
+private:
+    /// @brief TS input stream.
+    std::istream& input_;
+
+    /// @brief Log output stream.
+    std::ostream& log_;
+
+    /// @brief Size of the input.
+    uint64_t size_ = 0;
+
+    /// @brief Buffer for reading windows.
+    std::vector<uint8_t> buffer_;
+};
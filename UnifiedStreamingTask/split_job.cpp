@@ -0,0 +1,246 @@
+#include "error.hpp"
+#include "split_job.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+
+
+namespace
+{
+    /// @brief Get rules of selecting PIDs for job options.
+    /// @details Packets of ES without output are dropped, unless requested index or TS output needs them.
+    ///          Index covers audio and video ES only, so ES of other types are read for TS output only.
+    ///          Default index covers ES with outputs only, so it doesn't make more PIDs read.
+    PidSelection pidSelection(const ProgramOptions& options)
+    {
+        const bool hasTsOutput = !options.tsOutputName().empty();
+        const bool hasIndex = !options.indexName().empty() && !options.defaultIndexName();
+
+        PidSelection selection = options.pidSelection();
+        if (!hasTsOutput)
+            selection.excludedTypes.insert(EsType::OTHER);
+        if (!hasIndex && !hasTsOutput && options.audioOutputName().empty())
+            selection.excludedTypes.insert(EsType::AUDIO);
+        if (!hasIndex && !hasTsOutput && options.videoOutputName().empty())
+            selection.excludedTypes.insert(EsType::VIDEO);
+
+        // inventory covers all ES
+        if (options.probeRequested())
+            selection.excludedTypes.clear();
+        return selection;
+    }
+
+    /// @brief Check if time range is given.
+    bool hasRange(const ProgramOptions& options)
+    {
+        return options.startTime().isSet || options.endTime().isSet;
+    }
+}
+
+SplitJob::SplitJob(std::ostream& log, const ProgramOptions& options, const std::string& inputFile,
+                   PayloadParser::OnEsRawData rawDataHandler)
+    : log_(log)
+    , audioNameGenerator_(options.audioOutputName())
+    , videoNameGenerator_(options.videoOutputName())
+    , rangeFilter_(log, options.startTime(), options.endTime(), std::bind(&SplitJob::filterRawData, this, std::placeholders::_1))
+    , parser_(log, hasRange(options) ? PayloadParser::OnEsRawData(std::bind(&TimeRangeFilter::write, &rangeFilter_, std::placeholders::_1))
+                                     : PayloadParser::OnEsRawData(std::bind(&SplitJob::filterRawData, this, std::placeholders::_1)))
+    , pidFilter_(log, pidSelection(options), parser_.streams(), parser_.programs())
+    , rawDataHandler_(rawDataHandler)
+    , manifestName_(options.manifestName())
+{
+    if (options.probeRequested())
+    {
+        probe_.reset(new StreamProbe(log_));
+        return;
+    }
+
+    // ES outputs are not written if only TS output is requested, or if handler takes ES without named outputs
+    const bool hasEsOutput = !options.audioOutputName().empty() || !options.videoOutputName().empty();
+    if (hasEsOutput && !(rawDataHandler_ && options.defaultOutputNames()))
+        writer_.reset(new OutputWriter(log_, audioNameGenerator_, videoNameGenerator_, options.segmentPolicy(),
+                                       options.maxOpenFiles()));
+    if (writer_)
+    {
+        writer_->setHashing(!manifestName_.empty());
+        writer_->setFlushInterval(static_cast<uint64_t>(options.flushInterval()) * 1000000);
+        writer_->setLatencyReport(static_cast<uint64_t>(options.latencyReportInterval()) * 1000000000);
+        hasDeadlines_ = options.flushInterval() || options.latencyReportInterval();
+    }
+    if (!options.indexName().empty())
+        index_.reset(new IndexWriter(log_, options.indexName()));
+    if (options.timestampsRequested())
+        timestamps_.reset(new TimestampWriter(log_, audioNameGenerator_, videoNameGenerator_));
+    if (options.keyframesOnlyRequested())
+        keyframeFilter_.reset(new KeyframeFilter(log_, parser_.streams(), std::bind(&SplitJob::writeRawData, this, std::placeholders::_1)));
+    if (options.framesRequested())
+    {
+        frames_.reset(new FrameWriter(log_, audioNameGenerator_, videoNameGenerator_));
+        framer_.reset(new EsFramer(log_, parser_.streams(), std::bind(&FrameWriter::write, frames_.get(), std::placeholders::_1)));
+    }
+
+    // packets are copied from input file by offsets, if it's a regular file
+    if (!options.tsOutputName().empty())
+    {
+        tsWriter_.reset(new TsWriter(log_, OutputNameGenerator(options.tsOutputName()), options.tsPerProgramRequested(),
+                                     inputFile, pidFilter_, parser_.streams(), parser_.programs()));
+    }
+
+    parser_.setPesAssembly(options.pesAssembly());
+    parser_.setValidation(options.validation());
+    parser_.setTableHandler([this](const PayloadParser::TableInfo& table)
+    {
+        if (index_)
+            index_->writeTable(table);
+        pidFilter_.update();
+        if (tsWriter_)
+            tsWriter_->writeTable(table);
+    });
+}
+
+void SplitJob::parse(const TsPayload& payload)
+{
+    if (probe_)
+        probe_->parse(payload);
+    else if (pidFilter_.passes(payload.pid))
+        parser_.parse(payload);
+}
+
+void SplitJob::write(const uint8_t* packet, uint16_t pid, uint64_t offset)
+{
+    if (tsWriter_ && pidFilter_.passes(pid))
+        tsWriter_->write(packet, pid, offset);
+}
+
+bool SplitJob::finished() const
+{
+    return rangeFilter_.finished();
+}
+
+bool SplitJob::hasTsOutput() const
+{
+    return static_cast<bool>(tsWriter_);
+}
+
+bool SplitJob::hasDeadlines() const
+{
+    return hasDeadlines_;
+}
+
+const PidFilter& SplitJob::pidFilter() const
+{
+    return pidFilter_;
+}
+
+PayloadParser& SplitJob::parser()
+{
+    return parser_;
+}
+
+TimeRangeFilter& SplitJob::rangeFilter()
+{
+    return rangeFilter_;
+}
+
+void SplitJob::flushOutputs()
+{
+    if (writer_)
+        writer_->flushOutputs();
+    if (timestamps_)
+        timestamps_->flushOutputs();
+    if (frames_)
+        frames_->flushOutputs();
+    if (tsWriter_)
+        tsWriter_->flushOutputs();
+}
+
+void SplitJob::checkDeadlines(uint64_t time)
+{
+    if (writer_)
+        writer_->checkDeadlines(time);
+}
+
+void SplitJob::close(const TsReader::Statistics& statistics, std::ostream& report)
+{
+    if (probe_)
+    {
+        probe_->complete(statistics);
+        probe_->report(report, audioNameGenerator_, videoNameGenerator_);
+        return;
+    }
+
+    parser_.flush();
+    if (keyframeFilter_)
+        keyframeFilter_->flush();
+
+    if (index_)
+        index_->close(parser_.streams());
+    if (timestamps_)
+        timestamps_->closeOutputs();
+    if (tsWriter_)
+        tsWriter_->closeOutputs();
+    if (framer_)
+        framer_->flush();
+    if (frames_)
+        frames_->closeOutputs();
+
+    // ES outputs are complete once the job is closed, so they can be verified
+    if (writer_)
+    {
+        writer_->closeOutputs();
+        outputFiles_ = writer_->files();
+        writer_.reset();
+    }
+
+    if (!manifestName_.empty())
+    {
+        std::ofstream manifest(manifestName_, std::ofstream::out | std::ofstream::binary);
+        OutputWriter::writeManifest(manifest, outputFiles_);
+        manifest.close();
+        if (!manifest.good())
+            throw Error(Error::CORRUPTED_OUTPUT, "SplitJob, failed to write manifest '" + manifestName_ + "'");
+    }
+}
+
+void SplitJob::addOutputs(EsVerifier& verifier) const
+{
+    const auto& streams = parser_.streams();
+    for (const auto& file : outputFiles_)
+    {
+        const auto stream = std::find_if(streams.begin(), streams.end(),
+            [&file](const std::pair<const uint16_t, PayloadParser::StreamInfo>& pair)
+            {
+                return pair.second.type == file.type && pair.second.seqNumber == file.number;
+            });
+        verifier.add(file.name, stream != streams.end() ? EsVerifier::codecOf(stream->second) : EsVerifier::Codec::UNKNOWN);
+    }
+}
+
+void SplitJob::writeRawData(const EsRawData& rawData)
+{
+    if (timestamps_)
+        timestamps_->write(rawData);
+    if (writer_)
+        writer_->write(rawData);
+
+    // index refers to the segment file data is written into, so it's updated after the writer
+    if (index_)
+    {
+        OutputWriter::Position position;
+        const bool hasPosition = rawData.newEsPacket && writer_ && writer_->lastPosition(rawData.type, rawData.esNumber, position);
+        index_->write(rawData, hasPosition ? &position : nullptr);
+    }
+    if (rawDataHandler_)
+        rawDataHandler_(rawData);
+    if (framer_)
+        framer_->write(rawData);
+}
+
+void SplitJob::filterRawData(const EsRawData& rawData)
+{
+    if (keyframeFilter_)
+        keyframeFilter_->write(rawData);
+    else
+        writeRawData(rawData);
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "es_framer.hpp"
+#include "es_verifier.hpp"
+#include "frame_writer.hpp"
+#include "index_writer.hpp"
+#include "keyframe_filter.hpp"
+#include "message_types.hpp"
+#include "output_name_generator.hpp"
+#include "output_writer.hpp"
+#include "payload_parser.hpp"
+#include "pid_filter.hpp"
+#include "program_options.hpp"
+#include "stream_probe.hpp"
+#include "time_range_filter.hpp"
+#include "timestamp_writer.hpp"
+#include "ts_reader.hpp"
+#include "ts_writer.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+/// @class SplitJob.
+/// @brief One output configuration applied to TS input: its parser, PID filter, outputs,
+///        index, timestamps and time range, or stream inventory if probe is requested.
+/// @details Several jobs may consume payloads of one reader, every job drops payloads its
+///          PID filter doesn't pass, so the reader itself may read all PIDs.
+class SplitJob
+{
+public:
+    /// @brief Constructor.
+    /// @param[out] log - Stream for log messages.
+    /// @param[in] options - Options of the job.
+    /// @param[in] inputFile - Input file name to copy TS packets from, empty if input is not a file.
+    /// @param[in] rawDataHandler - Handler of ES raw data passed to outputs, may be empty. If set, ES files
+    ///                             are written only if their names are given explicitly.
+    /// @throws Error.
+    SplitJob(std::ostream& log, const ProgramOptions& options, const std::string& inputFile,
+             PayloadParser::OnEsRawData rawDataHandler = PayloadParser::OnEsRawData());
+
+    SplitJob(const SplitJob&) = delete;
+    SplitJob& operator=(const SplitJob&) = delete;
+
+    /// @brief Parse TS payload.
+    /// @param[in] payload - TS payload.
+    /// @throws Error.
+    void parse(const TsPayload& payload);
+
+    /// @brief Write whole TS packet into TS outputs, if any.
+    /// @param[in] packet - Start of TS packet.
+    /// @param[in] pid - PID of the packet.
+    /// @param[in] offset - Offset of the packet within input.
+    /// @throws Error.
+    void write(const uint8_t* packet, uint16_t pid, uint64_t offset);
+
+    /// @brief Check if all ES passed the end of time range, so no more input is needed.
+    bool finished() const;
+
+    /// @brief Check if job writes TS outputs, so it needs whole TS packets.
+    bool hasTsOutput() const;
+
+    /// @brief Check if ES outputs have flush interval or latency report, so their deadlines should be checked.
+    bool hasDeadlines() const;
+
+    /// @brief Get filter of PIDs the job reads.
+    const PidFilter& pidFilter() const;
+
+    /// @brief Get parser of TS payloads.
+    PayloadParser& parser();
+
+    /// @brief Get time range filter.
+    TimeRangeFilter& rangeFilter();
+
+    /// @brief Write all buffered data into outputs.
+    /// @throws Error.
+    void flushOutputs();
+
+    /// @brief Flush outputs with expired flush interval and log latency percentiles if it's time to.
+    /// @param[in] time - Current time in nanoseconds of LatencyHistogram::now().
+    /// @throws Error.
+    void checkDeadlines(uint64_t time);
+
+    /// @brief Complete the job: flush filters, write index, close outputs and write their manifest, or write inventory.
+    /// @param[in] statistics - Statistics of reader, which produced payloads.
+    /// @param[out] report - Stream for inventory report.
+    /// @throws Error.
+    void close(const TsReader::Statistics& statistics, std::ostream& report);
+
+    /// @brief Add ES output files written by the job to verifier, should be called after close().
+    /// @details Codec of every file is taken from stream type of its ES.
+    /// @param[in,out] verifier - Verifier of ES files.
+    void addOutputs(EsVerifier& verifier) const;
+
+private:
+    /// @brief Pass ES raw data into outputs.
+    void writeRawData(const EsRawData& rawData);
+
+    /// @brief Pass ES raw data through keyframe filter, if any, into outputs.
+    void filterRawData(const EsRawData& rawData);
+
+private:
+    /// @brief Log output stream.
+    std::ostream& log_;
+
+    /// @brief Generator of audio output names.
+    OutputNameGenerator audioNameGenerator_;
+
+    /// @brief Generator of video output names.
+    OutputNameGenerator videoNameGenerator_;
+
+    /// @brief ES outputs writer, null if only TS outputs or inventory are requested.
+    std::unique_ptr<OutputWriter> writer_;
+
+    /// @brief Index writer, may be null.
+    std::unique_ptr<IndexWriter> index_;
+
+    /// @brief Timestamp files writer, may be null.
+    std::unique_ptr<TimestampWriter> timestamps_;
+
+    /// @brief Frame files writer, may be null.
+    std::unique_ptr<FrameWriter> frames_;
+
+    /// @brief Access units detector, may be null.
+    std::unique_ptr<EsFramer> framer_;
+
+    /// @brief Keyframe filter, may be null.
+    std::unique_ptr<KeyframeFilter> keyframeFilter_;
+
+    /// @brief Time range filter, bypassed if no time range is given.
+    TimeRangeFilter rangeFilter_;
+
+    /// @brief Parser of TS payloads.
+    PayloadParser parser_;
+
+    /// @brief Filter of PIDs the job reads.
+    PidFilter pidFilter_;
+
+    /// @brief TS outputs writer, may be null.
+    std::unique_ptr<TsWriter> tsWriter_;
+
+    /// @brief Inventory collector, null unless probe is requested.
+    std::unique_ptr<StreamProbe> probe_;
+
+    /// @brief Set if ES outputs have flush interval or latency report.
+    bool hasDeadlines_ = false;
+
+    /// @brief Handler of ES raw data passed to outputs, may be empty.
+    PayloadParser::OnEsRawData rawDataHandler_;
+
+    /// @brief ES output files written by the job, known once it's closed.
+    std::vector<OutputWriter::File> outputFiles_;
+
+    /// @brief Manifest file name, empty if manifest is not requested.
+    std::string manifestName_;
+};
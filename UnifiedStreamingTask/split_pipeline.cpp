@@ -0,0 +1,102 @@
+#include "es_verifier.hpp"
+#include "latency_histogram.hpp"
+#include "split_pipeline.hpp"
+
+#include <algorithm>
+#include <functional>
+
+
+SplitPipeline::SplitPipeline(std::ostream& log, const ProgramOptions& options, const std::string& inputFile,
+                             OnJobRawData rawDataHandler)
+    : log_(log)
+    , options_(options)
+{
+    // every job passes its index along with raw data
+    auto jobHandler = [&rawDataHandler](size_t job)
+    {
+        return rawDataHandler ? PayloadParser::OnEsRawData(std::bind(rawDataHandler, job, std::placeholders::_1))
+                              : PayloadParser::OnEsRawData();
+    };
+
+    if (options.jobs().empty())
+        jobs_.emplace_back(new SplitJob(log_, options, inputFile, jobHandler(0)));
+    for (const auto& jobOptions : options.jobs())
+        jobs_.emplace_back(new SplitJob(log_, *jobOptions, inputFile, jobHandler(jobs_.size())));
+
+    hasDeadlines_ = std::any_of(jobs_.begin(), jobs_.end(), [](const std::unique_ptr<SplitJob>& job) { return job->hasDeadlines(); });
+}
+
+void SplitPipeline::configure(TsReader& reader) const
+{
+    if (jobs_.size() == 1)
+        reader.setPidFilter(&jobs_.front()->pidFilter());
+
+    if (std::any_of(jobs_.begin(), jobs_.end(), [](const std::unique_ptr<SplitJob>& job) { return job->hasTsOutput(); }))
+    {
+        reader.setPacketHandler([this](const uint8_t* packet, uint16_t pid, uint64_t offset)
+        {
+            for (auto& job : jobs_)
+                job->write(packet, pid, offset);
+        });
+    }
+
+    reader.setValidation(options_.validation());
+}
+
+TsReader::OnPayload SplitPipeline::payloadHandler(std::function<void()> onFinished)
+{
+    return [this, onFinished](const TsPayload& payload)
+    {
+        for (auto& job : jobs_)
+            job->parse(payload);
+        if (onFinished && finished())
+            onFinished();
+    };
+}
+
+bool SplitPipeline::finished() const
+{
+    return std::all_of(jobs_.begin(), jobs_.end(), [](const std::unique_ptr<SplitJob>& job) { return job->finished(); });
+}
+
+SplitJob* SplitPipeline::singleJob()
+{
+    return jobs_.size() == 1 ? jobs_.front().get() : nullptr;
+}
+
+void SplitPipeline::flushOutputs()
+{
+    for (auto& job : jobs_)
+        job->flushOutputs();
+}
+
+void SplitPipeline::checkDeadlines()
+{
+    if (!hasDeadlines_)
+        return;
+
+    const uint64_t time = LatencyHistogram::now();
+    for (auto& job : jobs_)
+        job->checkDeadlines(time);
+}
+
+bool SplitPipeline::close(const TsReader::Statistics& statistics, std::ostream& report, PerfCounters* counters)
+{
+    if (counters)
+        counters->enter(PerfStage::CLOSE);
+    for (auto& job : jobs_)
+        job->close(statistics, report);
+
+    if (!options_.verifyRequested())
+        return true;
+
+    // outputs of all jobs are verified together, so that files are verified in parallel
+    if (counters)
+        counters->enter(PerfStage::VERIFY);
+    EsVerifier verifier(log_);
+    for (const auto& job : jobs_)
+        job->addOutputs(verifier);
+    verifier.verifyAll();
+    verifier.report(report);
+    return verifier.passed();
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "message_types.hpp"
+#include "perf_counters.hpp"
+#include "program_options.hpp"
+#include "split_job.hpp"
+#include "ts_reader.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+/// @class SplitPipeline.
+/// @brief Jobs of options consuming one TS reader, and verification of their outputs.
+/// @details Pipeline keeps no state outside of itself, so independent pipelines may run in parallel threads.
+class SplitPipeline
+{
+public:
+    /// @brief Handler of ES raw data of a job.
+    /// @param[in] job - Index of the job, in order of jobs of options.
+    /// @param[in] rawData - ES raw data passed to outputs of the job.
+    using OnJobRawData = std::function<void(size_t job, const EsRawData& rawData)>;
+
+    /// @brief Constructor.
+    /// @details Job is created for every job of options, or for options themselves if they have no jobs.
+    /// @param[out] log - Stream for log messages.
+    /// @param[in] options - Options, should outlive the pipeline.
+    /// @param[in] inputFile - Input file name to copy TS packets from, empty if input is not a file.
+    /// @param[in] rawDataHandler - Handler of ES raw data of all jobs, may be empty, see SplitJob.
+    /// @throws Error.
+    SplitPipeline(std::ostream& log, const ProgramOptions& options, const std::string& inputFile,
+                  OnJobRawData rawDataHandler = OnJobRawData());
+
+    SplitPipeline(const SplitPipeline&) = delete;
+    SplitPipeline& operator=(const SplitPipeline&) = delete;
+
+    /// @brief Set up reader feeding the pipeline: its PID filter, packet handler and validation.
+    /// @details The only job filters PIDs by reader, otherwise every job filters them itself.
+    /// @param[in,out] reader - Reader, which payloads are passed to payloadHandler().
+    void configure(TsReader& reader) const;
+
+    /// @brief Get handler of reader payloads.
+    /// @param[in] onFinished - Called after every payload once all jobs are finished, may be empty.
+    TsReader::OnPayload payloadHandler(std::function<void()> onFinished);
+
+    /// @brief Check if all jobs passed the end of their time ranges, so no more input is needed.
+    bool finished() const;
+
+    /// @brief Get the only job, nullptr if there are several jobs.
+    SplitJob* singleJob();
+
+    /// @brief Write all buffered data of all jobs into outputs.
+    /// @throws Error.
+    void flushOutputs();
+
+    /// @brief Check deadlines of outputs of all jobs by wall clock, if some job has flush interval or
+    ///        latency report, so data of ES without new data or of idle input doesn't wait for it.
+    /// @throws Error.
+    void checkDeadlines();
+
+    /// @brief Close all jobs and verify their outputs together, if verification is requested.
+    /// @param[in] statistics - Statistics of reader, which produced payloads.
+    /// @param[out] report - Stream for inventory and verification reports.
+    /// @param[in,out] counters - Performance counters switched to stages of closing, may be null.
+    /// @returns true if outputs passed verification or it's not requested, false otherwise.
+    /// @throws Error.
+    bool close(const TsReader::Statistics& statistics, std::ostream& report, PerfCounters* counters = nullptr);
+
+private:
+    /// @brief Log output stream.
+    std::ostream& log_;
+
+    /// @brief Options of the pipeline.
+    const ProgramOptions& options_;
+
+    /// @brief Jobs consuming payloads of the reader.
+    std::vector<std::unique_ptr<SplitJob>> jobs_;
+
+    /// @brief Set if some job has deadlines of outputs.
+    bool hasDeadlines_ = false;
+};
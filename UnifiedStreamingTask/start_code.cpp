@@ -0,0 +1,100 @@
+#include "start_code.hpp"
+
+#ifdef SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef SIMD_AVX2
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+namespace
+{
+#if defined(SIMD_SSE2) || defined(SIMD_AVX2)
+    /// @brief Get index of the lowest set bit of non-zero mask.
+    inline unsigned lowestBit(unsigned mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return index;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+#endif
+}
+
+size_t findStartCode(const uint8_t* data, size_t size)
+{
+    return kernels().findStartCode(data, size);
+}
+
+#ifdef SIMD_SSE2
+size_t findStartCodeSse2(const uint8_t* data, size_t size)
+{
+    // every iteration checks 16 start code positions, the last one reads 2 bytes further
+    size_t i = 0;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    for (; i + 18 <= size; i += 16)
+    {
+        const __m128i third = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 2)), one);
+        if (_mm_movemask_epi8(third) == 0)
+            continue;
+
+        const __m128i first = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), zero);
+        const __m128i second = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1)), zero);
+        const unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_and_si128(first, second), third));
+        if (mask)
+            return i + lowestBit(mask);
+    }
+
+    return i + findStartCodeScalar(data + i, size - i);
+}
+#endif
+
+#ifdef SIMD_AVX2
+SIMD_TARGET_AVX2 size_t findStartCodeAvx2(const uint8_t* data, size_t size)
+{
+    // every iteration checks 32 start code positions, the last one reads 2 bytes further
+    size_t i = 0;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    for (; i + 34 <= size; i += 32)
+    {
+        const __m256i third = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 2)), one);
+        if (_mm256_movemask_epi8(third) == 0)
+            continue;
+
+        const __m256i first = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), zero);
+        const __m256i second = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 1)), zero);
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_and_si256(first, second), third)));
+        if (mask)
+            return i + lowestBit(mask);
+    }
+
+    return i + findStartCodeScalar(data + i, size - i);
+}
+#endif
+
+size_t findStartCodeScalar(const uint8_t* data, size_t size)
+{
+    size_t i = 0;
+    while (i + 2 < size)
+    {
+        // if the third byte is not zero, none of the next two positions can start a start code
+        if (data[i + 2] != 0)
+        {
+            if (data[i + 2] == 1 && data[i + 1] == 0 && data[i] == 0)
+                return i;
+            i += 3;
+        }
+        else
+            ++i;
+    }
+    return size;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "cpu_features.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+/// @brief Find the first start code 00 00 01 of H.264/HEVC byte stream.
+/// @details Uses kernel chosen by CPU features, see kernels().
+/// @param[in] data - Start of data.
+/// @param[in] size - Size of data.
+/// @returns Offset of the first byte of start code, size if not found.
+size_t findStartCode(const uint8_t* data, size_t size);
+
+/// @brief Portable implementation of findStartCode().
+/// @param[in] data - Start of data.
+/// @param[in] size - Size of data.
+/// @returns Offset of the first byte of start code, size if not found.
+size_t findStartCodeScalar(const uint8_t* data, size_t size);
+
+#ifdef SIMD_SSE2
+/// @brief SSE2 implementation of findStartCode().
+size_t findStartCodeSse2(const uint8_t* data, size_t size);
+#endif
+
+#ifdef SIMD_AVX2
+/// @brief AVX2 implementation of findStartCode(), CPU should support AVX2.
+size_t findStartCodeAvx2(const uint8_t* data, size_t size);
+#endif
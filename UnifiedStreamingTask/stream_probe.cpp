@@ -0,0 +1,433 @@
+#include "error.hpp"
+#include "stream_probe.hpp"
+#include "timestamp.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+
+namespace
+{
+    const size_t tsPacketSize = 188;
+    const uint16_t paTablePid = 0;
+    const uint16_t nullPacketPid = 8191;
+
+    /// @brief Maximum size of input head read by quick probe.
+    const uint64_t quickProbeMaxHeadSize = 188 * 1024 * 256;
+
+    /// @brief Size of block read by quick probe.
+    const size_t quickProbeBlockSize = 188 * 1024;
+
+    /// @brief Name of ES type for report.
+    const char* esTypeName(EsType type)
+    {
+        switch (type)
+        {
+        case EsType::AUDIO:
+            return "audio";
+        case EsType::VIDEO:
+            return "video";
+        default:
+            return "other";
+        }
+    }
+
+    /// @brief Write string as JSON string literal.
+    void writeJsonString(std::ostream& output, const std::string& value)
+    {
+        output << '"';
+        for (const char c : value)
+        {
+            if (c == '"' || c == '\\')
+                output << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20)
+                output << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec << std::setfill(' ');
+            else
+                output << c;
+        }
+        output << '"';
+    }
+
+    /// @brief Bitrate in bits per second.
+    uint64_t bitrate(uint64_t bytes, double duration)
+    {
+        return duration > 0 ? static_cast<uint64_t>(bytes * 8 / duration) : 0;
+    }
+
+    /// @brief Read up to size bytes from input into buffer.
+    /// @returns Number of read bytes.
+    size_t readBlock(std::istream& input, std::vector<uint8_t>& buffer, size_t size)
+    {
+        buffer.resize(size);
+        input.read(reinterpret_cast<char*>(buffer.data()), size);
+        if (input.bad())
+            throw Error(Error::CORRUPTED_INPUT, "StreamProbe, failed to read");
+        return static_cast<size_t>(input.gcount());
+    }
+}
+
+StreamProbe::StreamProbe(std::ostream& log)
+    : log_(log)
+    , parser_(log, std::bind(&StreamProbe::onEsRawData, this, std::placeholders::_1))
+{
+    if (!log_.good())
+        throw Error(Error::CONSTRUCTION_ERROR, "StreamProbe, bad log output");
+}
+
+void StreamProbe::probe(std::istream& input)
+{
+    using namespace std::placeholders;
+
+    TsReader reader(input, log_, std::bind(&PayloadParser::parse, std::ref(parser_), _1));
+    reader.readAll();
+
+    addReaderStatistics(reader.statistics());
+    inputSize_ = readerStatistics_.bytes;
+}
+
+void StreamProbe::parse(const TsPayload& payload)
+{
+    parser_.parse(payload);
+}
+
+void StreamProbe::complete(const TsReader::Statistics& statistics)
+{
+    addReaderStatistics(statistics);
+    inputSize_ = readerStatistics_.bytes;
+}
+
+void StreamProbe::quickProbe(std::istream& input, size_t windows, size_t windowSize)
+{
+    using namespace std::placeholders;
+
+    // get input size, fall back to full probe if input is not seekable
+    input.seekg(0, std::ios::end);
+    const std::streamoff size = input.tellg();
+    input.seekg(0, std::ios::beg);
+    if (size < 0 || !input.good())
+    {
+        log_ << "Notice: StreamProbe, input is not seekable, reading it whole" << std::endl;
+        input.clear();
+        probe(input);
+        return;
+    }
+
+    quickProbe_ = true;
+    inputSize_ = static_cast<uint64_t>(size);
+
+    // read head of input till all streams are found
+    std::vector<uint8_t> buffer;
+    uint64_t headSize = 0;
+    {
+        TsReader reader(log_, std::bind(&PayloadParser::parse, std::ref(parser_), _1));
+        while (headSize < inputSize_ && headSize < quickProbeMaxHeadSize && !headComplete())
+        {
+            const size_t read = readBlock(input, buffer, quickProbeBlockSize);
+            if (!read)
+                break;
+            reader.push(buffer.data(), read);
+            headSize += read;
+        }
+        headComplete_ = headComplete();
+
+        // small input, just read the rest of it
+        const uint64_t rest = inputSize_ - headSize;
+        if (windows < 2 || rest <= windows * windowSize)
+        {
+            size_t read = 0;
+            while ((read = readBlock(input, buffer, quickProbeBlockSize)) > 0)
+                reader.push(buffer.data(), read);
+            addReaderStatistics(reader.statistics());
+            quickProbe_ = false;
+            return;
+        }
+        addReaderStatistics(reader.statistics());
+    }
+
+    if (!headComplete_)
+        log_ << "Warning: StreamProbe, not all streams are found in the head of input" << std::endl;
+
+    // sample windows with equal strides, the last one ends at the end of input
+    const uint64_t stride = (inputSize_ - headSize - windowSize) / (windows - 1);
+    for (size_t i = 0; i < windows; ++i)
+        sampleWindow(input, headSize + i * stride, windowSize);
+}
+
+void StreamProbe::report(std::ostream& output,
+                         const OutputNameGenerator& audioNameGenerator,
+                         const OutputNameGenerator& videoNameGenerator) const
+{
+    const double seconds = duration();
+    const uint64_t totalBitrate = bitrate(inputSize_, seconds);
+    const auto& streams = parser_.streams();
+    const auto& programs = parser_.programs();
+    const auto& parserStatistics = parser_.statistics();
+
+    // share of PID packets in total bitrate, the same as PID bitrate if the whole input is read
+    auto pidBitrate = [this, totalBitrate](uint64_t packets)
+    {
+        return readerStatistics_.packets ? totalBitrate * packets / readerStatistics_.packets : 0;
+    };
+
+    output << "{\n"
+           << "  \"bytes\": " << inputSize_ << ",\n"
+           << "  \"packets\": " << readerStatistics_.packets << ",\n"
+           << "  \"duration\": " << std::fixed << std::setprecision(3) << seconds << ",\n"
+           << "  \"bitrate\": " << totalBitrate << ",\n";
+
+    if (quickProbe_)
+    {
+        output << "  \"quickProbe\": {\n"
+               << "    \"sampledBytes\": " << readerStatistics_.bytes << ",\n"
+               << "    \"windows\": " << windows_ << ",\n"
+               << "    \"coverage\": " << std::setprecision(6) << double(readerStatistics_.bytes) / inputSize_ << ",\n"
+               << "    \"headComplete\": " << (headComplete_ ? "true" : "false") << ",\n"
+               << "    \"confidence\": " << std::setprecision(3) << confidence() << "\n"
+               << "  },\n";
+    }
+
+    output << "  \"pmtChanges\": " << parserStatistics.pmtChanges << ",\n"
+           << "  \"errors\": {\n"
+           << "    \"corruptedPackets\": " << readerStatistics_.corruptedPackets << ",\n"
+           << "    \"continuityErrors\": " << readerStatistics_.continuityErrors << ",\n"
+           << "    \"psiErrors\": " << parserStatistics.psiErrors << ",\n"
+           << "    \"pesErrors\": " << parserStatistics.pesErrors << "\n"
+           << "  },\n";
+
+    // programs, program 0 refers to network information table
+    output << "  \"programs\": [";
+    bool first = true;
+    for (const auto& program : programs)
+    {
+        if (program.first == 0)
+            continue;
+
+        output << (first ? "\n" : ",\n")
+               << "    {\n"
+               << "      \"number\": " << program.first << ",\n"
+               << "      \"pmtPid\": " << program.second.pmtPid << ",\n";
+        if (program.second.pmtDetected)
+            output << "      \"pmtVersion\": " << int(program.second.pmtVersion) << ",\n";
+        output << "      \"pids\": [";
+
+        bool firstPid = true;
+        for (const auto& stream : streams)
+        {
+            if (stream.second.program != program.first)
+                continue;
+            output << (firstPid ? "" : ", ") << stream.first;
+            firstPid = false;
+        }
+        output << "]\n"
+               << "    }";
+        first = false;
+    }
+    output << (first ? "],\n" : "\n  ],\n");
+
+    // every detected PID
+    output << "  \"pids\": [";
+    first = true;
+    for (const auto& pid : readerStatistics_.pids)
+    {
+        output << (first ? "\n" : ",\n")
+               << "    {\n"
+               << "      \"pid\": " << pid.first << ",\n"
+               << "      \"packets\": " << pid.second.packets << ",\n"
+               << "      \"bitrate\": " << pidBitrate(pid.second.packets) << ",\n"
+               << "      \"continuityErrors\": " << pid.second.continuityErrors << ",\n"
+               << "      \"pcrs\": " << pid.second.pcrs << ",\n";
+        first = false;
+
+        const auto stream = streams.find(pid.first);
+        if (stream == streams.end())
+        {
+            const bool isPmt = std::any_of(programs.begin(), programs.end(),
+                [&pid](const std::pair<const uint16_t, PayloadParser::ProgramInfo>& program)
+                {
+                    return program.first != 0 && program.second.pmtPid == pid.first;
+                });
+
+            const char* kind = "unknown";
+            if (pid.first == paTablePid)
+                kind = "pat";
+            else if (pid.first == nullPacketPid)
+                kind = "null";
+            else if (isPmt)
+                kind = "pmt";
+            output << "      \"type\": \"" << kind << "\"\n"
+                   << "    }";
+            continue;
+        }
+
+        const auto& info = stream->second;
+        output << "      \"type\": \"" << esTypeName(info.type) << "\",\n";
+        if (info.program)
+            output << "      \"program\": " << info.program << ",\n";
+        if (info.streamType)
+            output << "      \"streamType\": " << int(info.streamType) << ",\n";
+        if (!info.codec.empty())
+        {
+            output << "      \"codec\": ";
+            writeJsonString(output, info.codec);
+            output << ",\n";
+        }
+        if (!info.language.empty())
+        {
+            output << "      \"language\": ";
+            writeJsonString(output, info.language);
+            output << ",\n"
+                   << "      \"audioType\": " << int(info.audioType) << ",\n";
+        }
+
+        if (info.type != EsType::OTHER)
+        {
+            const auto& generator = info.type == EsType::AUDIO ? audioNameGenerator : videoNameGenerator;
+            const auto name = generator.name(info.seqNumber);
+            output << "      \"esNumber\": " << info.seqNumber << ",\n";
+            if (!name.empty())
+            {
+                output << "      \"output\": ";
+                writeJsonString(output, name);
+                output << ",\n";
+            }
+        }
+
+        const auto es = esStatistics_.find(pid.first);
+        output << "      \"esBytes\": " << (es != esStatistics_.end() ? es->second.bytes : 0) << "\n"
+               << "    }";
+    }
+    output << (first ? "]\n" : "\n  ]\n")
+           << "}" << std::endl;
+}
+
+void StreamProbe::onEsRawData(const EsRawData& rawData)
+{
+    auto& statistics = esStatistics_[rawData.pid];
+    statistics.bytes += rawData.size;
+
+    if (rawData.pts == noTimestamp)
+        return;
+
+    if (statistics.lastPts != noTimestamp)
+    {
+        // PTS may decrease because of frames reordering, so track both minimum and maximum
+        statistics.unwrappedPts += ptsDelta(statistics.lastPts, rawData.pts);
+        statistics.minPts = std::min(statistics.minPts, statistics.unwrappedPts);
+        statistics.maxPts = std::max(statistics.maxPts, statistics.unwrappedPts);
+    }
+    statistics.lastPts = rawData.pts;
+
+    if (!inWindow_)
+        return;
+
+    // PTS range of current sample window
+    const auto insertionResult = windowPts_.insert({ rawData.pid, { statistics.unwrappedPts, statistics.unwrappedPts } });
+    auto& range = insertionResult.first->second;
+    range.first = std::min(range.first, statistics.unwrappedPts);
+    range.second = std::max(range.second, statistics.unwrappedPts);
+}
+
+double StreamProbe::duration() const
+{
+    int64_t result = 0;
+    for (const auto& pair : esStatistics_)
+        result = std::max(result, pair.second.maxPts - pair.second.minPts);
+    return double(result) / ptsFrequency;
+}
+
+bool StreamProbe::headComplete() const
+{
+    const auto& programs = parser_.programs();
+    if (programs.empty())
+        return false;
+
+    for (const auto& program : programs)
+    {
+        if (program.first != 0 && !program.second.pmtDetected)
+            return false;
+    }
+
+    for (const auto& stream : parser_.streams())
+    {
+        if (stream.second.type != EsType::OTHER && !esStatistics_.count(stream.first))
+            return false;
+    }
+
+    return true;
+}
+
+void StreamProbe::sampleWindow(std::istream& input, uint64_t offset, size_t size)
+{
+    using namespace std::placeholders;
+
+    input.clear();
+    input.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+
+    std::vector<uint8_t> buffer;
+    const size_t read = readBlock(input, buffer, size);
+
+    // new reader for every window to resync and not to treat gaps as broken sequences
+    TsReader reader(log_, std::bind(&PayloadParser::parse, std::ref(parser_), _1));
+    const uint64_t packets = readerStatistics_.packets;
+
+    windowPts_.clear();
+    inWindow_ = true;
+    reader.push(buffer.data(), read);
+    inWindow_ = false;
+
+    addReaderStatistics(reader.statistics());
+    ++windows_;
+
+    // mux bitrate within window
+    int64_t span = 0;
+    for (const auto& pair : windowPts_)
+        span = std::max(span, pair.second.second - pair.second.first);
+    if (span > 0)
+        windowBitrates_.push_back((readerStatistics_.packets - packets) * tsPacketSize * 8 * double(ptsFrequency) / span);
+}
+
+void StreamProbe::addReaderStatistics(const TsReader::Statistics& statistics)
+{
+    readerStatistics_.bytes += statistics.bytes;
+    readerStatistics_.packets += statistics.packets;
+    readerStatistics_.corruptedPackets += statistics.corruptedPackets;
+    readerStatistics_.continuityErrors += statistics.continuityErrors;
+    for (const auto& pair : statistics.pids)
+    {
+        auto& pid = readerStatistics_.pids[pair.first];
+        pid.packets += pair.second.packets;
+        pid.continuityErrors += pair.second.continuityErrors;
+        pid.pcrs += pair.second.pcrs;
+    }
+}
+
+double StreamProbe::confidence() const
+{
+    if (!quickProbe_)
+        return 1.0;
+
+    // relative standard error of mean window bitrate
+    double result = 0.0;
+    const size_t n = windowBitrates_.size();
+    if (n > 1)
+    {
+        double mean = 0.0;
+        for (const double value : windowBitrates_)
+            mean += value;
+        mean /= n;
+
+        double variance = 0.0;
+        for (const double value : windowBitrates_)
+            variance += (value - mean) * (value - mean);
+        variance /= n - 1;
+
+        result = std::max(0.0, 1.0 - std::sqrt(variance / n) / mean);
+    }
+
+    // streams may be missed
+    if (!headComplete_)
+        result /= 2;
+
+    return result;
+}
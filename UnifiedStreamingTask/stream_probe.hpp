@@ -0,0 +1,130 @@
+#pragma once
+
+#include "message_types.hpp"
+#include "output_name_generator.hpp"
+#include "payload_parser.hpp"
+#include "ts_reader.hpp"
+
+#include <iostream>
+#include <map>
+#include <vector>
+
+
+/// @class StreamProbe.
+/// @brief Collects inventory of programs and streams of TS input without writing any outputs.
+class StreamProbe
+{
+public:
+    /// @brief Constructor.
+    /// @param[out] log - Stream for log messages.
+    /// @throws Error.
+    StreamProbe(std::ostream& log);
+
+    /// @brief Read whole TS input and collect inventory.
+    /// @param[in] input - TS input.
+    /// @throws Error.
+    void probe(std::istream& input);
+
+    /// @brief Collect inventory from payload of input read by caller.
+    /// @details Used when input is shared with other consumers, see complete().
+    /// @param[in] payload - TS payload.
+    void parse(const TsPayload& payload);
+
+    /// @brief Complete inventory collected by parse().
+    /// @param[in] statistics - Statistics of reader, which produced payloads.
+    void complete(const TsReader::Statistics& statistics);
+
+    /// @brief Estimate inventory by reading head of TS input and sampling windows across the rest of it.
+    /// @details Head is read until PAT, all PMTs and first PES of every ES are found. If input is not
+    ///          seekable or is too small for sampling, the whole input is read.
+    /// @param[in] input - TS input.
+    /// @param[in] windows - Number of sampled windows.
+    /// @param[in] windowSize - Size of one sampled window.
+    /// @throws Error.
+    void quickProbe(std::istream& input, size_t windows = 32, size_t windowSize = 188 * 5000);
+
+    /// @brief Write collected inventory in JSON format.
+    /// @param[out] output - Stream for the report.
+    /// @param[in] audioNameGenerator - Generator for audio output file names.
+    /// @param[in] videoNameGenerator - Generator for video output file names.
+    void report(std::ostream& output,
+                const OutputNameGenerator& audioNameGenerator,
+                const OutputNameGenerator& videoNameGenerator) const;
+
+private:
+    /// @brief Collect statistics of ES raw data.
+    /// @param[in] rawData - ES raw data.
+    void onEsRawData(const EsRawData& rawData);
+
+    /// @brief Get duration of the input in seconds, 0 if unknown.
+    double duration() const;
+
+    /// @brief Check if PAT, all PMTs and first PES of every ES are found.
+    bool headComplete() const;
+
+    /// @brief Read sample window and add its statistics to collected ones.
+    /// @param[in] input - TS input.
+    /// @param[in] offset - Window offset within input.
+    /// @param[in] size - Window size.
+    /// @throws Error.
+    void sampleWindow(std::istream& input, uint64_t offset, size_t size);
+
+    /// @brief Add statistics of TS reader to collected ones.
+    void addReaderStatistics(const TsReader::Statistics& statistics);
+
+    /// @brief Estimate confidence of quick probe, from 0 to 1.
+    double confidence() const;
+
+private:
+    /// @brief Log output stream.
+    std::ostream& log_;
+
+    /// @brief Parser of TS payloads.
+    PayloadParser parser_;
+
+    /// @brief Statistics of read TS input.
+    TsReader::Statistics readerStatistics_;
+
+    /// @brief Size of the whole input, may be larger than read bytes in quick probe.
+    uint64_t inputSize_ = 0;
+
+    /// @brief Set if inventory is estimated by quick probe.
+    bool quickProbe_ = false;
+
+    /// @brief Set if quick probe found all PSI and ES in the head of input.
+    bool headComplete_ = false;
+
+    /// @brief Number of sampled windows.
+    size_t windows_ = 0;
+
+    /// @brief Bitrate estimates of every sampled window.
+    std::vector<double> windowBitrates_;
+
+    /// @brief Minimum and maximum unwrapped PTS within current window by PID.
+    std::map<uint16_t, std::pair<int64_t, int64_t>> windowPts_;
+
+    /// @brief Set while sample window is read.
+    bool inWindow_ = false;
+
+    /// @brief Statistics of one elementary stream.
+    struct EsStatistics
+    {
+        /// @brief Number of ES raw data bytes.
+        uint64_t bytes = 0;
+
+        /// @brief Last seen PTS as is.
+        int64_t lastPts = noTimestamp;
+
+        /// @brief Last seen PTS unwrapped relatively to the first one.
+        int64_t unwrappedPts = 0;
+
+        /// @brief Minimum unwrapped PTS.
+        int64_t minPts = 0;
+
+        /// @brief Maximum unwrapped PTS.
+        int64_t maxPts = 0;
+    };
+
+    /// @brief Statistics of detected elementary streams by PID.
+    std::map<uint16_t, EsStatistics> esStatistics_;
+};
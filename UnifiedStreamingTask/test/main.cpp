@@ -7,6 +7,29 @@ extern uint16_t testProgramOptions();
 extern uint16_t testTsReader();
 extern uint16_t testPayloadParser();
 extern uint16_t testOutputWriter();
+extern uint16_t testStreamProbe();
+extern uint16_t testIndexWriter();
+extern uint16_t testTimeRangeFilter();
+extern uint16_t testPtsSeeker();
+extern uint16_t testTimestampWriter();
+extern uint16_t testStartCode();
+extern uint16_t testEsFramer();
+extern uint16_t testKeyframeFilter();
+extern uint16_t testFrameWriter();
+extern uint16_t testUdpReceiver();
+extern uint16_t testFileWatcher();
+extern uint16_t testAsyncFileOpener();
+extern uint16_t testPidFilter();
+extern uint16_t testTsWriter();
+extern uint16_t testSplitJob();
+extern uint16_t testTsHeaders();
+extern uint16_t testCpuFeatures();
+extern uint16_t testEsVerifier();
+extern uint16_t testCrc32();
+extern uint16_t testTracer();
+extern uint16_t testPerfCounters();
+extern uint16_t testLatencyHistogram();
+extern uint16_t testLibTsSplitter();
 
 int main()
 {
@@ -18,6 +41,29 @@ int main()
     failures += testTsReader();
     failures += testPayloadParser();
     failures += testOutputWriter();
+    failures += testStreamProbe();
+    failures += testIndexWriter();
+    failures += testTimeRangeFilter();
+    failures += testPtsSeeker();
+    failures += testTimestampWriter();
+    failures += testStartCode();
+    failures += testEsFramer();
+    failures += testKeyframeFilter();
+    failures += testFrameWriter();
+    failures += testUdpReceiver();
+    failures += testFileWatcher();
+    failures += testAsyncFileOpener();
+    failures += testPidFilter();
+    failures += testTsWriter();
+    failures += testSplitJob();
+    failures += testTsHeaders();
+    failures += testCpuFeatures();
+    failures += testEsVerifier();
+    failures += testCrc32();
+    failures += testTracer();
+    failures += testPerfCounters();
+    failures += testLatencyHistogram();
+    failures += testLibTsSplitter();
 
     if (failures == 0)
     {
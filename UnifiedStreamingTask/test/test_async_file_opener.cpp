@@ -0,0 +1,122 @@
+#include "../async_file_opener.hpp"
+#include "../error.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    /// @brief Read whole file.
+    /// @returns File content or "<missing>" if there is no file.
+    std::string readFile(const std::string& name)
+    {
+        std::ifstream file(name, std::ifstream::in | std::ifstream::binary);
+        if (!file.good())
+            return "<missing>";
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    /// @brief Run one AsyncFileOpener unit test.
+    /// @details Every file is taken, written with its own name and handed over for closing.
+    /// @param[in] prepared - Files to prepare before taking.
+    /// @param[in] taken - Files to take and write.
+    /// @param[in] expectedError - Expected error code.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 const std::vector<std::string>& prepared,
+                 const std::vector<std::string>& taken,
+                 uint16_t expectedError)
+    {
+        std::cout << "Running AsyncFileOpener." << testName << " ... ";
+
+        bool result = true;
+        Error error{ Error::OK, "" };
+        std::ostringstream log;
+        std::vector<std::string> closed;
+
+        try
+        {
+            AsyncFileOpener opener;
+            for (const auto& file : prepared)
+                opener.prepare(file, 1024 * 1024);
+            for (const auto& file : taken)
+            {
+                auto stream = opener.take(file);
+                *stream << file;
+                opener.close(file, std::move(stream), file.size());
+            }
+            opener.finish();
+            closed = opener.closedFiles();
+        }
+        catch (const Error& err)
+        {
+            error = err;
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        if (error.code() != expectedError)
+        {
+            result = false;
+            if (expectedError == Error::OK)
+                log << "Unexpected exception caught: " << error.message() << std::endl;
+            else
+                log << "No expected exception caught" << std::endl;
+        }
+
+        if (expectedError == Error::OK && closed != taken)
+        {
+            result = false;
+            log << "Got " << closed.size() << " closed files instead of " << taken.size() << std::endl;
+        }
+        for (const auto& file : taken)
+        {
+            if (expectedError == Error::OK && readFile(file) != file)
+            {
+                result = false;
+                log << "File '" << file << "' has wrong content" << std::endl;
+            }
+            std::remove(file.c_str());
+        }
+
+        // prepared but not taken files are removed
+        for (const auto& file : prepared)
+        {
+            if (readFile(file) != "<missing>")
+            {
+                result = false;
+                log << "File '" << file << "' is not removed" << std::endl;
+                std::remove(file.c_str());
+            }
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+}
+
+/// @brief Run all AsyncFileOpener unit tests.
+/// @returns Number of failed tests.
+uint16_t testAsyncFileOpener()
+{
+    uint16_t failures = 0;
+
+    failures += 1 - runTest("take_Prepared_OK", { "opener_1.tmp", "opener_2.tmp" }, { "opener_1.tmp", "opener_2.tmp" }, Error::OK);
+    failures += 1 - runTest("take_NotPrepared_OK", {}, { "opener_1.tmp" }, Error::OK);
+    failures += 1 - runTest("dtor_NotTaken_Removed", { "opener_1.tmp", "opener_2.tmp" }, { "opener_1.tmp" }, Error::OK);
+    failures += 1 - runTest("take_WrongPath_Exception", { "no_such_dir/opener_1.tmp" }, { "no_such_dir/opener_1.tmp" },
+                            Error::CORRUPTED_OUTPUT);
+
+    return failures;
+}
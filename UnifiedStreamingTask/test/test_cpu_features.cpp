@@ -0,0 +1,68 @@
+#include "../cpu_features.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+
+namespace
+{
+    /// @brief Run one CPU features unit test.
+    /// @param[in] features - Features of CPU.
+    /// @param[in] expected - Expected level of kernels, if it's built.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName, const CpuFeatures& features, SimdLevel expected)
+    {
+        std::cout << "Running CpuFeatures." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+
+        // kernels of the highest level may be not built for target architecture
+        const SimdLevel level = supportedSimdLevel(features);
+        const SimdLevel built = kernelsFor(expected).level;
+        if (level != built)
+        {
+            result = false;
+            log << "Got level " << simdLevelName(level) << " instead of " << simdLevelName(built) << std::endl;
+        }
+        if (kernelsFor(level).level != level || !kernelsFor(level).findStartCode || !kernelsFor(level).decodeTsHeaders)
+        {
+            result = false;
+            log << "No kernels of level " << simdLevelName(level) << std::endl;
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+}
+
+/// @brief Run all CPU features unit tests.
+/// @returns Number of failed tests.
+uint16_t testCpuFeatures()
+{
+    uint16_t failures = 0;
+
+    CpuFeatures features;
+    failures += 1 - runTest("supportedSimdLevel_NoFeatures_Scalar", features, SimdLevel::SCALAR);
+
+    features.sse2 = true;
+    features.sse42 = true;
+    failures += 1 - runTest("supportedSimdLevel_Sse42_Sse2", features, SimdLevel::SSE2);
+
+    features.pclmul = true;
+    features.avx2 = true;
+    failures += 1 - runTest("supportedSimdLevel_Avx2_Avx2", features, SimdLevel::AVX2);
+
+    // chosen kernels are supported by CPU the tests run on
+    {
+        std::cout << "Running CpuFeatures.kernels_Chosen_Supported ... ";
+        const bool result = kernels().level <= supportedSimdLevel(detectCpuFeatures());
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        failures += 1 - result;
+    }
+
+    return failures;
+}
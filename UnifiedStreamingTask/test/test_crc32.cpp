@@ -0,0 +1,94 @@
+#include "../cpu_features.hpp"
+#include "../crc32.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    /// @brief Check value of CRC algorithms, CRC of this string.
+    const std::string checkString = "123456789";
+
+    /// @brief Run one CRC unit test.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName, uint32_t crc, uint32_t expected)
+    {
+        std::cout << "Running Crc32." << testName << " ... ";
+        const bool result = crc == expected;
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << "Got CRC " << std::hex << crc << " instead of " << expected << std::dec << std::endl;
+        return result;
+    }
+}
+
+/// @brief Run all CRC unit tests.
+/// @returns Number of failed tests.
+uint16_t testCrc32()
+{
+    uint16_t failures = 0;
+    const auto* check = reinterpret_cast<const uint8_t*>(checkString.data());
+
+    failures += 1 - runTest("crc32_CheckValue_OK", crc32(check, checkString.size()), 0x0376E6E7);
+    failures += 1 - runTest("crc32_Empty_OK", crc32(check, 0), 0xFFFFFFFF);
+    failures += 1 - runTest("crc32c_CheckValue_OK", crc32c(check, checkString.size()), 0xE3069283);
+    failures += 1 - runTest("crc32c_Empty_OK", crc32c(check, 0), 0);
+
+    // CRC of concatenated data is calculated incrementally
+    failures += 1 - runTest("crc32c_Incremental_OK", crc32c(check + 4, checkString.size() - 4, crc32c(check, 4)), 0xE3069283);
+
+    // kernels of all levels supported by CPU give the same CRC for all sizes and alignments
+    std::vector<uint8_t> data(1000);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i * 131 + (i >> 3));
+
+    const CpuFeatures features = detectCpuFeatures();
+    const SimdLevel supported = supportedSimdLevel(features);
+    for (SimdLevel level : { SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2 })
+    {
+        if (level > supported)
+            break;
+
+        const Kernels kernels = kernelsFor(level, features.sse42);
+        bool same = true;
+        for (size_t offset = 0; offset < 8; ++offset)
+        {
+            for (size_t size = 0; offset + size <= data.size(); size += 37)
+                same = same && kernels.crc32c(data.data() + offset, size, 0x12345678) == crc32cScalar(data.data() + offset, size, 0x12345678);
+        }
+        failures += 1 - runTest(std::string("crc32c_") + simdLevelName(level) + "Kernel_SameAsScalar",
+                                kernels.crc32c(check, checkString.size(), 0), same ? 0xE3069283 : 0);
+    }
+
+    // CRC instruction is used at any level of other kernels, if CPU supports SSE4.2
+    const Kernels scalar = kernelsFor(SimdLevel::SCALAR, features.sse42);
+#ifdef SIMD_AVX2
+    const bool hardwareExpected = features.sse42;
+#else
+    const bool hardwareExpected = false;
+#endif
+    failures += 1 - runTest("kernelsFor_ScalarLevel_HardwareCrcBySse42", scalar.hardwareCrc == hardwareExpected, true);
+
+    // carry-less multiplication kernel, if CPU supports it, gives the same CRC-32/MPEG-2 for all sizes and alignments
+#ifdef SIMD_AVX2
+    const bool carrylessSupported = features.pclmul && features.sse42;
+#else
+    const bool carrylessSupported = false;
+#endif
+    const Kernels carryless = kernelsFor(SimdLevel::SCALAR, false, carrylessSupported);
+    failures += 1 - runTest("kernelsFor_ScalarLevel_CarrylessCrcByPclmul", carryless.carrylessCrc == carrylessSupported, true);
+    {
+        bool same = true;
+        for (size_t offset = 0; offset < 16; ++offset)
+        {
+            for (size_t size = 0; offset + size <= data.size(); size += 13)
+                same = same && carryless.crc32(data.data() + offset, size) == crc32Scalar(data.data() + offset, size);
+        }
+        failures += 1 - runTest("crc32_CarrylessKernel_SameAsScalar", carryless.crc32(check, checkString.size()),
+                                same ? 0x0376E6E7 : 0);
+    }
+
+    return failures;
+}
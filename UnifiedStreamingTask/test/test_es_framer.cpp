@@ -0,0 +1,255 @@
+#include "../error.hpp"
+#include "../es_framer.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace
+{
+    const uint16_t esPid = 0x100;
+
+    /// @brief PTS of the first PES packet.
+    const int64_t firstPts = 1000;
+
+    /// @brief Sizes of raw data chunks ES is split into, to split start codes and headers in all ways.
+    const std::vector<size_t> chunkSizes{ 1, 2, 3, 4, 5, 7, 16, 184, 100000 };
+
+    /// @brief Expected result for EsFramer test.
+    struct ExpectedResult
+    {
+        /// @brief Offsets of access units.
+        std::vector<uint64_t> offsets;
+
+        /// @brief Keyframe flags of access units.
+        std::vector<bool> keyframes;
+
+        /// @brief Number of ADTS sync errors.
+        uint64_t syncErrors;
+
+        /// @brief Offsets and sizes of parameter sets of access units, not checked if empty.
+        std::vector<std::pair<uint64_t, uint64_t>> parameterSets;
+    };
+
+    /// @brief Make H.264 NAL unit with 4-byte start code.
+    /// @param[in] type - NAL unit type.
+    /// @param[in] firstSlice - If set, first_mb_in_slice is 0.
+    /// @param[in] size - Size of NAL unit payload.
+    std::string h264Nal(uint8_t type, bool firstSlice, size_t size)
+    {
+        return std::string("\x00\x00\x00\x01", 4) + char(0x60 | type) + char(firstSlice ? 0x88 : 0x48) + std::string(size, '\xAB');
+    }
+
+    /// @brief Make HEVC NAL unit with 3-byte start code.
+    /// @param[in] type - NAL unit type.
+    /// @param[in] firstSlice - Value of first_slice_segment_in_pic_flag.
+    /// @param[in] size - Size of NAL unit payload.
+    std::string hevcNal(uint8_t type, bool firstSlice, size_t size)
+    {
+        return std::string("\x00\x00\x01", 3) + char(type << 1) + char(0x01) + char(firstSlice ? 0xC0 : 0x40) + std::string(size, '\xAB');
+    }
+
+    /// @brief Make ADTS frame.
+    /// @param[in] size - Frame size including 7-byte header.
+    std::string adtsFrame(size_t size)
+    {
+        std::string frame(size, '\x21');
+        frame[0] = '\xFF';
+        frame[1] = '\xF1';
+        frame[2] = '\x50';
+        frame[3] = char(0x80 | ((size >> 11) & 0x03));
+        frame[4] = char((size >> 3) & 0xFF);
+        frame[5] = char(((size & 0x07) << 5) | 0x1F);
+        frame[6] = '\xFC';
+        return frame;
+    }
+
+    /// @brief Run one EsFramer unit test.
+    /// @details ES is passed as one PES packet with PTS split into chunks of all sizes from chunkSizes,
+    ///          every split should give the same access units.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 uint8_t streamType,
+                 const std::string& es,
+                 const ExpectedResult& expected)
+    {
+        std::cout << "Running EsFramer." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+
+        const EsType type = streamType == 0x0F ? EsType::AUDIO : EsType::VIDEO;
+        std::map<uint16_t, PayloadParser::StreamInfo> streams;
+        if (streamType)
+            streams[esPid] = PayloadParser::StreamInfo{ type, 1, 1, streamType };
+
+        for (size_t chunkSize : chunkSizes)
+        {
+            std::vector<EsFramer::AccessUnit> accessUnits;
+            std::vector<EsFramer::AccessUnit> pictures;
+            try
+            {
+                EsFramer framer(log, streams, [&accessUnits](const EsFramer::AccessUnit& accessUnit)
+                {
+                    accessUnits.push_back(accessUnit);
+                },
+                [&pictures](const EsFramer::AccessUnit& accessUnit)
+                {
+                    pictures.push_back(accessUnit);
+                });
+
+                for (size_t offset = 0; offset < es.size(); offset += chunkSize)
+                {
+                    const size_t size = std::min(chunkSize, es.size() - offset);
+                    const EsRawData rawData{ reinterpret_cast<const uint8_t*>(es.data()) + offset, static_cast<uint16_t>(size),
+                                             type, 1, esPid, offset == 0 ? firstPts : noTimestamp, offset == 0, 0, noTimestamp, false };
+                    framer.write(rawData);
+                }
+                framer.flush();
+
+                const auto it = framer.statistics().find(esPid);
+                const uint64_t syncErrors = it != framer.statistics().end() ? it->second.syncErrors : 0;
+                if (syncErrors != expected.syncErrors)
+                {
+                    result = false;
+                    log << "Got " << syncErrors << " sync errors instead of " << expected.syncErrors << std::endl;
+                }
+            }
+            catch (const std::exception& e)
+            {
+                result = false;
+                log << "Unexpected exception caught: " << e.what() << std::endl;
+            }
+
+            std::vector<uint64_t> offsets;
+            std::vector<bool> keyframes;
+            std::vector<std::pair<uint64_t, uint64_t>> parameterSets;
+            uint64_t end = expected.offsets.empty() ? 0 : expected.offsets.front();
+            for (size_t i = 0; i < accessUnits.size(); ++i)
+            {
+                const auto& accessUnit = accessUnits[i];
+                offsets.push_back(accessUnit.esOffset);
+                keyframes.push_back(accessUnit.keyframe);
+                parameterSets.push_back({ accessUnit.parameterSetsOffset, accessUnit.parameterSetsSize });
+                if (accessUnit.esOffset != end || accessUnit.pid != esPid || accessUnit.pts != (i == 0 ? firstPts : noTimestamp))
+                {
+                    result = false;
+                    log << "Wrong access unit " << i << " with chunk size " << chunkSize << std::endl;
+                }
+                end = accessUnit.esOffset + accessUnit.size;
+            }
+            if (!accessUnits.empty() && end != es.size())
+            {
+                result = false;
+                log << "The last access unit ends at " << end << " with chunk size " << chunkSize << std::endl;
+            }
+
+            // H.264 or HEVC access unit with picture is reported at it with the same flags
+            bool picturesMatch = pictures.empty() == (type != EsType::VIDEO || accessUnits.empty());
+            for (const auto& picture : pictures)
+            {
+                const auto accessUnit = std::find_if(accessUnits.begin(), accessUnits.end(), [&picture](const EsFramer::AccessUnit& unit)
+                {
+                    return unit.esOffset == picture.esOffset;
+                });
+                picturesMatch = picturesMatch && accessUnit != accessUnits.end() && picture.size < accessUnit->size &&
+                                picture.keyframe == accessUnit->keyframe &&
+                                picture.parameterSetsOffset == accessUnit->parameterSetsOffset &&
+                                picture.parameterSetsSize == accessUnit->parameterSetsSize;
+            }
+            if (!picturesMatch)
+            {
+                result = false;
+                log << "Wrong pictures with chunk size " << chunkSize << std::endl;
+            }
+
+            if (!expected.parameterSets.empty() && parameterSets != expected.parameterSets)
+            {
+                result = false;
+                log << "Wrong parameter sets with chunk size " << chunkSize << std::endl;
+            }
+
+            if (offsets != expected.offsets || keyframes != expected.keyframes)
+            {
+                result = false;
+                log << "Got " << offsets.size() << " access units instead of " << expected.offsets.size()
+                    << " with chunk size " << chunkSize << std::endl;
+            }
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+}
+
+/// @brief Run all EsFramer unit tests.
+/// @returns Number of failed tests.
+uint16_t testEsFramer()
+{
+    uint16_t failures = 0;
+
+    // H.264 with access unit delimiters
+    {
+        const std::string delimiter = h264Nal(9, false, 1);
+        const std::string parameterSets = h264Nal(7, false, 10) + h264Nal(8, false, 4);
+        const std::string au1 = delimiter + parameterSets + h264Nal(5, true, 300);
+        const std::string au2 = delimiter + h264Nal(1, true, 200);
+        const std::string au3 = delimiter + parameterSets;
+        ExpectedResult expected{ { 0, au1.size(), au1.size() + au2.size() }, { true, false, false }, 0,
+                                 { { delimiter.size(), parameterSets.size() }, { 0, 0 },
+                                   { au1.size() + au2.size() + delimiter.size(), parameterSets.size() } } };
+        failures += 1 - runTest("write_H264WithDelimiters_OK", 0x1B, au1 + au2 + au3, expected);
+    }
+
+    // H.264 without delimiters, pictures with several slices
+    {
+        const std::string au1 = h264Nal(7, false, 10) + h264Nal(8, false, 4) + h264Nal(6, false, 20) +
+                                h264Nal(5, true, 100) + h264Nal(5, false, 100);
+        const std::string au2 = h264Nal(1, true, 80) + h264Nal(1, false, 80);
+        const std::string au3 = h264Nal(6, false, 20) + h264Nal(1, true, 80);
+        ExpectedResult expected{ { 0, au1.size(), au1.size() + au2.size() }, { true, false, false }, 0 };
+        failures += 1 - runTest("write_H264MultipleSlices_OK", 0x1B, au1 + au2 + au3, expected);
+    }
+
+    // HEVC with parameter sets and IRAP picture
+    {
+        const std::string au1 = hevcNal(35, false, 1) + hevcNal(32, false, 20) + hevcNal(33, false, 30) +
+                                hevcNal(34, false, 5) + hevcNal(19, true, 300) + hevcNal(19, false, 100);
+        const std::string au2 = hevcNal(1, true, 200);
+        const std::string au3 = hevcNal(39, false, 10) + hevcNal(21, true, 250);
+        ExpectedResult expected{ { 0, au1.size(), au1.size() + au2.size() }, { true, false, true }, 0 };
+        failures += 1 - runTest("write_Hevc_OK", 0x24, au1 + au2 + au3, expected);
+    }
+
+    // ADTS frames
+    {
+        const std::string frame1 = adtsFrame(200);
+        const std::string frame2 = adtsFrame(7);
+        const std::string frame3 = adtsFrame(371);
+        ExpectedResult expected{ { 0, frame1.size(), frame1.size() + frame2.size() }, { true, true, true }, 0 };
+        failures += 1 - runTest("write_Adts_OK", 0x0F, frame1 + frame2 + frame3, expected);
+    }
+
+    // ADTS sync lost and found again, garbage belongs to previous frame
+    {
+        const std::string frame1 = adtsFrame(200);
+        const std::string garbage(50, '\x11');
+        const std::string frame2 = adtsFrame(100);
+        ExpectedResult expected{ { 0, frame1.size() + garbage.size() }, { true, true }, 1 };
+        failures += 1 - runTest("write_AdtsLostSync_ErrorCounted", 0x0F, frame1 + garbage + frame2, expected);
+    }
+
+    // ES without PMT is not framed
+    {
+        const std::string es = h264Nal(9, false, 1) + h264Nal(5, true, 300);
+        failures += 1 - runTest("write_NoPmt_NotFramed", 0, es, ExpectedResult{ {}, {}, 0 });
+    }
+
+    return failures;
+}
@@ -0,0 +1,298 @@
+#include "../es_verifier.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    /// @brief Size of blocks files are read by verifier.
+    const size_t blockSize = 1024 * 1024;
+
+    /// @brief Expected result for EsVerifier test.
+    struct ExpectedResult
+    {
+        /// @brief Codec the file is verified as.
+        EsVerifier::Codec codec;
+
+        /// @brief Number of frames or NAL units.
+        uint64_t units;
+
+        /// @brief Number of errors.
+        uint64_t errors;
+
+        /// @brief Offset of the first error, if any.
+        uint64_t firstErrorOffset;
+
+        /// @brief Number of slices before parameter sets.
+        uint64_t slicesBeforeParameterSets;
+    };
+
+    /// @brief Make NAL unit with 3-byte start code.
+    /// @param[in] header - NAL unit header, 1 byte for H.264 and 2 bytes for HEVC.
+    /// @param[in] size - Size of NAL unit payload.
+    std::string nal(const std::string& header, size_t size)
+    {
+        return std::string("\x00\x00\x01", 3) + header + std::string(size, '\xAB');
+    }
+
+    /// @brief Make H.264 NAL unit with nal_ref_idc 3.
+    std::string h264Nal(uint8_t type, size_t size)
+    {
+        return nal(std::string(1, char(0x60 | type)), size);
+    }
+
+    /// @brief Make HEVC NAL unit with temporal id 0.
+    std::string hevcNal(uint8_t type, size_t size)
+    {
+        return nal(std::string{ char(type << 1), char(0x01) }, size);
+    }
+
+    /// @brief Make ADTS frame.
+    /// @param[in] size - Frame size including 7-byte header.
+    std::string adtsFrame(size_t size)
+    {
+        std::string frame(size, '\x21');
+        frame[0] = '\xFF';
+        frame[1] = '\xF1';
+        frame[2] = '\x50';
+        frame[3] = char(0x80 | ((size >> 11) & 0x03));
+        frame[4] = char((size >> 3) & 0xFF);
+        frame[5] = char(((size & 0x07) << 5) | 0x1F);
+        frame[6] = '\xFC';
+        return frame;
+    }
+
+    /// @brief Make AC-3 sync frame of 48 kHz.
+    /// @param[in] frmsizecod - Frame size code.
+    std::string ac3Frame(uint8_t frmsizecod)
+    {
+        const size_t bitrates[] = { 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512, 576, 640 };
+        std::string frame(frmsizecod < 38 ? bitrates[frmsizecod / 2] * 4 : 64, '\x33');
+        frame[0] = '\x0B';
+        frame[1] = '\x77';
+        frame[4] = char(frmsizecod);
+        frame[5] = char(8 << 3);
+        return frame;
+    }
+
+    /// @brief Make E-AC-3 sync frame.
+    /// @param[in] words - Frame size in 16-bit words.
+    std::string eac3Frame(size_t words)
+    {
+        std::string frame(words * 2, '\x33');
+        frame[0] = '\x0B';
+        frame[1] = '\x77';
+        frame[2] = char(((words - 1) >> 8) & 0x07);
+        frame[3] = char((words - 1) & 0xFF);
+        frame[4] = '\x3F';
+        frame[5] = char(16 << 3);
+        return frame;
+    }
+
+    /// @brief Write file.
+    void writeFile(const std::string& fileName, const std::string& content)
+    {
+        std::ofstream file(fileName, std::ofstream::out | std::ofstream::binary);
+        file << content;
+    }
+
+    /// @brief Run one EsVerifier unit test.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 EsVerifier::Codec codec,
+                 const std::string& content,
+                 const ExpectedResult& expected)
+    {
+        std::cout << "Running EsVerifier." << testName << " ... ";
+
+        const std::string fileName = "es_verifier_test.out";
+        writeFile(fileName, content);
+        const auto result = EsVerifier::verify(fileName, codec);
+        std::remove(fileName.c_str());
+
+        const bool passed = result.codec == expected.codec && result.bytes == content.size() &&
+                            result.units == expected.units && result.errors == expected.errors &&
+                            (!expected.errors || result.firstErrorOffset == expected.firstErrorOffset) &&
+                            result.slicesBeforeParameterSets == expected.slicesBeforeParameterSets;
+
+        std::cout << (passed ? "OK" : "FAIL") << std::endl;
+        if (!passed)
+        {
+            std::cout << "Got codec " << EsVerifier::codecName(result.codec) << ", " << result.units << " units, "
+                      << result.errors << " errors";
+            if (result.errors)
+                std::cout << ", the first '" << result.firstError << "' at " << result.firstErrorOffset;
+            std::cout << ", " << result.slicesBeforeParameterSets << " slices before parameter sets" << std::endl;
+        }
+        return passed;
+    }
+
+    /// @brief Run EsVerifier unit test of several files verified in parallel.
+    /// @returns true if test passed, false otherwise.
+    bool runParallelTest(const std::string& testName)
+    {
+        std::cout << "Running EsVerifier." << testName << " ... ";
+
+        // every 3rd file has broken header of the 5th frame
+        const size_t files = 10;
+        std::ostringstream log;
+        EsVerifier verifier(log, 4);
+        for (size_t i = 0; i < files; ++i)
+        {
+            const std::string fileName = "es_verifier_test_" + std::to_string(i) + ".out";
+            std::string content;
+            for (size_t frame = 0; frame < 100 + i; ++frame)
+                content += adtsFrame(100 + frame);
+            if (i % 3 == 0)
+                content[406] = '\x00';
+            writeFile(fileName, content);
+            verifier.add(fileName, i % 2 ? EsVerifier::Codec::ADTS : EsVerifier::Codec::UNKNOWN);
+        }
+        verifier.add("es_verifier_missing.out", EsVerifier::Codec::H264);
+        verifier.verifyAll();
+
+        bool passed = verifier.results().size() == files + 1 && !verifier.passed();
+        for (size_t i = 0; passed && i < files; ++i)
+        {
+            const auto& result = verifier.results()[i];
+            passed = result.file == "es_verifier_test_" + std::to_string(i) + ".out" &&
+                     result.codec == EsVerifier::Codec::ADTS && (result.errors != 0) == (i % 3 == 0);
+            std::remove(result.file.c_str());
+        }
+        passed = passed && verifier.results().back().errors == 1;
+
+        std::ostringstream report;
+        verifier.report(report);
+        passed = passed && report.str().find("\"failedFiles\": 5") != std::string::npos &&
+                 report.str().find("\"firstError\": \"failed to open file\"") != std::string::npos;
+
+        std::cout << (passed ? "OK" : "FAIL") << std::endl;
+        if (!passed)
+            std::cout << report.str() << log.str();
+        return passed;
+    }
+}
+
+/// @brief Run all EsVerifier unit tests.
+/// @returns Number of failed tests.
+uint16_t testEsVerifier()
+{
+    using Codec = EsVerifier::Codec;
+    uint16_t failures = 0;
+
+    // ADTS frames longer than one block, header of one frame is split between blocks
+    {
+        std::string es = adtsFrame(4093);
+        for (size_t i = 0; i < 300; ++i)
+            es += adtsFrame(4096);
+        failures += 1 - runTest("verify_Adts_OK", Codec::ADTS, es, ExpectedResult{ Codec::ADTS, 301, 0, 0, 0 });
+    }
+
+    // ADTS sync lost and found again, lost once
+    {
+        const std::string es = adtsFrame(200) + std::string(50, '\x11') + adtsFrame(100) + adtsFrame(100);
+        failures += 1 - runTest("verify_AdtsLostSync_Error", Codec::ADTS, es, ExpectedResult{ Codec::ADTS, 3, 1, 200, 0 });
+    }
+
+    // the last ADTS frame is truncated
+    {
+        const std::string es = adtsFrame(200) + adtsFrame(200).substr(0, 100);
+        failures += 1 - runTest("verify_AdtsTruncated_Error", Codec::ADTS, es, ExpectedResult{ Codec::ADTS, 1, 1, 200, 0 });
+    }
+
+    // AC-3 and E-AC-3 frames
+    {
+        const std::string es = ac3Frame(20) + ac3Frame(21) + ac3Frame(37) + eac3Frame(768) + eac3Frame(100);
+        failures += 1 - runTest("verify_Ac3_OK", Codec::AC3, es, ExpectedResult{ Codec::AC3, 5, 0, 0, 0 });
+    }
+
+    // AC-3 frame with reserved frame size code
+    {
+        const std::string es = ac3Frame(20) + ac3Frame(38) + ac3Frame(20);
+        failures += 1 - runTest("verify_Ac3ReservedFrameSize_Error", Codec::AC3, es,
+                                ExpectedResult{ Codec::AC3, 2, 1, 768, 0 });
+    }
+
+    // H.264 longer than one block, start code is split between blocks
+    {
+        std::string es = std::string(1, '\0') + h264Nal(9, 1) + h264Nal(7, 10) + h264Nal(8, 4);
+        es += h264Nal(5, blockSize - 1 - es.size() - 4);
+        es += h264Nal(1, 1000) + h264Nal(1, blockSize) + h264Nal(6, 20);
+        failures += 1 - runTest("verify_H264_OK", Codec::H264, es, ExpectedResult{ Codec::H264, 7, 0, 0, 0 });
+    }
+
+    // H.264 starts with slice, parameter sets come later
+    {
+        const std::string es = h264Nal(1, 100) + h264Nal(7, 10) + h264Nal(8, 4) + h264Nal(5, 100);
+        failures += 1 - runTest("verify_H264SlicesBeforeParameterSets_OK", Codec::H264, es,
+                                ExpectedResult{ Codec::H264, 4, 0, 0, 1 });
+    }
+
+    // H.264 without PPS
+    {
+        const std::string es = h264Nal(7, 10) + h264Nal(5, 100) + h264Nal(1, 100);
+        failures += 1 - runTest("verify_H264NoParameterSets_Error", Codec::H264, es,
+                                ExpectedResult{ Codec::H264, 3, 1, 0, 2 });
+    }
+
+    // H.264 NAL unit with forbidden bit and IDR slice with zero nal_ref_idc
+    {
+        const std::string prefix = h264Nal(7, 10) + h264Nal(8, 4);
+        const std::string es = prefix + nal("\xE5", 100) + nal("\x05", 100);
+        failures += 1 - runTest("verify_H264WrongHeader_Error", Codec::H264, es,
+                                ExpectedResult{ Codec::H264, 4, 2, prefix.size() + 3, 0 });
+    }
+
+    // empty H.264 NAL unit, its zero byte is the leading one of 4-byte start code
+    {
+        const std::string prefix = h264Nal(7, 10) + h264Nal(8, 4);
+        const std::string es = prefix + std::string("\x00\x00\x01\x00", 4) + h264Nal(5, 100);
+        failures += 1 - runTest("verify_H264EmptyNal_Error", Codec::H264, es,
+                                ExpectedResult{ Codec::H264, 4, 1, prefix.size() + 3, 0 });
+    }
+
+    // H.264 doesn't start with start code
+    {
+        const std::string es = std::string("\x01\x02", 2) + h264Nal(7, 10) + h264Nal(8, 4) + h264Nal(5, 100);
+        failures += 1 - runTest("verify_H264NoStartCode_Error", Codec::H264, es,
+                                ExpectedResult{ Codec::H264, 3, 1, 0, 0 });
+    }
+
+    // HEVC with parameter sets
+    {
+        const std::string es = hevcNal(35, 1) + hevcNal(32, 20) + hevcNal(33, 30) + hevcNal(34, 5) +
+                               hevcNal(19, 300) + hevcNal(1, 200) + hevcNal(39, 10) + hevcNal(21, 250);
+        failures += 1 - runTest("verify_Hevc_OK", Codec::HEVC, es, ExpectedResult{ Codec::HEVC, 8, 0, 0, 0 });
+    }
+
+    // HEVC without VPS, IRAP slice with nonzero temporal id, NAL unit of reserved type
+    {
+        const std::string es = hevcNal(33, 30) + hevcNal(34, 5) + nal(std::string{ char(19 << 1), char(0x02) }, 300) +
+                               hevcNal(41, 10);
+        failures += 1 - runTest("verify_HevcWrongHeader_Error", Codec::HEVC, es,
+                                ExpectedResult{ Codec::HEVC, 4, 3, hevcNal(33, 30).size() + hevcNal(34, 5).size() + 3, 1 });
+    }
+
+    // codecs detected by content
+    {
+        const std::string h264 = h264Nal(9, 1) + h264Nal(7, 10) + h264Nal(8, 4) + h264Nal(5, 100);
+        const std::string hevc = hevcNal(32, 20) + hevcNal(33, 30) + hevcNal(34, 5) + hevcNal(19, 300);
+        failures += 1 - runTest("verify_DetectAdts_OK", Codec::UNKNOWN, adtsFrame(100) + adtsFrame(100),
+                                ExpectedResult{ Codec::ADTS, 2, 0, 0, 0 });
+        failures += 1 - runTest("verify_DetectAc3_OK", Codec::UNKNOWN, ac3Frame(20) + eac3Frame(100),
+                                ExpectedResult{ Codec::AC3, 2, 0, 0, 0 });
+        failures += 1 - runTest("verify_DetectH264_OK", Codec::UNKNOWN, h264, ExpectedResult{ Codec::H264, 4, 0, 0, 0 });
+        failures += 1 - runTest("verify_DetectHevc_OK", Codec::UNKNOWN, hevc, ExpectedResult{ Codec::HEVC, 4, 0, 0, 0 });
+        failures += 1 - runTest("verify_Unsupported_OK", Codec::UNKNOWN, std::string(1000, 'x'),
+                                ExpectedResult{ Codec::UNKNOWN, 0, 0, 0, 0 });
+    }
+
+    failures += 1 - runParallelTest("verifyAll_ManyFiles_OK");
+
+    return failures;
+}
@@ -0,0 +1,109 @@
+#include "../error.hpp"
+#include "../file_watcher.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    const std::string fileName = "test_file_watcher.ts";
+
+    /// @brief Idle timeout of watcher in tests.
+    const int idleTimeout = 100;
+
+    /// @brief Run one FileWatcher unit test.
+    /// @details File is created before watching, then every step changes it and waits, so changes
+    ///          are made before waiting as in the reader catching up with the writer.
+    /// @param[in] steps - Changes of the file made before every wait, get the opened file stream.
+    /// @param[in] expectedResults - Expected results of every wait.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 const std::vector<std::function<void(std::ofstream&)>>& steps,
+                 const std::vector<bool>& expectedResults)
+    {
+        std::cout << "Running FileWatcher." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+        std::vector<bool> results;
+
+#ifdef __linux__
+        try
+        {
+            std::ofstream file(fileName, std::ios::binary);
+            file << "head";
+            file.flush();
+
+            FileWatcher watcher(log, fileName, idleTimeout);
+            for (const auto& step : steps)
+            {
+                step(file);
+                results.push_back(watcher.wait());
+            }
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+        std::remove(fileName.c_str());
+
+        if (results != expectedResults)
+        {
+            result = false;
+            log << "Got " << results.size() << " wait results, different from expected" << std::endl;
+        }
+#else
+        (void)steps;
+        (void)expectedResults;
+        std::cout << "SKIPPED ";
+#endif // __linux__
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+}
+
+/// @brief Run all FileWatcher unit tests.
+/// @returns Number of failed tests.
+uint16_t testFileWatcher()
+{
+    uint16_t failures = 0;
+
+    const auto append = [](std::ofstream& file) { file << "data"; file.flush(); };
+    const auto close = [](std::ofstream& file) { file.close(); };
+    const auto nothing = [](std::ofstream&) {};
+
+    // file grows till writer closes it, data written before closing is still to be read
+    failures += 1 - runTest("wait_AppendAndClose_OK", { append, append, close, nothing }, { true, true, true, false });
+
+    // file complete if nothing is appended within timeout
+    failures += 1 - runTest("wait_Idle_OK", { append, nothing }, { true, false });
+
+    // missing file can't be watched
+    {
+        std::cout << "Running FileWatcher.ctor_NoFile_Exception ... ";
+        bool result = false;
+        std::ostringstream log;
+        try
+        {
+            FileWatcher watcher(log, "no_such_file.ts", idleTimeout);
+        }
+        catch (const Error& e)
+        {
+            result = e.code() == Error::CONSTRUCTION_ERROR;
+        }
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        failures += 1 - result;
+    }
+
+    return failures;
+}
@@ -0,0 +1,188 @@
+#include "../error.hpp"
+#include "../frame_writer.hpp"
+#include "../timestamp.hpp"
+#include "../ts_index.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+
+namespace
+{
+    const uint16_t videoPid = 0x100;
+    const uint16_t audioPid = 0x101;
+
+    /// @brief Expected frame file.
+    struct ExpectedFile
+    {
+        /// @brief File name.
+        std::string name;
+
+        /// @brief If not set, file should not exist.
+        bool exists;
+
+        /// @brief Expected records.
+        std::vector<TsFramesRecord> records;
+    };
+
+    /// @brief Expected result for FrameWriter test.
+    struct ExpectedResult
+    {
+        /// @brief Error code. If OK - no error expected.
+        uint16_t errorCode;
+
+        /// @brief Expected frame files.
+        std::vector<ExpectedFile> files;
+    };
+
+    /// @brief Make access unit of the first ES of PID type.
+    EsFramer::AccessUnit makeAccessUnit(uint16_t pid, uint64_t esOffset, uint64_t size, int64_t pts, bool keyframe,
+                                        uint64_t parameterSetsSize = 0)
+    {
+        return EsFramer::AccessUnit{ pid, pid == videoPid ? EsType::VIDEO : EsType::AUDIO, 1, esOffset, size, pts,
+                                     keyframe, parameterSetsSize ? esOffset : 0, parameterSetsSize };
+    }
+
+    /// @brief Check frame file content.
+    void checkFile(const ExpectedFile& expected)
+    {
+        std::ifstream file(expected.name, std::ifstream::in | std::ifstream::binary);
+        if (!expected.exists)
+        {
+            if (file.good())
+                throw std::logic_error("Unexpected file '" + expected.name + "'");
+            return;
+        }
+        if (!file.good())
+            throw std::logic_error("Failed to open file '" + expected.name + "'");
+
+        TsFramesHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file.good())
+            throw std::logic_error("Frame file is too short");
+        if (std::memcmp(header.magic, tsFramesMagic, sizeof(header.magic)) != 0 ||
+            header.version != tsFramesVersion ||
+            header.recordSize != sizeof(TsFramesRecord))
+            throw std::logic_error("Wrong frame file header");
+
+        for (size_t i = 0; i < expected.records.size(); ++i)
+        {
+            TsFramesRecord record;
+            file.read(reinterpret_cast<char*>(&record), sizeof(record));
+            if (!file.good())
+                throw std::logic_error("Frame file is too short");
+            const auto& expectedRecord = expected.records[i];
+            if (record.esOffset != expectedRecord.esOffset || record.size != expectedRecord.size ||
+                record.pts != expectedRecord.pts || record.flags != expectedRecord.flags || record.reserved != 0)
+                throw std::logic_error("Wrong record " + std::to_string(i) + " in file '" + expected.name + "'");
+        }
+
+        if (file.peek() != std::ifstream::traits_type::eof())
+            throw std::logic_error("Frame file '" + expected.name + "' is too long");
+    }
+
+    /// @brief Run one FrameWriter unit test.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 const std::string& audioOutput,
+                 const std::string& videoOutput,
+                 const std::vector<EsFramer::AccessUnit>& input,
+                 const ExpectedResult& expected)
+    {
+        std::cout << "Running FrameWriter." << testName << " ... ";
+
+        bool result = true;
+        Error error{ Error::OK, "" };
+        std::ostringstream log;
+
+        try
+        {
+            OutputNameGenerator audioNameGenerator(audioOutput);
+            OutputNameGenerator videoNameGenerator(videoOutput);
+            FrameWriter writer(log, audioNameGenerator, videoNameGenerator);
+            for (const auto& accessUnit : input)
+                writer.write(accessUnit);
+            writer.closeOutputs();
+        }
+        catch (const Error& err)
+        {
+            error = err;
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        if (error.code() != expected.errorCode)
+        {
+            result = false;
+            if (expected.errorCode == Error::OK)
+                log << "Unexpected exception caught: " << error.message() << std::endl;
+            else
+                log << "No expected exception caught" << std::endl;
+        }
+
+        for (const auto& file : expected.files)
+        {
+            try
+            {
+                checkFile(file);
+            }
+            catch (const std::exception& e)
+            {
+                result = false;
+                log << "Wrong frame file: " << e.what() << std::endl;
+            }
+            std::remove(file.name.c_str());
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+}
+
+/// @brief Run all FrameWriter unit tests.
+/// @returns Number of failed tests.
+uint16_t testFrameWriter()
+{
+    uint16_t failures = 0;
+
+    // keyframe with parameter sets, frame without PTS, ADTS frames are keyframes
+    {
+        std::vector<EsFramer::AccessUnit> input{ makeAccessUnit(videoPid, 0, 1000, 3600, true, 40),
+                                                 makeAccessUnit(audioPid, 0, 200, 3000, true),
+                                                 makeAccessUnit(videoPid, 1000, 300, noTimestamp, false),
+                                                 makeAccessUnit(audioPid, 200, 210, 4920, true) };
+        ExpectedResult expected{ Error::OK, { { "audio.out.frames", true, { { 0, 200, 3000, FRAME_KEYFRAME, 0 },
+                                                                             { 200, 210, 4920, FRAME_KEYFRAME, 0 } } },
+                                              { "video.out.frames", true, { { 0, 1000, 3600, FRAME_KEYFRAME | FRAME_PARAMETER_SETS, 0 },
+                                                                             { 1000, 300, noTimestamp, 0, 0 } } } } };
+        failures += 1 - runTest("write_AudioAndVideo_OK", "audio.out", "video.out", input, expected);
+    }
+
+    // no frame file for ES without output
+    {
+        std::vector<EsFramer::AccessUnit> input{ makeAccessUnit(videoPid, 0, 1000, 3600, true),
+                                                 makeAccessUnit(audioPid, 0, 200, 3000, true) };
+        ExpectedResult expected{ Error::OK, { { "audio.out.frames", true, { { 0, 200, 3000, FRAME_KEYFRAME, 0 } } },
+                                              { "video.out.frames", false, {} } } };
+        failures += 1 - runTest("write_NoVideoOutput_OK", "audio.out", "", input, expected);
+    }
+
+    // frame file cannot be opened
+    {
+        std::vector<EsFramer::AccessUnit> input{ makeAccessUnit(audioPid, 0, 200, 3000, true) };
+        ExpectedResult expected{ Error::CORRUPTED_OUTPUT, {} };
+        failures += 1 - runTest("write_BadFile_Exception", "no_such_directory/audio.out", "", input, expected);
+    }
+
+    return failures;
+}
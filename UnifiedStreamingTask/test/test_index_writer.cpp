@@ -0,0 +1,299 @@
+#include "../error.hpp"
+#include "../index_writer.hpp"
+#include "../output_writer.hpp"
+#include "../payload_parser.hpp"
+#include "../ts_reader.hpp"
+#include "ts_generator.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+
+namespace
+{
+    const uint16_t pmtPid = 0x20;
+    const uint16_t videoPid = 0x100;
+    const uint16_t audioPid = 0x101;
+
+    /// @brief Expected result for IndexWriter test.
+    struct ExpectedResult
+    {
+        /// @brief Error code. If OK - no error expected.
+        uint16_t errorCode;
+
+        /// @brief Expected stream records.
+        std::vector<TsIndexStream> streams;
+
+        /// @brief Expected table records.
+        std::vector<TsIndexTable> tables;
+
+        /// @brief Expected entries.
+        std::vector<TsIndexEntry> entries;
+    };
+
+    /// @brief Generator with one program containing video and audio streams.
+    TsGenerator makeGenerator()
+    {
+        TsGenerator generator;
+        generator.addProgram(1, pmtPid);
+        generator.addStream(1, videoPid, 0x1B);
+        generator.addStream(1, audioPid, 0x0F);
+        return generator;
+    }
+
+    bool operator==(const TsIndexStream& lhs, const TsIndexStream& rhs)
+    {
+        return lhs.pid == rhs.pid && lhs.program == rhs.program && lhs.esNumber == rhs.esNumber &&
+               lhs.type == rhs.type && lhs.streamType == rhs.streamType &&
+               lhs.firstEntry == rhs.firstEntry && lhs.entries == rhs.entries;
+    }
+
+    bool operator==(const TsIndexTable& lhs, const TsIndexTable& rhs)
+    {
+        return lhs.tsOffset == rhs.tsOffset && lhs.pid == rhs.pid && lhs.number == rhs.number &&
+               lhs.tableId == rhs.tableId && lhs.version == rhs.version;
+    }
+
+    bool operator==(const TsIndexEntry& lhs, const TsIndexEntry& rhs)
+    {
+        return lhs.tsOffset == rhs.tsOffset && lhs.esOffset == rhs.esOffset && lhs.pts == rhs.pts &&
+               lhs.segment == rhs.segment;
+    }
+
+    /// @brief Read array of records from index file and compare them with expected ones.
+    template <typename T>
+    void checkRecords(std::istream& input, const std::vector<T>& expected, const std::string& name)
+    {
+        std::vector<T> records(expected.size());
+        input.read(reinterpret_cast<char*>(records.data()), sizeof(T) * records.size());
+        if (!input.good())
+            throw std::logic_error("Index file is too short");
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            if (!(records[i] == expected[i]))
+                throw std::logic_error("Wrong " + name + " record " + std::to_string(i));
+        }
+    }
+
+    /// @brief Check index file content.
+    void checkIndex(const std::string& name, const ExpectedResult& expected)
+    {
+        std::ifstream file(name, std::ifstream::in | std::ifstream::binary);
+        if (!file.good())
+            throw std::logic_error("Failed to open file '" + name + "'");
+
+        TsIndexHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file.good())
+            throw std::logic_error("Index file is too short");
+        if (std::memcmp(header.magic, tsIndexMagic, sizeof(header.magic)) != 0 ||
+            header.version != tsIndexVersion ||
+            header.headerSize != sizeof(TsIndexHeader))
+            throw std::logic_error("Wrong index header");
+        if (header.streams != expected.streams.size() ||
+            header.tables != expected.tables.size() ||
+            header.entries != expected.entries.size())
+            throw std::logic_error("Wrong number of index records");
+
+        checkRecords(file, expected.streams, "stream");
+        checkRecords(file, expected.tables, "table");
+        checkRecords(file, expected.entries, "entry");
+
+        if (file.peek() != std::ifstream::traits_type::eof())
+            throw std::logic_error("Index file is too long");
+    }
+
+    /// @brief Run one IndexWriter unit test.
+    /// @details If video output is given, video ES is written into it and indexed by its positions.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 const std::string& fileName,
+                 const std::string& input,
+                 const ExpectedResult& expected,
+                 const OutputNameGenerator& videoOutput = OutputNameGenerator(),
+                 const SegmentPolicy& segmentPolicy = SegmentPolicy())
+    {
+        std::cout << "Running IndexWriter." << testName << " ... ";
+
+        bool result = true;
+        Error error{ Error::OK, "" };
+        std::ostringstream log;
+
+        try
+        {
+            using namespace std::placeholders;
+
+            std::istringstream stream(input);
+            IndexWriter index(log, fileName);
+            const OutputNameGenerator audioOutput;
+            std::unique_ptr<OutputWriter> writer;
+            if (!videoOutput.name(0).empty())
+                writer.reset(new OutputWriter(log, audioOutput, videoOutput, segmentPolicy));
+
+            PayloadParser parser(log, [&index, &writer](const EsRawData& rawData)
+            {
+                OutputWriter::Position position;
+                if (writer)
+                    writer->write(rawData);
+                index.write(rawData, writer && writer->lastPosition(rawData.type, rawData.esNumber, position) ? &position : nullptr);
+            });
+            parser.setTableHandler(std::bind(&IndexWriter::writeTable, std::ref(index), _1));
+            TsReader reader(stream, log, std::bind(&PayloadParser::parse, std::ref(parser), _1));
+            reader.readAll();
+            index.close(parser.streams());
+            if (writer)
+            {
+                writer->closeOutputs();
+                for (const auto& file : writer->files())
+                    std::remove(file.name.c_str());
+            }
+        }
+        catch (const Error& err)
+        {
+            error = err;
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        if (error.code() != expected.errorCode)
+        {
+            result = false;
+            if (expected.errorCode == Error::OK)
+                log << "Unexpected exception caught: " << error.message() << std::endl;
+            else
+                log << "No expected exception caught" << std::endl;
+        }
+
+        if (expected.errorCode == Error::OK)
+        {
+            try
+            {
+                checkIndex(fileName, expected);
+            }
+            catch (const std::exception& e)
+            {
+                result = false;
+                log << "Wrong index: " << e.what() << std::endl;
+            }
+            std::remove(fileName.c_str());
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+}
+
+/// @brief Run all IndexWriter unit tests.
+/// @returns Number of failed tests.
+uint16_t testIndexWriter()
+{
+    uint16_t failures = 0;
+
+    // program with video and audio
+    {
+        TsGenerator generator = makeGenerator();
+        const std::string psi = generator.pat() + generator.pmt(1);
+        const std::string video1 = generator.pes(videoPid, 0xE0, std::string(500, 'v'), 0);
+        const std::string audio1 = generator.pes(audioPid, 0xC0, std::string(100, 'a'), 0);
+        const std::string video2 = generator.pes(videoPid, 0xE0, std::string(500, 'v'), 3600);
+        const std::string audio2 = generator.pes(audioPid, 0xC0, std::string(100, 'a'), 1920);
+        const std::string input = psi + video1 + audio1 + video2 + audio2;
+
+        const uint64_t audio1Offset = psi.size() + video1.size();
+        const uint64_t video2Offset = audio1Offset + audio1.size();
+        const uint64_t audio2Offset = video2Offset + video2.size();
+
+        ExpectedResult expected{ Error::OK };
+        expected.streams = { { videoPid, 1, 1, INDEX_VIDEO, 0x1B, 0, 2 },
+                             { audioPid, 1, 1, INDEX_AUDIO, 0x0F, 2, 2 } };
+        expected.tables = { { 0, 0, 1, 0x00, 0, 0 },
+                            { 188, pmtPid, 1, 0x02, 0, 0 } };
+        expected.entries = { { psi.size(), 0, 0 },
+                             { video2Offset, 500, 3600 },
+                             { audio1Offset, 0, 0 },
+                             { audio2Offset, 100, 1920 } };
+        failures += 1 - runTest("write_ProgramWithAudioAndVideo_OK", "index.out", input, expected);
+    }
+
+    // changed PMT version
+    {
+        TsGenerator generator = makeGenerator();
+        std::string input = generator.pat() + generator.pmt(1) + generator.pmt(1);
+        generator.setPmtVersion(1, 3);
+        const uint64_t pmtOffset = input.size();
+        input += generator.pmt(1) + generator.pmt(1);
+
+        ExpectedResult expected{ Error::OK };
+        expected.tables = { { 0, 0, 1, 0x00, 0, 0 },
+                            { 188, pmtPid, 1, 0x02, 0, 0 },
+                            { pmtOffset, pmtPid, 1, 0x02, 3, 0 } };
+        failures += 1 - runTest("write_PmtVersionChanged_OK", "index.out", input, expected);
+    }
+
+    // streams without PSI tables
+    {
+        TsGenerator generator;
+        const std::string video1 = generator.pes(videoPid, 0xE0, std::string(300, 'v'), 8589934000);
+        const std::string video2 = generator.pes(videoPid, 0xE0, std::string(300, 'v'), 90000);
+        const std::string input = video1 + video2;
+
+        ExpectedResult expected{ Error::OK };
+        expected.streams = { { videoPid, 0, 1, INDEX_VIDEO, 0, 0, 2 } };
+        expected.entries = { { 0, 0, 8589934000 },
+                             { video1.size(), 300, 90000 } };
+        failures += 1 - runTest("write_NoPsi_OK", "index.out", input, expected);
+    }
+
+    // video is indexed by positions in its segment files, audio without output by offsets in the whole ES
+    {
+        TsGenerator generator = makeGenerator();
+        const std::string psi = generator.pat() + generator.pmt(1);
+        const std::string video1 = generator.pes(videoPid, 0xE0, std::string(500, 'v'), 0);
+        const std::string audio1 = generator.pes(audioPid, 0xC0, std::string(100, 'a'), 0);
+        const std::string video2 = generator.pes(videoPid, 0xE0, std::string(500, 'v'), 3600);
+        const std::string audio2 = generator.pes(audioPid, 0xC0, std::string(100, 'a'), 1920);
+        const std::string video3 = generator.pes(videoPid, 0xE0, std::string(500, 'v'), 7200);
+        const std::string input = psi + video1 + audio1 + video2 + audio2 + video3;
+
+        const uint64_t audio1Offset = psi.size() + video1.size();
+        const uint64_t video2Offset = audio1Offset + audio1.size();
+        const uint64_t audio2Offset = video2Offset + video2.size();
+        const uint64_t video3Offset = audio2Offset + audio2.size();
+
+        SegmentPolicy segmentPolicy;
+        segmentPolicy.size = 600;
+
+        ExpectedResult expected{ Error::OK };
+        expected.streams = { { videoPid, 1, 1, INDEX_VIDEO, 0x1B, 0, 3 },
+                             { audioPid, 1, 1, INDEX_AUDIO, 0x0F, 3, 2 } };
+        expected.tables = { { 0, 0, 1, 0x00, 0, 0 },
+                            { 188, pmtPid, 1, 0x02, 0, 0 } };
+        expected.entries = { { psi.size(), 0, 0, 0, 0 },
+                             { video2Offset, 500, 3600, 0, 0 },
+                             { video3Offset, 0, 7200, 1, 0 },
+                             { audio1Offset, 0, 0, 0, 0 },
+                             { audio2Offset, 100, 1920, 0, 0 } };
+        failures += 1 - runTest("write_SegmentedOutput_OK", "index.out", input, expected,
+                                OutputNameGenerator("index_video_%d.out"), segmentPolicy);
+    }
+
+    // index file cannot be opened
+    {
+        ExpectedResult expected{ Error::CORRUPTED_OUTPUT };
+        failures += 1 - runTest("ctor_BadFile_Exception", "no_such_directory/index.out", "", expected);
+    }
+
+    return failures;
+}
@@ -0,0 +1,203 @@
+#include "../error.hpp"
+#include "../keyframe_filter.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    const uint16_t videoPid = 0x100;
+    const uint16_t audioPid = 0x101;
+
+    /// @brief Size of raw data chunks PES packets are split into.
+    const size_t chunkSize = 7;
+
+    /// @brief PES packet of test input.
+    struct Pes
+    {
+        /// @brief PID of ES.
+        uint16_t pid;
+
+        /// @brief PES packet data.
+        std::string data;
+
+        /// @brief Random access indicator of the first TS packet.
+        bool randomAccess;
+    };
+
+    /// @brief Expected result for KeyframeFilter test.
+    struct ExpectedResult
+    {
+        /// @brief Concatenation of passed video data.
+        std::string video;
+
+        /// @brief Concatenation of passed audio data.
+        std::string audio;
+
+        /// @brief Number of passed keyframes.
+        uint64_t keyframes;
+
+        /// @brief Number of dropped access units.
+        uint64_t dropped;
+
+        /// @brief Maximal number of passed video bytes not pointing into input.
+        size_t copied;
+    };
+
+    /// @brief Make H.264 NAL unit with 4-byte start code.
+    /// @param[in] type - NAL unit type.
+    /// @param[in] size - Size of NAL unit payload.
+    std::string h264Nal(uint8_t type, size_t size)
+    {
+        return std::string("\x00\x00\x00\x01", 4) + char(0x60 | type) + char(0x88) + std::string(size, char('A' + type));
+    }
+
+    /// @brief Run one KeyframeFilter unit test.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 uint8_t videoStreamType,
+                 const std::vector<Pes>& input,
+                 const ExpectedResult& expected)
+    {
+        std::cout << "Running KeyframeFilter." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+        std::string video;
+        std::string audio;
+        bool readTimeLost = false;
+        size_t copied = 0;
+
+        std::map<uint16_t, PayloadParser::StreamInfo> streams;
+        streams[videoPid] = PayloadParser::StreamInfo{ EsType::VIDEO, 1, 1, videoStreamType };
+        streams[audioPid] = PayloadParser::StreamInfo{ EsType::AUDIO, 1, 1, 0x0F };
+
+        try
+        {
+            KeyframeFilter filter(log, streams, [&input, &video, &audio, &readTimeLost, &copied](const EsRawData& rawData)
+            {
+                readTimeLost = readTimeLost || !rawData.readTime;
+                const char* data = reinterpret_cast<const char*>(rawData.data);
+                const bool inPlace = std::any_of(input.begin(), input.end(), [data](const Pes& pes)
+                {
+                    return data >= pes.data.data() && data < pes.data.data() + pes.data.size();
+                });
+                if (rawData.type == EsType::VIDEO && !inPlace)
+                    copied += rawData.size;
+                auto& output = rawData.type == EsType::VIDEO ? video : audio;
+                output.append(reinterpret_cast<const char*>(rawData.data), rawData.size);
+            });
+
+            int64_t pts = 0;
+            for (const auto& pes : input)
+            {
+                const EsType type = pes.pid == videoPid ? EsType::VIDEO : EsType::AUDIO;
+                for (size_t offset = 0; offset < pes.data.size(); offset += chunkSize)
+                {
+                    const size_t size = std::min(chunkSize, pes.data.size() - offset);
+                    const bool first = offset == 0;
+                    const EsRawData rawData{ reinterpret_cast<const uint8_t*>(pes.data.data()) + offset, static_cast<uint16_t>(size),
+                                             type, 1, pes.pid, first ? pts : noTimestamp, first, 0, first ? pts : noTimestamp,
+                                             first && pes.randomAccess, false, 1 };
+                    filter.write(rawData);
+                }
+                pts += 3600;
+            }
+            filter.flush();
+
+            const auto it = filter.statistics().find(videoPid);
+            if (it == filter.statistics().end() || it->second.keyframes != expected.keyframes || it->second.dropped != expected.dropped)
+            {
+                result = false;
+                log << "Wrong statistics" << std::endl;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        if (readTimeLost)
+        {
+            result = false;
+            log << "Read time of passed data is lost" << std::endl;
+        }
+        if (copied > expected.copied)
+        {
+            result = false;
+            log << "Got " << copied << " bytes of video copied instead of " << expected.copied << " at most" << std::endl;
+        }
+        if (video != expected.video)
+        {
+            result = false;
+            log << "Got " << video.size() << " bytes of video instead of " << expected.video.size() << std::endl;
+        }
+        if (audio != expected.audio)
+        {
+            result = false;
+            log << "Got " << audio.size() << " bytes of audio instead of " << expected.audio.size() << std::endl;
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+}
+
+/// @brief Run all KeyframeFilter unit tests.
+/// @returns Number of failed tests.
+uint16_t testKeyframeFilter()
+{
+    uint16_t failures = 0;
+
+    const std::string delimiter = h264Nal(9, 1);
+    const std::string parameterSets = h264Nal(7, 10) + h264Nal(8, 4);
+    const std::string idrWithParameterSets = delimiter + parameterSets + h264Nal(5, 300);
+    const std::string idr = delimiter + h264Nal(5, 250);
+    const std::string nonIdr = delimiter + h264Nal(1, 100);
+    const std::string audio(50, 'a');
+    // only access unit data preceding picture, inserted parameter sets and a few bytes at start codes are copied
+    const size_t copied = 2 * (delimiter.size() + parameterSets.size() + 6);
+
+    // keyframes are detected by NAL unit types, parameter sets are inserted before keyframe without them
+    {
+        std::vector<Pes> input{ { videoPid, idrWithParameterSets, false }, { audioPid, audio, false },
+                                { videoPid, nonIdr, false }, { videoPid, nonIdr, false },
+                                { videoPid, idr, false }, { audioPid, audio, false }, { videoPid, nonIdr, false } };
+        ExpectedResult expected{ idrWithParameterSets + parameterSets + idr, audio + audio, 2, 3, copied };
+        failures += 1 - runTest("write_NalTypes_OK", 0x1B, input, expected);
+    }
+
+    // PES packets without random access indicator are dropped
+    {
+        std::vector<Pes> input{ { videoPid, idrWithParameterSets, true }, { videoPid, nonIdr, false },
+                                { videoPid, idr, true }, { videoPid, nonIdr, false } };
+        ExpectedResult expected{ idrWithParameterSets + parameterSets + idr, "", 2, 2, copied };
+        failures += 1 - runTest("write_RandomAccessIndicator_OK", 0x1B, input, expected);
+    }
+
+    // keyframe without random access indicator is lost, the indicator is not trusted after it
+    {
+        std::vector<Pes> input{ { videoPid, idrWithParameterSets, true }, { videoPid, idr, false },
+                                { videoPid, nonIdr, false }, { videoPid, idr, false } };
+        ExpectedResult expected{ idrWithParameterSets + parameterSets + idr, "", 2, 2, copied };
+        failures += 1 - runTest("write_MissingRandomAccessIndicator_Ignored", 0x1B, input, expected);
+    }
+
+    // codec without framing is filtered by random access indicator only
+    {
+        const std::string picture1(200, 'i');
+        const std::string picture2(100, 'p');
+        std::vector<Pes> input{ { videoPid, picture1, true }, { videoPid, picture2, false }, { videoPid, picture1, true } };
+        ExpectedResult expected{ picture1 + picture1, "", 0, 0, 0 };
+        failures += 1 - runTest("write_Mpeg2Video_OK", 0x02, input, expected);
+    }
+
+    return failures;
+}
@@ -0,0 +1,104 @@
+#include "../latency_histogram.hpp"
+
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+
+namespace
+{
+    /// @brief Check if value is within 1% of expected one.
+    bool near(uint64_t value, uint64_t expected)
+    {
+        const uint64_t difference = value > expected ? value - expected : expected - value;
+        return difference <= expected / 100;
+    }
+
+    /// @brief Run one LatencyHistogram unit test.
+    /// @param[in] values - Recorded values, value and number of its repetitions.
+    /// @param[in] expected - Percents and expected percentiles.
+    /// @param[in] expectedMax - Expected maximum.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 std::initializer_list<std::pair<uint64_t, uint64_t>> values,
+                 std::initializer_list<std::pair<double, uint64_t>> expected,
+                 uint64_t expectedMax)
+    {
+        std::cout << "Running LatencyHistogram." << testName << " ... ";
+
+        LatencyHistogram histogram;
+        uint64_t count = 0;
+        for (const auto& value : values)
+        {
+            for (uint64_t i = 0; i < value.second; ++i)
+                histogram.record(value.first);
+            count += value.second;
+        }
+
+        bool result = histogram.count() == count && histogram.max() == expectedMax;
+        std::ostringstream failureDescription;
+        if (!result)
+            failureDescription << "Got count " << histogram.count() << ", max " << histogram.max() << std::endl;
+        for (const auto& percentile : expected)
+        {
+            const uint64_t value = histogram.percentile(percentile.first);
+            if (!near(value, percentile.second))
+            {
+                result = false;
+                failureDescription << "Got p" << percentile.first << " " << value << " instead of " << percentile.second << std::endl;
+            }
+        }
+
+        histogram.reset();
+        if (histogram.count() || histogram.max() || histogram.percentile(50))
+        {
+            result = false;
+            failureDescription << "Got values after reset" << std::endl;
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << failureDescription.str();
+        return result;
+    }
+}
+
+/// @brief Run all LatencyHistogram unit tests.
+/// @returns Number of failed tests.
+uint16_t testLatencyHistogram()
+{
+    uint16_t failures = 0;
+
+    failures += 1 - runTest("percentile_Empty_Zero", {}, { { 50, 0 }, { 99.9, 0 } }, 0);
+    failures += 1 - runTest("percentile_SmallValues_Exact", { { 3, 50 }, { 7, 49 }, { 200, 1 } }, { { 50, 3 }, { 51, 7 }, { 99, 7 }, { 100, 200 } }, 200);
+
+    // 1 ms to 1 s in 1 ms steps
+    LatencyHistogram histogram;
+    bool result = true;
+    for (uint64_t value = 1000000; value <= 1000000000; value += 1000000)
+        histogram.record(value);
+    for (const auto& percentile : { std::make_pair(50.0, 500000000ULL), std::make_pair(99.0, 990000000ULL), std::make_pair(99.9, 999000000ULL) })
+        result = result && near(histogram.percentile(percentile.first), percentile.second);
+    std::cout << "Running LatencyHistogram.percentile_UniformValues_OnePercentPrecision ... " << (result ? "OK" : "FAIL") << std::endl;
+    failures += 1 - result;
+
+    failures += 1 - runTest("percentile_Outliers_OK", { { 20000000, 990 }, { 500000000, 9 }, { 5000000000ULL, 1 } },
+                            { { 50, 20000000 }, { 99, 20000000 }, { 99.9, 500000000 }, { 100, 5000000000ULL } }, 5000000000ULL);
+    failures += 1 - runTest("record_HugeValue_OK", { { ~0ULL, 1 } }, { { 50, ~0ULL } }, ~0ULL);
+
+    // summary is in milliseconds
+    histogram.reset();
+    histogram.record(1500000);
+    std::ostringstream summary;
+    histogram.writeSummary(summary);
+    result = summary.str() == "1 samples, p50 1.500 ms, p99 1.500 ms, p99.9 1.500 ms, max 1.500 ms";
+    std::cout << "Running LatencyHistogram.writeSummary_OneSample_OK ... " << (result ? "OK" : "FAIL") << std::endl;
+    if (!result)
+        std::cout << "Got summary '" << summary.str() << "'" << std::endl;
+    failures += 1 - result;
+
+    return failures;
+}
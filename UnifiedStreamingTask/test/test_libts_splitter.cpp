@@ -0,0 +1,313 @@
+#include "../libts_splitter.h"
+#include "ts_generator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+    /// @brief ES data collected by output callback, by job, type and number like "0:video_2".
+    using Collected = std::map<std::string, std::string>;
+
+    /// @brief Generate MPTS with 2 programs, every one has audio and video streams.
+    std::string makeInput()
+    {
+        TsGenerator generator;
+        generator.addProgram(1, 0x100);
+        generator.addStream(1, 0x101, 0x1B);
+        generator.addStream(1, 0x102, 0x0F);
+        generator.addProgram(2, 0x200);
+        generator.addStream(2, 0x201, 0x1B);
+        generator.addStream(2, 0x202, 0x0F);
+
+        std::string input = generator.pat() + generator.pmt(1) + generator.pmt(2);
+        for (int i = 0; i < 2; ++i)
+        {
+            input += generator.pes(0x101, 0xE0, std::string(300, 'v'), 90000 * i);
+            input += generator.pes(0x102, 0xC0, std::string(100, 'a'), 90000 * i);
+            input += generator.pes(0x201, 0xE0, std::string(300, 'V'), 90000 * i);
+            input += generator.pes(0x202, 0xC0, std::string(100, 'A'), 90000 * i);
+        }
+        return input;
+    }
+
+    /// @brief ES data of makeInput() split with default options.
+    const Collected& expectedEs()
+    {
+        static const Collected expected{ { "0:audio_1", std::string(200, 'a') }, { "0:audio_2", std::string(200, 'A') },
+                                         { "0:video_1", std::string(600, 'v') }, { "0:video_2", std::string(600, 'V') } };
+        return expected;
+    }
+
+    /// @brief Output callback collecting ES data.
+    void collect(void* context, const ts_splitter_es_data* data)
+    {
+        const std::string key = std::to_string(data->job) + (data->type == TS_SPLITTER_AUDIO ? ":audio_" : ":video_") +
+                                std::to_string(data->es_number);
+        (*static_cast<Collected*>(context))[key].append(reinterpret_cast<const char*>(data->data), data->size);
+    }
+
+    /// @brief Log callback collecting log lines.
+    void collectLog(void* context, const char* line)
+    {
+        *static_cast<std::ostringstream*>(context) << line << std::endl;
+    }
+
+    /// @brief Read file and remove it.
+    std::string readFile(const std::string& fileName)
+    {
+        std::string result;
+        {
+            std::ifstream file(fileName, std::ifstream::in | std::ifstream::binary);
+            result.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        std::remove(fileName.c_str());
+        return result;
+    }
+
+    /// @brief Split input by splitter pushing it in blocks.
+    /// @param[in] args - Options of splitter.
+    /// @param[in] input - TS input.
+    /// @param[in] blockSize - Size of pushed blocks.
+    /// @param[out] collected - ES data passed to output callback.
+    /// @param[out] report - Report of splitter.
+    /// @param[out] log - Stream for log lines and errors.
+    /// @returns Status of the first failed call, TS_SPLITTER_OK if all calls succeeded.
+    int split(const std::vector<const char*>& args, const std::string& input, size_t blockSize,
+              Collected& collected, std::string& report, std::ostringstream& log)
+    {
+        ts_splitter* splitter = ts_splitter_create();
+        int status = ts_splitter_set_log_callback(splitter, collectLog, &log);
+        if (status == TS_SPLITTER_OK)
+            status = ts_splitter_set_options(splitter, static_cast<int>(args.size()), args.data());
+        if (status == TS_SPLITTER_OK)
+            status = ts_splitter_set_output_callback(splitter, collect, &collected);
+
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(input.data());
+        for (size_t offset = 0; status == TS_SPLITTER_OK && offset < input.size(); offset += blockSize)
+            status = ts_splitter_push(splitter, data + offset, std::min(blockSize, input.size() - offset));
+
+        if (status == TS_SPLITTER_OK)
+            status = ts_splitter_finish(splitter);
+        if (status != TS_SPLITTER_OK)
+            log << "Error: " << ts_splitter_last_error(splitter) << std::endl;
+        report = ts_splitter_report(splitter);
+        ts_splitter_destroy(splitter);
+        return status;
+    }
+
+    /// @brief Run one libts_splitter unit test pushing input into one splitter.
+    /// @param[in] args - Options of splitter.
+    /// @param[in] blockSize - Size of pushed blocks.
+    /// @param[in] expectedStatus - Expected status of the first failed call.
+    /// @param[in] expectedEs - Expected ES data passed to output callback.
+    /// @param[in] expectedFiles - Expected content of output files by names.
+    /// @param[in] expectedReport - Expected fragment of report, may be empty.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 const std::vector<const char*>& args,
+                 size_t blockSize,
+                 int expectedStatus,
+                 const Collected& expectedEs,
+                 const std::map<std::string, std::string>& expectedFiles = std::map<std::string, std::string>(),
+                 const std::string& expectedReport = std::string())
+    {
+        std::cout << "Running LibTsSplitter." << testName << " ... ";
+
+        Collected collected;
+        std::string report;
+        std::ostringstream log;
+        const int status = split(args, makeInput(), blockSize, collected, report, log);
+
+        bool result = true;
+        if (status != expectedStatus)
+        {
+            result = false;
+            log << "Got status " << status << " instead of " << expectedStatus << std::endl;
+        }
+        if (collected != expectedEs)
+        {
+            result = false;
+            log << "Unexpected ES data, got " << collected.size() << " ES instead of " << expectedEs.size() << std::endl;
+        }
+        for (const auto& pair : expectedFiles)
+        {
+            if (readFile(pair.first) != pair.second)
+            {
+                result = false;
+                log << "Unexpected content of '" << pair.first << "'" << std::endl;
+            }
+        }
+        if (!expectedReport.empty() && report.find(expectedReport) == std::string::npos)
+        {
+            result = false;
+            log << "No '" << expectedReport << "' in report" << std::endl;
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+
+    /// @brief Test independent splitters running in parallel threads.
+    bool testConcurrentSplitters()
+    {
+        std::cout << "Running LibTsSplitter.push_ConcurrentSplitters_OK ... ";
+
+        const size_t threadCount = 4;
+        const std::string input = makeInput();
+        std::vector<Collected> collected(threadCount);
+        std::vector<int> statuses(threadCount, TS_SPLITTER_OK);
+        std::vector<std::ostringstream> logs(threadCount);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < threadCount; ++i)
+        {
+            threads.emplace_back([i, &input, &collected, &statuses, &logs]()
+            {
+                std::string report;
+                statuses[i] = split({}, input, 188 * (i + 1) + i, collected[i], report, logs[i]);
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        bool result = true;
+        std::ostringstream log;
+        for (size_t i = 0; i < threadCount; ++i)
+        {
+            if (statuses[i] != TS_SPLITTER_OK || collected[i] != expectedEs())
+            {
+                result = false;
+                log << "Splitter " << i << " failed with status " << statuses[i] << std::endl << logs[i].str();
+            }
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+
+    /// @brief Test reading input from file descriptor.
+    bool testAttachFd()
+    {
+        std::cout << "Running LibTsSplitter.attachFd_File_OK ... ";
+
+        const std::string fileName = "libts_splitter_input.ts";
+        {
+            std::ofstream file(fileName, std::ofstream::out | std::ofstream::binary);
+            file << makeInput();
+        }
+
+        Collected collected;
+        std::ostringstream log;
+        ts_splitter* splitter = ts_splitter_create();
+        ts_splitter_set_log_callback(splitter, collectLog, &log);
+        ts_splitter_set_output_callback(splitter, collect, &collected);
+        FILE* file = std::fopen(fileName.c_str(), "rb");
+        int status = file ? ts_splitter_attach_fd(splitter, fileno(file)) : TS_SPLITTER_CORRUPTED_INPUT;
+        if (status == TS_SPLITTER_OK)
+            status = ts_splitter_finish(splitter);
+        const std::string error = ts_splitter_last_error(splitter);
+        ts_splitter_destroy(splitter);
+        if (file)
+            std::fclose(file);
+        std::remove(fileName.c_str());
+
+        const bool result = status == TS_SPLITTER_OK && collected == expectedEs();
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << "Got status " << status << " '" << error << "'" << std::endl;
+        return result;
+    }
+
+    /// @brief Test calls made out of order.
+    bool testInvalidCalls()
+    {
+        std::cout << "Running LibTsSplitter.push_InvalidCalls_Error ... ";
+
+        const uint8_t packet[188] = { 0x47, 0x1F, 0xFF, 0x10 };
+        const char* const args[] = { "-oa", "audio.out" };
+        ts_splitter* splitter = ts_splitter_create();
+
+        std::ostringstream log;
+        bool result = true;
+        auto check = [&log, &result, splitter](const std::string& call, int status, int expectedStatus)
+        {
+            if (status != expectedStatus)
+            {
+                result = false;
+                log << call << " returned " << status << " instead of " << expectedStatus << std::endl;
+            }
+            if ((status == TS_SPLITTER_OK) != (*ts_splitter_last_error(splitter) == '\0'))
+            {
+                result = false;
+                log << call << " left wrong error '" << ts_splitter_last_error(splitter) << "'" << std::endl;
+            }
+        };
+
+        check("push", ts_splitter_push(splitter, packet, sizeof(packet)), TS_SPLITTER_OK);
+        check("set_options", ts_splitter_set_options(splitter, 2, args), TS_SPLITTER_INVALID_CALL);
+        check("set_output_callback", ts_splitter_set_output_callback(splitter, collect, nullptr), TS_SPLITTER_INVALID_CALL);
+        check("push", ts_splitter_push(splitter, nullptr, 1), TS_SPLITTER_INVALID_CALL);
+        check("finish", ts_splitter_finish(splitter), TS_SPLITTER_OK);
+        check("push", ts_splitter_push(splitter, packet, sizeof(packet)), TS_SPLITTER_INVALID_CALL);
+        check("finish", ts_splitter_finish(splitter), TS_SPLITTER_INVALID_CALL);
+        ts_splitter_destroy(splitter);
+
+        if (ts_splitter_push(nullptr, packet, sizeof(packet)) != TS_SPLITTER_INVALID_CALL)
+        {
+            result = false;
+            log << "push accepted no splitter" << std::endl;
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+}
+
+/// @brief Run all libts_splitter unit tests.
+/// @returns Number of failed tests.
+uint16_t testLibTsSplitter()
+{
+    uint16_t failures = 0;
+
+    // no files are written without output names, ES are passed to callback only
+    failures += 1 - runTest("push_AlignedBlocks_OK", {}, 188 * 7, TS_SPLITTER_OK, expectedEs(),
+                            { { "audio_1.out", "" }, { "video_1.out", "" } });
+    failures += 1 - runTest("push_UnalignedBlocks_OK", {}, 100, TS_SPLITTER_OK, expectedEs());
+
+    failures += 1 - runTest("push_NamedOutputs_OK", { "-oa", "lib_audio.out", "--program", "2" }, 188, TS_SPLITTER_OK,
+                            { { "0:audio_1", std::string(200, 'A') } },
+                            { { "lib_audio.out", std::string(200, 'A') } });
+
+    // ES of every job are passed to callback along with its index
+    const std::string jobsFile = "lib_jobs.txt";
+    std::ofstream(jobsFile) << "-oa lib_job_audio.out --program 1\n-ov lib_job_video.out --program 2\n";
+    failures += 1 - runTest("push_Jobs_OK", { "--jobs", jobsFile.c_str() }, 188, TS_SPLITTER_OK,
+                            { { "0:audio_1", std::string(200, 'a') }, { "1:video_1", std::string(600, 'V') } },
+                            { { "lib_job_audio.out", std::string(200, 'a') }, { "lib_job_video.out", std::string(600, 'V') } });
+    std::remove(jobsFile.c_str());
+
+    failures += 1 - runTest("finish_Probe_OK", { "--probe" }, 188, TS_SPLITTER_OK, Collected(), {}, "\"pmtPid\": 512");
+
+    failures += 1 - runTest("setOptions_Input_Error", { "-i", "input.ts" }, 188, TS_SPLITTER_WRONG_OPTION_ARGUMENT, Collected());
+    failures += 1 - runTest("setOptions_UnknownOption_Error", { "--unknown", "value" }, 188, TS_SPLITTER_UNKNOWN_OPTION, Collected());
+
+    failures += 1 - testConcurrentSplitters();
+    failures += 1 - testAttachFd();
+    failures += 1 - testInvalidCalls();
+
+    return failures;
+}
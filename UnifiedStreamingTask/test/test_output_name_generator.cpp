@@ -23,6 +23,26 @@ namespace
 
         return result;
     }
+
+    /// @brief Run one OutputNameGenerator unit test on segment names.
+    /// @returns true if test passed, false otherwise.
+    bool runSegmentTest(const std::string& testName,
+                        const std::string& nameExample,
+                        uint16_t fileNumber,
+                        uint32_t segmentNumber,
+                        const std::string& expectedName)
+    {
+        std::cout << "Running OutputNameGenerator." << testName << " ... ";
+
+        OutputNameGenerator ong(nameExample);
+        const bool result = ong.name(fileNumber, segmentNumber) == expectedName;
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cerr << "Got " << ong.name(fileNumber, segmentNumber) << " instead of " << expectedName << std::endl;
+
+        return result;
+    }
 }
 
 /// @brief Run all OutputNameGenerator unit tests.
@@ -46,5 +66,12 @@ uint16_t testOutputNameGenerator()
     failures += 1 - runTest("name_Uninitialized_File1", "", 1, "");
     failures += 1 - runTest("name_Uninitialized_File2", "", 2, "");
 
+    failures += 1 - runTest("name_Segmented_File1", "video_1_%05d.h264", 1, "video_1.h264");
+    failures += 1 - runSegmentTest("name_Segmented_File1Segment0", "video_1_%05d.h264", 1, 0, "video_1_00000.h264");
+    failures += 1 - runSegmentTest("name_Segmented_File2Segment3", "video_1_%05d.h264", 2, 3, "video_2_00003.h264");
+    failures += 1 - runSegmentTest("name_SegmentedNoWidth_File1Segment12", "audio-%d.aac", 1, 12, "audio-12.aac");
+    failures += 1 - runSegmentTest("name_SegmentedNoWidth_File2Segment0", "audio-%d.aac", 2, 0, "audio_2-0.aac");
+    failures += 1 - runSegmentTest("name_NotSegmented_File2Segment3", "video_%s.h264", 2, 3, "video_%s_2.h264");
+
     return failures;
 }
\ No newline at end of file
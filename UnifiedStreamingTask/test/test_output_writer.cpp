@@ -1,5 +1,7 @@
+#include "../crc32.hpp"
 #include "../error.hpp"
 #include "../output_writer.hpp"
+#include "../timestamp.hpp"
 
 #include <cstdio>
 #include <fstream>
@@ -80,6 +82,9 @@ namespace
         /// @brief Expected output file names and contents.
         ///        If content is empty, file shouldn't exist.
         std::map<std::string, std::string> outputs;
+
+        /// @brief Expected number of output files reopened after being closed by the limit.
+        uint64_t reopens;
     };
 
     /// @brief Check file existance (or non-existance) and content.
@@ -102,25 +107,33 @@ namespace
     }
 
     /// @brief Run one OutputWriter unit test.
+    /// @details Outputs are hashed, sizes and hashes of written files are checked against expected content.
     /// @returns true if test passed, false otherwise.
     bool runTest(const std::string& testName,
                  const OutputNameGenerator& audioGenerator,
                  const OutputNameGenerator& videoGenerator,
                  const std::vector<EsRawData>& input,
-                 const ExpectedResult& expected)
+                 const ExpectedResult& expected,
+                 const SegmentPolicy& segmentPolicy = SegmentPolicy(),
+                 size_t maxOpenFiles = 0)
     {
         std::cout << "Running OutputWriter." << testName << " ... ";
 
         bool result = true;
         Error error{ Error::OK, "" };
         std::ostringstream log;
+        uint64_t reopens = 0;
+        std::vector<OutputWriter::File> files;
 
         try
         {
-            OutputWriter writer(log, audioGenerator, videoGenerator);
+            OutputWriter writer(log, audioGenerator, videoGenerator, segmentPolicy, maxOpenFiles);
+            writer.setHashing(true);
             for (const auto& data : input)
                 writer.write(data);
             writer.closeOutputs();
+            reopens = writer.statistics().reopens;
+            files = writer.files();
         }
         catch (const Error& err)
         {
@@ -140,6 +153,27 @@ namespace
             else
                 log << "No expected exception caught" << std::endl;
         }
+        if (reopens != expected.reopens)
+        {
+            result = false;
+            log << "Got " << reopens << " reopened files instead of " << expected.reopens << std::endl;
+        }
+        for (const auto& file : files)
+        {
+            const auto output = expected.outputs.find(file.name);
+            if (output == expected.outputs.end())
+            {
+                result = false;
+                log << "Unexpected file '" << file.name << "'" << std::endl;
+                continue;
+            }
+            const auto& content = output->second;
+            if (file.size != content.size() || file.crc32c != crc32c(reinterpret_cast<const uint8_t*>(content.data()), content.size()))
+            {
+                result = false;
+                log << "Got wrong size or hash of file '" << file.name << "'" << std::endl;
+            }
+        }
         for (const auto& pair : expected.outputs)
         {
             try
@@ -246,5 +280,239 @@ uint16_t testOutputWriter()
         failures += 1 - runTest("write_DiscardAudio_OK", audioNamer, videoNamer, rawData, expected);
     }
 
+    // segments end at the first PES packet after size limit
+    {
+        OutputNameGenerator audioNamer;
+        OutputNameGenerator videoNamer("video_1_%03d.out");
+        SegmentPolicy segmentPolicy;
+        segmentPolicy.size = 100;
+        std::vector<EsRawData> rawData;
+        rawData.push_back({ videoRawData1.data(), static_cast<uint16_t>(videoRawData1.size()), EsType::VIDEO, 1, 0x100, 0, true });
+        rawData.push_back({ videoRawData2.data(), static_cast<uint16_t>(videoRawData2.size()), EsType::VIDEO, 1, 0x100, noTimestamp, false });
+        rawData.push_back({ videoRawData1.data(), static_cast<uint16_t>(videoRawData1.size()), EsType::VIDEO, 1, 0x100, 3600, true });
+        ExpectedResult expected{ Error::OK };
+        expected.outputs["video_1_000.out"] = std::string(videoRawData1.begin(), videoRawData1.end()) +
+                                              std::string(videoRawData2.begin(), videoRawData2.end());
+        expected.outputs["video_1_001.out"] = std::string(videoRawData1.begin(), videoRawData1.end());
+        expected.outputs["video_1_002.out"] = std::string();
+        failures += 1 - runTest("write_SegmentsBySize_OK", audioNamer, videoNamer, rawData, expected, segmentPolicy);
+    }
+
+    // video segments start at random access points after duration, audio ones right after it
+    {
+        OutputNameGenerator audioNamer("audio_1_%d.out");
+        OutputNameGenerator videoNamer("video_1_%d.out");
+        SegmentPolicy segmentPolicy;
+        segmentPolicy.duration = 3600;
+        segmentPolicy.atKeyframes = true;
+        std::vector<EsRawData> rawData;
+        rawData.push_back({ videoRawData1.data(), static_cast<uint16_t>(videoRawData1.size()), EsType::VIDEO, 1, 0x100, 0, true, 0, 0, true });
+        rawData.push_back({ audioRawData1.data(), static_cast<uint16_t>(audioRawData1.size()), EsType::AUDIO, 1, 0x101, 0, true, 0, 0, false });
+        rawData.push_back({ videoRawData2.data(), static_cast<uint16_t>(videoRawData2.size()), EsType::VIDEO, 1, 0x100, 3600, true, 0, 3600, false });
+        rawData.push_back({ audioRawData2.data(), static_cast<uint16_t>(audioRawData2.size()), EsType::AUDIO, 1, 0x101, 3600, true, 0, 3600, false });
+        rawData.push_back({ videoRawData1.data(), static_cast<uint16_t>(videoRawData1.size()), EsType::VIDEO, 1, 0x100, 7200, true, 0, 7200, true });
+        ExpectedResult expected{ Error::OK };
+        expected.outputs["video_1_0.out"] = std::string(videoRawData1.begin(), videoRawData1.end()) +
+                                            std::string(videoRawData2.begin(), videoRawData2.end());
+        expected.outputs["video_1_1.out"] = std::string(videoRawData1.begin(), videoRawData1.end());
+        expected.outputs["audio_1_0.out"] = std::string(audioRawData1.begin(), audioRawData1.end());
+        expected.outputs["audio_1_1.out"] = std::string(audioRawData2.begin(), audioRawData2.end());
+        expected.outputs["video_1_2.out"] = std::string();
+        expected.outputs["audio_1_2.out"] = std::string();
+        failures += 1 - runTest("write_SegmentsByDurationAtKeyframes_OK", audioNamer, videoNamer, rawData, expected, segmentPolicy);
+    }
+
+    // data of closed output is buffered and written when it's reopened on closing
+    {
+        OutputNameGenerator audioNamer("audio_1.out");
+        OutputNameGenerator videoNamer("video_1.out");
+        std::vector<EsRawData> rawData;
+        rawData.push_back({ audioRawData1.data(), static_cast<uint16_t>(audioRawData1.size()), EsType::AUDIO, 1, 0x101, 0, true });
+        rawData.push_back({ videoRawData1.data(), static_cast<uint16_t>(videoRawData1.size()), EsType::VIDEO, 1, 0x100, 0, true });
+        rawData.push_back({ audioRawData2.data(), static_cast<uint16_t>(audioRawData2.size()), EsType::AUDIO, 1, 0x101, noTimestamp, false });
+        rawData.push_back({ videoRawData2.data(), static_cast<uint16_t>(videoRawData2.size()), EsType::VIDEO, 1, 0x100, noTimestamp, false });
+        ExpectedResult expected{ Error::OK };
+        expected.outputs["audio_1.out"] = std::string(audioRawData1.begin(), audioRawData1.end()) +
+                                          std::string(audioRawData2.begin(), audioRawData2.end());
+        expected.outputs["video_1.out"] = std::string(videoRawData1.begin(), videoRawData1.end()) +
+                                          std::string(videoRawData2.begin(), videoRawData2.end());
+        expected.reopens = 1;
+        failures += 1 - runTest("write_LimitedOpenFiles_OK", audioNamer, videoNamer, rawData, expected, SegmentPolicy(), 1);
+    }
+
+    // closed output is reopened to complete its segment, segments are not opened ahead
+    {
+        OutputNameGenerator audioNamer("audio_1_%03d.out");
+        OutputNameGenerator videoNamer("video_1_%03d.out");
+        SegmentPolicy segmentPolicy;
+        segmentPolicy.size = 100;
+        std::vector<EsRawData> rawData;
+        rawData.push_back({ videoRawData1.data(), static_cast<uint16_t>(videoRawData1.size()), EsType::VIDEO, 1, 0x100, 0, true });
+        rawData.push_back({ audioRawData1.data(), static_cast<uint16_t>(audioRawData1.size()), EsType::AUDIO, 1, 0x101, 0, true });
+        rawData.push_back({ videoRawData1.data(), static_cast<uint16_t>(videoRawData1.size()), EsType::VIDEO, 1, 0x100, 3600, true });
+        rawData.push_back({ audioRawData2.data(), static_cast<uint16_t>(audioRawData2.size()), EsType::AUDIO, 1, 0x101, 3600, true });
+        ExpectedResult expected{ Error::OK };
+        expected.outputs["video_1_000.out"] = std::string(videoRawData1.begin(), videoRawData1.end());
+        expected.outputs["video_1_001.out"] = std::string(videoRawData1.begin(), videoRawData1.end());
+        expected.outputs["audio_1_000.out"] = std::string(audioRawData1.begin(), audioRawData1.end());
+        expected.outputs["audio_1_001.out"] = std::string(audioRawData2.begin(), audioRawData2.end());
+        expected.outputs["video_1_002.out"] = std::string();
+        expected.outputs["audio_1_002.out"] = std::string();
+        expected.reopens = 3;
+        failures += 1 - runTest("write_LimitedOpenSegments_OK", audioNamer, videoNamer, rawData, expected, segmentPolicy, 1);
+    }
+
+    // output is flushed by the first write after its oldest data is older than flush interval
+    {
+        std::cout << "Running OutputWriter.write_FlushInterval_OK ... ";
+        std::ostringstream failureDescription;
+        bool result = true;
+        auto fileSize = [](const char* name) { return std::ifstream(name, std::ifstream::binary | std::ifstream::ate).tellg(); };
+        try
+        {
+            OutputNameGenerator audioNamer("audio_1.out");
+            OutputNameGenerator videoNamer("video_1.out");
+            OutputWriter writer(failureDescription, audioNamer, videoNamer);
+            writer.setFlushInterval(20000000);
+
+            EsRawData video{ videoRawData1.data(), static_cast<uint16_t>(videoRawData1.size()), EsType::VIDEO, 1 };
+            EsRawData audio{ audioRawData1.data(), static_cast<uint16_t>(audioRawData1.size()), EsType::AUDIO, 1 };
+            video.readTime = 1000000000;
+            audio.readTime = video.readTime + 10000000;
+            writer.write(video);
+            writer.write(audio);
+            if (fileSize("video_1.out") != 0)
+            {
+                result = false;
+                failureDescription << "Video is flushed before interval" << std::endl;
+            }
+
+            audio.readTime = video.readTime + 20000000;
+            writer.write(audio);
+            if (fileSize("video_1.out") != static_cast<std::streamoff>(videoRawData1.size()) || fileSize("audio_1.out") != 0)
+            {
+                result = false;
+                failureDescription << "Only video should be flushed after interval" << std::endl;
+            }
+            if (writer.latency().count() != 1)
+            {
+                result = false;
+                failureDescription << "Got " << writer.latency().count() << " latency samples instead of 1" << std::endl;
+            }
+        }
+        catch (const Error& err)
+        {
+            result = false;
+            failureDescription << "Unexpected error: " << err.message() << std::endl;
+        }
+        std::remove("audio_1.out");
+        std::remove("video_1.out");
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << failureDescription.str();
+        failures += 1 - result;
+    }
+
+    // without flush interval data is handed to file system in 64 KB blocks, every hand-off is sampled
+    {
+        std::cout << "Running OutputWriter.write_LatencyOfHandOffs_OK ... ";
+        std::ostringstream failureDescription;
+        bool result = true;
+        auto fileSize = [](const char* name) { return std::ifstream(name, std::ifstream::binary | std::ifstream::ate).tellg(); };
+        try
+        {
+            OutputNameGenerator audioNamer("audio_1.out");
+            OutputNameGenerator videoNamer("video_1.out");
+            OutputWriter writer(failureDescription, audioNamer, videoNamer);
+            writer.setLatencyReport(3600000000000ULL);
+
+            const std::vector<uint8_t> data(1000, 0x55);
+            EsRawData video{ data.data(), static_cast<uint16_t>(data.size()), EsType::VIDEO, 1 };
+            video.readTime = LatencyHistogram::now();
+            for (size_t i = 0; i < 200; ++i)
+                writer.write(video);
+
+            // hand-off of 65 collected writes and the one not fitting
+            if (fileSize("video_1.out") != 3 * 66000)
+            {
+                result = false;
+                failureDescription << "Got " << fileSize("video_1.out") << " bytes handed off instead of " << 3 * 66000 << std::endl;
+            }
+            if (writer.latency().count() != 3)
+            {
+                result = false;
+                failureDescription << "Got " << writer.latency().count() << " latency samples instead of 3" << std::endl;
+            }
+        }
+        catch (const Error& err)
+        {
+            result = false;
+            failureDescription << "Unexpected error: " << err.message() << std::endl;
+        }
+        std::remove("audio_1.out");
+        std::remove("video_1.out");
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << failureDescription.str();
+        failures += 1 - result;
+    }
+
+    // data of idle ES is flushed by check of deadlines without new data
+    {
+        std::cout << "Running OutputWriter.checkDeadlines_IdleOutput_Flushed ... ";
+        std::ostringstream failureDescription;
+        bool result = true;
+        auto fileSize = [](const char* name) { return std::ifstream(name, std::ifstream::binary | std::ifstream::ate).tellg(); };
+        try
+        {
+            OutputNameGenerator audioNamer("audio_1.out");
+            OutputNameGenerator videoNamer("video_1.out");
+            OutputWriter writer(failureDescription, audioNamer, videoNamer);
+            writer.setFlushInterval(1000000);
+
+            const std::vector<uint8_t> data(1000, 0x55);
+            EsRawData video{ data.data(), static_cast<uint16_t>(data.size()), EsType::VIDEO, 1 };
+            video.readTime = LatencyHistogram::now();
+            writer.write(video);
+
+            writer.checkDeadlines(video.readTime + 999999);
+            if (fileSize("video_1.out") != 0)
+            {
+                result = false;
+                failureDescription << "Got " << fileSize("video_1.out") << " bytes flushed before deadline" << std::endl;
+            }
+            writer.checkDeadlines(video.readTime + 1000000);
+            if (fileSize("video_1.out") != 1000)
+            {
+                result = false;
+                failureDescription << "Got " << fileSize("video_1.out") << " bytes flushed at deadline instead of 1000" << std::endl;
+            }
+        }
+        catch (const Error& err)
+        {
+            result = false;
+            failureDescription << "Unexpected error: " << err.message() << std::endl;
+        }
+        std::remove("audio_1.out");
+        std::remove("video_1.out");
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << failureDescription.str();
+        failures += 1 - result;
+    }
+
+    // manifest lists hashes, sizes and names of files
+    {
+        std::cout << "Running OutputWriter.writeManifest_TwoFiles_OK ... ";
+        std::ostringstream manifest;
+        OutputWriter::writeManifest(manifest, { { "video_1.out", EsType::VIDEO, 1, 1000, 0xE3069283 },
+                                                { "audio_1.out", EsType::AUDIO, 1, 20, 0x1F } });
+        const bool result = manifest.str() == "e3069283 1000 video_1.out\n0000001f 20 audio_1.out\n";
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << "Got manifest:\n" << manifest.str();
+        failures += 1 - result;
+    }
+
     return failures;
 }
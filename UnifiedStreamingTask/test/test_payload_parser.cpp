@@ -1,6 +1,8 @@
+#include "../crc32.hpp"
 #include "../error.hpp"
 #include "../payload_parser.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <set>
 #include <sstream>
@@ -216,10 +218,12 @@ namespace
     };
 
     /// @brief Run one PayloadParser unit test.
+    /// @param[in] assembly - Mode of passing raw data of PES packets.
     /// @returns true if test passed, false otherwise.
     bool runTest(const std::string& testName,
                  const std::vector<TsPayload>& input,
-                 const ExpectedResult& expected)
+                 const ExpectedResult& expected,
+                 PayloadParser::PesAssembly assembly = PayloadParser::PesAssembly::NONE)
     {
         std::cout << "Running PayloadParser." << testName << " ... ";
 
@@ -230,8 +234,10 @@ namespace
         std::ostringstream audioRawData;
         std::ostringstream videoRawData;
         std::ostringstream log;
-        auto handler = [&audioStreams, &videoStreams, &audioRawData, &videoRawData](const EsRawData& rd)
+        bool partialPes = false;
+        auto handler = [&audioStreams, &videoStreams, &audioRawData, &videoRawData, &partialPes](const EsRawData& rd)
         {
+            partialPes |= !rd.newEsPacket;
             if (rd.type == EsType::AUDIO)
             {
                 audioStreams.insert(rd.esNumber);
@@ -247,8 +253,10 @@ namespace
         try
         {
             PayloadParser parser(log, handler);
+            parser.setPesAssembly(assembly);
             for (const auto& payload : input)
                 parser.parse(payload);
+            parser.flush();
         }
         catch (const Error& err)
         {
@@ -288,12 +296,126 @@ namespace
             result = false;
             log << "Produced video raw data differs from expected" << std::endl;
         }
+        if (assembly != PayloadParser::PesAssembly::NONE && partialPes)
+        {
+            result = false;
+            log << "Produced raw data is not a whole PES packet" << std::endl;
+        }
 
         std::cout << (result ? "OK" : "FAIL") << std::endl;
         if (!result)
             std::cout << log.str();
         return result;
     }
+
+    /// @brief Run one PayloadParser unit test on validation levels.
+    /// @param[in] expectedStreams - Number of detected audio and video streams.
+    /// @param[in] expected - Expected error counters of statistics.
+    /// @returns true if test passed, false otherwise.
+    bool runValidationTest(const std::string& testName,
+                           const std::vector<TsPayload>& input,
+                           Validation validation,
+                           size_t expectedStreams,
+                           const PayloadParser::Statistics& expected)
+    {
+        std::cout << "Running PayloadParser." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+        try
+        {
+            PayloadParser parser(log, [](const EsRawData&) {});
+            parser.setValidation(validation);
+            for (const auto& payload : input)
+                parser.parse(payload);
+
+            size_t streams = 0;
+            for (const auto& pair : parser.streams())
+                streams += pair.second.type != EsType::OTHER;
+            if (streams != expectedStreams)
+            {
+                result = false;
+                log << "Got " << streams << " streams instead of " << expectedStreams << std::endl;
+            }
+
+            const auto& statistics = parser.statistics();
+            if (statistics.psiErrors != expected.psiErrors || statistics.pesErrors != expected.pesErrors ||
+                statistics.timestampErrors != expected.timestampErrors)
+            {
+                result = false;
+                log << "Got " << statistics.psiErrors << " PSI, " << statistics.pesErrors << " PES and "
+                    << statistics.timestampErrors << " timestamp errors instead of " << expected.psiErrors << ", "
+                    << expected.pesErrors << " and " << expected.timestampErrors << std::endl;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+
+    /// @brief Run one PayloadParser unit test on logging of broken PES packets by validation levels.
+    /// @param[in] expectedLogged - If set, warning on broken PES packet is expected in log.
+    /// @returns true if test passed, false otherwise.
+    bool runBrokenPesLogTest(const std::string& testName,
+                             const std::vector<TsPayload>& input,
+                             Validation validation,
+                             bool expectedLogged)
+    {
+        std::cout << "Running PayloadParser." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+        std::ostringstream parserLog;
+        try
+        {
+            PayloadParser parser(parserLog, [](const EsRawData&) {});
+            parser.setValidation(validation);
+            parser.setPesAssembly(PayloadParser::PesAssembly::FLAG);
+            for (const auto& payload : input)
+                parser.parse(payload);
+            parser.flush();
+
+            if (parser.statistics().brokenPes != 1)
+            {
+                result = false;
+                log << "Got " << parser.statistics().brokenPes << " broken PES packets instead of 1" << std::endl;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        const bool logged = parserLog.str().find("broken PES packet") != std::string::npos;
+        if (logged != expectedLogged)
+        {
+            result = false;
+            log << "Broken PES packet is " << (logged ? "" : "not ") << "logged" << std::endl;
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+
+    /// @brief Make statistics with given error counters.
+    PayloadParser::Statistics errors(uint64_t psiErrors, uint64_t pesErrors, uint64_t timestampErrors)
+    {
+        PayloadParser::Statistics statistics;
+        statistics.psiErrors = psiErrors;
+        statistics.pesErrors = pesErrors;
+        statistics.timestampErrors = timestampErrors;
+        return statistics;
+    }
 }
 
 /// @brief Run all PayloadParser unit tests.
@@ -420,5 +542,137 @@ uint16_t testPayloadParser()
         failures += 1 - runTest("parse_Ac3AndVideoPayloadsWithPmt_OK", payloads, expected);
     }
 
+    // video payload with PTS and DTS
+    {
+        const std::vector<uint8_t> header{ 0x00, 0x00, 0x01, 0xE0, 0x00, 0x00, 0x84, 0xC0, 0x0A,
+                                           0x31, 0x00, 0x05, 0xBF, 0x21, 0x11, 0x00, 0x05, 0xA3, 0x55 };
+        std::vector<uint8_t> payload = header;
+        payload.insert(payload.end(), videoRawData1.begin(), videoRawData1.end());
+
+        std::vector<TsPayload> payloads;
+        payloads.push_back({ payload.data(), static_cast<uint16_t>(payload.size()), videoPid, true });
+        std::ostringstream videoRawData;
+        videoRawData.write(reinterpret_cast<const char*>(videoRawData1.data()), videoRawData1.size());
+        ExpectedResult expected{ Error::OK, 0, 1, "", videoRawData.str() };
+        failures += 1 - runTest("parse_VideoPayloadWithPtsAndDts_OK", payloads, expected);
+    }
+
+    // whole video PES packet without length, passed at the end of input
+    {
+        std::vector<TsPayload> payloads;
+        payloads.push_back({ videoPayload1.data(), static_cast<uint16_t>(videoPayload1.size()), videoPid, true });
+        payloads.push_back({ videoPayload2.data(), static_cast<uint16_t>(videoPayload2.size()), videoPid, false });
+        std::ostringstream videoRawData;
+        videoRawData.write(reinterpret_cast<const char*>(videoRawData1.data()), videoRawData1.size());
+        videoRawData.write(reinterpret_cast<const char*>(videoRawData2.data()), videoRawData2.size());
+        ExpectedResult expected{ Error::OK, 0, 1, "", videoRawData.str() };
+        failures += 1 - runTest("parse_AssembledVideo_OK", payloads, expected, PayloadParser::PesAssembly::DROP);
+    }
+
+    // whole video PES packets with length, 2nd one is passed as soon as it's complete
+    {
+        const std::vector<uint8_t> header{ 0x00, 0x00, 0x01, 0xE0, 0x00, 0x00, 0x84, 0x80, 0x05, 0x21, 0x00, 0x37, 0x77, 0x41 };
+        std::vector<uint8_t> payload = header;
+        payload.insert(payload.end(), videoRawData1.begin(), videoRawData1.end());
+        const size_t pesSize = payload.size() - 6;
+        payload[4] = static_cast<uint8_t>(pesSize >> 8);
+        payload[5] = static_cast<uint8_t>(pesSize);
+
+        std::vector<TsPayload> payloads;
+        payloads.push_back({ payload.data(), static_cast<uint16_t>(payload.size()), videoPid, true });
+        payloads.push_back({ payload.data(), static_cast<uint16_t>(payload.size()), videoPid, true });
+        payloads.push_back({ videoPayload2.data(), static_cast<uint16_t>(videoPayload2.size()), videoPid, false });
+        std::ostringstream videoRawData;
+        videoRawData.write(reinterpret_cast<const char*>(videoRawData1.data()), videoRawData1.size());
+        videoRawData.write(reinterpret_cast<const char*>(videoRawData1.data()), videoRawData1.size());
+        ExpectedResult expected{ Error::OK, 0, 1, "", videoRawData.str() };
+        failures += 1 - runTest("parse_AssembledVideoWithLength_OK", payloads, expected, PayloadParser::PesAssembly::DROP);
+    }
+
+    // audio PES packet is shorter than its length
+    {
+        std::vector<TsPayload> payloads;
+        payloads.push_back({ audioPayload1.data(), static_cast<uint16_t>(audioPayload1.size()), audioPid, true });
+        payloads.push_back({ audioPayload2.data(), static_cast<uint16_t>(audioPayload2.size()), audioPid, false });
+        std::ostringstream audioRawData;
+        audioRawData.write(reinterpret_cast<const char*>(audioRawData1.data()), audioRawData1.size());
+        audioRawData.write(reinterpret_cast<const char*>(audioRawData2.data()), audioRawData2.size());
+        ExpectedResult expected{ Error::OK, 1, 0, audioRawData.str(), "" };
+        failures += 1 - runTest("parse_AssembledAudioWrongLengthFlag_OK", payloads, expected, PayloadParser::PesAssembly::FLAG);
+
+        expected = { Error::OK, 0, 0, "", "" };
+        failures += 1 - runTest("parse_AssembledAudioWrongLengthDrop_OK", payloads, expected, PayloadParser::PesAssembly::DROP);
+    }
+
+    // video PES packet with lost TS packets is dropped, the next one is passed
+    {
+        std::vector<TsPayload> payloads;
+        payloads.push_back({ videoPayload1.data(), static_cast<uint16_t>(videoPayload1.size()), videoPid, true });
+        payloads.push_back({ videoPayload2.data(), static_cast<uint16_t>(videoPayload2.size()), videoPid, false, 0, noTimestamp, false, true });
+        payloads.push_back({ videoPayload1.data(), static_cast<uint16_t>(videoPayload1.size()), videoPid, true });
+        std::ostringstream videoRawData;
+        videoRawData.write(reinterpret_cast<const char*>(videoRawData1.data()), videoRawData1.size());
+        ExpectedResult expected{ Error::OK, 0, 1, "", videoRawData.str() };
+        failures += 1 - runTest("parse_AssembledVideoDiscontinuity_OK", payloads, expected, PayloadParser::PesAssembly::DROP);
+    }
+
+    // PAT with wrong CRC is dropped, unless input is trusted
+    {
+        std::vector<uint8_t> pat = patPayload;
+        pat[16] ^= 0xFF;
+        std::vector<TsPayload> payloads;
+        payloads.push_back({ pat.data(), static_cast<uint16_t>(pat.size()), patPid, true });
+        payloads.push_back({ pmtPayload.data(), static_cast<uint16_t>(pmtPayload.size()), pmtPid, true });
+        failures += 1 - runValidationTest("parse_WrongCrcDefault_Dropped", payloads, Validation::DEFAULT, 0, errors(1, 0, 0));
+        failures += 1 - runValidationTest("parse_WrongCrcTrusted_Parsed", payloads, Validation::TRUSTED, 2, errors(0, 0, 0));
+    }
+
+    // PMT refers to null packets PID as audio ES
+    {
+        std::vector<uint8_t> pmt = pmtPayload;
+        pmt[22] = 0xFF;
+        pmt[23] = 0xFF;
+        const uint32_t crc = crc32(pmt.data() + 1, 28);
+        for (size_t i = 0; i < 4; ++i)
+            pmt[29 + i] = static_cast<uint8_t>(crc >> (24 - 8 * i));
+        std::vector<TsPayload> payloads;
+        payloads.push_back({ patPayload.data(), static_cast<uint16_t>(patPayload.size()), patPid, true });
+        payloads.push_back({ pmt.data(), static_cast<uint16_t>(pmt.size()), pmtPid, true });
+        failures += 1 - runValidationTest("parse_ReservedEsPidDefault_OK", payloads, Validation::DEFAULT, 2, errors(0, 0, 0));
+        failures += 1 - runValidationTest("parse_ReservedEsPidParanoid_Dropped", payloads, Validation::PARANOID, 1, errors(1, 0, 0));
+    }
+
+    // audio PES packet is shorter than its length
+    {
+        std::vector<TsPayload> payloads;
+        payloads.push_back({ audioPayload1.data(), static_cast<uint16_t>(audioPayload1.size()), audioPid, true });
+        payloads.push_back({ audioPayload2.data(), static_cast<uint16_t>(audioPayload2.size()), audioPid, false });
+        payloads.push_back({ audioPayload1.data(), static_cast<uint16_t>(audioPayload1.size()), audioPid, true });
+        failures += 1 - runValidationTest("parse_WrongPesLengthDefault_OK", payloads, Validation::DEFAULT, 1, errors(0, 0, 0));
+        failures += 1 - runValidationTest("parse_WrongPesLengthParanoid_Counted", payloads, Validation::PARANOID, 1, errors(0, 1, 0));
+
+        // broken assembled PES packet is counted, but not logged for trusted input
+        payloads.pop_back();
+        failures += 1 - runBrokenPesLogTest("flush_BrokenPesDefault_Logged", payloads, Validation::DEFAULT, true);
+        failures += 1 - runBrokenPesLogTest("flush_BrokenPesTrusted_NotLogged", payloads, Validation::TRUSTED, false);
+    }
+
+    // DTS of the 2nd video PES packet goes backwards
+    {
+        const std::vector<uint8_t> header{ 0x00, 0x00, 0x01, 0xE0, 0x00, 0x00, 0x84, 0xC0, 0x0A,
+                                           0x31, 0x00, 0x05, 0xBF, 0x21, 0x11, 0x00, 0x05, 0xA3, 0x55 };
+        std::vector<uint8_t> payload = header;
+        payload.insert(payload.end(), videoRawData1.begin(), videoRawData1.end());
+
+        std::vector<TsPayload> payloads;
+        payloads.push_back({ videoPayload1.data(), static_cast<uint16_t>(videoPayload1.size()), videoPid, true });
+        payloads.push_back({ payload.data(), static_cast<uint16_t>(payload.size()), videoPid, true });
+        failures += 1 - runValidationTest("parse_DtsBackwardsDefault_OK", payloads, Validation::DEFAULT, 1, errors(0, 0, 0));
+        failures += 1 - runValidationTest("parse_DtsBackwardsParanoid_Counted", payloads, Validation::PARANOID, 1, errors(0, 0, 1));
+
+        std::reverse(payloads.begin(), payloads.end());
+        failures += 1 - runValidationTest("parse_DtsForwardParanoid_OK", payloads, Validation::PARANOID, 1, errors(0, 0, 0));
+    }
+
     return failures;
 }
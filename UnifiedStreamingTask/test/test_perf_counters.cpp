@@ -0,0 +1,133 @@
+#include "../error.hpp"
+#include "../perf_counters.hpp"
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    /// @brief Open performance counters.
+    /// @returns Counters or nullptr if they are unavailable on this host, then test is skipped.
+    std::unique_ptr<PerfCounters> openCounters()
+    {
+        try
+        {
+            return std::unique_ptr<PerfCounters>(new PerfCounters());
+        }
+        catch (const Error& e)
+        {
+            std::cout << "skipped, " << e.what() << " ... ";
+            return nullptr;
+        }
+    }
+
+    /// @brief Do some work touching memory.
+    size_t touchMemory()
+    {
+        std::vector<char> memory(4 * 1024 * 1024);
+        size_t sum = 0;
+        for (size_t i = 0; i < memory.size(); i += 4096)
+        {
+            memory[i] = static_cast<char>(i);
+            sum += memory[i];
+        }
+        return sum;
+    }
+
+    /// @brief Check if report has row of stage.
+    bool hasRow(const std::string& report, const std::string& stage)
+    {
+        return report.find("\n" + stage + " ") != std::string::npos;
+    }
+}
+
+/// @brief Run all PerfCounters unit tests.
+/// @returns Number of failed tests.
+uint16_t testPerfCounters()
+{
+    uint16_t failures = 0;
+
+    // counts are added to the stage entered before them
+    {
+        std::cout << "Running PerfCounters.enter_TwoStages_CountedSeparately ... ";
+        bool result = true;
+        std::ostringstream failureDescription;
+        auto counters = openCounters();
+        if (counters)
+        {
+            counters->enter(PerfStage::SPLIT);
+            const size_t sum = touchMemory();
+            counters->enter(PerfStage::CLOSE);
+            counters->stop();
+            const auto& split = counters->counts(PerfStage::SPLIT);
+
+            if (!split.nanoseconds || !counters->counts(PerfStage::CLOSE).nanoseconds || counters->counts(PerfStage::READ).nanoseconds)
+            {
+                result = false;
+                failureDescription << "Got wrong stage times" << std::endl;
+            }
+            for (auto value : counters->counts(PerfStage::READ).events)
+            {
+                if (value)
+                {
+                    result = false;
+                    failureDescription << "Got counts of not entered stage" << std::endl;
+                }
+            }
+            if (counters->available(PerfCounters::INSTRUCTIONS) && split.events[PerfCounters::INSTRUCTIONS] < 1000)
+            {
+                result = false;
+                failureDescription << "Got " << split.events[PerfCounters::INSTRUCTIONS] << " instructions only, checksum " << sum << std::endl;
+            }
+
+            // stopped counters count nothing
+            const auto closeTime = counters->counts(PerfStage::CLOSE).nanoseconds;
+            counters->stop();
+            if (counters->counts(PerfStage::CLOSE).nanoseconds != closeTime)
+            {
+                result = false;
+                failureDescription << "Got counts of stopped counters" << std::endl;
+            }
+        }
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << failureDescription.str();
+        failures += 1 - result;
+    }
+
+    // report has rows of entered stages and total, unavailable counters are 'n/a'
+    {
+        std::cout << "Running PerfCounters.report_EnteredStages_OK ... ";
+        bool result = true;
+        std::string report;
+        auto counters = openCounters();
+        if (counters)
+        {
+            counters->enter(PerfStage::READ);
+            counters->enter(PerfStage::SPLIT);
+            touchMemory();
+            counters->stop();
+            std::ostringstream output;
+            counters->report(output, 1024 * 1024, 5577);
+            report = output.str();
+
+            bool allAvailable = true;
+            for (auto event : { PerfCounters::CYCLES, PerfCounters::INSTRUCTIONS, PerfCounters::CACHE_MISSES, PerfCounters::BRANCH_MISSES, PerfCounters::PAGE_FAULTS })
+                allAvailable = allAvailable && counters->available(event);
+
+            result = report.find("1048576 bytes, 5577 packets") != std::string::npos && report.find("cycles/packet") != std::string::npos &&
+                     hasRow(report, "read") && hasRow(report, "split") && !hasRow(report, "close") && !hasRow(report, "verify") &&
+                     hasRow(report, "total") && (report.find("n/a") == std::string::npos) == allAvailable;
+        }
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << "Got report:\n" << report;
+        failures += 1 - result;
+    }
+
+    return failures;
+}
@@ -0,0 +1,167 @@
+#include "../error.hpp"
+#include "../payload_parser.hpp"
+#include "../pid_filter.hpp"
+#include "../ts_reader.hpp"
+#include "ts_generator.hpp"
+
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+
+
+namespace
+{
+    /// @brief Generate MPTS with 2 programs, the 2nd one also has private data stream,
+    ///        audio streams have English and German languages.
+    std::string makeInput()
+    {
+        TsGenerator generator;
+        generator.addProgram(1, 0x100);
+        generator.addStream(1, 0x101, 0x1B);
+        generator.addStream(1, 0x102, 0x0F, std::string("\x0A\x04" "eng\x00", 6));
+        generator.addProgram(2, 0x200);
+        generator.addStream(2, 0x201, 0x1B);
+        generator.addStream(2, 0x202, 0x0F, std::string("\x0A\x04" "deu\x00", 6));
+        generator.addStream(2, 0x203, 0x06);
+
+        std::string input = generator.pat() + generator.pmt(1) + generator.pmt(2);
+        for (int i = 0; i < 2; ++i)
+        {
+            input += generator.pes(0x101, 0xE0, std::string(300, 'v'), 90000 * i);
+            input += generator.pes(0x102, 0xC0, std::string(100, 'a'), 90000 * i);
+            input += generator.pes(0x201, 0xE0, std::string(300, 'V'), 90000 * i);
+            input += generator.pes(0x202, 0xC0, std::string(100, 'A'), 90000 * i);
+            input += generator.pes(0x203, 0xBD, std::string(100, 'p'), 90000 * i);
+        }
+        return input;
+    }
+
+    /// @brief Run one PidFilter unit test.
+    /// @details Input is read by TsReader with filter, which is updated by PayloadParser tables.
+    /// @param[in] selection - Rules of selecting PIDs.
+    /// @param[in] expectedPids - Expected PIDs of payloads passed by reader.
+    /// @param[in] expectedStreams - Expected ES numbers of raw data by PID, audio and video ES are numbered separately.
+    /// @param[in] expectedLog - Expected fragment of log, may be empty.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 const PidSelection& selection,
+                 const std::set<uint16_t>& expectedPids,
+                 const std::map<uint16_t, uint16_t>& expectedStreams,
+                 const std::string& expectedLog = std::string())
+    {
+        std::cout << "Running PidFilter." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+        std::set<uint16_t> pids;
+        std::map<uint16_t, uint16_t> streams;
+        uint64_t filteredPackets = 0;
+
+        try
+        {
+            std::istringstream input(makeInput());
+            PayloadParser parser(log, [&streams](const EsRawData& rawData) { streams[rawData.pid] = rawData.esNumber; });
+            PidFilter filter(log, selection, parser.streams(), parser.programs());
+            parser.setTableHandler([&filter](const PayloadParser::TableInfo&) { filter.update(); });
+
+            TsReader reader(input, log, [&parser, &pids](const TsPayload& payload)
+            {
+                pids.insert(payload.pid);
+                parser.parse(payload);
+            });
+            reader.setPidFilter(&filter);
+            reader.readAll();
+            filteredPackets = reader.statistics().filteredPackets;
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        if (pids != expectedPids)
+        {
+            result = false;
+            log << "Got " << pids.size() << " passed PIDs instead of " << expectedPids.size() << std::endl;
+        }
+        if (streams != expectedStreams)
+        {
+            result = false;
+            log << "Got " << streams.size() << " ES instead of " << expectedStreams.size() << std::endl;
+        }
+        if ((filteredPackets == 0) != (expectedPids.size() == 8))
+        {
+            result = false;
+            log << "Got " << filteredPackets << " filtered packets" << std::endl;
+        }
+        if (!expectedLog.empty() && log.str().find(expectedLog) == std::string::npos)
+        {
+            result = false;
+            log << "No '" << expectedLog << "' in log" << std::endl;
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+}
+
+/// @brief Run all PidFilter unit tests.
+/// @returns Number of failed tests.
+uint16_t testPidFilter()
+{
+    uint16_t failures = 0;
+
+    const std::set<uint16_t> allPids{ 0, 0x100, 0x101, 0x102, 0x200, 0x201, 0x202, 0x203 };
+    const std::map<uint16_t, uint16_t> allStreams{ { 0x101, 1 }, { 0x102, 1 }, { 0x201, 2 }, { 0x202, 2 } };
+
+    failures += 1 - runTest("update_NothingSelected_OK", PidSelection(), allPids, allStreams);
+
+    // ES of other programs are not numbered
+    failures += 1 - runTest("update_Program_OK", PidSelection{ {}, { 2 }, {}, {} },
+                            { 0, 0x200, 0x201, 0x202, 0x203 }, { { 0x201, 1 }, { 0x202, 1 } });
+
+    // ES are numbered by all PMTs as if nothing is selected
+    failures += 1 - runTest("update_Pids_OK", PidSelection{ { 0x202 }, {}, {}, {} },
+                            { 0, 0x100, 0x200, 0x202 }, { { 0x202, 2 } });
+
+    // PID of other program is detected by PES header after ES of selected program
+    failures += 1 - runTest("update_ProgramAndPids_OK", PidSelection{ { 0x102 }, { 2 }, { 0x203 }, {} },
+                            { 0, 0x102, 0x200, 0x201, 0x202 }, { { 0x102, 2 }, { 0x201, 1 }, { 0x202, 1 } });
+
+    failures += 1 - runTest("update_ExcludedPids_OK", PidSelection{ {}, {}, { 0x101, 0x203 }, {} },
+                            { 0, 0x100, 0x102, 0x200, 0x201, 0x202 }, { { 0x102, 1 }, { 0x201, 2 }, { 0x202, 2 } });
+
+    failures += 1 - runTest("update_ExcludedTypes_OK", PidSelection{ {}, {}, {}, { EsType::VIDEO, EsType::OTHER } },
+                            { 0, 0x100, 0x102, 0x200, 0x202 }, { { 0x102, 1 }, { 0x202, 2 } });
+
+    failures += 1 - runTest("update_AudioLanguages_OK", PidSelection{ {}, {}, {}, {}, { "deu" } },
+                            { 0, 0x100, 0x101, 0x200, 0x201, 0x202, 0x203 }, { { 0x101, 1 }, { 0x201, 2 }, { 0x202, 2 } });
+
+    failures += 1 - runTest("update_MissingProgram_Warning", PidSelection{ {}, { 3 }, {}, {} }, { 0 }, {},
+                            "Warning: PidFilter, program 3 is not found in PAT");
+
+    // PID out of range
+    {
+        std::cout << "Running PidFilter.ctor_WrongPid_Exception ... ";
+        bool result = false;
+        std::ostringstream log;
+        const std::map<uint16_t, PayloadParser::StreamInfo> streams;
+        const std::map<uint16_t, PayloadParser::ProgramInfo> programs;
+        try
+        {
+            PidFilter filter(log, PidSelection{ { 0x2000 }, {}, {}, {} }, streams, programs);
+        }
+        catch (const Error& e)
+        {
+            result = e.code() == Error::CONSTRUCTION_ERROR;
+        }
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        failures += 1 - result;
+    }
+
+    return failures;
+}
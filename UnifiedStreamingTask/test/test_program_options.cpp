@@ -1,7 +1,10 @@
 #include "../error.hpp"
 #include "../program_options.hpp"
 
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <set>
 #include <sstream>
 #include <vector>
 
@@ -25,8 +28,74 @@ namespace
 
         /// @brief Video output name.
         std::string videoOutputName;
+
+        /// @brief Request for streams inventory.
+        bool probeRequested;
+
+        /// @brief Request for sampling streams inventory.
+        bool quickProbeRequested;
+
+        /// @brief Start of time range.
+        TimePoint startTime;
+
+        /// @brief End of time range.
+        TimePoint endTime;
+
+        /// @brief Request for following growing input.
+        bool followRequested;
+
+        /// @brief PIDs to read.
+        std::set<uint16_t> pids;
+
+        /// @brief Programs to read.
+        std::set<uint16_t> programs;
+
+        /// @brief Languages of audio ES to read.
+        std::set<std::string> audioLanguages;
+
+        /// @brief TS output name.
+        std::string tsOutputName;
+
+        /// @brief Request for SPTS per program.
+        bool tsPerProgramRequested;
+
+        /// @brief Number of jobs parsed from job file.
+        size_t jobs;
+
+        /// @brief Maximum number of open ES output files.
+        size_t maxOpenFiles;
+
+        /// @brief Request for report of CPU features.
+        bool cpuFeaturesRequested;
+
+        /// @brief Level of input validation.
+        Validation validation;
+
+        /// @brief Request for verification of ES outputs.
+        bool verifyRequested;
+
+        /// @brief Manifest file name.
+        std::string manifestName;
+
+        /// @brief Request for report of performance counters.
+        bool perfReportRequested;
+
+        /// @brief Interval in milliseconds of flushing ES outputs.
+        size_t flushInterval;
+
+        /// @brief Interval in seconds of logging latency percentiles.
+        size_t latencyReportInterval;
+
+        /// @brief Index file name.
+        std::string indexName;
     };
 
+    /// @brief Check time points equality.
+    bool equal(const TimePoint& lhs, const TimePoint& rhs)
+    {
+        return lhs.isSet == rhs.isSet && lhs.ticks == rhs.ticks && lhs.isPts == rhs.isPts;
+    }
+
     /// @brief Run one Error unit test.
     /// @returns true if test passed, false otherwise.
     bool runTest(const std::string& testName,
@@ -92,6 +161,103 @@ namespace
             result = false;
             failureDescription << "Got video output '" << po.videoOutputName() << "' instead of '" << expected.videoOutputName << "'" << std::endl;
         }
+        if (po.probeRequested() != expected.probeRequested)
+        {
+            result = false;
+            failureDescription << "Got probe requested " << po.probeRequested() << " instead of " << expected.probeRequested << std::endl;
+        }
+        if (po.quickProbeRequested() != expected.quickProbeRequested)
+        {
+            result = false;
+            failureDescription << "Got quick probe requested " << po.quickProbeRequested() << " instead of " << expected.quickProbeRequested << std::endl;
+        }
+        if (!equal(po.startTime(), expected.startTime))
+        {
+            result = false;
+            failureDescription << "Got start time " << po.startTime().ticks << " instead of " << expected.startTime.ticks << std::endl;
+        }
+        if (!equal(po.endTime(), expected.endTime))
+        {
+            result = false;
+            failureDescription << "Got end time " << po.endTime().ticks << " instead of " << expected.endTime.ticks << std::endl;
+        }
+        if (po.followRequested() != expected.followRequested)
+        {
+            result = false;
+            failureDescription << "Got follow requested " << po.followRequested() << " instead of " << expected.followRequested << std::endl;
+        }
+        if (po.pidSelection().pids != expected.pids || po.pidSelection().programs != expected.programs)
+        {
+            result = false;
+            failureDescription << "Got " << po.pidSelection().pids.size() << " PIDs and " << po.pidSelection().programs.size()
+                               << " programs instead of " << expected.pids.size() << " and " << expected.programs.size() << std::endl;
+        }
+        if (po.pidSelection().audioLanguages != expected.audioLanguages)
+        {
+            result = false;
+            failureDescription << "Got " << po.pidSelection().audioLanguages.size() << " audio languages instead of "
+                               << expected.audioLanguages.size() << std::endl;
+        }
+        if (po.tsOutputName() != expected.tsOutputName || po.tsPerProgramRequested() != expected.tsPerProgramRequested)
+        {
+            result = false;
+            failureDescription << "Got TS output '" << po.tsOutputName() << "' per program " << po.tsPerProgramRequested()
+                               << " instead of '" << expected.tsOutputName << "' per program " << expected.tsPerProgramRequested << std::endl;
+        }
+        if (po.jobs().size() != expected.jobs)
+        {
+            result = false;
+            failureDescription << "Got " << po.jobs().size() << " jobs instead of " << expected.jobs << std::endl;
+        }
+        if (po.cpuFeaturesRequested() != expected.cpuFeaturesRequested)
+        {
+            result = false;
+            failureDescription << "Got CPU features requested " << po.cpuFeaturesRequested() << " instead of " << expected.cpuFeaturesRequested << std::endl;
+        }
+        if (po.maxOpenFiles() != expected.maxOpenFiles)
+        {
+            result = false;
+            failureDescription << "Got max open files " << po.maxOpenFiles() << " instead of " << expected.maxOpenFiles << std::endl;
+        }
+        if (po.validation() != expected.validation)
+        {
+            result = false;
+            failureDescription << "Got validation " << int(po.validation()) << " instead of " << int(expected.validation) << std::endl;
+        }
+        if (po.verifyRequested() != expected.verifyRequested)
+        {
+            result = false;
+            failureDescription << "Got verify requested " << po.verifyRequested() << " instead of " << expected.verifyRequested << std::endl;
+        }
+        if (po.manifestName() != expected.manifestName)
+        {
+            result = false;
+            failureDescription << "Got manifest name '" << po.manifestName() << "' instead of '" << expected.manifestName << "'" << std::endl;
+        }
+        if (po.perfReportRequested() != expected.perfReportRequested)
+        {
+            result = false;
+            failureDescription << "Got perf report requested " << po.perfReportRequested() << " instead of " << expected.perfReportRequested << std::endl;
+        }
+        if (po.flushInterval() != expected.flushInterval || po.latencyReportInterval() != expected.latencyReportInterval)
+        {
+            result = false;
+            failureDescription << "Got flush interval " << po.flushInterval() << " and latency report interval " << po.latencyReportInterval()
+                               << " instead of " << expected.flushInterval << " and " << expected.latencyReportInterval << std::endl;
+        }
+        if (po.indexName() != expected.indexName)
+        {
+            result = false;
+            failureDescription << "Got index name '" << po.indexName() << "' instead of '" << expected.indexName << "'" << std::endl;
+        }
+        for (const auto& job : po.jobs())
+        {
+            if (job->validation() != expected.validation)
+            {
+                result = false;
+                failureDescription << "Got job validation " << int(job->validation()) << " instead of " << int(expected.validation) << std::endl;
+            }
+        }
 
         std::cout << (result ? "OK" : "FAIL") << std::endl;
         if (!result)
@@ -113,6 +279,7 @@ uint16_t testProgramOptions()
 
     args = { "ts_plitter", "-i", "input.ts" };
     expected = { Error::OK, false, "input.ts", "audio_1.out", "video_1.out" };
+    expected.indexName = "video_1.out.idx";
     failures += 1 - runTest("init_InputNoAudioNoVideo_OK", args, expected);
 
     args = { "ts_plitter", "-oa", "audio.out" };
@@ -121,6 +288,7 @@ uint16_t testProgramOptions()
 
     args = { "ts_plitter", "-i", "intput.ts", "-ov", "video.out" };
     expected = { Error::OK, false, "intput.ts", "", "video.out" };
+    expected.indexName = "video.out.idx";
     failures += 1 - runTest("init_InputNoAudioVideo_OK", args, expected);
 
     args = { "ts_plitter", "-oa", "audio.out", "-ov", "video.out" };
@@ -160,11 +328,261 @@ uint16_t testProgramOptions()
     // test repeated options
     args = { "ts_plitter", "-i", "intput1.ts", "-oa", "audio.out", "-i", "intput2.ts" };
     expected = { Error::OK, false, "intput2.ts", "audio.out", "" };
+    expected.indexName = "audio.out.idx";
     failures += 1 - runTest("init_RepeatedInput_OK", args, expected);
 
     args = { "ts_plitter", "-ov", "video_1.out", "-ov", "video_2.out" };
     expected = { Error::OK, false, "", "", "video_2.out" };
     failures += 1 - runTest("init_RepeatedVideo_OK", args, expected);
 
+    // test options without argument
+    args = { "ts_plitter", "-i", "intput.ts", "--probe" };
+    expected = { Error::OK, false, "intput.ts", "audio_1.out", "video_1.out", true };
+    failures += 1 - runTest("init_Probe_OK", args, expected);
+
+    args = { "ts_plitter", "--probe", "-oa", "audio.out" };
+    expected = { Error::OK, false, "", "audio.out", "", true };
+    failures += 1 - runTest("init_ProbeAudio_OK", args, expected);
+
+    args = { "ts_plitter", "-i", "intput.ts", "--quick-probe" };
+    expected = { Error::OK, false, "intput.ts", "audio_1.out", "video_1.out", true, true };
+    failures += 1 - runTest("init_QuickProbe_OK", args, expected);
+
+    args = { "ts_plitter", "-i", "intput.ts", "--follow" };
+    expected = { Error::OK, false, "intput.ts", "audio_1.out", "video_1.out", false, false, { false, 0, false }, { false, 0, false }, true };
+    failures += 1 - runTest("init_Follow_OK", args, expected);
+
+    args = { "ts_plitter", "--follow" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, true, "", "", "", false, false, { false, 0, false }, { false, 0, false }, true };
+    failures += 1 - runTest("init_FollowStdin_Exception", args, expected);
+
+    // test segmentation
+    args = { "ts_plitter", "-ov", "video_1_%05d.h264", "--segment-size", "64M", "--segment-keyframes" };
+    expected = { Error::OK, false, "", "", "video_1_%05d.h264" };
+    failures += 1 - runTest("init_SegmentSize_OK", args, expected);
+
+    args = { "ts_plitter", "-ov", "video_1.h264", "--segment-duration", "10" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, true, "", "", "video_1.h264" };
+    failures += 1 - runTest("init_SegmentNoPattern_Exception", args, expected);
+
+    args = { "ts_plitter", "-ov", "video_1_%05d.h264", "--segment-size", "64X" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, false, "", "", "video_1_%05d.h264" };
+    failures += 1 - runTest("init_WrongSegmentSize_Exception", args, expected);
+
+    args = { "ts_plitter", "-oa", "audio_%05d.aac", "--segment-size", "1M", "--max-open-files", "16" };
+    expected = { Error::OK, false, "", "audio_%05d.aac", "", false, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "", false, 0, 16 };
+    failures += 1 - runTest("init_MaxOpenFiles_OK", args, expected);
+
+    args = { "ts_plitter", "-oa", "audio.aac", "--max-open-files", "0" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, false, "", "audio.aac", "" };
+    failures += 1 - runTest("init_WrongMaxOpenFiles_Exception", args, expected);
+
+    args = { "ts_plitter", "--cpu-features" };
+    expected = { Error::OK, false, "", "audio_1.out", "video_1.out", false, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "", false, 0, 0, true };
+    failures += 1 - runTest("init_CpuFeatures_OK", args, expected);
+
+    // test validation level
+    args = { "ts_plitter", "--validation", "paranoid" };
+    expected = { Error::OK, false, "", "audio_1.out", "video_1.out", false, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "", false, 0, 0, false, Validation::PARANOID };
+    failures += 1 - runTest("init_Validation_OK", args, expected);
+
+    args = { "ts_plitter", "--validation", "none" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, false, "", "", "" };
+    failures += 1 - runTest("init_WrongValidation_Exception", args, expected);
+
+    // test verification of outputs
+    args = { "ts_plitter", "-ov", "video.out", "--verify" };
+    expected = { Error::OK, false, "", "", "video.out", false, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "", false, 0, 0, false, Validation::DEFAULT, true };
+    failures += 1 - runTest("init_Verify_OK", args, expected);
+
+    args = { "ts_plitter", "--verify", "--probe" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, true, "", "", "", true, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "", false, 0, 0, false, Validation::DEFAULT, true };
+    failures += 1 - runTest("init_VerifyProbe_Exception", args, expected);
+
+    // test manifest of outputs
+    args = { "ts_plitter", "-ov", "video.out", "--manifest", "outputs.txt" };
+    expected = { Error::OK, false, "", "", "video.out", false, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "", false, 0, 0, false, Validation::DEFAULT, false, "outputs.txt" };
+    failures += 1 - runTest("init_Manifest_OK", args, expected);
+
+    args = { "ts_plitter", "--manifest", "outputs.txt", "--probe" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, true, "", "", "", true, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "", false, 0, 0, false, Validation::DEFAULT, false, "outputs.txt" };
+    failures += 1 - runTest("init_ManifestProbe_Exception", args, expected);
+
+    // test report of performance counters
+    args = { "ts_plitter", "-ov", "video.out", "--perf-report" };
+    expected = { Error::OK, false, "", "", "video.out", false, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "", false, 0, 0, false, Validation::DEFAULT, false, "", true };
+    failures += 1 - runTest("init_PerfReport_OK", args, expected);
+
+    args = { "ts_plitter", "--perf-report", "--probe" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, true, "", "", "", true, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "", false, 0, 0, false, Validation::DEFAULT, false, "", true };
+    failures += 1 - runTest("init_PerfReportProbe_Exception", args, expected);
+
+    // test flush interval and latency report
+    args = { "ts_plitter", "-ov", "video.out", "--flush-interval", "20", "--latency-report", "10" };
+    expected = { Error::OK, false, "", "", "video.out", false, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "", false, 0, 0, false, Validation::DEFAULT, false, "", false, 20, 10 };
+    failures += 1 - runTest("init_FlushIntervalLatencyReport_OK", args, expected);
+
+    args = { "ts_plitter", "-ov", "video.out", "--flush-interval", "0" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, false, "", "", "video.out" };
+    failures += 1 - runTest("init_ZeroFlushInterval_Exception", args, expected);
+
+    args = { "ts_plitter", "--latency-report", "5", "--probe" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, true, "", "", "", true, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "", false, 0, 0, false, Validation::DEFAULT, false, "", false, 0, 5 };
+    failures += 1 - runTest("init_LatencyReportProbe_Exception", args, expected);
+
+    // test PID selection
+    args = { "ts_plitter", "--pids", "256,0x101", "--program", "3" };
+    expected = { Error::OK, false, "", "audio_1.out", "video_1.out", false, false, { false, 0, false }, { false, 0, false }, false,
+                 { 256, 257 }, { 3 } };
+    failures += 1 - runTest("init_PidsAndProgram_OK", args, expected);
+
+    args = { "ts_plitter", "--pids", "256,8192" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, false, "", "", "" };
+    failures += 1 - runTest("init_WrongPid_Exception", args, expected);
+
+    args = { "ts_plitter", "--program", "0" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, false, "", "", "" };
+    failures += 1 - runTest("init_WrongProgram_Exception", args, expected);
+
+    args = { "ts_plitter", "--exclude-pids", "256,", "-i", "input.ts" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, false, "", "", "" };
+    failures += 1 - runTest("init_WrongExcludedPids_Exception", args, expected);
+
+    args = { "ts_plitter", "--audio-lang", "eng,DEU" };
+    expected = { Error::OK, false, "", "audio_1.out", "video_1.out", false, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, { "deu", "eng" } };
+    failures += 1 - runTest("init_AudioLang_OK", args, expected);
+
+    args = { "ts_plitter", "--audio-lang", "en,deu" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, false, "", "", "" };
+    failures += 1 - runTest("init_WrongAudioLang_Exception", args, expected);
+
+    args = { "ts_plitter", "--probe", "--pids", "256" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, true, "", "", "", true, false, { false, 0, false }, { false, 0, false }, false,
+                 { 256 } };
+    failures += 1 - runTest("init_PidsProbe_Exception", args, expected);
+
+    // test TS output, no ES output is written by default
+    args = { "ts_plitter", "-ots", "out.ts", "--ts-per-program" };
+    expected = { Error::OK, false, "", "", "", false, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "out.ts", true };
+    failures += 1 - runTest("init_TsOutput_OK", args, expected);
+
+    args = { "ts_plitter", "-ov", "video.out", "-ots", "out.ts" };
+    expected = { Error::OK, false, "", "", "video.out", false, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "out.ts", false };
+    failures += 1 - runTest("init_TsAndVideoOutputs_OK", args, expected);
+
+    args = { "ts_plitter", "--ts-per-program", "-oa", "audio.out" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, true, "", "audio.out", "", false, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "", true };
+    failures += 1 - runTest("init_TsPerProgramWithoutOutput_Exception", args, expected);
+
+    // test time range
+    args = { "ts_plitter", "-i", "intput.ts", "--start", "90.5", "--end", "120" };
+    expected = { Error::OK, false, "intput.ts", "audio_1.out", "video_1.out", false, false, { true, 8145000, false }, { true, 10800000, false } };
+    expected.indexName = "video_1.out.idx";
+    failures += 1 - runTest("init_RangeSeconds_OK", args, expected);
+
+    args = { "ts_plitter", "--start", "8145000pts" };
+    expected = { Error::OK, false, "", "audio_1.out", "video_1.out", false, false, { true, 8145000, true } };
+    failures += 1 - runTest("init_StartPts_OK", args, expected);
+
+    args = { "ts_plitter", "--end", "1:30" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, false, "", "", "" };
+    failures += 1 - runTest("init_WrongEnd_Exception", args, expected);
+
+    args = { "ts_plitter", "--start", "20", "--end", "10" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, true, "", "", "", false, false, { true, 1800000, false }, { true, 900000, false } };
+    failures += 1 - runTest("init_EndBeforeStart_Exception", args, expected);
+
+    // test index, it's written by default for input file only
+    args = { "ts_plitter", "-i", "intput.ts", "-ov", "video_1_%05d.h264", "--segment-size", "64M" };
+    expected = { Error::OK, false, "intput.ts", "", "video_1_%05d.h264" };
+    expected.indexName = "video_1.h264.idx";
+    failures += 1 - runTest("init_DefaultIndexSegmented_OK", args, expected);
+
+    args = { "ts_plitter", "-i", "intput.ts", "--index", "input.idx" };
+    expected = { Error::OK, false, "intput.ts", "audio_1.out", "video_1.out" };
+    expected.indexName = "input.idx";
+    failures += 1 - runTest("init_Index_OK", args, expected);
+
+    args = { "ts_plitter", "-i", "intput.ts", "--no-index" };
+    expected = { Error::OK, false, "intput.ts", "audio_1.out", "video_1.out" };
+    failures += 1 - runTest("init_NoIndex_OK", args, expected);
+
+    args = { "ts_plitter", "-i", "udp://@239.0.0.1:1234" };
+    expected = { Error::OK, false, "udp://@239.0.0.1:1234", "audio_1.out", "video_1.out" };
+    failures += 1 - runTest("init_UdpNoDefaultIndex_OK", args, expected);
+
+    // test job file, outputs of jobs are not set for the whole run
+    const std::string jobsFile = "program_options_jobs.txt";
+    std::ofstream(jobsFile) << "# comment\n-oa audio.out --program 1\n\n-ots out.ts --ts-per-program\n--probe\n";
+    args = { "ts_plitter", "-i", "input.ts", "--jobs", jobsFile };
+    expected = { Error::OK, false, "input.ts", "", "", false, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "", false, 3 };
+    failures += 1 - runTest("init_Jobs_OK", args, expected);
+
+    // validation level is common for all jobs
+    args = { "ts_plitter", "--validation", "trusted", "--jobs", jobsFile };
+    expected = { Error::OK, false, "", "", "", false, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "", false, 3, 0, false, Validation::TRUSTED };
+    failures += 1 - runTest("init_JobsWithValidation_OK", args, expected);
+
+    args = { "ts_plitter", "--verify", "--jobs", jobsFile };
+    expected = { Error::OK, false, "", "", "", false, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "", false, 3, 0, false, Validation::DEFAULT, true };
+    failures += 1 - runTest("init_JobsWithVerify_OK", args, expected);
+
+    args = { "ts_plitter", "--perf-report", "--jobs", jobsFile };
+    expected = { Error::OK, false, "", "", "", false, false, { false, 0, false }, { false, 0, false }, false,
+                 {}, {}, {}, "", false, 3, 0, false, Validation::DEFAULT, false, "", true };
+    failures += 1 - runTest("init_JobsWithPerfReport_OK", args, expected);
+
+    args = { "ts_plitter", "--jobs", jobsFile, "-oa", "audio.out" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, true, "", "audio.out", "" };
+    failures += 1 - runTest("init_JobsWithOutput_Exception", args, expected);
+
+    std::ofstream(jobsFile) << "-oa audio.out\n-ov video.out -i input.ts\n";
+    args = { "ts_plitter", "--jobs", jobsFile };
+    expected = { Error::WRONG_OPTION_ARGUMENT, true, "", "", "" };
+    failures += 1 - runTest("init_JobInput_Exception", args, expected);
+
+    std::ofstream(jobsFile) << "-oa audio.out --validation trusted\n";
+    args = { "ts_plitter", "--jobs", jobsFile };
+    expected = { Error::WRONG_OPTION_ARGUMENT, true, "", "", "" };
+    failures += 1 - runTest("init_JobValidation_Exception", args, expected);
+
+    std::ofstream(jobsFile) << "-oa audio.out --verify\n";
+    args = { "ts_plitter", "--jobs", jobsFile };
+    expected = { Error::WRONG_OPTION_ARGUMENT, true, "", "", "" };
+    failures += 1 - runTest("init_JobVerify_Exception", args, expected);
+
+    std::ofstream(jobsFile) << "-oa audio.out --perf-report\n";
+    args = { "ts_plitter", "--jobs", jobsFile };
+    expected = { Error::WRONG_OPTION_ARGUMENT, true, "", "", "" };
+    failures += 1 - runTest("init_JobPerfReport_Exception", args, expected);
+
+    std::ofstream(jobsFile) << "-oa audio.out\n-oa video.out -ov audio.out\n";
+    args = { "ts_plitter", "--jobs", jobsFile };
+    expected = { Error::WRONG_OPTION_ARGUMENT, true, "", "", "" };
+    failures += 1 - runTest("init_JobsSameOutput_Exception", args, expected);
+    std::remove(jobsFile.c_str());
+
+    args = { "ts_plitter", "--jobs", "no_such_file.txt" };
+    expected = { Error::WRONG_OPTION_ARGUMENT, true, "", "", "" };
+    failures += 1 - runTest("init_NoJobsFile_Exception", args, expected);
+
     return failures;
 }
\ No newline at end of file
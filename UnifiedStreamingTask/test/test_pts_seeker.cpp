@@ -0,0 +1,130 @@
+#include "../error.hpp"
+#include "../pts_seeker.hpp"
+#include "ts_generator.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    const uint16_t pmtPid = 0x20;
+    const uint16_t videoPid = 0x100;
+
+    /// @brief PTS increment between PES packets.
+    const int64_t ptsStep = 3600;
+
+    /// @brief Size of window read by every probe of PtsSeeker.
+    const uint64_t windowSize = 188 * 1024;
+
+    /// @brief Make input with PSI tables and one-packet video PES packets.
+    /// @param[in] firstPts - PTS of the first PES packet.
+    /// @param[in] packets - Number of PES packets.
+    /// @param[out] offsets - Offsets of PES packets.
+    std::string makeInput(int64_t firstPts, size_t packets, std::vector<uint64_t>& offsets)
+    {
+        TsGenerator generator;
+        generator.addProgram(1, pmtPid);
+        generator.addStream(1, videoPid, 0x1B);
+
+        std::string input = generator.pat() + generator.pmt(1);
+        for (size_t i = 0; i < packets; ++i)
+        {
+            offsets.push_back(input.size());
+            input += generator.pes(videoPid, 0xE0, std::string(100, 'v'), (firstPts + int64_t(i) * ptsStep) % (int64_t(1) << 33));
+        }
+        return input;
+    }
+
+    /// @brief Run one PtsSeeker unit test.
+    /// @details Found offset should be before the PES packet with searched PTS, but not farther than one window.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 const std::string& input,
+                 int64_t expectedFirstPts,
+                 int64_t pts,
+                 uint64_t expectedOffset)
+    {
+        std::cout << "Running PtsSeeker." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+
+        try
+        {
+            std::istringstream stream(input);
+            PtsSeeker seeker(stream, log);
+
+            const int64_t firstPts = seeker.firstPts();
+            if (firstPts != expectedFirstPts)
+            {
+                result = false;
+                log << "Got first PTS " << firstPts << " instead of " << expectedFirstPts << std::endl;
+            }
+
+            const uint64_t offset = seeker.find(pts);
+            if (offset > expectedOffset || offset + windowSize + 188 < expectedOffset || offset % 188)
+            {
+                result = false;
+                log << "Got offset " << offset << " for expected " << expectedOffset << std::endl;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+}
+
+/// @brief Run all PtsSeeker unit tests.
+/// @returns Number of failed tests.
+uint16_t testPtsSeeker()
+{
+    uint16_t failures = 0;
+
+    // long input, PTS in the middle
+    {
+        std::vector<uint64_t> offsets;
+        const std::string input = makeInput(0, 10000, offsets);
+        failures += 1 - runTest("find_Middle_OK", input, 0, 6000 * ptsStep, offsets[6000]);
+    }
+
+    // PTS before the first one
+    {
+        std::vector<uint64_t> offsets;
+        const std::string input = makeInput(90000, 10000, offsets);
+        failures += 1 - runTest("find_BeforeFirst_OK", input, 90000, 0, 0);
+    }
+
+    // PTS after the last one
+    {
+        std::vector<uint64_t> offsets;
+        const std::string input = makeInput(0, 10000, offsets);
+        failures += 1 - runTest("find_AfterLast_OK", input, 0, 20000 * ptsStep, input.size());
+    }
+
+    // PTS wraps around in the middle of the input
+    {
+        std::vector<uint64_t> offsets;
+        const int64_t firstPts = (int64_t(1) << 33) - 5000 * ptsStep;
+        const std::string input = makeInput(firstPts, 10000, offsets);
+        failures += 1 - runTest("find_WrappedPts_OK", input, firstPts, 2000 * ptsStep, offsets[7000]);
+    }
+
+    // input without PES packets
+    {
+        TsGenerator generator;
+        const std::string input = generator.nullPacket() + generator.nullPacket();
+        failures += 1 - runTest("find_NoPes_OK", input, noTimestamp, 0, 0);
+    }
+
+    return failures;
+}
@@ -0,0 +1,142 @@
+#include "../program_options.hpp"
+#include "../split_job.hpp"
+#include "../ts_reader.hpp"
+#include "ts_generator.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    /// @brief Generate MPTS with 2 programs, every one has audio and video streams.
+    std::string makeInput()
+    {
+        TsGenerator generator;
+        generator.addProgram(1, 0x100);
+        generator.addStream(1, 0x101, 0x1B);
+        generator.addStream(1, 0x102, 0x0F);
+        generator.addProgram(2, 0x200);
+        generator.addStream(2, 0x201, 0x1B);
+        generator.addStream(2, 0x202, 0x0F);
+
+        std::string input = generator.pat() + generator.pmt(1) + generator.pmt(2);
+        for (int i = 0; i < 2; ++i)
+        {
+            input += generator.pes(0x101, 0xE0, std::string(300, 'v'), 90000 * i);
+            input += generator.pes(0x102, 0xC0, std::string(100, 'a'), 90000 * i);
+            input += generator.pes(0x201, 0xE0, std::string(300, 'V'), 90000 * i);
+            input += generator.pes(0x202, 0xC0, std::string(100, 'A'), 90000 * i);
+        }
+        return input;
+    }
+
+    /// @brief Read file and remove it.
+    std::string readFile(const std::string& fileName)
+    {
+        std::string result;
+        {
+            std::ifstream file(fileName, std::ifstream::in | std::ifstream::binary);
+            result.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        std::remove(fileName.c_str());
+        return result;
+    }
+
+    /// @brief Run one SplitJob unit test.
+    /// @details All jobs consume payloads of one reader without PID filter.
+    /// @param[in] jobArgs - Command line options of every job.
+    /// @param[in] expectedFiles - Expected content of output files by names.
+    /// @param[in] expectedReport - Expected fragment of inventory report, may be empty.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 const std::vector<std::vector<const char*>>& jobArgs,
+                 const std::map<std::string, std::string>& expectedFiles,
+                 const std::string& expectedReport = std::string())
+    {
+        std::cout << "Running SplitJob." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+        std::ostringstream report;
+
+        try
+        {
+            std::vector<std::unique_ptr<ProgramOptions>> options;
+            std::vector<std::unique_ptr<SplitJob>> jobs;
+            for (const auto& args : jobArgs)
+            {
+                options.emplace_back(new ProgramOptions("ts_splitter"));
+                options.back()->init(static_cast<int>(args.size()), args.data());
+                jobs.emplace_back(new SplitJob(log, *options.back(), std::string()));
+            }
+
+            std::istringstream input(makeInput());
+            TsReader reader(input, log, [&jobs](const TsPayload& payload)
+            {
+                for (auto& job : jobs)
+                    job->parse(payload);
+            });
+            reader.readAll();
+            for (auto& job : jobs)
+                job->close(reader.statistics(), report);
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        for (const auto& pair : expectedFiles)
+        {
+            if (readFile(pair.first) != pair.second)
+            {
+                result = false;
+                log << "Unexpected content of '" << pair.first << "'" << std::endl;
+            }
+        }
+        if (!expectedReport.empty() && report.str().find(expectedReport) == std::string::npos)
+        {
+            result = false;
+            log << "No '" << expectedReport << "' in report" << std::endl;
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+}
+
+/// @brief Run all SplitJob unit tests.
+/// @returns Number of failed tests.
+uint16_t testSplitJob()
+{
+    uint16_t failures = 0;
+
+    failures += 1 - runTest("parse_SingleJob_OK",
+                            { { "ts_splitter", "-oa", "job_audio.out", "-ov", "job_video.out" } },
+                            { { "job_audio.out", std::string(200, 'a') }, { "job_audio_2.out", std::string(200, 'A') },
+                              { "job_video.out", std::string(600, 'v') }, { "job_video_2.out", std::string(600, 'V') } });
+
+    // the same ES are written by different jobs, every job numbers ES of its programs only
+    failures += 1 - runTest("parse_SeveralJobs_OK",
+                            { { "ts_splitter", "-oa", "job1_audio.out", "--program", "1" },
+                              { "ts_splitter", "-ov", "job2_video.out", "--program", "2" },
+                              { "ts_splitter", "-oa", "job3_audio.out" } },
+                            { { "job1_audio.out", std::string(200, 'a') }, { "job2_video.out", std::string(600, 'V') },
+                              { "job3_audio.out", std::string(200, 'a') }, { "job3_audio_2.out", std::string(200, 'A') } });
+
+    failures += 1 - runTest("close_ProbeJob_OK",
+                            { { "ts_splitter", "-oa", "job_audio.out", "--program", "2" }, { "ts_splitter", "--probe" } },
+                            { { "job_audio.out", std::string(200, 'A') } },
+                            "\"pmtPid\": 512");
+
+    return failures;
+}
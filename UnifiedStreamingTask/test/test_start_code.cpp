@@ -0,0 +1,122 @@
+#include "../cpu_features.hpp"
+#include "../start_code.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    /// @brief Data and expected offset of start code.
+    struct TestCase
+    {
+        std::vector<uint8_t> data;
+        size_t expected;
+    };
+
+    /// @brief Run one start code search unit test.
+    /// @details Checks that searches of all levels supported by CPU give the same result as scalar one
+    ///          for every suffix of data.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName, const std::vector<TestCase>& testCases)
+    {
+        std::cout << "Running StartCode." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+
+        for (const auto& testCase : testCases)
+        {
+            const auto& data = testCase.data;
+            const size_t found = findStartCode(data.data(), data.size());
+            if (found != testCase.expected)
+            {
+                result = false;
+                log << "Found start code at " << found << " instead of " << testCase.expected << std::endl;
+            }
+
+            const SimdLevel supported = supportedSimdLevel(detectCpuFeatures());
+            for (SimdLevel level = SimdLevel::SSE2; level <= supported; level = SimdLevel(int(level) + 1))
+            {
+                const Kernels kernels = kernelsFor(level);
+                for (size_t i = 0; i < data.size(); ++i)
+                {
+                    const size_t simd = kernels.findStartCode(data.data() + i, data.size() - i);
+                    const size_t scalar = findStartCodeScalar(data.data() + i, data.size() - i);
+                    if (simd != scalar)
+                    {
+                        result = false;
+                        log << simdLevelName(kernels.level) << " and scalar searches differ from offset " << i << ": "
+                            << simd << " and " << scalar << std::endl;
+                    }
+                }
+            }
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+
+    /// @brief Make data without start codes.
+    std::vector<uint8_t> makeData(size_t size)
+    {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; ++i)
+            data[i] = static_cast<uint8_t>(i % 3 == 2 ? 0x02 : 0x00);
+        return data;
+    }
+}
+
+/// @brief Run all start code search unit tests.
+/// @returns Number of failed tests.
+uint16_t testStartCode()
+{
+    uint16_t failures = 0;
+
+    {
+        failures += 1 - runTest("find_NoStartCode_NotFound", { { makeData(100), 100 }, { {}, 0 }, { { 0x00, 0x00 }, 2 } });
+    }
+
+    // start code at every position of 64 bytes, including SIMD block borders and the tail
+    {
+        std::vector<TestCase> testCases;
+        for (size_t position = 0; position + 3 <= 64; ++position)
+        {
+            std::vector<uint8_t> data = makeData(64);
+            data[position] = 0x00;
+            data[position + 1] = 0x00;
+            data[position + 2] = 0x01;
+            testCases.push_back({ data, position });
+        }
+        failures += 1 - runTest("find_StartCodeAtEveryPosition_Found", testCases);
+    }
+
+    // 4-byte start code
+    {
+        std::vector<uint8_t> data = makeData(40);
+        data[19] = 0x00;
+        data[20] = 0x00;
+        data[21] = 0x00;
+        data[22] = 0x01;
+        failures += 1 - runTest("find_FourByteStartCode_Found", { { data, 20 } });
+    }
+
+    // pseudo-random data with many zeros and ones
+    {
+        std::vector<uint8_t> data(4096);
+        uint32_t state = 12345;
+        for (auto& byte : data)
+        {
+            state = state * 1103515245u + 12345u;
+            byte = static_cast<uint8_t>((state >> 16) % 4);
+        }
+        const size_t expected = findStartCodeScalar(data.data(), data.size());
+        failures += 1 - runTest("find_RandomData_SameAsScalar", { { data, expected } });
+    }
+
+    return failures;
+}
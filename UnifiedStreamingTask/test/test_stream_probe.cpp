@@ -0,0 +1,184 @@
+#include "../error.hpp"
+#include "../stream_probe.hpp"
+#include "ts_generator.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+
+namespace
+{
+    const uint16_t pmtPid = 0x20;
+    const uint16_t videoPid = 0x100;
+    const uint16_t audioPid = 0x101;
+
+    /// @brief Generator with one program containing video and audio streams.
+    TsGenerator makeGenerator()
+    {
+        TsGenerator generator;
+        generator.addProgram(1, pmtPid);
+        generator.addStream(1, videoPid, 0x1B);
+        generator.addStream(1, audioPid, 0x0F);
+        return generator;
+    }
+
+    /// @brief Run one StreamProbe unit test.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 const std::string& input,
+                 bool quick,
+                 const std::vector<std::string>& expectedFragments)
+    {
+        std::cout << "Running StreamProbe." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+        std::ostringstream report;
+
+        try
+        {
+            std::istringstream stream(input);
+            StreamProbe probe(log);
+            if (quick)
+                probe.quickProbe(stream, 8, 188 * 100);
+            else
+                probe.probe(stream);
+            probe.report(report, OutputNameGenerator("audio_1.out"), OutputNameGenerator("video_1.out"));
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        for (const auto& fragment : expectedFragments)
+        {
+            if (report.str().find(fragment) == std::string::npos)
+            {
+                result = false;
+                log << "Report has no '" << fragment << "'" << std::endl;
+            }
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str() << report.str();
+        return result;
+    }
+}
+
+/// @brief Run all StreamProbe unit tests.
+/// @returns Number of failed tests.
+uint16_t testStreamProbe()
+{
+    uint16_t failures = 0;
+
+    // program with video and audio
+    {
+        TsGenerator generator = makeGenerator();
+        const std::string input = generator.pat() +
+                                  generator.pmt(1) +
+                                  generator.pes(videoPid, 0xE0, std::string(500, 'v'), 0) +
+                                  generator.pes(audioPid, 0xC0, std::string(100, 'a'), 0) +
+                                  generator.pes(videoPid, 0xE0, std::string(500, 'v'), 180000) +
+                                  generator.pes(audioPid, 0xC0, std::string(100, 'a'), 90000);
+        failures += 1 - runTest("probe_ProgramWithAudioAndVideo_OK", input, false,
+                                { "\"duration\": 2.000",
+                                  "\"number\": 1",
+                                  "\"pmtVersion\": 0",
+                                  "\"pids\": [256, 257]",
+                                  "\"streamType\": 27",
+                                  "\"output\": \"video_1.out\"",
+                                  "\"output\": \"audio_1.out\"",
+                                  "\"esBytes\": 1000",
+                                  "\"esBytes\": 200",
+                                  "\"type\": \"pat\"",
+                                  "\"type\": \"pmt\"" });
+    }
+
+    // AC-3 in private data and language from PMT descriptors
+    {
+        TsGenerator generator;
+        generator.addProgram(1, pmtPid);
+        generator.addStream(1, audioPid, 0x06, std::string("\x6A\x01\x00\x0A\x04" "ENG\x03", 9));
+        const std::string input = generator.pat() +
+                                  generator.pmt(1) +
+                                  generator.pes(audioPid, 0xBD, std::string(100, 'a'), 0);
+        failures += 1 - runTest("probe_Descriptors_OK", input, false,
+                                { "\"type\": \"audio\"",
+                                  "\"streamType\": 6",
+                                  "\"codec\": \"AC-3\"",
+                                  "\"language\": \"eng\"",
+                                  "\"audioType\": 3",
+                                  "\"output\": \"audio_1.out\"",
+                                  "\"esBytes\": 100" });
+    }
+
+    // broken packet sequence
+    {
+        TsGenerator generator = makeGenerator();
+        const std::string pes = generator.pes(videoPid, 0xE0, std::string(500, 'v'), 0);
+        const std::string input = generator.pat() +
+                                  generator.pmt(1) +
+                                  pes.substr(0, 188) +
+                                  pes.substr(2 * 188);
+        failures += 1 - runTest("probe_BrokenSequence_ErrorCounted", input, false,
+                                { "\"continuityErrors\": 1" });
+    }
+
+    // streams without PSI tables
+    {
+        TsGenerator generator;
+        const std::string input = generator.pes(videoPid, 0xE0, std::string(100, 'v'), 0) +
+                                  generator.pes(audioPid, 0xC0, std::string(100, 'a'), 0) +
+                                  generator.nullPacket();
+        failures += 1 - runTest("probe_NoPsi_OK", input, false,
+                                { "\"programs\": []",
+                                  "\"type\": \"video\"",
+                                  "\"type\": \"audio\"",
+                                  "\"type\": \"null\"",
+                                  "\"esNumber\": 1" });
+    }
+
+    // empty input
+    {
+        failures += 1 - runTest("probe_EmptyInput_OK", "", false,
+                                { "\"packets\": 0", "\"pids\": []" });
+    }
+
+    // long input with changed PMT
+    {
+        TsGenerator generator = makeGenerator();
+        std::string input;
+        for (int i = 0; i < 400; ++i)
+        {
+            if (i == 200)
+                generator.setPmtVersion(1, 1);
+            if (i % 10 == 0)
+                input += generator.pat() + generator.pmt(1);
+            input += generator.pes(videoPid, 0xE0, std::string(1000, 'v'), i * 3600);
+            input += generator.pes(audioPid, 0xC0, std::string(100, 'a'), i * 3600);
+        }
+        failures += 1 - runTest("quickProbe_LongInput_OK", input, true,
+                                { "\"quickProbe\"",
+                                  "\"windows\": 8",
+                                  "\"headComplete\": true",
+                                  "\"duration\": 15.960",
+                                  "\"pmtChanges\": 1",
+                                  "\"output\": \"video_1.out\"" });
+    }
+
+    // short input is read whole
+    {
+        TsGenerator generator = makeGenerator();
+        const std::string input = generator.pat() +
+                                  generator.pmt(1) +
+                                  generator.pes(videoPid, 0xE0, std::string(500, 'v'), 0) +
+                                  generator.pes(videoPid, 0xE0, std::string(500, 'v'), 90000);
+        failures += 1 - runTest("quickProbe_ShortInput_OK", input, true,
+                                { "\"duration\": 1.000", "\"esBytes\": 1000" });
+    }
+
+    return failures;
+}
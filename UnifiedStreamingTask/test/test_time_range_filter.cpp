@@ -0,0 +1,151 @@
+#include "../error.hpp"
+#include "../time_range_filter.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    const uint16_t videoPid = 0x100;
+    const uint16_t audioPid = 0x101;
+
+    /// @brief One second in 90 kHz ticks.
+    const int64_t second = 90000;
+
+    /// @brief Expected result for TimeRangeFilter test.
+    struct ExpectedResult
+    {
+        /// @brief Concatenation of passed raw data.
+        std::string output;
+
+        /// @brief Expected finished state after all input.
+        bool finished;
+    };
+
+    /// @brief Make raw data from string.
+    EsRawData makeRawData(const std::string& data, uint16_t pid, int64_t pts, bool newEsPacket)
+    {
+        EsRawData rawData{ reinterpret_cast<const uint8_t*>(data.data()), static_cast<uint16_t>(data.size()),
+                           pid == videoPid ? EsType::VIDEO : EsType::AUDIO, 1, pid, pts, newEsPacket, 0, pts, false };
+        return rawData;
+    }
+
+    /// @brief Run one TimeRangeFilter unit test.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 const TimePoint& start,
+                 const TimePoint& end,
+                 const std::vector<EsRawData>& input,
+                 const ExpectedResult& expected)
+    {
+        std::cout << "Running TimeRangeFilter." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+        std::string output;
+
+        try
+        {
+            TimeRangeFilter filter(log, start, end, [&output](const EsRawData& rawData)
+            {
+                output.append(reinterpret_cast<const char*>(rawData.data), rawData.size);
+            });
+            for (const auto& rawData : input)
+                filter.write(rawData);
+
+            if (filter.finished() != expected.finished)
+            {
+                result = false;
+                log << "Got finished " << filter.finished() << " instead of " << expected.finished << std::endl;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        if (output != expected.output)
+        {
+            result = false;
+            log << "Got output '" << output << "' instead of '" << expected.output << "'" << std::endl;
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+}
+
+/// @brief Run all TimeRangeFilter unit tests.
+/// @returns Number of failed tests.
+uint16_t testTimeRangeFilter()
+{
+    uint16_t failures = 0;
+
+    const TimePoint unset{ false, 0, false };
+
+    // video PES packets every second with continuation, audio PES packets every half second
+    std::vector<EsRawData> input;
+    const int64_t firstPts = 1000;
+    const std::vector<std::string> video{ "V0", "v0", "V1", "v1", "V2", "v2", "V3", "v3" };
+    const std::vector<std::string> audio{ "A0", "A1", "A2", "A3", "A4", "A5", "A6", "A7" };
+    for (int i = 0; i < 8; ++i)
+    {
+        if (i % 2 == 0)
+            input.push_back(makeRawData(video[i], videoPid, firstPts + i / 2 * second, true));
+        else
+            input.push_back(makeRawData(video[i], videoPid, noTimestamp, false));
+        input.push_back(makeRawData(audio[i], audioPid, firstPts + i * second / 2, true));
+    }
+
+    {
+        ExpectedResult expected{ "V0A0v0A1V1A2v1A3V2A4v2A5V3A6v3A7", false };
+        failures += 1 - runTest("write_NoRange_OK", unset, unset, input, expected);
+    }
+
+    {
+        ExpectedResult expected{ "V1A2v1A3", true };
+        failures += 1 - runTest("write_RelativeRange_OK", TimePoint{ true, second, false }, TimePoint{ true, 2 * second, false },
+                                input, expected);
+    }
+
+    {
+        ExpectedResult expected{ "V2A4v2A5V3A6v3A7", false };
+        failures += 1 - runTest("write_AbsoluteStart_OK", TimePoint{ true, firstPts + 2 * second, true }, unset,
+                                input, expected);
+    }
+
+    {
+        ExpectedResult expected{ "V0A0v0A1", true };
+        failures += 1 - runTest("write_RelativeEnd_OK", unset, TimePoint{ true, second, false }, input, expected);
+    }
+
+    // PTS wraps around within the range
+    {
+        const int64_t wrapPts = (int64_t(1) << 33) - second;
+        std::vector<EsRawData> wrapped;
+        for (int i = 0; i < 4; ++i)
+            wrapped.push_back(makeRawData(audio[i], audioPid, (wrapPts + i * second) % (int64_t(1) << 33), true));
+        ExpectedResult expected{ "A1A2", true };
+        failures += 1 - runTest("write_WrappedPts_OK", TimePoint{ true, second, false }, TimePoint{ true, 3 * second, false },
+                                wrapped, expected);
+    }
+
+    // ES without PTS is dropped if range has start and doesn't prevent finishing
+    {
+        const std::string data = "X";
+        std::vector<EsRawData> untimed = input;
+        untimed.push_back(makeRawData(data, 0x102, noTimestamp, true));
+        untimed.insert(untimed.begin(), makeRawData(data, 0x102, noTimestamp, true));
+        ExpectedResult expected{ "V1A2v1A3", true };
+        failures += 1 - runTest("write_NoPts_Dropped", TimePoint{ true, second, false }, TimePoint{ true, 2 * second, false },
+                                untimed, expected);
+    }
+
+    return failures;
+}
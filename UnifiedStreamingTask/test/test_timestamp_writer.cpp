@@ -0,0 +1,196 @@
+#include "../error.hpp"
+#include "../timestamp_writer.hpp"
+#include "../ts_index.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+
+namespace
+{
+    const uint16_t videoPid = 0x100;
+    const uint16_t audioPid = 0x101;
+
+    /// @brief Expected timestamp file.
+    struct ExpectedFile
+    {
+        /// @brief File name.
+        std::string name;
+
+        /// @brief If not set, file should not exist.
+        bool exists;
+
+        /// @brief Expected records.
+        std::vector<TsTimestampsRecord> records;
+    };
+
+    /// @brief Expected result for TimestampWriter test.
+    struct ExpectedResult
+    {
+        /// @brief Error code. If OK - no error expected.
+        uint16_t errorCode;
+
+        /// @brief Expected timestamp files.
+        std::vector<ExpectedFile> files;
+    };
+
+    /// @brief Make raw data from string.
+    EsRawData makeRawData(const std::string& data, uint16_t pid, int64_t pts, int64_t dts, bool newEsPacket)
+    {
+        EsRawData rawData{ reinterpret_cast<const uint8_t*>(data.data()), static_cast<uint16_t>(data.size()),
+                           pid == videoPid ? EsType::VIDEO : EsType::AUDIO, 1, pid, pts, newEsPacket, 0, dts, false };
+        return rawData;
+    }
+
+    /// @brief Check timestamp file content and remove it.
+    void checkFile(const ExpectedFile& expected)
+    {
+        std::ifstream file(expected.name, std::ifstream::in | std::ifstream::binary);
+        if (!expected.exists)
+        {
+            if (file.good())
+                throw std::logic_error("Unexpected file '" + expected.name + "'");
+            return;
+        }
+        if (!file.good())
+            throw std::logic_error("Failed to open file '" + expected.name + "'");
+
+        TsTimestampsHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file.good())
+            throw std::logic_error("Timestamp file is too short");
+        if (std::memcmp(header.magic, tsTimestampsMagic, sizeof(header.magic)) != 0 ||
+            header.version != tsTimestampsVersion ||
+            header.recordSize != sizeof(TsTimestampsRecord))
+            throw std::logic_error("Wrong timestamp file header");
+
+        for (size_t i = 0; i < expected.records.size(); ++i)
+        {
+            TsTimestampsRecord record;
+            file.read(reinterpret_cast<char*>(&record), sizeof(record));
+            if (!file.good())
+                throw std::logic_error("Timestamp file is too short");
+            const auto& expectedRecord = expected.records[i];
+            if (record.esOffset != expectedRecord.esOffset || record.pts != expectedRecord.pts || record.dts != expectedRecord.dts)
+                throw std::logic_error("Wrong record " + std::to_string(i) + " in file '" + expected.name + "'");
+        }
+
+        if (file.peek() != std::ifstream::traits_type::eof())
+            throw std::logic_error("Timestamp file '" + expected.name + "' is too long");
+    }
+
+    /// @brief Run one TimestampWriter unit test.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 const std::string& audioOutput,
+                 const std::string& videoOutput,
+                 const std::vector<EsRawData>& input,
+                 const ExpectedResult& expected)
+    {
+        std::cout << "Running TimestampWriter." << testName << " ... ";
+
+        bool result = true;
+        Error error{ Error::OK, "" };
+        std::ostringstream log;
+
+        try
+        {
+            OutputNameGenerator audioNameGenerator(audioOutput);
+            OutputNameGenerator videoNameGenerator(videoOutput);
+            TimestampWriter writer(log, audioNameGenerator, videoNameGenerator);
+            for (const auto& rawData : input)
+                writer.write(rawData);
+            writer.closeOutputs();
+        }
+        catch (const Error& err)
+        {
+            error = err;
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        if (error.code() != expected.errorCode)
+        {
+            result = false;
+            if (expected.errorCode == Error::OK)
+                log << "Unexpected exception caught: " << error.message() << std::endl;
+            else
+                log << "No expected exception caught" << std::endl;
+        }
+
+        for (const auto& file : expected.files)
+        {
+            try
+            {
+                checkFile(file);
+            }
+            catch (const std::exception& e)
+            {
+                result = false;
+                log << "Wrong timestamp file: " << e.what() << std::endl;
+            }
+            std::remove(file.name.c_str());
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+}
+
+/// @brief Run all TimestampWriter unit tests.
+/// @returns Number of failed tests.
+uint16_t testTimestampWriter()
+{
+    uint16_t failures = 0;
+
+    const std::string video(500, 'v');
+    const std::string audio(100, 'a');
+
+    // video with DTS and continuation, audio without DTS
+    {
+        std::vector<EsRawData> input{ makeRawData(video, videoPid, 7200, 3600, true),
+                                      makeRawData(video, videoPid, noTimestamp, noTimestamp, false),
+                                      makeRawData(audio, audioPid, 3000, 3000, true),
+                                      makeRawData(video, videoPid, 10800, 7200, true),
+                                      makeRawData(audio, audioPid, 4920, 4920, true) };
+        ExpectedResult expected{ Error::OK, { { "audio.out.pts", true, { { 0, 3000, 3000 }, { 100, 4920, 4920 } } },
+                                              { "video.out.pts", true, { { 0, 7200, 3600 }, { 1000, 10800, 7200 } } } } };
+        failures += 1 - runTest("write_AudioAndVideo_OK", "audio.out", "video.out", input, expected);
+    }
+
+    // PES packet without PTS has no record, but its data is counted
+    {
+        std::vector<EsRawData> input{ makeRawData(audio, audioPid, noTimestamp, noTimestamp, true),
+                                      makeRawData(audio, audioPid, 1920, 1920, true) };
+        ExpectedResult expected{ Error::OK, { { "audio.out.pts", true, { { 100, 1920, 1920 } } } } };
+        failures += 1 - runTest("write_PesWithoutPts_Skipped", "audio.out", "", input, expected);
+    }
+
+    // no timestamp file for ES without output
+    {
+        std::vector<EsRawData> input{ makeRawData(video, videoPid, 7200, 3600, true),
+                                      makeRawData(audio, audioPid, 3000, 3000, true) };
+        ExpectedResult expected{ Error::OK, { { "audio.out.pts", true, { { 0, 3000, 3000 } } },
+                                              { "video.out.pts", false, {} } } };
+        failures += 1 - runTest("write_NoVideoOutput_OK", "audio.out", "", input, expected);
+    }
+
+    // timestamp file cannot be opened
+    {
+        std::vector<EsRawData> input{ makeRawData(audio, audioPid, 3000, 3000, true) };
+        ExpectedResult expected{ Error::CORRUPTED_OUTPUT, {} };
+        failures += 1 - runTest("write_BadFile_Exception", "no_such_directory/audio.out", "", input, expected);
+    }
+
+    return failures;
+}
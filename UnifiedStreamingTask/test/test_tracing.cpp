@@ -0,0 +1,91 @@
+#include "../tracing.hpp"
+
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+
+
+namespace
+{
+    /// @brief Count occurrences of substring.
+    size_t count(const std::string& text, const std::string& pattern)
+    {
+        size_t result = 0;
+        for (size_t position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + 1))
+            ++result;
+        return result;
+    }
+
+    /// @brief Run one Tracer unit test.
+    /// @details Spans recorded by test are dumped and the trace is checked by its fragments.
+    /// @param[in] record - Function recording spans.
+    /// @param[in] expectedFragments - Fragments expected in the trace and their number of occurrences.
+    /// @returns true if test passed, false otherwise.
+    template <typename Function>
+    bool runTest(const std::string& testName, Function record, std::initializer_list<std::pair<std::string, size_t>> expectedFragments)
+    {
+        std::cout << "Running Tracer." << testName << " ... ";
+
+        Tracer::clear();
+        record();
+        std::ostringstream trace;
+        Tracer::dump(trace);
+
+        bool result = trace.str().compare(0, 16, "{\"traceEvents\":[") == 0;
+        std::ostringstream failureDescription;
+        for (const auto& fragment : expectedFragments)
+        {
+            const size_t occurrences = count(trace.str(), fragment.first);
+            if (occurrences != fragment.second)
+            {
+                result = false;
+                failureDescription << "Got " << occurrences << " occurrences of '" << fragment.first << "' instead of " << fragment.second << std::endl;
+            }
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << failureDescription.str() << trace.str().substr(0, 1000) << std::endl;
+        return result;
+    }
+}
+
+/// @brief Run all Tracer unit tests.
+/// @returns Number of failed tests.
+uint16_t testTracer()
+{
+    uint16_t failures = 0;
+
+    failures += 1 - runTest("dump_NoSpans_OK", []() {},
+                            { { "\"ph\":\"X\"", 0 }, { "\"droppedSpans\":0}", 1 } });
+
+    failures += 1 - runTest("dump_Span_OK", []() { Tracer::record("read block", 1234567, 1240001); },
+                            { { "{\"name\":\"read block\",\"ph\":\"X\",\"pid\":1,\"tid\":", 1 }, { "\"ts\":1234.567,\"dur\":5.434}", 1 } });
+
+    failures += 1 - runTest("dump_ScopedSpan_OK", []() { TraceSpan span("open file"); },
+                            { { "\"name\":\"open file\"", 1 } });
+
+    // spans of other threads are kept after threads finish
+    failures += 1 - runTest("dump_SpansOfThreads_OK", []()
+                            {
+                                Tracer::record("parse PAT", 1, 2);
+                                std::thread([]() { Tracer::record("parse PMT", 3, 4); }).join();
+                                std::thread([]() { Tracer::record("parse PMT", 5, 6); }).join();
+                            },
+                            { { "\"name\":\"parse PAT\"", 1 }, { "\"name\":\"parse PMT\"", 2 } });
+
+    // the oldest spans are overwritten
+    failures += 1 - runTest("dump_FullRing_LatestSpansKept", []()
+                            {
+                                Tracer::record("first", 0, 1);
+                                for (size_t i = 0; i < Tracer::capacity; ++i)
+                                    Tracer::record("next", 0, 1);
+                            },
+                            { { "\"name\":\"first\"", 0 }, { "\"name\":\"next\"", Tracer::capacity }, { "\"droppedSpans\":1}", 1 } });
+
+    return failures;
+}
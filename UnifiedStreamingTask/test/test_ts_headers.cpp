@@ -0,0 +1,131 @@
+#include "../cpu_features.hpp"
+#include "../ts_headers.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    const size_t tsPacketSize = 188;
+
+    /// @brief Make block of packets with pseudo-random headers and sync bytes.
+    /// @param[in] count - Number of packets.
+    /// @param[in] seed - Seed of pseudo-random generator.
+    std::vector<uint8_t> makeBlock(size_t count, uint32_t seed)
+    {
+        std::vector<uint8_t> block(count * tsPacketSize);
+        for (auto& byte : block)
+        {
+            seed = seed * 1103515245 + 12345;
+            byte = static_cast<uint8_t>(seed >> 16);
+        }
+        for (size_t i = 0; i < count; ++i)
+            block[i * tsPacketSize] = 0x47;
+        return block;
+    }
+
+    /// @brief Compare headers decoded by SIMD code of all levels supported by CPU and scalar code.
+    /// @returns true if headers are equal, false otherwise.
+    bool compare(const std::vector<uint8_t>& block, size_t count, std::ostream& log)
+    {
+        TsHeaders scalar;
+        const size_t scalarCount = decodeTsHeadersScalar(block.data(), count, scalar);
+
+        const SimdLevel supported = supportedSimdLevel(detectCpuFeatures());
+        for (SimdLevel level = SimdLevel::SSE2; level <= supported; level = SimdLevel(int(level) + 1))
+        {
+            const Kernels kernels = kernelsFor(level);
+            TsHeaders simd;
+            const size_t simdCount = kernels.decodeTsHeaders(block.data(), count, simd);
+            if (simdCount != scalarCount)
+            {
+                log << "Decoded " << simdCount << " by " << simdLevelName(kernels.level) << " and " << scalarCount
+                    << " by scalar of " << count << " packets" << std::endl;
+                return false;
+            }
+
+            for (size_t i = 0; i < simdCount; ++i)
+            {
+                if (simd.pids[i] != scalar.pids[i] || simd.payloadOffsets[i] != scalar.payloadOffsets[i] ||
+                    simd.flags[i] != scalar.flags[i] || simd.seqNumbers[i] != scalar.seqNumbers[i])
+                {
+                    log << "Headers of packet " << i << " of " << count << " decoded by "
+                        << simdLevelName(kernels.level) << " and scalar differ" << std::endl;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /// @brief Run one TsHeaders unit test.
+    /// @details Checks that SIMD decoders of every level and scalar decoder give the same result for every number of packets,
+    ///          including blocks broken by missing sync byte at every position.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName, uint32_t seed)
+    {
+        std::cout << "Running TsHeaders." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+
+        const std::vector<uint8_t> block = makeBlock(TsHeaders::capacity, seed);
+        for (size_t count = 0; count <= TsHeaders::capacity; ++count)
+            result &= compare(block, count, log);
+
+        for (size_t broken = 0; broken < TsHeaders::capacity; ++broken)
+        {
+            std::vector<uint8_t> brokenBlock = block;
+            brokenBlock[broken * tsPacketSize] = 0x46;
+            result &= compare(brokenBlock, TsHeaders::capacity, log);
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+}
+
+/// @brief Run all TsHeaders unit tests.
+/// @returns Number of failed tests.
+uint16_t testTsHeaders()
+{
+    uint16_t failures = 0;
+
+    // headers with all fields set, without adaptation field and with the longest one
+    {
+        std::cout << "Running TsHeaders.decode_KnownHeaders_OK ... ";
+        std::vector<uint8_t> block(5 * tsPacketSize, 0xFF);
+        const uint8_t headers[5][5] = { { 0x47, 0x40, 0x00, 0x10, 0x00 },
+                                        { 0x47, 0x01, 0x00, 0x3F, 0x07 },
+                                        { 0x47, 0xBF, 0xFF, 0x2A, 0xFF },
+                                        { 0x47, 0x1F, 0xFF, 0x10, 0x00 },
+                                        { 0x47, 0x41, 0x01, 0x35, 0x00 } };
+        for (size_t i = 0; i < 5; ++i)
+            std::memcpy(block.data() + i * tsPacketSize, headers[i], 5);
+
+        TsHeaders decoded;
+        const uint16_t pids[5] = { 0x0000, 0x0100, 0x1FFF, 0x1FFF, 0x0101 };
+        const uint16_t offsets[5] = { 4, 12, 260, 4, 5 };
+        const uint8_t flags[5] = { 0x50, 0x30, 0xA0, 0x10, 0x70 };
+        const uint8_t seqNumbers[5] = { 0, 15, 10, 0, 5 };
+        const bool result = decodeTsHeaders(block.data(), 5, decoded) == 5 &&
+                            std::equal(pids, pids + 5, decoded.pids) &&
+                            std::equal(offsets, offsets + 5, decoded.payloadOffsets) &&
+                            std::equal(flags, flags + 5, decoded.flags) &&
+                            std::equal(seqNumbers, seqNumbers + 5, decoded.seqNumbers);
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        failures += 1 - result;
+    }
+
+    failures += 1 - runTest("decode_RandomHeaders_SameAsScalar", 1);
+    failures += 1 - runTest("decode_OtherRandomHeaders_SameAsScalar", 2018);
+
+    return failures;
+}
@@ -236,6 +236,187 @@ namespace
             std::cout << log.str();
         return result;
     }
+
+    /// @brief Run one TsReader unit test on adaptation field fields of payloads.
+    /// @returns true if test passed, false otherwise.
+    bool runAdaptationTest(const std::string& testName,
+                           std::stringstream& input,
+                           const std::vector<int64_t>& expectedPcrs,
+                           const std::vector<bool>& expectedRandomAccess)
+    {
+        std::cout << "Running TsReader." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+        std::vector<int64_t> pcrs;
+        std::vector<bool> randomAccess;
+        auto handler = [&pcrs, &randomAccess](const TsPayload& p)
+        {
+            pcrs.push_back(p.pcr);
+            randomAccess.push_back(p.randomAccess);
+        };
+
+        try
+        {
+            TsReader reader(input, log, handler);
+            reader.readAll();
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        if (pcrs != expectedPcrs)
+        {
+            result = false;
+            log << "Produced PCRs differ from expected" << std::endl;
+        }
+        if (randomAccess != expectedRandomAccess)
+        {
+            result = false;
+            log << "Produced random access indicators differ from expected" << std::endl;
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+
+    /// @brief Run one TsReader unit test on validation levels.
+    /// @details Input has broken packet sequence and corrupted packet.
+    /// @returns true if test passed, false otherwise.
+    bool runValidationTest(const std::string& testName,
+                           Validation validation,
+                           uint64_t expectedContinuityErrors,
+                           bool expectedLog)
+    {
+        std::cout << "Running TsReader." << testName << " ... ";
+
+        // the second packet follows lost one, the third one has transport error indicator set
+        std::vector<uint8_t> corruptedPacket = videoPacket2;
+        corruptedPacket[1] |= 0x80;
+        std::stringstream input;
+        input.write(reinterpret_cast<const char*>(videoPacket1.data()), videoPacket1.size());
+        input.write(reinterpret_cast<const char*>(videoPacket3.data()), videoPacket3.size());
+        input.write(reinterpret_cast<const char*>(corruptedPacket.data()), corruptedPacket.size());
+
+        bool result = true;
+        std::ostringstream log;
+        std::ostringstream readerLog;
+        std::vector<bool> discontinuities;
+        try
+        {
+            TsReader reader(input, readerLog, [&discontinuities](const TsPayload& p)
+            {
+                discontinuities.push_back(p.discontinuity);
+            });
+            reader.setValidation(validation);
+            reader.readAll();
+
+            const auto statistics = reader.statistics();
+            if (statistics.continuityErrors != expectedContinuityErrors)
+            {
+                result = false;
+                log << "Got " << statistics.continuityErrors << " continuity errors instead of " << expectedContinuityErrors << std::endl;
+            }
+            if (statistics.corruptedPackets != 1)
+            {
+                result = false;
+                log << "Got " << statistics.corruptedPackets << " corrupted packets instead of 1" << std::endl;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        if (discontinuities != std::vector<bool>{ false, expectedContinuityErrors != 0 })
+        {
+            result = false;
+            log << "Produced discontinuity flags differ from expected" << std::endl;
+        }
+        if (readerLog.str().empty() == expectedLog)
+        {
+            result = false;
+            log << (expectedLog ? "No expected log messages" : "Unexpected log messages: " + readerLog.str()) << std::endl;
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+
+    /// @brief Run one TsReader unit test on input growing at its end.
+    /// @details Every time the input ends, the next part is appended to it, every part is read as one block.
+    /// @returns true if test passed, false otherwise.
+    bool runGrowingTest(const std::string& testName,
+                        const std::vector<std::string>& parts,
+                        const std::string& expectedPayload)
+    {
+        std::cout << "Running TsReader." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+        std::ostringstream payload;
+        std::stringstream input;
+        input << parts.front();
+
+        size_t calls = 0;
+        size_t blocks = 0;
+        try
+        {
+            TsReader reader(input, log, [&payload](const TsPayload& p)
+            {
+                payload.write(reinterpret_cast<const char*>(p.data), p.size);
+            });
+            reader.setEndOfInputHandler([&input, &parts, &calls]()
+            {
+                if (++calls >= parts.size())
+                    return false;
+                input.clear();
+                input << parts[calls];
+                return true;
+            });
+            reader.setBlockHandler([&blocks]() { ++blocks; });
+            reader.readAll();
+
+            if (reader.statistics().corruptedPackets != 0)
+            {
+                result = false;
+                log << "Got " << reader.statistics().corruptedPackets << " corrupted packets" << std::endl;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        if (calls != parts.size())
+        {
+            result = false;
+            log << "End of input handler called " << calls << " times instead of " << parts.size() << std::endl;
+        }
+        if (blocks != parts.size())
+        {
+            result = false;
+            log << "Block handler called " << blocks << " times instead of " << parts.size() << std::endl;
+        }
+        if (payload.str() != expectedPayload)
+        {
+            result = false;
+            log << "Produced payload differs from expected" << std::endl;
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
 }
 
 /// @brief Run all TsReader unit tests.
@@ -260,6 +441,25 @@ uint16_t testTsReader()
         failures += 1 - runTest("readAll_Video1Packet_OK", input, Error::OK, payload.str(), 1);
     }
 
+    // video packet with PCR and random access indicator, audio packet with random access indicator only
+    {
+        std::stringstream input;
+        input.write(reinterpret_cast<const char*>(videoPacket1.data()), videoPacket1.size());
+        input.write(reinterpret_cast<const char*>(audioPacket1.data()), audioPacket1.size());
+        failures += 1 - runAdaptationTest("readAll_PcrAndRandomAccess_OK", input, { 888750 * 300, noTimestamp }, { true, true });
+    }
+
+    // input grows by parts, the second packet is split between them
+    {
+        const std::string packet1(reinterpret_cast<const char*>(videoPacket1.data()), videoPacket1.size());
+        const std::string packet2(reinterpret_cast<const char*>(videoPacket2.data()), videoPacket2.size());
+        std::ostringstream payload;
+        payload.write(reinterpret_cast<const char*>(videoPayload1.data()), videoPayload1.size());
+        payload.write(reinterpret_cast<const char*>(videoPayload2.data()), videoPayload2.size());
+        failures += 1 - runGrowingTest("readAll_GrowingInput_OK", { packet1 + packet2.substr(0, 100), "", packet2.substr(100) },
+                                       payload.str());
+    }
+
     // 2 video packets, start of elementary stream and continuation
     {
         std::stringstream input;
@@ -428,5 +628,12 @@ uint16_t testTsReader()
         failures += 1 - runTest("readAll_CorruptedTsMiddleWithoutSyncByte_OK", input, Error::OK, "", 0);
     }
 
+    // broken packet sequence and corrupted packet are counted and logged by default
+    failures += 1 - runValidationTest("readAll_DefaultValidation_ContinuityChecked", Validation::DEFAULT, 1, true);
+    failures += 1 - runValidationTest("readAll_ParanoidValidation_ContinuityChecked", Validation::PARANOID, 1, true);
+
+    // trusted input is not checked for continuity, corrupted packet is dropped without logging
+    failures += 1 - runValidationTest("readAll_TrustedValidation_ContinuityNotChecked", Validation::TRUSTED, 0, false);
+
     return failures;
 }
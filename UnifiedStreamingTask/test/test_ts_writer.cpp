@@ -0,0 +1,237 @@
+#include "../error.hpp"
+#include "../output_name_generator.hpp"
+#include "../payload_parser.hpp"
+#include "../pid_filter.hpp"
+#include "../ts_reader.hpp"
+#include "../ts_writer.hpp"
+#include "ts_generator.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    /// @brief Name of input file for tests copying packets from file.
+    const std::string inputFile = "ts_writer_input.ts";
+
+    /// @brief Generate MPTS with 2 programs, the 2nd one also has private data stream,
+    ///        video streams carry PCR, null packets are inserted between PES packets.
+    /// @param[in] pcrPid - If set, PCR of the 2nd program is carried by packets of this PID without payload.
+    std::string makeInput(uint16_t pcrPid = 0)
+    {
+        TsGenerator generator;
+        generator.addProgram(1, 0x100);
+        generator.addStream(1, 0x101, 0x1B);
+        generator.addStream(1, 0x102, 0x0F);
+        generator.addProgram(2, 0x200);
+        generator.addStream(2, 0x201, 0x1B);
+        generator.addStream(2, 0x202, 0x0F);
+        generator.addStream(2, 0x203, 0x06);
+        if (pcrPid)
+            generator.setPcrPid(2, pcrPid);
+
+        std::string input = generator.pat() + generator.pmt(1) + generator.pmt(2);
+        for (int i = 0; i < 3; ++i)
+        {
+            input += generator.pes(0x101, 0xE0, std::string(500, 'v'), 90000 * i, noTimestamp, 27000000LL * i);
+            input += generator.pes(0x102, 0xC0, std::string(100, 'a'), 90000 * i);
+            input += generator.nullPacket();
+            if (pcrPid)
+                input += generator.packets(pcrPid, std::string(), false, 27000000LL * i);
+            input += generator.pes(0x201, 0xE0, std::string(500, 'V'), 90000 * i, noTimestamp,
+                                   pcrPid ? TsGenerator::noPcr : 27000000LL * i);
+            input += generator.pes(0x202, 0xC0, std::string(100, 'A'), 90000 * i);
+            input += generator.pes(0x203, 0xBD, std::string(100, 'p'), 90000 * i);
+            input += generator.pat();
+        }
+        return input;
+    }
+
+    /// @brief Content of output transport stream.
+    struct Content
+    {
+        /// @brief PIDs of all packets.
+        std::set<uint16_t> pids;
+
+        /// @brief Programs listed in PAT.
+        std::set<uint16_t> programs;
+
+        bool operator==(const Content& other) const
+        {
+            return pids == other.pids && programs == other.programs;
+        }
+    };
+
+    /// @brief Read output file, check it and remove it.
+    /// @param[in] fileName - Output file name.
+    /// @param[out] data - Output file data.
+    /// @param[out] log - Stream for error messages.
+    /// @returns Content of the output, empty if it's broken.
+    Content readOutput(const std::string& fileName, std::string& data, std::ostream& log)
+    {
+        Content result;
+        {
+            std::ifstream file(fileName, std::ifstream::in | std::ifstream::binary);
+            data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        std::remove(fileName.c_str());
+
+        if (data.empty() || data.size() % 188 || data[1] != 0x40 || data[2] != 0x00)
+        {
+            log << "File '" << fileName << "' of " << data.size() << " bytes doesn't start with PAT" << std::endl;
+            return result;
+        }
+
+        std::ostringstream parserLog;
+        PayloadParser parser(parserLog, [](const EsRawData&) {});
+        TsReader reader(parserLog, [&parser](const TsPayload& payload) { parser.parse(payload); });
+        reader.setPacketHandler([&result](const uint8_t*, uint16_t pid, uint64_t) { result.pids.insert(pid); });
+        reader.push(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+
+        if (parser.statistics().psiErrors || reader.statistics().continuityErrors)
+        {
+            log << "File '" << fileName << "' has broken PSI tables or packet sequences" << std::endl;
+            return Content();
+        }
+        for (const auto& pair : parser.programs())
+            result.programs.insert(pair.first);
+        return result;
+    }
+
+    /// @brief Run one TsWriter unit test.
+    /// @details Input is read by TsReader with filter, which is updated by PayloadParser tables.
+    /// @param[in] selection - Rules of selecting PIDs.
+    /// @param[in] perProgram - If set, SPTS per program is written.
+    /// @param[in] expected - Expected content of outputs by file names.
+    /// @param[in] pcrPid - PCR PID of the 2nd program without ES, see makeInput().
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 const PidSelection& selection,
+                 bool perProgram,
+                 const std::map<std::string, Content>& expected,
+                 uint16_t pcrPid = 0)
+    {
+        std::cout << "Running TsWriter." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+
+        // the same outputs are written from memory and by copying input file
+        std::map<std::string, std::string> outputs[2];
+        for (int fromFile = 0; fromFile < 2; ++fromFile)
+        {
+            const std::string input = makeInput(pcrPid);
+            if (fromFile)
+                std::ofstream(inputFile, std::ofstream::out | std::ofstream::binary) << input;
+
+            try
+            {
+                std::istringstream stream(input);
+                PayloadParser parser(log, [](const EsRawData&) {});
+                PidFilter filter(log, selection, parser.streams(), parser.programs());
+                TsWriter writer(log, OutputNameGenerator("out.ts"), perProgram, fromFile ? inputFile : std::string(),
+                                filter, parser.streams(), parser.programs());
+                parser.setTableHandler([&filter, &writer](const PayloadParser::TableInfo& table)
+                {
+                    filter.update();
+                    writer.writeTable(table);
+                });
+
+                TsReader reader(stream, log, [&parser](const TsPayload& payload) { parser.parse(payload); });
+                reader.setPidFilter(&filter);
+                reader.setPacketHandler([&writer](const uint8_t* packet, uint16_t pid, uint64_t offset)
+                {
+                    writer.write(packet, pid, offset);
+                });
+                reader.readAll();
+                writer.closeOutputs();
+            }
+            catch (const std::exception& e)
+            {
+                result = false;
+                log << "Unexpected exception caught: " << e.what() << std::endl;
+            }
+            std::remove(inputFile.c_str());
+
+            for (const auto& pair : expected)
+            {
+                if (!(readOutput(pair.first, outputs[fromFile][pair.first], log) == pair.second))
+                {
+                    result = false;
+                    log << "Unexpected content of '" << pair.first << "'" << (fromFile ? " copied from file" : "") << std::endl;
+                }
+            }
+        }
+
+        if (outputs[0] != outputs[1])
+        {
+            result = false;
+            log << "Outputs copied from file differ from ones written from memory" << std::endl;
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+}
+
+/// @brief Run all TsWriter unit tests.
+/// @returns Number of failed tests.
+uint16_t testTsWriter()
+{
+    uint16_t failures = 0;
+
+    failures += 1 - runTest("write_AllPids_OK", PidSelection(), false,
+                            { { "out.ts", { { 0, 0x100, 0x101, 0x102, 0x200, 0x201, 0x202, 0x203 }, { 1, 2 } } } });
+
+    failures += 1 - runTest("write_PerProgram_OK", PidSelection(), true,
+                            { { "out.ts", { { 0, 0x100, 0x101, 0x102 }, { 1 } } },
+                              { "out_2.ts", { { 0, 0x200, 0x201, 0x202, 0x203 }, { 2 } } } });
+
+    // PAT lists only programs, which PMTs are read
+    failures += 1 - runTest("write_Program_OK", PidSelection{ {}, { 2 }, { 0x203 }, {} }, false,
+                            { { "out.ts", { { 0, 0x200, 0x201, 0x202 }, { 2 } } } });
+
+    // PMTs are read even if only some ES are selected
+    failures += 1 - runTest("write_Pids_OK", PidSelection{ { 0x102, 0x202 }, {}, {}, {} }, true,
+                            { { "out.ts", { { 0, 0x100, 0x102 }, { 1 } } },
+                              { "out_2.ts", { { 0, 0x200, 0x202 }, { 2 } } } });
+
+    // PCR PID without ES is read along with selected program or its ES
+    failures += 1 - runTest("write_ProgramWithPcrPid_OK", PidSelection{ {}, { 2 }, {}, {} }, true,
+                            { { "out_2.ts", { { 0, 0x200, 0x201, 0x202, 0x203, 0x2FF }, { 2 } } } }, 0x2FF);
+    failures += 1 - runTest("write_PidsWithPcrPid_OK", PidSelection{ { 0x102, 0x202 }, {}, {}, {} }, true,
+                            { { "out.ts", { { 0, 0x100, 0x102 }, { 1 } } },
+                              { "out_2.ts", { { 0, 0x200, 0x202, 0x2FF }, { 2 } } } }, 0x2FF);
+
+    // output can't be opened
+    {
+        std::cout << "Running TsWriter.ctor_BadFile_Exception ... ";
+        bool result = false;
+        std::ostringstream log;
+        const std::map<uint16_t, PayloadParser::StreamInfo> streams;
+        const std::map<uint16_t, PayloadParser::ProgramInfo> programs;
+        try
+        {
+            PidFilter filter(log, PidSelection(), streams, programs);
+            TsWriter writer(log, OutputNameGenerator("no_such_directory/out.ts"), false, std::string(), filter, streams, programs);
+        }
+        catch (const Error& e)
+        {
+            result = e.code() == Error::CORRUPTED_OUTPUT;
+        }
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        failures += 1 - result;
+    }
+
+    return failures;
+}
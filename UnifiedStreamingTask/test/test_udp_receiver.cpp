@@ -0,0 +1,321 @@
+#include "../error.hpp"
+#include "../ts_reader.hpp"
+#include "../udp_receiver.hpp"
+#include "ts_generator.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif // __linux__
+
+
+namespace
+{
+    const uint16_t pmtPid = 0x1000;
+    const uint16_t videoPid = 0x100;
+    const uint16_t audioPid = 0x101;
+    const size_t tsPacketSize = 188;
+
+    /// @brief Number of TS packets in datagram.
+    const size_t packetsPerDatagram = 7;
+
+    /// @brief Idle timeout of receiver in tests, datagrams are sent before receiving starts.
+    const int idleTimeout = 200;
+
+    /// @brief RTP header to prepend to datagrams.
+    struct RtpHeader
+    {
+        /// @brief Number of CSRC identifiers.
+        uint8_t csrcCount;
+
+        /// @brief Number of 32-bit words of header extension or -1 if there is no extension.
+        int extensionSize;
+    };
+
+    /// @brief Expected result for UdpReceiver test.
+    struct ExpectedResult
+    {
+        /// @brief Number of received datagrams.
+        uint64_t datagrams;
+
+        /// @brief Number of datagrams with RTP header.
+        uint64_t rtpDatagrams;
+
+        /// @brief Number of lost RTP datagrams.
+        uint64_t rtpLost;
+    };
+
+    /// @brief Generate TS input with two ES.
+    std::string generateInput()
+    {
+        TsGenerator generator;
+        generator.addProgram(1, pmtPid);
+        generator.addStream(1, videoPid, 0x1B);
+        generator.addStream(1, audioPid, 0x0F);
+
+        std::string input = generator.pat() + generator.pmt(1);
+        for (int i = 0; i < 20; ++i)
+        {
+            input += generator.pes(videoPid, 0xE0, std::string(1000 + i * 10, 'v'), 3600 * i);
+            input += generator.pes(audioPid, 0xC0, std::string(300, 'a'), 3600 * i);
+        }
+        return input;
+    }
+
+    /// @brief Make RTP header.
+    /// @param[in] header - Header layout.
+    /// @param[in] sequence - Sequence number.
+    std::string rtpHeader(const RtpHeader& header, uint16_t sequence)
+    {
+        std::string result(12, '\0');
+        result[0] = char(0x80 | (header.extensionSize >= 0 ? 0x10 : 0) | header.csrcCount);
+        result[1] = char(33);
+        result[2] = char(sequence >> 8);
+        result[3] = char(sequence & 0xFF);
+        result += std::string(4 * header.csrcCount, 'c');
+        if (header.extensionSize >= 0)
+        {
+            result += std::string("\xBE\xDE", 2) + char(header.extensionSize >> 8) + char(header.extensionSize & 0xFF);
+            result += std::string(4 * header.extensionSize, 'e');
+        }
+        return result;
+    }
+
+#ifdef __linux__
+    /// @brief Send datagrams to local port.
+    /// @returns true if all datagrams sent, false otherwise.
+    bool sendDatagrams(uint16_t port, const std::vector<std::string>& datagrams)
+    {
+        const int sender = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (sender < 0)
+            return false;
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        bool result = true;
+        for (const auto& datagram : datagrams)
+        {
+            const ssize_t sent = ::sendto(sender, datagram.data(), datagram.size(), 0,
+                                          reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+            result = result && sent == static_cast<ssize_t>(datagram.size());
+        }
+
+        ::close(sender);
+        return result;
+    }
+#endif // __linux__
+
+    /// @brief Run one UdpReceiver unit test.
+    /// @details Input is sent over loopback in datagrams of 7 TS packets, received data is checked
+    ///          to be the input and to be read by TsReader.
+    /// @param[in] rtpHeaders - RTP headers of datagrams, cycled, no headers if empty.
+    /// @param[in] skippedSequences - Number of RTP sequence numbers skipped after the first datagram.
+    /// @returns true if test passed, false otherwise.
+    bool runTest(const std::string& testName,
+                 const std::vector<RtpHeader>& rtpHeaders,
+                 uint16_t skippedSequences,
+                 const ExpectedResult& expected)
+    {
+        std::cout << "Running UdpReceiver." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+
+#ifdef __linux__
+        const std::string input = generateInput();
+        std::vector<std::string> datagrams;
+        uint16_t sequence = 0xFFFE;
+        for (size_t offset = 0; offset < input.size(); offset += packetsPerDatagram * tsPacketSize)
+        {
+            std::string datagram;
+            if (!rtpHeaders.empty())
+            {
+                datagram = rtpHeader(rtpHeaders[datagrams.size() % rtpHeaders.size()], sequence);
+                sequence = static_cast<uint16_t>(sequence + 1 + (datagrams.empty() ? skippedSequences : 0));
+            }
+            datagrams.push_back(datagram + input.substr(offset, packetsPerDatagram * tsPacketSize));
+        }
+
+        std::string received;
+        uint64_t payloads = 0;
+        try
+        {
+            TsReader reader(log, [&payloads](const TsPayload&) { ++payloads; });
+            UdpReceiver receiver(log, "udp://127.0.0.1:0", idleTimeout, [&received, &reader](const uint8_t* data, size_t size)
+            {
+                received.append(reinterpret_cast<const char*>(data), size);
+                reader.push(data, size);
+            });
+
+            if (!sendDatagrams(receiver.port(), datagrams))
+            {
+                result = false;
+                log << "Failed to send datagrams" << std::endl;
+            }
+            receiver.receiveAll();
+
+            const auto& statistics = receiver.statistics();
+            if (statistics.datagrams != expected.datagrams || statistics.rtpDatagrams != expected.rtpDatagrams ||
+                statistics.rtpLost != expected.rtpLost || statistics.dropped != 0 || statistics.bytes != input.size())
+            {
+                result = false;
+                log << "Wrong statistics: " << statistics.datagrams << " datagrams, " << statistics.rtpDatagrams
+                    << " RTP datagrams, " << statistics.rtpLost << " lost" << std::endl;
+            }
+            if (statistics.batches == 0 || statistics.batches > statistics.datagrams)
+            {
+                result = false;
+                log << "Wrong number of batches " << statistics.batches << std::endl;
+            }
+            if (reader.statistics().packets != input.size() / tsPacketSize || reader.statistics().corruptedPackets != 0)
+            {
+                result = false;
+                log << "TsReader got " << reader.statistics().packets << " packets" << std::endl;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        if (received != input)
+        {
+            result = false;
+            log << "Got " << received.size() << " bytes instead of " << input.size() << std::endl;
+        }
+        if (payloads == 0)
+        {
+            result = false;
+            log << "No payloads read" << std::endl;
+        }
+#else
+        (void)rtpHeaders;
+        (void)skippedSequences;
+        (void)expected;
+        std::cout << "SKIPPED ";
+#endif // __linux__
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+
+    /// @brief Run UdpReceiver unit test for tick handler.
+    /// @details Ticks follow batches of datagrams, then every interval till idle timeout.
+    /// @returns true if test passed, false otherwise.
+    bool runTickTest(const std::string& testName, int interval, size_t expectedIdleTicks)
+    {
+        std::cout << "Running UdpReceiver." << testName << " ... ";
+
+        bool result = true;
+        std::ostringstream log;
+
+#ifdef __linux__
+        size_t busyTicks = 0;
+        size_t idleTicks = 0;
+        try
+        {
+            UdpReceiver receiver(log, "udp://127.0.0.1:0", idleTimeout, [](const uint8_t*, size_t) {});
+            receiver.setTickHandler(interval, [&busyTicks, &idleTicks](bool idle)
+            {
+                ++(idle ? idleTicks : busyTicks);
+            });
+
+            if (!sendDatagrams(receiver.port(), { std::string(tsPacketSize, 'x') }))
+            {
+                result = false;
+                log << "Failed to send datagrams" << std::endl;
+            }
+            receiver.receiveAll();
+        }
+        catch (const std::exception& e)
+        {
+            result = false;
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        if (busyTicks != 1 || idleTicks != expectedIdleTicks)
+        {
+            result = false;
+            log << "Got " << busyTicks << " ticks after datagrams and " << idleTicks << " idle ticks instead of 1 and "
+                << expectedIdleTicks << std::endl;
+        }
+#else
+        (void)interval;
+        (void)expectedIdleTicks;
+        std::cout << "SKIPPED ";
+#endif // __linux__
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+
+    /// @brief Run UdpReceiver unit test for wrong URL.
+    /// @returns true if test passed, false otherwise.
+    bool runWrongUrlTest(const std::string& testName, const std::string& url)
+    {
+        std::cout << "Running UdpReceiver." << testName << " ... ";
+
+        bool result = false;
+        std::ostringstream log;
+        try
+        {
+            UdpReceiver receiver(log, url, idleTimeout, [](const uint8_t*, size_t) {});
+            log << "No exception for URL '" << url << "'" << std::endl;
+        }
+        catch (const Error& e)
+        {
+            result = e.code() == Error::CONSTRUCTION_ERROR;
+            if (!result)
+                log << "Unexpected error code " << e.code() << std::endl;
+        }
+        catch (const std::exception& e)
+        {
+            log << "Unexpected exception caught: " << e.what() << std::endl;
+        }
+
+        std::cout << (result ? "OK" : "FAIL") << std::endl;
+        if (!result)
+            std::cout << log.str();
+        return result;
+    }
+}
+
+/// @brief Run all UdpReceiver unit tests.
+/// @returns Number of failed tests.
+uint16_t testUdpReceiver()
+{
+    uint16_t failures = 0;
+
+    const size_t datagrams = (generateInput().size() / tsPacketSize + packetsPerDatagram - 1) / packetsPerDatagram;
+
+    failures += 1 - runTest("receiveAll_Udp_OK", {}, 0, ExpectedResult{ datagrams, 0, 0 });
+
+    // headers of different sizes, sequence number wraps and one datagram is lost
+    failures += 1 - runTest("receiveAll_Rtp_OK", { { 0, -1 }, { 2, -1 }, { 1, 3 } }, 1, ExpectedResult{ datagrams, datagrams, 1 });
+
+    // idle timeout is divided into intervals, the last one ends receiving instead of tick
+    failures += 1 - runTickTest("receiveAll_TickHandler_OK", idleTimeout / 4, 3);
+    failures += 1 - runTickTest("receiveAll_TickIntervalOverIdleTimeout_OK", idleTimeout * 2, 0);
+
+    failures += 1 - runWrongUrlTest("ctor_WrongPort_Exception", "udp://127.0.0.1:65536");
+    failures += 1 - runWrongUrlTest("ctor_NoPort_Exception", "udp://@239.0.0.1");
+    failures += 1 - runWrongUrlTest("ctor_WrongAddress_Exception", "udp://localhost:1234");
+    failures += 1 - runWrongUrlTest("ctor_NotUrl_Exception", "input.ts");
+
+    return failures;
+}
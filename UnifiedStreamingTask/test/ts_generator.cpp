@@ -0,0 +1,222 @@
+#include "../crc32.hpp"
+#include "ts_generator.hpp"
+
+#include <algorithm>
+
+
+namespace
+{
+    const size_t tsPacketSize = 188;
+    const size_t tsHeaderSize = 4;
+
+    /// @brief Encode PES timestamp with given 4-bit prefix.
+    std::string timestamp(uint8_t prefix, int64_t value)
+    {
+        std::string result(5, '\0');
+        result[0] = char((prefix << 4) | ((value >> 29) & 0x0E) | 0x01);
+        result[1] = char((value >> 22) & 0xFF);
+        result[2] = char(((value >> 14) & 0xFE) | 0x01);
+        result[3] = char((value >> 7) & 0xFF);
+        result[4] = char(((value << 1) & 0xFE) | 0x01);
+        return result;
+    }
+}
+
+const int64_t TsGenerator::noPcr;
+
+void TsGenerator::addProgram(uint16_t program, uint16_t pmtPid)
+{
+    programs_[program] = Program{ pmtPid, 0, {}, 0 };
+}
+
+void TsGenerator::addStream(uint16_t program, uint16_t pid, uint8_t streamType, const std::string& descriptors)
+{
+    programs_[program].streams.push_back(Stream{ pid, streamType, descriptors });
+}
+
+void TsGenerator::setPcrPid(uint16_t program, uint16_t pcrPid)
+{
+    programs_[program].pcrPid = pcrPid;
+}
+
+void TsGenerator::setPmtVersion(uint16_t program, uint8_t version)
+{
+    programs_[program].version = version;
+}
+
+std::string TsGenerator::pat()
+{
+    std::string body;
+    for (const auto& pair : programs_)
+    {
+        body += char(pair.first >> 8);
+        body += char(pair.first & 0xFF);
+        body += char(0xE0 | (pair.second.pmtPid >> 8));
+        body += char(pair.second.pmtPid & 0xFF);
+    }
+    return packets(0, std::string(1, '\0') + section(0x00, 1, 0, body), true);
+}
+
+std::string TsGenerator::pmt(uint16_t program)
+{
+    const auto& info = programs_[program];
+    const uint16_t pcrPid = info.pcrPid ? info.pcrPid : info.streams.empty() ? 0x1FFF : info.streams.front().pid;
+
+    std::string body;
+    body += char(0xE0 | (pcrPid >> 8));
+    body += char(pcrPid & 0xFF);
+    body += char(0xF0);
+    body += char(0x00);
+    for (const auto& stream : info.streams)
+    {
+        body += char(stream.streamType);
+        body += char(0xE0 | (stream.pid >> 8));
+        body += char(stream.pid & 0xFF);
+        body += char(0xF0 | (stream.descriptors.size() >> 8));
+        body += char(stream.descriptors.size() & 0xFF);
+        body += stream.descriptors;
+    }
+    return packets(info.pmtPid, std::string(1, '\0') + section(0x02, program, info.version, body), true);
+}
+
+std::string TsGenerator::pes(uint16_t pid,
+                             uint8_t streamId,
+                             const std::string& data,
+                             int64_t pts,
+                             int64_t dts,
+                             int64_t pcr,
+                             bool randomAccess)
+{
+    std::string optional;
+    uint8_t flags = 0;
+    if (pts != noTimestamp && dts != noTimestamp)
+    {
+        flags = 0xC0;
+        optional = timestamp(0x3, pts) + timestamp(0x1, dts);
+    }
+    else if (pts != noTimestamp)
+    {
+        flags = 0x80;
+        optional = timestamp(0x2, pts);
+    }
+
+    const size_t length = 3 + optional.size() + data.size();
+
+    std::string header("\0\0\1", 3);
+    header += char(streamId);
+    header += char(length > 0xFFFF ? 0 : length >> 8);
+    header += char(length > 0xFFFF ? 0 : length & 0xFF);
+    header += char(0x80);
+    header += char(flags);
+    header += char(optional.size());
+
+    return packets(pid, header + optional + data, true, pcr, randomAccess);
+}
+
+std::string TsGenerator::nullPacket()
+{
+    std::string result(tsPacketSize, char(0xFF));
+    result[0] = 0x47;
+    result[1] = 0x1F;
+    result[2] = char(0xFF);
+    result[3] = 0x10;
+    return result;
+}
+
+std::string TsGenerator::packets(uint16_t pid,
+                                 const std::string& payload,
+                                 bool unitStart,
+                                 int64_t pcr,
+                                 bool randomAccess)
+{
+    std::string result;
+    size_t offset = 0;
+    bool first = true;
+
+    do
+    {
+        // adaptation field content of the first packet
+        std::string adaptation;
+        if (first && (pcr != noPcr || randomAccess))
+        {
+            adaptation += char((randomAccess ? 0x40 : 0x00) | (pcr != noPcr ? 0x10 : 0x00));
+            if (pcr != noPcr)
+            {
+                const int64_t base = pcr / 300;
+                const int64_t extension = pcr % 300;
+                adaptation += char((base >> 25) & 0xFF);
+                adaptation += char((base >> 17) & 0xFF);
+                adaptation += char((base >> 9) & 0xFF);
+                adaptation += char((base >> 1) & 0xFF);
+                adaptation += char(((base & 0x01) << 7) | 0x7E | (extension >> 8));
+                adaptation += char(extension & 0xFF);
+            }
+        }
+
+        // payload room left after adaptation field with its length byte
+        bool hasAdaptation = !adaptation.empty();
+        const size_t room = tsPacketSize - tsHeaderSize - (hasAdaptation ? adaptation.size() + 1 : 0);
+        const size_t chunk = std::min(payload.size() - offset, room);
+
+        // fill the rest of the last packet with stuffing bytes
+        size_t stuffing = room - chunk;
+        if (stuffing && !hasAdaptation)
+        {
+            hasAdaptation = true;
+            --stuffing;
+            if (stuffing)
+            {
+                adaptation += char(0x00);
+                --stuffing;
+            }
+        }
+        adaptation += std::string(stuffing, char(0xFF));
+
+        uint8_t& counter = counters_[pid];
+
+        std::string packet;
+        packet += char(0x47);
+        packet += char((first && unitStart ? 0x40 : 0x00) | (pid >> 8));
+        packet += char(pid & 0xFF);
+        packet += char((hasAdaptation ? 0x20 : 0x00) | (chunk ? 0x10 : 0x00) | counter);
+        if (hasAdaptation)
+        {
+            packet += char(adaptation.size());
+            packet += adaptation;
+        }
+        packet += payload.substr(offset, chunk);
+        result += packet;
+
+        if (chunk)
+            counter = (counter + 1) & 0x0F;
+        offset += chunk;
+        first = false;
+    }
+    while (offset < payload.size());
+
+    return result;
+}
+
+std::string TsGenerator::section(uint8_t tableId, uint16_t id, uint8_t version, const std::string& body)
+{
+    // 5 bytes of header after length and 4 bytes of CRC
+    const size_t length = 5 + body.size() + 4;
+
+    std::string result;
+    result += char(tableId);
+    result += char(0xB0 | (length >> 8));
+    result += char(length & 0xFF);
+    result += char(id >> 8);
+    result += char(id & 0xFF);
+    result += char(0xC1 | ((version & 0x1F) << 1));
+    result += char(0x00);
+    result += char(0x00);
+    result += body;
+
+    const uint32_t crc = crc32(reinterpret_cast<const uint8_t*>(result.data()), result.size());
+    result += char(crc >> 24);
+    result += char((crc >> 16) & 0xFF);
+    result += char((crc >> 8) & 0xFF);
+    result += char(crc & 0xFF);
+    return result;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../message_types.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+
+/// @class TsGenerator.
+/// @brief Generates synthetic TS streams for unit tests.
+class TsGenerator
+{
+public:
+    /// @brief Value of absent PCR.
+    static const int64_t noPcr = -1;
+
+    /// @brief Add program to PAT.
+    /// @param[in] program - Program number.
+    /// @param[in] pmtPid - PID of program map table.
+    void addProgram(uint16_t program, uint16_t pmtPid);
+
+    /// @brief Add elementary stream to PMT.
+    /// @param[in] program - Program number.
+    /// @param[in] pid - PID of elementary stream.
+    /// @param[in] streamType - Stream type.
+    /// @param[in] descriptors - ES info descriptors.
+    void addStream(uint16_t program, uint16_t pid, uint8_t streamType, const std::string& descriptors = std::string());
+
+    /// @brief Set PCR PID of program, by default PCR is carried by the first ES.
+    /// @param[in] program - Program number.
+    /// @param[in] pcrPid - PID of PCR.
+    void setPcrPid(uint16_t program, uint16_t pcrPid);
+
+    /// @brief Set version of program map table.
+    /// @param[in] program - Program number.
+    /// @param[in] version - Table version.
+    void setPmtVersion(uint16_t program, uint8_t version);
+
+    /// @brief Generate TS packet with program association table.
+    std::string pat();
+
+    /// @brief Generate TS packet with program map table.
+    /// @param[in] program - Program number.
+    std::string pmt(uint16_t program);
+
+    /// @brief Generate TS packets carrying one PES packet.
+    /// @param[in] pid - PID of elementary stream.
+    /// @param[in] streamId - PES stream id.
+    /// @param[in] data - ES data.
+    /// @param[in] pts - PTS or noTimestamp.
+    /// @param[in] dts - DTS or noTimestamp.
+    /// @param[in] pcr - PCR in 27 MHz units or noPcr.
+    /// @param[in] randomAccess - Value of random access indicator.
+    std::string pes(uint16_t pid,
+                    uint8_t streamId,
+                    const std::string& data,
+                    int64_t pts = noTimestamp,
+                    int64_t dts = noTimestamp,
+                    int64_t pcr = noPcr,
+                    bool randomAccess = false);
+
+    /// @brief Generate null packet.
+    std::string nullPacket();
+
+    /// @brief Split payload into TS packets.
+    /// @param[in] pid - PID of packets.
+    /// @param[in] payload - Payload to split.
+    /// @param[in] unitStart - Value of payload unit start indicator of the first packet.
+    /// @param[in] pcr - PCR of the first packet in 27 MHz units or noPcr.
+    /// @param[in] randomAccess - Value of random access indicator of the first packet.
+    std::string packets(uint16_t pid,
+                        const std::string& payload,
+                        bool unitStart,
+                        int64_t pcr = noPcr,
+                        bool randomAccess = false);
+
+private:
+    /// @brief Make PSI section with CRC.
+    static std::string section(uint8_t tableId, uint16_t id, uint8_t version, const std::string& body);
+
+private:
+    /// @brief Elementary stream description.
+    struct Stream
+    {
+        uint16_t pid;
+        uint8_t streamType;
+        std::string descriptors;
+    };
+
+    /// @brief Program description.
+    struct Program
+    {
+        uint16_t pmtPid;
+        uint8_t version;
+        std::vector<Stream> streams;
+
+        /// @brief PCR PID, 0 if PCR is carried by the first ES.
+        uint16_t pcrPid;
+    };
+
+    /// @brief Programs by number.
+    std::map<uint16_t, Program> programs_;
+
+    /// @brief Continuity counters by PID.
+    std::map<uint16_t, uint8_t> counters_;
+};
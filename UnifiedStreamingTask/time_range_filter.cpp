@@ -0,0 +1,83 @@
+#include "error.hpp"
+#include "time_range_filter.hpp"
+#include "timestamp.hpp"
+
+
+TimeRangeFilter::TimeRangeFilter(std::ostream& log, const TimePoint& start, const TimePoint& end, OnEsRawData handler)
+    : log_(log)
+    , start_(start)
+    , end_(end)
+    , handler_(handler)
+{
+    if (!log_.good())
+        throw Error(Error::CONSTRUCTION_ERROR, "TimeRangeFilter, bad log output");
+    if (!handler_)
+        throw Error(Error::CONSTRUCTION_ERROR, "TimeRangeFilter, empty handler");
+}
+
+void TimeRangeFilter::setReference(int64_t pts)
+{
+    reference_ = pts;
+}
+
+int64_t TimeRangeFilter::startPts() const
+{
+    return resolve(start_);
+}
+
+void TimeRangeFilter::write(const EsRawData& rawData)
+{
+    if (reference_ == noTimestamp && rawData.pts != noTimestamp)
+        setReference(rawData.pts);
+
+    const bool hasPts = rawData.newEsPacket && rawData.pts != noTimestamp;
+    auto it = streams_.find(rawData.pid);
+
+    // ES is tracked since its first PTS, ES without PTS can't be cut, so it's passed only if range has no start
+    if (it == streams_.end())
+    {
+        if (!hasPts)
+        {
+            if (!start_.isSet)
+                handler_(rawData);
+            return;
+        }
+        it = streams_.insert({ rawData.pid, start_.isSet ? BEFORE : INSIDE }).first;
+    }
+    auto& state = it->second;
+
+    if (hasPts)
+    {
+        const int64_t start = resolve(start_);
+        const int64_t end = resolve(end_);
+
+        if (state == BEFORE && ptsDelta(start, rawData.pts) >= 0)
+            state = INSIDE;
+
+        if (state != AFTER && end != noTimestamp && ptsDelta(end, rawData.pts) >= 0)
+        {
+            state = AFTER;
+            ++finishedStreams_;
+            log_ << "Notice: TimeRangeFilter, stream with pid " << rawData.pid << " reached range end" << std::endl;
+        }
+    }
+
+    if (state == INSIDE)
+        handler_(rawData);
+}
+
+bool TimeRangeFilter::finished() const
+{
+    return !streams_.empty() && finishedStreams_ == streams_.size();
+}
+
+int64_t TimeRangeFilter::resolve(const TimePoint& point) const
+{
+    if (!point.isSet)
+        return noTimestamp;
+    if (point.isPts)
+        return point.ticks % ptsModulo;
+    if (reference_ == noTimestamp)
+        return noTimestamp;
+    return (reference_ + point.ticks) % ptsModulo;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "message_types.hpp"
+
+#include <functional>
+#include <map>
+#include <ostream>
+
+
+/// @struct TimePoint.
+/// @brief Bound of time range.
+struct TimePoint
+{
+    /// @brief Set if bound is given.
+    bool isSet;
+
+    /// @brief Time in 90 kHz ticks.
+    int64_t ticks;
+
+    /// @brief If set, time is absolute PTS, otherwise it is relative to the first PTS of the input.
+    bool isPts;
+};
+
+/// @class TimeRangeFilter.
+/// @brief Pass only ES raw data within time range.
+/// @details Every ES starts with the first PES packet with PTS not less than range start and ends
+///          before the first PES packet with PTS not less than range end, so the passed data is
+///          contiguous. PES packets without PTS follow the previous one. ES without PTS at all
+///          are passed only if range has no start and are not waited for to reach range end.
+class TimeRangeFilter
+{
+public:
+    /// @brief Type of raw data handler.
+    using OnEsRawData = std::function<void(const EsRawData&)>;
+
+    /// @brief Constructor.
+    /// @param[out] log - Stream for log messages.
+    /// @param[in] start - Start of time range, may be unset.
+    /// @param[in] end - End of time range, may be unset.
+    /// @param[in] handler - Raw data handler.
+    /// @throws Error.
+    TimeRangeFilter(std::ostream& log, const TimePoint& start, const TimePoint& end, OnEsRawData handler);
+
+    /// @brief Set the first PTS of the input, relative time points are counted from it.
+    /// @details If not set, the first PTS passed to the filter is used.
+    /// @param[in] pts - The first PTS of the input.
+    void setReference(int64_t pts);
+
+    /// @brief Get absolute PTS of range start, noTimestamp if unset or reference is unknown.
+    int64_t startPts() const;
+
+    /// @brief Filter raw data.
+    /// @details Calls handler, which may throws exceptions.
+    /// @param[in] rawData - ES raw data.
+    void write(const EsRawData& rawData);
+
+    /// @brief Check if all detected ES have passed range end.
+    bool finished() const;
+
+private:
+    /// @brief State of ES relatively to time range.
+    enum State
+    {
+        BEFORE,
+        INSIDE,
+        AFTER,
+    };
+
+    /// @brief Get absolute PTS of time point.
+    /// @param[in] point - Time point.
+    /// @returns PTS or noTimestamp if point is unset or reference is unknown.
+    int64_t resolve(const TimePoint& point) const;
+
+private:
+    /// @brief Log output stream.
+    std::ostream& log_;
+
+    /// @brief Start of time range.
+    const TimePoint start_;
+
+    /// @brief End of time range.
+    const TimePoint end_;
+
+    /// @brief Raw data handler.
+    OnEsRawData handler_;
+
+    /// @brief The first PTS of the input.
+    int64_t reference_ = noTimestamp;
+
+    /// @brief States of detected ES by PID.
+    std::map<uint16_t, State> streams_;
+
+    /// @brief Number of ES which have passed range end.
+    size_t finishedStreams_ = 0;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+
+/// @brief PTS and DTS clock frequency, ticks per second.
+const int64_t ptsFrequency = 90000;
+
+/// @brief PTS and DTS wrap around after 33 bits.
+const int64_t ptsModulo = int64_t(1) << 33;
+
+/// @brief PCR clock frequency, ticks per second.
+const int64_t pcrFrequency = 27000000;
+
+/// @brief Read 33-bit timestamp from PES header.
+/// @param[in] data - Start of 5-byte timestamp field.
+inline int64_t readTimestamp(const uint8_t* data)
+{
+    return (int64_t(data[0] & 0x0E) << 29) +
+           (int64_t(data[1]) << 22) +
+           (int64_t(data[2] & 0xFE) << 14) +
+           (int64_t(data[3]) << 7) +
+           (int64_t(data[4]) >> 1);
+}
+
+/// @brief Read PCR from adaptation field.
+/// @param[in] data - Start of 6-byte PCR field.
+/// @returns PCR in 27 MHz ticks.
+inline int64_t readPcr(const uint8_t* data)
+{
+    const int64_t base = (int64_t(data[0]) << 25) +
+                         (int64_t(data[1]) << 17) +
+                         (int64_t(data[2]) << 9) +
+                         (int64_t(data[3]) << 1) +
+                         (int64_t(data[4]) >> 7);
+    const int64_t extension = (int64_t(data[4] & 0x01) << 8) + data[5];
+    return base * 300 + extension;
+}
+
+/// @brief Signed difference between two PTS values taking wrap around into account.
+/// @param[in] from - Reference PTS.
+/// @param[in] to - Another PTS.
+/// @returns Difference from reference PTS to another one.
+inline int64_t ptsDelta(int64_t from, int64_t to)
+{
+    int64_t delta = (to - from) % ptsModulo;
+    if (delta >= ptsModulo / 2)
+        delta -= ptsModulo;
+    else if (delta < -ptsModulo / 2)
+        delta += ptsModulo;
+    return delta;
+}
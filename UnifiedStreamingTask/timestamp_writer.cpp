@@ -0,0 +1,143 @@
+#include "error.hpp"
+#include "timestamp_writer.hpp"
+#include "ts_index.hpp"
+
+#include <cstring>
+#include <list>
+#include <sstream>
+
+
+TimestampWriter::TimestampWriter(std::ostream& log,
+                                 const OutputNameGenerator& audioNameGenerator,
+                                 const OutputNameGenerator& videoNameGenerator)
+    : log_(log)
+    , audioNameGenerator_(audioNameGenerator)
+    , videoNameGenerator_(videoNameGenerator)
+    , dummyOutput_{ "", nullptr, 0 }
+{
+    if (!log_.good())
+        throw Error(Error::CONSTRUCTION_ERROR, "TimestampWriter, bad log output");
+}
+
+TimestampWriter::~TimestampWriter()
+{
+    try
+    {
+        closeOutputs();
+    }
+    catch (const Error& err)
+    {
+        log_ << "Error: TimestampWriter, failed to close timestamp files, " << err.message() << std::endl;
+    }
+}
+
+void TimestampWriter::write(const EsRawData& rawData)
+{
+    auto& output = chooseOutput(rawData.type, rawData.esNumber);
+    if (!output.stream)
+        return;
+
+    if (rawData.newEsPacket && rawData.pts != noTimestamp)
+    {
+        const TsTimestampsRecord record{ output.esBytes, rawData.pts, rawData.dts };
+        output.stream->write(reinterpret_cast<const char*>(&record), sizeof(record));
+        if (!output.stream->good())
+            throw Error(Error::CORRUPTED_OUTPUT, "TimestampWriter, failed to write into file '" + output.file + "'");
+    }
+    output.esBytes += rawData.size;
+}
+
+void TimestampWriter::flushOutputs()
+{
+    auto flushOutput = [](Output& output)
+    {
+        if (output.stream && !output.stream->flush().good())
+            throw Error(Error::CORRUPTED_OUTPUT, "TimestampWriter, failed to flush file '" + output.file + "'");
+    };
+
+    for (auto& pair : audioOutputs_)
+        flushOutput(pair.second);
+    for (auto& pair : videoOutputs_)
+        flushOutput(pair.second);
+}
+
+void TimestampWriter::closeOutputs()
+{
+    // to collect names of failed files
+    std::list<std::string> failedFiles;
+    auto closeOutput = [&failedFiles](Output& output)
+    {
+        if (!output.stream)
+            return;
+        output.stream->close();
+        if (!output.stream->good())
+            failedFiles.push_back(output.file);
+        output.stream.reset();
+    };
+
+    for (auto& pair : audioOutputs_)
+        closeOutput(pair.second);
+    for (auto& pair : videoOutputs_)
+        closeOutput(pair.second);
+
+    if (!failedFiles.empty())
+    {
+        std::ostringstream msg;
+        msg << "TimestampWriter, failed to close file(s) ";
+
+        auto end = --failedFiles.cend();
+        for (auto it = failedFiles.cbegin(); it != end; ++it)
+            msg << "'" << *it << "',";
+        msg << "'" << *end << "'";
+
+        throw Error(Error::CORRUPTED_OUTPUT, msg.str());
+    }
+}
+
+TimestampWriter::Output& TimestampWriter::chooseOutput(EsType type, uint16_t number)
+{
+    std::map<uint16_t, Output>* outputs = nullptr;
+    const OutputNameGenerator* generator = nullptr;
+
+    if (type == EsType::AUDIO)
+    {
+        outputs = &audioOutputs_;
+        generator = &audioNameGenerator_;
+    }
+    else if (type == EsType::VIDEO)
+    {
+        outputs = &videoOutputs_;
+        generator = &videoNameGenerator_;
+    }
+    else
+        return dummyOutput_;
+
+    // ES already detected
+    const auto it = outputs->find(number);
+    if (it != outputs->end())
+        return it->second;
+
+    // no timestamp file if no output file for this ES
+    const std::string name = generator->name(number);
+    auto& output = (*outputs)[number];
+    output.esBytes = 0;
+    if (name.empty())
+        return output;
+
+    // try to open new file for write
+    output.file = name + ".pts";
+    output.stream.reset(new std::ofstream(output.file, std::fstream::out | std::fstream::binary));
+    if (!output.stream->good())
+    {
+        output.stream.reset();
+        throw Error(Error::CORRUPTED_OUTPUT, "TimestampWriter, failed to open file '" + output.file + "' for writing");
+    }
+
+    TsTimestampsHeader header;
+    std::memcpy(header.magic, tsTimestampsMagic, sizeof(header.magic));
+    header.version = tsTimestampsVersion;
+    header.recordSize = sizeof(TsTimestampsRecord);
+    output.stream->write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    return output;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "message_types.hpp"
+#include "output_name_generator.hpp"
+
+#include <fstream>
+#include <map>
+#include <memory>
+
+
+/// @class TimestampWriter.
+/// @brief Write PTS and DTS of every PES packet of output ES into timestamp files.
+/// @details Timestamp file of ES is named after its output file with '.pts' suffix,
+///          its format is described in ts_index.hpp.
+class TimestampWriter
+{
+public:
+    /// @brief Constructor.
+    /// @param[out] log - Stream for log messages.
+    /// @param[in] audioNameGenerator - Generator for audio output file names.
+    /// @param[in] videoNameGenerator - Generator for video output file names.
+    /// @throws Error.
+    TimestampWriter(std::ostream& log,
+                    const OutputNameGenerator& audioNameGenerator,
+                    const OutputNameGenerator& videoNameGenerator);
+
+    /// @brief Desctructor.
+    ~TimestampWriter();
+
+    /// @brief Add raw data, which is written into output ES.
+    /// @param[in] rawData - ES raw data.
+    /// @throws Error in case of corrupted output streams.
+    void write(const EsRawData& rawData);
+
+    /// @brief Flush buffered records into timestamp files.
+    /// @throws Error in case of corrupted output streams.
+    void flushOutputs();
+
+    /// @brief Close timestamp files.
+    /// @throws Error in case of corrupted output streams.
+    void closeOutputs();
+
+private:
+    /// @brief Timestamp file of ES.
+    struct Output
+    {
+        /// @brief Timestamp file name.
+        std::string file;
+
+        /// @brief Timestamp file stream.
+        std::unique_ptr<std::ofstream> stream;
+
+        /// @brief Number of ES bytes already written into output ES.
+        uint64_t esBytes;
+    };
+
+    /// @brief Choose or open timestamp file for ES.
+    /// @param[in] type - Type of ES.
+    /// @param[in] number - Sequence number of ES.
+    /// @throws Error if fails to open file stream.
+    Output& chooseOutput(EsType type, uint16_t number);
+
+private:
+    /// @brief Log output stream.
+    std::ostream& log_;
+
+    /// @brief Generator for audio output file names.
+    const OutputNameGenerator& audioNameGenerator_;
+
+    /// @brief Generator for video output file names.
+    const OutputNameGenerator& videoNameGenerator_;
+
+    /// @brief Timestamp files of detected audio ES.
+    std::map<uint16_t, Output> audioOutputs_;
+
+    /// @brief Timestamp files of detected video ES.
+    std::map<uint16_t, Output> videoOutputs_;
+
+    /// @brief Dummy output for ES without output file.
+    Output dummyOutput_;
+};
@@ -0,0 +1,137 @@
+#include "tracing.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    /// @brief Environment variable naming trace file.
+    const char* const traceEnvironmentVariable = "TS_SPLITTER_TRACE";
+
+    /// @brief Default trace file name.
+    const char* const defaultTraceFile = "ts_splitter_trace.json";
+
+    /// @brief Recorded span.
+    struct Span
+    {
+        const char* name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    /// @brief Spans of one thread, the oldest ones are overwritten.
+    struct Ring
+    {
+        /// @brief Thread number, starting from 1.
+        size_t thread;
+
+        /// @brief Preallocated spans.
+        std::vector<Span> spans;
+
+        /// @brief Number of spans recorded since the last clear.
+        uint64_t count;
+    };
+
+    /// @brief Rings of all threads, they outlive their threads to be dumped at exit.
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Ring>> rings;
+    };
+
+    Registry& registry()
+    {
+        static Registry instance;
+        return instance;
+    }
+
+    /// @brief Get ring of the calling thread, allocate it by the first call.
+    Ring& threadRing()
+    {
+        static thread_local Ring* ring = nullptr;
+        if (!ring)
+        {
+            auto& instance = registry();
+            std::lock_guard<std::mutex> lock(instance.mutex);
+            instance.rings.emplace_back(new Ring{ instance.rings.size() + 1, std::vector<Span>(Tracer::capacity), 0 });
+            ring = instance.rings.back().get();
+        }
+        return *ring;
+    }
+
+    /// @brief Write time in nanoseconds as microseconds, the unit of trace format.
+    void writeMicroseconds(std::ostream& output, uint64_t time)
+    {
+        output << time / 1000 << '.' << std::setw(3) << std::setfill('0') << time % 1000 << std::setfill(' ');
+    }
+}
+
+uint64_t Tracer::now()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+void Tracer::record(const char* name, uint64_t begin, uint64_t end)
+{
+    Ring& ring = threadRing();
+    ring.spans[ring.count % capacity] = Span{ name, begin, end };
+    ++ring.count;
+}
+
+void Tracer::dump(std::ostream& output)
+{
+    auto& instance = registry();
+    std::lock_guard<std::mutex> lock(instance.mutex);
+
+    uint64_t dropped = 0;
+    bool first = true;
+    output << "{\"traceEvents\":[";
+    for (const auto& ring : instance.rings)
+    {
+        const uint64_t kept = std::min<uint64_t>(ring->count, capacity);
+        dropped += ring->count - kept;
+        for (uint64_t i = ring->count - kept; i < ring->count; ++i)
+        {
+            const Span& span = ring->spans[i % capacity];
+            output << (first ? "\n" : ",\n") << "{\"name\":\"" << span.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->thread << ",\"ts\":";
+            writeMicroseconds(output, span.begin);
+            output << ",\"dur\":";
+            writeMicroseconds(output, span.end - span.begin);
+            output << "}";
+            first = false;
+        }
+    }
+    output << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"droppedSpans\":" << dropped << "}}\n";
+}
+
+void Tracer::dumpToFile()
+{
+    const char* value = std::getenv(traceEnvironmentVariable);
+    const std::string file = value && *value ? value : defaultTraceFile;
+
+    std::ofstream output(file, std::fstream::out | std::fstream::binary);
+    dump(output);
+    output.close();
+    if (!output.good())
+        std::clog << "Warning: Tracer, failed to write trace file '" << file << "'" << std::endl;
+    else
+        std::clog << "Notice: Tracer, trace written to '" << file << "'" << std::endl;
+}
+
+void Tracer::clear()
+{
+    auto& instance = registry();
+    std::lock_guard<std::mutex> lock(instance.mutex);
+    for (auto& ring : instance.rings)
+        ring->count = 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#ifdef TS_SPLITTER_TRACING
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+/// @brief Trace the rest of enclosing scope as span with given name, a string literal.
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+
+/// @brief Write spans of all threads into trace file.
+#define TRACE_DUMP() Tracer::dumpToFile()
+#else
+#define TRACE_SPAN(name) ((void)0)
+#define TRACE_DUMP() ((void)0)
+#endif // TS_SPLITTER_TRACING
+
+
+/// @class Tracer.
+/// @brief Collects spans of pipeline stages in preallocated per-thread rings and writes them in
+///        Chrome trace JSON format, which chrome://tracing and Perfetto UI show as timeline.
+/// @details Recording a span takes no lock, ring of a thread is allocated by its first span and
+///          keeps the latest spans. Spans are recorded only in builds with TS_SPLITTER_TRACING
+///          defined, by TRACE_SPAN() macro.
+class Tracer
+{
+public:
+    /// @brief Number of spans kept per thread.
+    static const size_t capacity = 1 << 16;
+
+    /// @brief Get time since the first call, in nanoseconds.
+    static uint64_t now();
+
+    /// @brief Record span of the calling thread.
+    /// @param[in] name - Span name, string literal.
+    /// @param[in] begin - Span begin time from now().
+    /// @param[in] end - Span end time from now().
+    static void record(const char* name, uint64_t begin, uint64_t end);
+
+    /// @brief Write spans of all threads in Chrome trace JSON format.
+    /// @details Traced threads must be finished or idle.
+    /// @param[out] output - Stream for the trace.
+    static void dump(std::ostream& output);
+
+    /// @brief Write spans of all threads into file named by TS_SPLITTER_TRACE environment variable,
+    ///        ts_splitter_trace.json by default. Failure is logged only.
+    static void dumpToFile();
+
+    /// @brief Drop recorded spans of all threads.
+    static void clear();
+};
+
+/// @class TraceSpan.
+/// @brief Records span from construction till destruction.
+class TraceSpan
+{
+public:
+    /// @brief Constructor.
+    /// @param[in] name - Span name, string literal.
+    explicit TraceSpan(const char* name)
+        : name_(name)
+        , begin_(Tracer::now())
+    {
+    }
+
+    /// @brief Destructor, records the span.
+    ~TraceSpan()
+    {
+        Tracer::record(name_, begin_, Tracer::now());
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    /// @brief Span name.
+    const char* name_;
+
+    /// @brief Span begin time.
+    uint64_t begin_;
+};
@@ -0,0 +1,150 @@
+#include "ts_headers.hpp"
+
+#include <cstring>
+
+#ifdef SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+
+const size_t TsHeaders::capacity;
+const uint8_t TsHeaders::transportError;
+const uint8_t TsHeaders::payloadStart;
+const uint8_t TsHeaders::adaptationField;
+const uint8_t TsHeaders::payload;
+
+namespace
+{
+    const size_t tsPacketSize = 188;
+    const uint8_t tsSyncByte = 0x47;
+
+#ifdef SIMD_SSE2
+    /// @brief Read the first 4 bytes of packet as little endian number.
+    inline int readWord(const uint8_t* packet)
+    {
+        int word;
+        std::memcpy(&word, packet, sizeof(word));
+        return word;
+    }
+#endif
+}
+
+size_t decodeTsHeaders(const uint8_t* data, size_t count, TsHeaders& headers)
+{
+    return kernels().decodeTsHeaders(data, count, headers);
+}
+
+#ifdef SIMD_SSE2
+size_t decodeTsHeadersSse2(const uint8_t* data, size_t count, TsHeaders& headers)
+{
+    // every iteration gathers headers of 4 packets into 32-bit lanes, byte 0 of header is the lowest one
+    const __m128i lowByte = _mm_set1_epi32(0xFF);
+    const __m128i sync = _mm_set1_epi32(tsSyncByte);
+    const __m128i adaptation = _mm_set1_epi32(0x20000000);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const uint8_t* packet = data + i * tsPacketSize;
+        const __m128i words = _mm_set_epi32(readWord(packet + 3 * tsPacketSize), readWord(packet + 2 * tsPacketSize),
+                                            readWord(packet + tsPacketSize), readWord(packet));
+
+        // all 4 sync bytes are checked at once, the rest is decoded by scalar code
+        const __m128i synced = _mm_cmpeq_epi32(_mm_and_si128(words, lowByte), sync);
+        if (_mm_movemask_epi8(synced) != 0xFFFF)
+            break;
+
+        // PID is 13 bits of bytes 1 and 2
+        const __m128i pids = _mm_or_si128(_mm_and_si128(words, _mm_set1_epi32(0x1F00)),
+                                          _mm_and_si128(_mm_srli_epi32(words, 16), lowByte));
+
+        // flags are 2 high bits of byte 1 and adaptation field control of byte 3
+        const __m128i flags = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(words, 8), _mm_set1_epi32(0xC0)),
+                                           _mm_and_si128(_mm_srli_epi32(words, 24), _mm_set1_epi32(0x30)));
+        const __m128i seqNumbers = _mm_and_si128(_mm_srli_epi32(words, 24), _mm_set1_epi32(0x0F));
+
+        // payload follows adaptation field of byte 4 + 1 bytes, if it's present
+        const __m128i lengths = _mm_set_epi32(packet[3 * tsPacketSize + 4], packet[2 * tsPacketSize + 4],
+                                              packet[tsPacketSize + 4], packet[4]);
+        const __m128i hasAdaptation = _mm_cmpeq_epi32(_mm_and_si128(words, adaptation), adaptation);
+        const __m128i offsets = _mm_add_epi32(_mm_set1_epi32(4),
+                                              _mm_and_si128(hasAdaptation, _mm_add_epi32(lengths, _mm_set1_epi32(1))));
+
+        // all values fit into 16 bits, flags and counters fit into 8 bits
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(headers.pids + i), _mm_packs_epi32(pids, pids));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(headers.payloadOffsets + i), _mm_packs_epi32(offsets, offsets));
+        const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(flags, seqNumbers), _mm_setzero_si128());
+        const int packed = _mm_cvtsi128_si32(bytes);
+        std::memcpy(headers.flags + i, &packed, 4);
+        const int packedSeqNumbers = _mm_cvtsi128_si32(_mm_srli_si128(bytes, 4));
+        std::memcpy(headers.seqNumbers + i, &packedSeqNumbers, 4);
+    }
+
+    return decodeTsHeadersScalar(data, count, headers, i);
+}
+#endif
+
+#ifdef SIMD_AVX2
+SIMD_TARGET_AVX2 size_t decodeTsHeadersAvx2(const uint8_t* data, size_t count, TsHeaders& headers)
+{
+    // every iteration gathers headers of 8 packets into 32-bit lanes, byte 0 of header is the lowest one
+    const __m256i offsets = _mm256_setr_epi32(0, tsPacketSize, 2 * tsPacketSize, 3 * tsPacketSize,
+                                              4 * tsPacketSize, 5 * tsPacketSize, 6 * tsPacketSize, 7 * tsPacketSize);
+    const __m256i lowByte = _mm256_set1_epi32(0xFF);
+    const __m256i sync = _mm256_set1_epi32(tsSyncByte);
+    const __m256i adaptation = _mm256_set1_epi32(0x20000000);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const int* packet = reinterpret_cast<const int*>(data + i * tsPacketSize);
+        const __m256i words = _mm256_i32gather_epi32(packet, offsets, 1);
+
+        // all 8 sync bytes are checked at once, the rest is decoded by scalar code
+        const __m256i synced = _mm256_cmpeq_epi32(_mm256_and_si256(words, lowByte), sync);
+        if (_mm256_movemask_epi8(synced) != -1)
+            break;
+
+        const __m256i pids = _mm256_or_si256(_mm256_and_si256(words, _mm256_set1_epi32(0x1F00)),
+                                             _mm256_and_si256(_mm256_srli_epi32(words, 16), lowByte));
+        const __m256i flags = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(words, 8), _mm256_set1_epi32(0xC0)),
+                                              _mm256_and_si256(_mm256_srli_epi32(words, 24), _mm256_set1_epi32(0x30)));
+        const __m256i seqNumbers = _mm256_and_si256(_mm256_srli_epi32(words, 24), _mm256_set1_epi32(0x0F));
+
+        // byte 4 is adaptation field length
+        const __m256i lengths = _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(data + i * tsPacketSize + 4), offsets, 1), lowByte);
+        const __m256i hasAdaptation = _mm256_cmpeq_epi32(_mm256_and_si256(words, adaptation), adaptation);
+        const __m256i payloadOffsets = _mm256_add_epi32(_mm256_set1_epi32(4),
+                                                        _mm256_and_si256(hasAdaptation, _mm256_add_epi32(lengths, _mm256_set1_epi32(1))));
+
+        // 128-bit packs keep order of packets
+        const __m128i packedPids = _mm_packs_epi32(_mm256_castsi256_si128(pids), _mm256_extracti128_si256(pids, 1));
+        const __m128i packedOffsets = _mm_packs_epi32(_mm256_castsi256_si128(payloadOffsets), _mm256_extracti128_si256(payloadOffsets, 1));
+        const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(_mm256_castsi256_si128(flags), _mm256_extracti128_si256(flags, 1)),
+                                               _mm_packs_epi32(_mm256_castsi256_si128(seqNumbers), _mm256_extracti128_si256(seqNumbers, 1)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(headers.pids + i), packedPids);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(headers.payloadOffsets + i), packedOffsets);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(headers.flags + i), bytes);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(headers.seqNumbers + i), _mm_srli_si128(bytes, 8));
+    }
+
+    return decodeTsHeadersScalar(data, count, headers, i);
+}
+#endif
+
+size_t decodeTsHeadersScalar(const uint8_t* data, size_t count, TsHeaders& headers, size_t first)
+{
+    for (size_t i = first; i < count; ++i)
+    {
+        const uint8_t* packet = data + i * tsPacketSize;
+        if (packet[0] != tsSyncByte)
+            return i;
+
+        headers.pids[i] = static_cast<uint16_t>(((packet[1] & 0x1F) << 8) + packet[2]);
+        headers.flags[i] = static_cast<uint8_t>((packet[1] & 0xC0) | (packet[3] & 0x30));
+        headers.seqNumbers[i] = packet[3] & 0x0F;
+        headers.payloadOffsets[i] = static_cast<uint16_t>((packet[3] & 0x20) ? 5 + packet[4] : 4);
+    }
+    return count;
+}
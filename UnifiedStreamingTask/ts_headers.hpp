@@ -0,0 +1,65 @@
+#pragma once
+
+#include "cpu_features.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+/// @struct TsHeaders.
+/// @brief Headers of block of TS packets decoded into structure of arrays.
+struct TsHeaders
+{
+    /// @brief Maximum number of packets decoded at once.
+    static const size_t capacity = 64;
+
+    /// @brief Flag of transport error indicator.
+    static const uint8_t transportError = 0x80;
+
+    /// @brief Flag of payload unit start indicator.
+    static const uint8_t payloadStart = 0x40;
+
+    /// @brief Flag of adaptation field presence.
+    static const uint8_t adaptationField = 0x20;
+
+    /// @brief Flag of payload presence.
+    static const uint8_t payload = 0x10;
+
+    /// @brief PIDs of packets.
+    uint16_t pids[capacity];
+
+    /// @brief Offsets of payloads within packets, may exceed packet size in corrupted packets.
+    uint16_t payloadOffsets[capacity];
+
+    /// @brief Flags of packets, combination of transportError, payloadStart, adaptationField and payload.
+    uint8_t flags[capacity];
+
+    /// @brief Continuity counters of packets.
+    uint8_t seqNumbers[capacity];
+};
+
+/// @brief Decode headers of consecutive TS packets of 188 bytes.
+/// @details Uses kernel chosen by CPU features, see kernels(). Decoding stops at the first packet without sync byte.
+/// @param[in] data - Start of the first packet.
+/// @param[in] count - Number of packets, not more than TsHeaders::capacity.
+/// @param[out] headers - Decoded headers.
+/// @returns Number of decoded packets.
+size_t decodeTsHeaders(const uint8_t* data, size_t count, TsHeaders& headers);
+
+/// @brief Portable implementation of decodeTsHeaders().
+/// @param[in] data - Start of the first packet.
+/// @param[in] count - Number of packets, not more than TsHeaders::capacity.
+/// @param[out] headers - Decoded headers.
+/// @param[in] first - Index of the first packet to decode, previous ones are already decoded.
+/// @returns Number of decoded packets, including previous ones.
+size_t decodeTsHeadersScalar(const uint8_t* data, size_t count, TsHeaders& headers, size_t first = 0);
+
+#ifdef SIMD_SSE2
+/// @brief SSE2 implementation of decodeTsHeaders().
+size_t decodeTsHeadersSse2(const uint8_t* data, size_t count, TsHeaders& headers);
+#endif
+
+#ifdef SIMD_AVX2
+/// @brief AVX2 implementation of decodeTsHeaders(), CPU should support AVX2.
+size_t decodeTsHeadersAvx2(const uint8_t* data, size_t count, TsHeaders& headers);
+#endif
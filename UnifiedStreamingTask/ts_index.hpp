@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstdint>
+
+
+/// @file ts_index.hpp.
+/// @brief Layouts of sidecar random-access index of TS input, and timestamp and frame files of output ES.
+/// @details Index file consists of header, array of stream records, array of table records and array
+///          of entries. All sections are 8-byte aligned, so file can be mapped into memory and
+///          accessed as arrays of the structs below. All values are little-endian.
+///          Entries of one stream are contiguous and sorted by TS offset.
+
+/// @brief Index file signature.
+const char tsIndexMagic[8] = { 'T', 'S', 'I', 'N', 'D', 'E', 'X', 0 };
+
+/// @brief Current version of index format.
+const uint32_t tsIndexVersion = 2;
+
+/// @brief Type of indexed stream.
+enum TsIndexStreamType : uint8_t
+{
+    INDEX_AUDIO = 1,
+    INDEX_VIDEO = 2,
+};
+
+/// @struct TsIndexHeader.
+/// @brief Header of index file.
+struct TsIndexHeader
+{
+    /// @brief Signature, equals to tsIndexMagic.
+    char magic[8];
+
+    /// @brief Version of index format.
+    uint32_t version;
+
+    /// @brief Size of the header, stream records follow it.
+    uint32_t headerSize;
+
+    /// @brief Number of stream records.
+    uint32_t streams;
+
+    /// @brief Number of table records, they follow stream records.
+    uint32_t tables;
+
+    /// @brief Number of entries, they follow table records.
+    uint64_t entries;
+};
+
+/// @struct TsIndexStream.
+/// @brief Record of one indexed elementary stream.
+struct TsIndexStream
+{
+    /// @brief PID of the stream.
+    uint16_t pid;
+
+    /// @brief Program number, 0 if stream is not described by PMT.
+    uint16_t program;
+
+    /// @brief Stream number in the set of all streams of same type.
+    uint16_t esNumber;
+
+    /// @brief Type of the stream, one of TsIndexStreamType.
+    uint8_t type;
+
+    /// @brief Stream type from PMT, 0 if stream is not described by PMT.
+    uint8_t streamType;
+
+    /// @brief Index of the first entry of the stream.
+    uint64_t firstEntry;
+
+    /// @brief Number of entries of the stream.
+    uint64_t entries;
+};
+
+/// @struct TsIndexTable.
+/// @brief Record of PSI table version seen in the input.
+struct TsIndexTable
+{
+    /// @brief Offset of TS packet with the table within input.
+    uint64_t tsOffset;
+
+    /// @brief PID of the table.
+    uint16_t pid;
+
+    /// @brief Transport stream id for PAT, program number for PMT.
+    uint16_t number;
+
+    /// @brief Table id.
+    uint8_t tableId;
+
+    /// @brief Table version.
+    uint8_t version;
+
+    /// @brief Reserved, set to 0.
+    uint16_t reserved;
+};
+
+/// @struct TsIndexEntry.
+/// @brief Entry for one PES packet start.
+struct TsIndexEntry
+{
+    /// @brief Offset of TS packet with PES header within input.
+    uint64_t tsOffset;
+
+    /// @brief Offset of PES packet data within output ES file, which is segment file for segmented output.
+    uint64_t esOffset;
+
+    /// @brief PTS of PES packet, -1 if absent.
+    int64_t pts;
+
+    /// @brief Sequence number of segment file with PES packet data, 0 if output is not segmented.
+    uint32_t segment;
+
+    /// @brief Reserved, set to 0.
+    uint32_t reserved;
+};
+
+/// @brief Timestamp file signature.
+const char tsTimestampsMagic[8] = { 'T', 'S', 'T', 'I', 'M', 'E', 'S', 0 };
+
+/// @brief Current version of timestamp file format.
+const uint32_t tsTimestampsVersion = 1;
+
+/// @struct TsTimestampsHeader.
+/// @brief Header of timestamp file of one output ES, records follow it till the end of file.
+struct TsTimestampsHeader
+{
+    /// @brief Signature, equals to tsTimestampsMagic.
+    char magic[8];
+
+    /// @brief Version of timestamp file format.
+    uint32_t version;
+
+    /// @brief Size of one record.
+    uint32_t recordSize;
+};
+
+/// @struct TsTimestampsRecord.
+/// @brief Timestamps of one PES packet with PTS.
+struct TsTimestampsRecord
+{
+    /// @brief Offset of PES packet data within output ES.
+    uint64_t esOffset;
+
+    /// @brief PTS of PES packet.
+    int64_t pts;
+
+    /// @brief DTS of PES packet, equals to PTS if absent.
+    int64_t dts;
+};
+
+/// @brief Frame file signature.
+const char tsFramesMagic[8] = { 'T', 'S', 'F', 'R', 'A', 'M', 'E', 0 };
+
+/// @brief Current version of frame file format.
+const uint32_t tsFramesVersion = 1;
+
+/// @brief Flags of access unit.
+enum TsFramesFlags : uint32_t
+{
+    FRAME_KEYFRAME = 1,
+    FRAME_PARAMETER_SETS = 2,
+};
+
+/// @struct TsFramesHeader.
+/// @brief Header of frame file of one output ES, records follow it till the end of file.
+struct TsFramesHeader
+{
+    /// @brief Signature, equals to tsFramesMagic.
+    char magic[8];
+
+    /// @brief Version of frame file format.
+    uint32_t version;
+
+    /// @brief Size of one record.
+    uint32_t recordSize;
+};
+
+/// @struct TsFramesRecord.
+/// @brief One access unit of output ES.
+struct TsFramesRecord
+{
+    /// @brief Offset of access unit within output ES.
+    uint64_t esOffset;
+
+    /// @brief Size of access unit.
+    uint64_t size;
+
+    /// @brief PTS of PES packet the access unit starts in, -1 if absent or used by previous access unit.
+    int64_t pts;
+
+    /// @brief Combination of TsFramesFlags: keyframe (IDR, IRAP, every ADTS frame), has parameter sets.
+    uint32_t flags;
+
+    /// @brief Reserved, set to 0.
+    uint32_t reserved;
+};
+
+static_assert(sizeof(TsIndexHeader) == 32, "Wrong size of TsIndexHeader");
+static_assert(sizeof(TsIndexStream) == 24, "Wrong size of TsIndexStream");
+static_assert(sizeof(TsIndexTable) == 16, "Wrong size of TsIndexTable");
+static_assert(sizeof(TsIndexEntry) == 32, "Wrong size of TsIndexEntry");
+static_assert(sizeof(TsTimestampsHeader) == 16, "Wrong size of TsTimestampsHeader");
+static_assert(sizeof(TsTimestampsRecord) == 24, "Wrong size of TsTimestampsRecord");
+static_assert(sizeof(TsFramesHeader) == 16, "Wrong size of TsFramesHeader");
+static_assert(sizeof(TsFramesRecord) == 32, "Wrong size of TsFramesRecord");
@@ -1,6 +1,13 @@
 #include "error.hpp"
+#include "latency_histogram.hpp"
+#include "perf_counters.hpp"
+#include "pid_filter.hpp"
+#include "timestamp.hpp"
+#include "tracing.hpp"
+#include "ts_headers.hpp"
 #include "ts_reader.hpp"
 
+#include <algorithm>
 #include <cstring>
 
 
@@ -10,6 +17,9 @@ namespace
     const uint8_t tsSyncByte = 0x47;
     const uint16_t nullPacketPid = 8191;
 
+    /// @brief Number of packets read from input at once.
+    const size_t packetsPerBlock = 1024;
+
     /// @brief Parsed TS packet.
     struct TsPacket
     {
@@ -19,146 +29,332 @@ namespace
         bool isCorrupted;
         bool newEsPacket;
         bool hasPayload;
+        bool randomAccess;
+        int64_t pcr;
 
-        TsPacket(const std::vector<uint8_t>& data)
+        TsPacket(const uint8_t* data, const TsHeaders& headers, size_t index)
         {
-            isCorrupted = data[1] & 0x80;
-            newEsPacket = data[1] & 0x40;
-            pid = ((data[1] & 0x1F) << 8) + data[2];
-            hasPayload = data[3] & 0x10;
-            seqNumber = data[3] & 0x0F;
-
-            // check for adaptation field
-            if (!(data[3] & 0x20))
-                payloadOffset = 4;
-            else
-                payloadOffset = 5 + data[4];
+            const uint8_t flags = headers.flags[index];
+            isCorrupted = flags & TsHeaders::transportError;
+            newEsPacket = flags & TsHeaders::payloadStart;
+            pid = headers.pids[index];
+            hasPayload = flags & TsHeaders::payload;
+            seqNumber = headers.seqNumbers[index];
+            payloadOffset = headers.payloadOffsets[index];
+
+            // adaptation field length and flags are zero if there is no adaptation field
+            const uint8_t adaptationLength = (flags & TsHeaders::adaptationField) ? data[4] : 0;
+            const uint8_t adaptationFlags = adaptationLength ? data[5] : 0;
+            randomAccess = adaptationFlags & 0x40;
+            pcr = (adaptationFlags & 0x10) && adaptationLength >= 7 ? readPcr(data + 6) : noTimestamp;
         }
     };
 
 }
 
 TsReader::TsReader(std::istream& input, std::ostream& log, OnPayload handler)
-    : input_(input)
+    : input_(&input)
     , log_(log)
     , handler_(handler)
-    , buffer_(tsPacketSize, 0)
+    , buffer_(tsPacketSize * packetsPerBlock, 0)
+    , pids_(nullPacketPid + 1)
 {
-    if (!input_.good())
+    if (!input_->good())
         throw Error(Error::CONSTRUCTION_ERROR, "TsReader, bad input");
     if (!log_.good())
         throw Error(Error::CONSTRUCTION_ERROR, "TsReader, bad log output");
     if (!handler_)
         throw Error(Error::CONSTRUCTION_ERROR, "TsReader, empty handler");
+
+    // offsets of packets are counted from the beginning of the input, not from the current position
+    const std::streamoff position = input_->tellg();
+    if (position > 0)
+        position_ = static_cast<uint64_t>(position);
 }
 
-void TsReader::readAll()
+TsReader::TsReader(std::ostream& log, OnPayload handler)
+    : input_(nullptr)
+    , log_(log)
+    , handler_(handler)
+    , pids_(nullPacketPid + 1)
 {
-    while (!input_.eof())
-    {
-        if (readPacket())
-            processPacket();
-    }
+    if (!log_.good())
+        throw Error(Error::CONSTRUCTION_ERROR, "TsReader, bad log output");
+    if (!handler_)
+        throw Error(Error::CONSTRUCTION_ERROR, "TsReader, empty handler");
 }
 
-bool TsReader::readPacket()
+void TsReader::setEndOfInputHandler(OnEndOfInput handler)
 {
-    // read data
-    if (!readFromStream(0, tsPacketSize))
-        return false;
+    endOfInputHandler_ = handler;
+}
+
+void TsReader::setBlockHandler(OnBlock handler)
+{
+    blockHandler_ = handler;
+}
+
+void TsReader::setPacketHandler(OnPacket handler)
+{
+    packetHandler_ = handler;
+}
+
+void TsReader::setPidFilter(const PidFilter* filter)
+{
+    pidFilter_ = filter;
+}
+
+void TsReader::setValidation(Validation validation)
+{
+    validation_ = validation;
+}
+
+void TsReader::setPerfCounters(PerfCounters* counters)
+{
+    perfCounters_ = counters;
+}
+
+void TsReader::readAll()
+{
+    if (!input_)
+        throw Error(Error::CORRUPTED_INPUT, "TsReader, no input to read");
+
+    // number of buffered but not yet processed bytes
+    size_t size = 0;
 
-    // check sync byte
     while (true)
     {
-        // buffer starts with sync byte and either next unread char is also sync byte
-        // or EOF reached - most probably we got a valid packet in buffer
-        if (buffer_[0] == tsSyncByte && (input_.peek() == tsSyncByte || input_.eof()))
-            return true;
+        {
+            TRACE_SPAN("read block");
+            if (perfCounters_)
+                perfCounters_->enter(PerfStage::READ);
+            input_->read(reinterpret_cast<char*>(buffer_.data() + size), buffer_.size() - size);
+            readTime_ = LatencyHistogram::now();
+            if (perfCounters_)
+                perfCounters_->enter(PerfStage::SPLIT);
+        }
 
-        // otherwise search for sync byte
-        size_t offset = 1;
-        while (offset < tsPacketSize && buffer_[offset] != tsSyncByte)
-            ++offset;
+        const size_t read = input_->gcount();
+        if (!input_->good() && !input_->eof())
+            throw Error(Error::CORRUPTED_INPUT, "TsReader, failed to read");
 
-        if (offset == tsPacketSize)
-        {
-            // no sync byte, that's corrupted packet, move to the next one
-            log_ << "Warning: TsReader, corrupted TS packet" << std::endl;
+        bytes_ += read;
+        size += read;
+
+        const bool eof = input_->eof();
+        const size_t processed = processBlock(buffer_.data(), size, eof, position_ + bytes_ - size);
+        size -= processed;
+
+        if (stopped_)
             break;
+        if (blockHandler_)
+            blockHandler_();
+
+        // input may grow, incomplete packet at the end is kept till more data arrives
+        if (eof && endOfInputHandler_ && endOfInputHandler_())
+        {
+            input_->clear();
+            std::memmove(buffer_.data(), buffer_.data() + processed, size);
+            continue;
         }
-        else
+
+        if (eof)
         {
-            // sync byte found, align it with buffer
-            std::memmove(&buffer_[0], &buffer_[offset], tsPacketSize - offset);
-            if (!readFromStream(tsPacketSize - offset, offset))
-                return false;
+            // tail of the stream is too short to be a packet
+            if (size)
+            {
+                log_ << "Warning: TsReader, corrupted TS packet" << std::endl;
+                ++corruptedPackets_;
+            }
+            break;
         }
+
+        // keep unprocessed tail for the next block
+        std::memmove(buffer_.data(), buffer_.data() + processed, size);
     }
+}
 
-    return false;
+void TsReader::push(const uint8_t* data, size_t size)
+{
+    if (stopped_)
+        return;
+
+    bytes_ += size;
+    readTime_ = LatencyHistogram::now();
+
+    // usually blocks are aligned with packets, so process them in place
+    if (pending_.empty())
+    {
+        const size_t processed = processBlock(data, size, true, position_ + bytes_ - size);
+        pending_.assign(data + processed, data + size);
+        return;
+    }
+
+    pending_.insert(pending_.end(), data, data + size);
+    const size_t processed = processBlock(pending_.data(), pending_.size(), true, position_ + bytes_ - pending_.size());
+    pending_.erase(pending_.begin(), pending_.begin() + processed);
 }
 
-bool TsReader::readFromStream(size_t bufferOffset, size_t size)
+void TsReader::stop()
 {
-    input_.read(reinterpret_cast<char*>(buffer_.data() + bufferOffset), size);
+    stopped_ = true;
+}
 
-    const size_t read = input_.gcount();
-    if (read != size)
+TsReader::Statistics TsReader::statistics() const
+{
+    Statistics result;
+    result.bytes = bytes_;
+    result.packets = packets_;
+    result.corruptedPackets = corruptedPackets_;
+    result.filteredPackets = filteredPackets_;
+    result.continuityErrors = continuityErrors_;
+    for (uint16_t pid = 0; pid <= nullPacketPid; ++pid)
     {
-        if (read)
-            log_ << "Warning: TsReader, corrupted TS packet" << std::endl;
-        if (!input_.eof())
-            throw Error(Error::CORRUPTED_INPUT, "TsReader, failed to read");
-        return false;
+        if (pids_[pid].statistics.packets)
+            result.pids[pid] = pids_[pid].statistics;
     }
-    return true;
+    return result;
 }
 
-void TsReader::processPacket()
+size_t TsReader::processBlock(const uint8_t* data, size_t size, bool atEnd, uint64_t position)
 {
-    TsPacket pkt(buffer_);
+    TRACE_SPAN("process block");
+
+    // policy is chosen once per block, so checks are resolved at compile time for every packet
+    switch (validation_)
+    {
+    case Validation::TRUSTED:
+        return processPackets<TrustedValidation>(data, size, atEnd, position);
+    case Validation::PARANOID:
+        return processPackets<ParanoidValidation>(data, size, atEnd, position);
+    default:
+        return processPackets<DefaultValidation>(data, size, atEnd, position);
+    }
+}
+
+template <typename Policy>
+size_t TsReader::processPackets(const uint8_t* data, size_t size, bool atEnd, uint64_t position)
+{
+    TsHeaders headers;
+    size_t offset = 0;
+    while (size - offset >= tsPacketSize && !stopped_)
+    {
+        const uint8_t* packet = data + offset;
+
+        // headers of following packets with sync bytes are decoded at once
+        const size_t decoded = decodeTsHeaders(packet, std::min((size - offset) / tsPacketSize, TsHeaders::capacity), headers);
+
+        // packet starts with sync byte and either next packet also starts with sync byte
+        // or end of data reached - most probably we got a valid packet
+        const size_t next = offset + decoded * tsPacketSize;
+        size_t valid = decoded ? decoded - 1 : 0;
+        if (decoded && (next == size ? atEnd : data[next] == tsSyncByte))
+            valid = decoded;
+
+        for (size_t i = 0; i < valid && !stopped_; ++i)
+        {
+            processPacket<Policy>(packet, headers, i, position + offset);
+            packet += tsPacketSize;
+            offset += tsPacketSize;
+        }
+        if (valid)
+            continue;
+
+        // need one more byte to check the next sync byte
+        if (decoded && next == size)
+            break;
+
+        // otherwise search for sync byte
+        size_t shift = 1;
+        while (shift < tsPacketSize && packet[shift] != tsSyncByte)
+            ++shift;
+
+        if (shift == tsPacketSize)
+        {
+            // no sync byte, that's corrupted packet, move to the next one
+            if (Policy::logging)
+                log_ << "Warning: TsReader, corrupted TS packet" << std::endl;
+            ++corruptedPackets_;
+        }
+
+        // sync byte found, align packet with it
+        offset += shift;
+    }
+
+    return offset;
+}
+
+template <typename Policy>
+void TsReader::processPacket(const uint8_t* packet, const TsHeaders& headers, size_t index, uint64_t position)
+{
+    TsPacket pkt(packet, headers, index);
 
     // check for corrupted packet
-    if (pkt.isCorrupted)
+    if (pkt.isCorrupted || pkt.payloadOffset > tsPacketSize)
     {
-        log_ << "Warning: TsReader, corrupted TS packet" << std::endl;
+        if (Policy::logging)
+            log_ << "Warning: TsReader, corrupted TS packet" << std::endl;
+        ++corruptedPackets_;
         return;
     }
 
-    // check for payload
-    if (!pkt.hasPayload)
+    ++packets_;
+
+    // dropped PIDs are not even tracked
+    if (pidFilter_ && !pidFilter_->passes(pkt.pid))
+    {
+        ++filteredPackets_;
         return;
+    }
+
+    auto& state = pids_[pkt.pid];
+    ++state.statistics.packets;
+    state.statistics.pcrs += pkt.pcr != noTimestamp;
 
     // skip null packets
     if (pkt.pid == nullPacketPid)
         return;
 
-    // check corresponding elementary stream started
-    if (!checkEsStarted(pkt.pid, pkt.newEsPacket, pkt.seqNumber))
-        return;
+    // handle TS payload, if corresponding elementary stream started
+    bool discontinuity = false;
+    if (pkt.hasPayload && checkEsStarted<Policy>(state, pkt.pid, pkt.newEsPacket, pkt.seqNumber, discontinuity))
+    {
+        TsPayload& payload = payload_;
+        payload.pid = pkt.pid;
+        payload.data = packet + pkt.payloadOffset;
+        payload.size = tsPacketSize - pkt.payloadOffset;
+        payload.newEsPacket = pkt.newEsPacket;
+        payload.offset = position;
+        payload.pcr = pkt.pcr;
+        payload.randomAccess = pkt.randomAccess;
+        payload.discontinuity = discontinuity;
+        payload.readTime = readTime_;
 
-    // handle TS payload
-    static TsPayload payload;
-    payload.pid = pkt.pid;
-    payload.data = &buffer_[pkt.payloadOffset];
-    payload.size = tsPacketSize - pkt.payloadOffset;
-    payload.newEsPacket = pkt.newEsPacket;
+        // skip zero-length payloads
+        if (payload.size)
+            handler_(payload);
+    }
 
-    // skip zero-length payloads
-    if (payload.size)
-        handler_(payload);
+    // whole packet is handled after its payload, so tables it carries are already parsed
+    if (packetHandler_ && !stopped_)
+        packetHandler_(packet, pkt.pid, position);
 }
 
-bool TsReader::checkEsStarted(uint16_t pid, bool newEsPacket, uint16_t seq)
+template <typename Policy>
+bool TsReader::checkEsStarted(PidState& state, uint16_t pid, bool newEsPacket, uint16_t seq, bool& discontinuity)
 {
-    auto it = streams_.find(pid);
-
     // stream already started
-    if (it != streams_.end())
+    if (state.started)
     {
-        if ((it->second + 1) % 0x10 != seq)
-            log_ << "Warning: TsReader, packet sequence within PID " << pid << " is broken" << std::endl;
-        it->second = seq;
+        if (Policy::continuity && (state.seqNumber + 1) % 0x10 != seq)
+        {
+            if (Policy::logging)
+                log_ << "Warning: TsReader, packet sequence within PID " << pid << " is broken" << std::endl;
+            ++state.statistics.continuityErrors;
+            ++continuityErrors_;
+            discontinuity = true;
+        }
+        state.seqNumber = seq;
         return true;
     }
 
@@ -167,6 +363,7 @@ bool TsReader::checkEsStarted(uint16_t pid, bool newEsPacket, uint16_t seq)
         return false;
 
     // start stream
-    streams_[pid] = seq;
+    state.started = true;
+    state.seqNumber = seq;
     return true;
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "message_types.hpp"
+#include "validation.hpp"
 
 #include <functional>
 #include <iostream>
@@ -8,6 +9,10 @@
 #include <vector>
 
 
+class PerfCounters;
+class PidFilter;
+struct TsHeaders;
+
 /// @class TsReader.
 /// @brief Reads payload from input TS stream.
 class TsReader
@@ -16,6 +21,50 @@ public:
     /// @brief Type of payload handler.
     using OnPayload = std::function<void(const TsPayload&)>;
 
+    /// @brief Type of whole packet handler, gets packet start, its PID and offset within input.
+    using OnPacket = std::function<void(const uint8_t*, uint16_t, uint64_t)>;
+
+    /// @brief Type of end of input handler, returns true if input may have more data after waiting.
+    using OnEndOfInput = std::function<bool()>;
+
+    /// @brief Type of block handler.
+    using OnBlock = std::function<void()>;
+
+    /// @brief Statistics of one PID.
+    struct PidStatistics
+    {
+        /// @brief Number of valid TS packets.
+        uint64_t packets = 0;
+
+        /// @brief Number of broken packet sequences.
+        uint64_t continuityErrors = 0;
+
+        /// @brief Number of packets with PCR.
+        uint64_t pcrs = 0;
+    };
+
+    /// @brief Statistics of read TS stream.
+    struct Statistics
+    {
+        /// @brief Number of bytes read from input.
+        uint64_t bytes = 0;
+
+        /// @brief Number of valid TS packets.
+        uint64_t packets = 0;
+
+        /// @brief Number of corrupted or unsynchronized TS packets.
+        uint64_t corruptedPackets = 0;
+
+        /// @brief Number of valid TS packets dropped by PID filter.
+        uint64_t filteredPackets = 0;
+
+        /// @brief Number of broken packet sequences in all PIDs.
+        uint64_t continuityErrors = 0;
+
+        /// @brief Statistics of every detected and not filtered PID.
+        std::map<uint16_t, PidStatistics> pids;
+    };
+
     /// @brief Constructor.
     /// @param[in] input - TS input.
     /// @param[out] log - Stream for log messages.
@@ -23,37 +72,114 @@ public:
     /// @throws Error.
     TsReader(std::istream& input, std::ostream& log, OnPayload handler);
 
+    /// @brief Constructor for reader without input, all data is pushed by caller.
+    /// @param[out] log - Stream for log messages.
+    /// @param[in] handler - Paylod handler.
+    /// @throws Error.
+    TsReader(std::ostream& log, OnPayload handler);
+
+    /// @brief Set handler called when input ends.
+    /// @details If handler returns true, reading continues after the end of input, so growing input
+    ///          is followed. All PID states and incomplete packet are kept.
+    /// @param[in] handler - End of input handler.
+    void setEndOfInputHandler(OnEndOfInput handler);
+
+    /// @brief Set handler called after every block of input is read and processed by readAll().
+    /// @param[in] handler - Block handler.
+    void setBlockHandler(OnBlock handler);
+
+    /// @brief Set filter of PIDs to read.
+    /// @details Packets of dropped PIDs are counted only, they are not checked for continuity
+    ///          and produce no payloads.
+    /// @param[in] filter - PID filter, must outlive reader, nullptr to read all PIDs.
+    void setPidFilter(const PidFilter* filter);
+
+    /// @brief Set handler called for every valid TS packet passed by PID filter, except null packets.
+    /// @details Handler is called after payload of the packet is handled.
+    /// @param[in] handler - Packet handler.
+    void setPacketHandler(OnPacket handler);
+
+    /// @brief Set level of input validation.
+    /// @details Trusted input is not checked for continuity and its corrupted packets are not logged,
+    ///          though they are still dropped and counted.
+    /// @param[in] validation - Level of validation, Validation::DEFAULT if not set.
+    void setValidation(Validation validation);
+
+    /// @brief Set performance counters, reading of input blocks is counted as PerfStage::READ
+    ///        and their processing as PerfStage::SPLIT.
+    /// @param[in] counters - Performance counters, must outlive reader, nullptr not to count.
+    void setPerfCounters(PerfCounters* counters);
+
     /// @brief Read all available TS packets and produce payloads.
     /// @throws Error.
     void readAll();
 
+    /// @brief Process block of TS data.
+    /// @details Packet ending exactly at the end of block is treated as valid,
+    ///          incomplete packet at the end is kept till the next block.
+    ///          Calls handler, which may throws exceptions.
+    /// @param[in] data - Start of the block.
+    /// @param[in] size - Size of the block.
+    void push(const uint8_t* data, size_t size);
+
+    /// @brief Stop reading, no more payloads are produced after the current one.
+    void stop();
+
+    /// @brief Get statistics of already read data.
+    Statistics statistics() const;
+
 private:
-    /// @brief Read packet from TS stream.
+    /// @brief State of every detected PID.
+    struct PidState
+    {
+        /// @brief Set if elementary stream is started.
+        bool started = false;
+
+        /// @brief Sequence number of the last packet.
+        uint16_t seqNumber = 0;
+
+        /// @brief PID statistics.
+        PidStatistics statistics;
+    };
+
+    /// @brief Process packets from memory block.
     /// @details Calls handler, which may throws exceptions.
-    /// @returns true if valid packet is read, false otherwise.
-    /// @throws Error if input stream is corrupted.
-    bool readPacket();
+    /// @param[in] data - Start of the block.
+    /// @param[in] size - Size of the block.
+    /// @param[in] atEnd - If set, packet ending exactly at the end of block is treated as valid.
+    /// @param[in] position - Offset of the block within input.
+    /// @returns Number of processed bytes, the rest is too short to contain verifiable packet.
+    size_t processBlock(const uint8_t* data, size_t size, bool atEnd, uint64_t position);
 
-    /// @brief Read data from input stream into buffer.
-    /// @param[in] bufferOffset - Offset within buffer to store data.
-    /// @param[in] size - Size of data to read.
-    /// @throws Error if input stream is corrupted.
-    bool readFromStream(size_t bufferOffset, size_t size);
+    /// @brief Process packets from memory block with given validation policy.
+    /// @details Same as processBlock(), Policy is one of TrustedValidation, DefaultValidation or ParanoidValidation.
+    template <typename Policy>
+    size_t processPackets(const uint8_t* data, size_t size, bool atEnd, uint64_t position);
 
     /// @brief Process successfully read packet.
     /// @details Calls handler, which may throws exceptions.
-    void processPacket();
+    /// @tparam Policy - Validation policy.
+    /// @param[in] packet - Start of TS packet.
+    /// @param[in] headers - Decoded headers of block of packets.
+    /// @param[in] index - Index of the packet within headers.
+    /// @param[in] position - Offset of the packet within input.
+    template <typename Policy>
+    void processPacket(const uint8_t* packet, const TsHeaders& headers, size_t index, uint64_t position);
 
     /// @brief Check if elementary stream is started, i.e. can be decoded.
+    /// @tparam Policy - Validation policy, continuity is checked only if Policy::continuity is set.
+    /// @param[in,out] state - State of current packet's PID.
     /// @param[in] pid - PID of current packet.
     /// @param[in] newEsPacket - Flag, set if current packet starts new ES packet.
     /// @param[in] seq - Sequence number of current packet.
+    /// @param[out] discontinuity - Set if packets were lost before current one, not changed otherwise.
     /// @returns true if corresponding elementary stream is started, false otherwise.
-    bool checkEsStarted(uint16_t pid, bool newEsPacket, uint16_t seq);
+    template <typename Policy>
+    bool checkEsStarted(PidState& state, uint16_t pid, bool newEsPacket, uint16_t seq, bool& discontinuity);
 
 private:
-    /// @brief TS input stream.
-    std::istream& input_;
+    /// @brief TS input stream, null if data is pushed.
+    std::istream* input_;
 
     /// @brief Log output stream.
     std::ostream& log_;
@@ -61,9 +187,57 @@ private:
     /// @brief Payload handler.
     OnPayload handler_;
 
-    /// @brief Buffer for storing packets.
+    /// @brief Packet handler, may be empty.
+    OnPacket packetHandler_;
+
+    /// @brief End of input handler, may be empty.
+    OnEndOfInput endOfInputHandler_;
+
+    /// @brief Block handler, may be empty.
+    OnBlock blockHandler_;
+
+    /// @brief PID filter, may be null.
+    const PidFilter* pidFilter_ = nullptr;
+
+    /// @brief Level of input validation.
+    Validation validation_ = Validation::DEFAULT;
+
+    /// @brief Performance counters, may be null.
+    PerfCounters* perfCounters_ = nullptr;
+
+    /// @brief Time the last block is read or pushed at.
+    uint64_t readTime_ = 0;
+
+    /// @brief Payload passed to handler, reused for every packet.
+    TsPayload payload_;
+
+    /// @brief Buffer for storing blocks of packets.
     std::vector<uint8_t> buffer_;
 
-    /// @brief Set of started elementary streams as pair (PID, seq.number).
-    std::map<uint16_t, uint16_t> streams_;
+    /// @brief Incomplete packet left from the previous pushed block.
+    std::vector<uint8_t> pending_;
+
+    /// @brief State of every PID indexed by PID, PIDs without packets are not detected.
+    std::vector<PidState> pids_;
+
+    /// @brief Offset of input position the reader started from.
+    uint64_t position_ = 0;
+
+    /// @brief Set if reading is stopped.
+    bool stopped_ = false;
+
+    /// @brief Number of bytes read from input.
+    uint64_t bytes_ = 0;
+
+    /// @brief Number of valid TS packets.
+    uint64_t packets_ = 0;
+
+    /// @brief Number of corrupted or unsynchronized TS packets.
+    uint64_t corruptedPackets_ = 0;
+
+    /// @brief Number of valid TS packets dropped by PID filter.
+    uint64_t filteredPackets_ = 0;
+
+    /// @brief Number of broken packet sequences in all PIDs.
+    uint64_t continuityErrors_ = 0;
 };
@@ -1,11 +1,20 @@
+#include "cpu_features.hpp"
 #include "error.hpp"
+#include "file_watcher.hpp"
 #include "output_name_generator.hpp"
-#include "output_writer.hpp"
 #include "payload_parser.hpp"
+#include "perf_counters.hpp"
+#include "pts_seeker.hpp"
+#include "split_pipeline.hpp"
+#include "stream_probe.hpp"
+#include "timestamp.hpp"
 #include "ts_reader.hpp"
 #include "ts_splitter.hpp"
+#include "udp_receiver.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
 
 #ifdef _WIN32
 #include <fcntl.h>
@@ -13,6 +22,29 @@
 #endif // _WIN32
 
 
+namespace
+{
+    /// @brief Input is searched for the time this far before range start, as PES packets of
+    ///        different ES are not muxed in strict PTS order.
+    const int64_t seekMargin = 5 * ptsFrequency;
+
+    /// @brief Maximum size of input head read to get PSI tables before seeking.
+    const uint64_t maxHeadSize = 188 * 1024 * 64;
+
+    /// @brief Size of block read from input head.
+    const size_t headBlockSize = 188 * 1024;
+
+    /// @brief UDP input ends if no datagrams arrive for this time in milliseconds.
+    const int udpIdleTimeout = 5000;
+
+    /// @brief Interval in milliseconds to check output deadlines at while no datagrams arrive,
+    ///        outputs are flushed after this time without datagrams.
+    const int udpTickInterval = 100;
+
+    /// @brief Followed input is complete if nothing is appended to it for this time in milliseconds.
+    const int followIdleTimeout = 10000;
+}
+
 void TsSplitter::init(int argc, char** argv)
 {
     programOptions_.reset(new ProgramOptions(argv[0]));
@@ -35,10 +67,19 @@ bool TsSplitter::run()
         return false;
     }
 
+    if (programOptions_->cpuFeaturesRequested())
+    {
+        reportCpuFeatures(std::cout);
+        return true;
+    }
+
     try
     {
         openInput();
-        splitInput();
+        if (programOptions_->probeRequested())
+            probeInput();
+        else
+            splitInput();
     }
     catch (const std::exception& e)
     {
@@ -53,6 +94,14 @@ void TsSplitter::openInput()
 {
     const auto& fileName = programOptions_->inputName();
 
+    // UDP socket is opened when reading starts
+    if (UdpReceiver::isUrl(fileName))
+    {
+        if (programOptions_->followRequested())
+            throw Error(Error::WRONG_OPTION_ARGUMENT, "TsSplitter, UDP input can't be followed");
+        return;
+    }
+
     // read from std::cin
     if (fileName.empty())
     {
@@ -70,16 +119,147 @@ void TsSplitter::openInput()
 
 void TsSplitter::splitInput()
 {
-    OutputNameGenerator audioNameGenerator(programOptions_->audioOutputName());
-    OutputNameGenerator videoNameGenerator(programOptions_->videoOutputName());
+    using namespace std::placeholders;
+
+    // packets are copied by TS outputs from input file by offsets, if it's a regular file
+    const bool isFile = input_ && !UdpReceiver::isUrl(programOptions_->inputName());
+    const std::string inputFile = isFile ? programOptions_->inputName() : std::string();
+
+    // every job consumes payloads of one reader
+    SplitPipeline pipeline(std::clog, *programOptions_, inputFile);
+
+    // watching starts before reading, so nothing appended meanwhile is missed
+    std::unique_ptr<FileWatcher> watcher;
+    if (programOptions_->followRequested())
+        watcher.reset(new FileWatcher(std::clog, programOptions_->inputName(), followIdleTimeout));
+
+    // counters of the splitting thread, seeking is counted as reading
+    std::unique_ptr<PerfCounters> perfCounters;
+    if (programOptions_->perfReportRequested())
+    {
+        perfCounters.reset(new PerfCounters());
+        perfCounters->enter(PerfStage::READ);
+    }
+
+    // input is searched for range start of the only job
+    SplitJob* singleJob = pipeline.singleJob();
+    if (input_ && singleJob && programOptions_->startTime().isSet)
+        seekInput(singleJob->parser(), singleJob->rangeFilter());
+
+    // reading stops as soon as all ES of all jobs pass the end of time range
+    TsReader::Statistics statistics;
+    if (UdpReceiver::isUrl(programOptions_->inputName()))
+    {
+        // datagrams are processed in place, TS packets never cross their boundaries
+        std::unique_ptr<UdpReceiver> receiver;
+        TsReader reader(std::clog, pipeline.payloadHandler([&receiver]() { receiver->stop(); }));
+        pipeline.configure(reader);
+        if (perfCounters)
+            perfCounters->enter(PerfStage::SPLIT);
+        receiver.reset(new UdpReceiver(std::clog, programOptions_->inputName(), udpIdleTimeout,
+                                       std::bind(&TsReader::push, std::ref(reader), _1, _2)));
+
+        // outputs are flushed when datagrams pause, so they are up to date while waiting for input
+        const size_t flushInterval = programOptions_->flushInterval();
+        const int tickInterval = flushInterval ? static_cast<int>(std::min<size_t>(flushInterval, udpTickInterval))
+                                               : udpTickInterval;
+        receiver->setTickHandler(tickInterval, [&pipeline](bool idle)
+        {
+            if (idle)
+                pipeline.flushOutputs();
+            pipeline.checkDeadlines();
+        });
+        receiver->receiveAll();
+        statistics = reader.statistics();
+    }
+    else
+    {
+        TsReader reader(input_ ? *input_ : std::cin, std::clog, pipeline.payloadHandler([&reader]() { reader.stop(); }));
+        pipeline.configure(reader);
+        reader.setPerfCounters(perfCounters.get());
+        reader.setBlockHandler([&pipeline]() { pipeline.checkDeadlines(); });
+
+        // outputs are flushed, so they are up to date while waiting for input to grow
+        if (watcher)
+        {
+            reader.setEndOfInputHandler([&pipeline, &watcher]()
+            {
+                pipeline.flushOutputs();
+                return watcher->wait();
+            });
+        }
+        reader.readAll();
+        statistics = reader.statistics();
+    }
+
+    const bool verified = pipeline.close(statistics, std::cout, perfCounters.get());
+
+    if (perfCounters)
+    {
+        perfCounters->stop();
+        perfCounters->report(std::cout, statistics.bytes, statistics.packets);
+    }
+
+    if (!verified)
+        throw Error(Error::CORRUPTED_OUTPUT, "TsSplitter, some outputs failed verification");
+}
 
+void TsSplitter::seekInput(PayloadParser& parser, TimeRangeFilter& filter)
+{
     using namespace std::placeholders;
 
-    OutputWriter writer(std::clog, audioNameGenerator, videoNameGenerator);
-    PayloadParser parser(std::clog, std::bind(&OutputWriter::write, std::ref(writer), _1));
-    TsReader reader(input_ ? *input_ : std::cin,
-                    std::clog,
-                    std::bind(&PayloadParser::parse, std::ref(parser), _1));
+    PtsSeeker seeker(*input_, std::clog);
+    const int64_t firstPts = seeker.firstPts();
+    if (firstPts == noTimestamp)
+    {
+        std::clog << "Warning: TsSplitter, no PTS found in the head of input, reading it whole" << std::endl;
+        input_->seekg(0, std::ios::beg);
+        return;
+    }
+    filter.setReference(firstPts);
+
+    // no need to search if range starts at the beginning of the input
+    const int64_t target = (filter.startPts() - seekMargin + ptsModulo) % ptsModulo;
+    if (ptsDelta(firstPts, target) <= 0)
+    {
+        input_->seekg(0, std::ios::beg);
+        return;
+    }
+    const uint64_t offset = seeker.find(target);
+
+    // read PSI tables from the head, so ES are detected and numbered as if the input is read whole
+    input_->seekg(0, std::ios::beg);
+    uint64_t headSize = 0;
+    {
+        std::vector<uint8_t> buffer(headBlockSize);
+        TsReader reader(std::clog, std::bind(&PayloadParser::parse, std::ref(parser), _1));
+        while (headSize < offset && headSize < maxHeadSize && !parser.psiComplete())
+        {
+            const size_t size = static_cast<size_t>(std::min<uint64_t>(buffer.size(), offset - headSize));
+            input_->read(reinterpret_cast<char*>(buffer.data()), size);
+            if (input_->gcount() <= 0)
+                break;
+            reader.push(buffer.data(), static_cast<size_t>(input_->gcount()));
+            headSize += input_->gcount();
+        }
+    }
+
+    input_->clear();
+    input_->seekg(static_cast<std::streamoff>(std::max(offset, headSize)), std::ios::beg);
+}
+
+void TsSplitter::probeInput()
+{
+    OutputNameGenerator audioNameGenerator(programOptions_->audioOutputName());
+    OutputNameGenerator videoNameGenerator(programOptions_->videoOutputName());
+
+    if (UdpReceiver::isUrl(programOptions_->inputName()))
+        throw Error(Error::WRONG_OPTION_ARGUMENT, "TsSplitter, probing UDP input is not supported");
 
-    reader.readAll();
+    StreamProbe probe(std::clog);
+    if (programOptions_->quickProbeRequested() && input_)
+        probe.quickProbe(*input_);
+    else
+        probe.probe(input_ ? *input_ : std::cin);
+    probe.report(std::cout, audioNameGenerator, videoNameGenerator);
 }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "payload_parser.hpp"
 #include "program_options.hpp"
+#include "time_range_filter.hpp"
 
 #include <fstream>
 #include <memory>
@@ -29,6 +31,17 @@ private:
     /// @throws Error.
     void splitInput();
 
+    /// @brief Move input position close before the start of time range.
+    /// @details Head of the input is read to get PSI tables, the rest is searched by PTS.
+    /// @param[in] parser - Parser of TS payloads, which gets the head of the input.
+    /// @param[in] filter - Time range filter, which gets the first PTS of the input.
+    /// @throws Error.
+    void seekInput(PayloadParser& parser, TimeRangeFilter& filter);
+
+    /// @brief Print inventory of the input without splitting it.
+    /// @throws Error.
+    void probeInput();
+
 private:
     /// @class Program options parsed from command line.
     std::unique_ptr<ProgramOptions> programOptions_;
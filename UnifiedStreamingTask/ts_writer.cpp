@@ -0,0 +1,393 @@
+#include "crc32.hpp"
+#include "error.hpp"
+#include "ts_writer.hpp"
+
+#include <algorithm>
+#include <list>
+#include <sstream>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // __linux__
+
+
+namespace
+{
+    const size_t tsPacketSize = 188;
+    const uint16_t paTablePid = 0;
+    const uint16_t nullPacketPid = 8191;
+
+    /// @brief Size of batched packets or input range written at once.
+    const size_t batchSize = tsPacketSize * 512;
+}
+
+TsWriter::TsWriter(std::ostream& log,
+                   const OutputNameGenerator& nameGenerator,
+                   bool perProgram,
+                   const std::string& inputFile,
+                   const PidFilter& pidFilter,
+                   const std::map<uint16_t, PayloadParser::StreamInfo>& streams,
+                   const std::map<uint16_t, PayloadParser::ProgramInfo>& programs)
+    : log_(log)
+    , nameGenerator_(nameGenerator)
+    , perProgram_(perProgram)
+    , pidFilter_(pidFilter)
+    , streams_(streams)
+    , programs_(programs)
+    , routes_(nullPacketPid + 1)
+{
+    if (!log_.good())
+        throw Error(Error::CONSTRUCTION_ERROR, "TsWriter, bad log output");
+    if (nameGenerator_.name(0).empty())
+        throw Error(Error::CONSTRUCTION_ERROR, "TsWriter, name generator is uninitialized");
+
+#ifdef __linux__
+    // only regular files can be copied from by offsets
+    if (!inputFile.empty())
+    {
+        struct stat status;
+        const int descriptor = ::open(inputFile.c_str(), O_RDONLY | O_CLOEXEC);
+        if (descriptor >= 0 && ::fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode))
+            inputDescriptor_ = descriptor;
+        else if (descriptor >= 0)
+            ::close(descriptor);
+    }
+#else
+    (void)inputFile;
+#endif // __linux__
+
+    updateRoutes();
+}
+
+TsWriter::~TsWriter()
+{
+    try
+    {
+        closeOutputs();
+    }
+    catch (const Error& err)
+    {
+        log_ << "Error: TsWriter, failed to close output streams, " << err.message() << std::endl;
+    }
+
+#ifdef __linux__
+    if (inputDescriptor_ >= 0)
+        ::close(inputDescriptor_);
+#endif // __linux__
+}
+
+void TsWriter::write(const uint8_t* packet, uint16_t pid, uint64_t offset)
+{
+    // PAT is replaced with regenerated one at the start of every input PAT section
+    if (pid == paTablePid)
+    {
+        if (packet[1] & 0x40)
+        {
+            for (auto& pair : outputs_)
+                writePat(pair.second);
+        }
+        return;
+    }
+
+    for (Output* out : routes_[pid & nullPacketPid])
+    {
+        if (out->started)
+            append(*out, packet, offset);
+    }
+}
+
+void TsWriter::writeTable(const PayloadParser::TableInfo& table)
+{
+    if (table.pid == paTablePid)
+    {
+        transportStreamId_ = table.number;
+        patVersion_ = table.version;
+    }
+    updateRoutes();
+}
+
+void TsWriter::flushOutputs()
+{
+    for (auto& pair : outputs_)
+    {
+        flush(pair.second);
+#ifndef __linux__
+        if (pair.second.stream && !pair.second.stream->flush().good())
+            throw Error(Error::CORRUPTED_OUTPUT, "TsWriter, failed to flush file '" + pair.second.file + "'");
+#endif // __linux__
+    }
+}
+
+void TsWriter::closeOutputs()
+{
+    // to collect names of failed files
+    std::list<std::string> failedFiles;
+    for (auto& pair : outputs_)
+    {
+        auto& out = pair.second;
+        try
+        {
+            flush(out);
+        }
+        catch (const Error&)
+        {
+            failedFiles.push_back(out.file);
+        }
+        if (!closeFile(out))
+        {
+            if (std::find(failedFiles.begin(), failedFiles.end(), out.file) == failedFiles.end())
+                failedFiles.push_back(out.file);
+            continue;
+        }
+        log_ << "Notice: TsWriter, written " << out.packets << " packets into '" << out.file << "'" << std::endl;
+    }
+    outputs_.clear();
+    for (auto& outputs : routes_)
+        outputs.clear();
+
+    if (!failedFiles.empty())
+    {
+        std::ostringstream msg;
+        msg << "TsWriter, failed to close file(s) ";
+
+        auto end = --failedFiles.cend();
+        for (auto it = failedFiles.cbegin(); it != end; ++it)
+            msg << "'" << *it << "',";
+        msg << "'" << *end << "'";
+
+        throw Error(Error::CORRUPTED_OUTPUT, msg.str());
+    }
+}
+
+void TsWriter::updateRoutes()
+{
+    for (auto& outputs : routes_)
+        outputs.clear();
+
+    auto route = [this](uint16_t pid, Output* out)
+    {
+        auto& outputs = routes_[pid & nullPacketPid];
+        if (pid != paTablePid && pid != nullPacketPid && pidFilter_.passes(pid) &&
+            std::find(outputs.begin(), outputs.end(), out) == outputs.end())
+            outputs.push_back(out);
+    };
+
+    // all read PIDs go into one TS
+    if (!perProgram_)
+    {
+        Output* out = &output(0);
+        for (uint16_t pid = 0; pid < nullPacketPid; ++pid)
+            route(pid, out);
+        return;
+    }
+
+    for (const auto& pair : programs_)
+    {
+        // program 0 refers to network information table
+        if (!pair.first || !pidFilter_.passes(pair.second.pmtPid))
+            continue;
+
+        Output* out = &output(pair.first);
+        route(pair.second.pmtPid, out);
+        route(pair.second.pcrPid, out);
+        for (const auto& stream : streams_)
+        {
+            if (stream.second.program == pair.first)
+                route(stream.first, out);
+        }
+    }
+}
+
+TsWriter::Output& TsWriter::output(uint16_t program)
+{
+    auto it = outputs_.find(program);
+    if (it != outputs_.end())
+        return it->second;
+
+    Output& out = outputs_[program];
+    out.program = program;
+    out.file = nameGenerator_.name(program ? program : 1);
+    openFile(out);
+    return out;
+}
+
+void TsWriter::writePat(Output& output)
+{
+    // programs of output, which PMTs are read
+    std::string body;
+    for (const auto& pair : programs_)
+    {
+        if (!pair.first || (output.program && pair.first != output.program) || !pidFilter_.passes(pair.second.pmtPid))
+            continue;
+        body += char(pair.first >> 8);
+        body += char(pair.first & 0xFF);
+        body += char(0xE0 | (pair.second.pmtPid >> 8));
+        body += char(pair.second.pmtPid & 0xFF);
+    }
+
+    // section header is followed by programs and CRC
+    const size_t sectionLength = 5 + body.size() + 4;
+    std::vector<uint8_t> packet(tsPacketSize, 0xFF);
+    packet[0] = 0x47;
+    packet[1] = 0x40;
+    packet[2] = 0x00;
+    packet[3] = static_cast<uint8_t>(0x10 | (output.patCounter++ & 0x0F));
+    packet[4] = 0x00;
+
+    uint8_t* section = packet.data() + 5;
+    section[0] = 0x00;
+    section[1] = static_cast<uint8_t>(0xB0 | (sectionLength >> 8));
+    section[2] = static_cast<uint8_t>(sectionLength & 0xFF);
+    section[3] = static_cast<uint8_t>(transportStreamId_ >> 8);
+    section[4] = static_cast<uint8_t>(transportStreamId_ & 0xFF);
+    section[5] = static_cast<uint8_t>(0xC1 | ((patVersion_ & 0x1F) << 1));
+    section[6] = 0x00;
+    section[7] = 0x00;
+    std::copy(body.begin(), body.end(), section + 8);
+
+    const uint32_t crc = crc32(section, 3 + sectionLength - 4);
+    uint8_t* crcData = section + 3 + sectionLength - 4;
+    crcData[0] = static_cast<uint8_t>(crc >> 24);
+    crcData[1] = static_cast<uint8_t>(crc >> 16);
+    crcData[2] = static_cast<uint8_t>(crc >> 8);
+    crcData[3] = static_cast<uint8_t>(crc);
+
+    output.started = true;
+    append(output, packet.data(), 0);
+}
+
+void TsWriter::append(Output& output, const uint8_t* packet, uint64_t offset)
+{
+    ++output.packets;
+
+    // packets of input file are copied by ranges, generated PATs from memory
+    const uint16_t pid = ((packet[1] & 0x1F) << 8) + packet[2];
+    if (inputDescriptor_ >= 0 && pid != paTablePid)
+    {
+        if (!output.batch.empty())
+            flush(output);
+        if (output.rangeSize && output.rangeOffset + output.rangeSize != offset)
+            flush(output);
+        if (!output.rangeSize)
+            output.rangeOffset = offset;
+        output.rangeSize += tsPacketSize;
+        if (output.rangeSize >= batchSize)
+            flush(output);
+        return;
+    }
+
+    if (output.rangeSize)
+        flush(output);
+    output.batch.insert(output.batch.end(), packet, packet + tsPacketSize);
+    if (output.batch.size() >= batchSize)
+        flush(output);
+}
+
+void TsWriter::flush(Output& output)
+{
+    if (output.rangeSize)
+    {
+        const uint64_t offset = output.rangeOffset;
+        const uint64_t size = output.rangeSize;
+        output.rangeSize = 0;
+        copyRange(output, offset, size);
+    }
+    if (!output.batch.empty())
+    {
+        writeFile(output, output.batch.data(), output.batch.size());
+        output.batch.clear();
+    }
+}
+
+#ifdef __linux__
+
+void TsWriter::openFile(Output& output)
+{
+    output.descriptor = ::open(output.file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (output.descriptor < 0)
+        throw Error(Error::CORRUPTED_OUTPUT, "TsWriter, failed to open file '" + output.file + "' for writing");
+}
+
+void TsWriter::writeFile(Output& output, const uint8_t* data, size_t size)
+{
+    while (size)
+    {
+        const ssize_t written = ::write(output.descriptor, data, size);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            throw Error(Error::CORRUPTED_OUTPUT, "TsWriter, failed to write into file '" + output.file + "': " +
+                                                 std::strerror(errno));
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+void TsWriter::copyRange(Output& output, uint64_t offset, uint64_t size)
+{
+    loff_t inputOffset = static_cast<loff_t>(offset);
+    while (size)
+    {
+        const ssize_t copied = ::copy_file_range(inputDescriptor_, &inputOffset, output.descriptor, nullptr, size, 0);
+        if (copied < 0 && errno == EINTR)
+            continue;
+        if (copied > 0)
+        {
+            size -= static_cast<uint64_t>(copied);
+            continue;
+        }
+
+        // copying between file systems or by old kernels is not supported, so data passes user space
+        std::vector<uint8_t> buffer(static_cast<size_t>(size));
+        const ssize_t read = ::pread(inputDescriptor_, buffer.data(), buffer.size(), inputOffset);
+        if (read != static_cast<ssize_t>(buffer.size()))
+            throw Error(Error::CORRUPTED_OUTPUT, "TsWriter, failed to copy input into file '" + output.file + "'");
+        writeFile(output, buffer.data(), buffer.size());
+        return;
+    }
+}
+
+bool TsWriter::closeFile(Output& output)
+{
+    if (output.descriptor < 0)
+        return true;
+    const bool result = ::close(output.descriptor) == 0;
+    output.descriptor = -1;
+    return result;
+}
+
+#else
+
+void TsWriter::openFile(Output& output)
+{
+    output.stream.reset(new std::ofstream(output.file, std::fstream::out | std::fstream::binary));
+    if (!output.stream->good())
+        throw Error(Error::CORRUPTED_OUTPUT, "TsWriter, failed to open file '" + output.file + "' for writing");
+}
+
+void TsWriter::writeFile(Output& output, const uint8_t* data, size_t size)
+{
+    output.stream->write(reinterpret_cast<const char*>(data), size);
+    if (!output.stream->good())
+        throw Error(Error::CORRUPTED_OUTPUT, "TsWriter, failed to write into file '" + output.file + "'");
+}
+
+void TsWriter::copyRange(Output&, uint64_t, uint64_t)
+{
+}
+
+bool TsWriter::closeFile(Output& output)
+{
+    if (!output.stream)
+        return true;
+    output.stream->close();
+    const bool result = output.stream->good();
+    output.stream.reset();
+    return result;
+}
+
+#endif // __linux__
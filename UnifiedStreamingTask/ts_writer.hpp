@@ -0,0 +1,174 @@
+#pragma once
+
+#include "output_name_generator.hpp"
+#include "payload_parser.hpp"
+#include "pid_filter.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+/// @class TsWriter.
+/// @brief Writes whole TS packets of input into filtered transport streams.
+/// @details Either one TS with all PIDs passed by PID filter is written, or one SPTS per program
+///          with its PMT, PCR PID and ES. PAT of every output is regenerated to list only its
+///          programs, other packets are copied as is. Output starts with its first PAT, null
+///          packets are dropped. Packets are written in batches, if input is a file on Linux,
+///          ranges of consecutive packets are copied from it by copy_file_range() without
+///          passing them through user space.
+class TsWriter
+{
+public:
+    /// @brief Constructor.
+    /// @param[out] log - Stream for log messages.
+    /// @param[in] nameGenerator - Generator of output names, SPTS are named by program numbers.
+    /// @param[in] perProgram - If set, SPTS per program is written, otherwise one TS.
+    /// @param[in] inputFile - Input file name to copy packets from, empty if input is not a file.
+    /// @param[in] pidFilter - Filter of read PIDs.
+    /// @param[in] streams - Detected streams by PID, see PayloadParser::streams().
+    /// @param[in] programs - Detected programs by number, see PayloadParser::programs().
+    /// @throws Error.
+    TsWriter(std::ostream& log,
+             const OutputNameGenerator& nameGenerator,
+             bool perProgram,
+             const std::string& inputFile,
+             const PidFilter& pidFilter,
+             const std::map<uint16_t, PayloadParser::StreamInfo>& streams,
+             const std::map<uint16_t, PayloadParser::ProgramInfo>& programs);
+
+    /// @brief Destructor, closes all outputs.
+    ~TsWriter();
+
+    TsWriter(const TsWriter&) = delete;
+    TsWriter& operator=(const TsWriter&) = delete;
+
+    /// @brief Write TS packet into outputs it belongs to.
+    /// @details Packet should be written after its payload is parsed, so PSI tables it carries
+    ///          are taken into account.
+    /// @param[in] packet - Start of TS packet.
+    /// @param[in] pid - PID of the packet.
+    /// @param[in] offset - Offset of the packet within input.
+    /// @throws Error.
+    void write(const uint8_t* packet, uint16_t pid, uint64_t offset);
+
+    /// @brief Update outputs and their PIDs by new version of PAT or PMT.
+    /// @param[in] table - PSI table information.
+    void writeTable(const PayloadParser::TableInfo& table);
+
+    /// @brief Write all batched packets.
+    /// @throws Error.
+    void flushOutputs();
+
+    /// @brief Write all batched packets and close outputs.
+    /// @throws Error.
+    void closeOutputs();
+
+private:
+    /// @brief Output transport stream.
+    struct Output
+    {
+        /// @brief File name.
+        std::string file;
+
+        /// @brief Program number for SPTS, 0 for TS with all programs.
+        uint16_t program = 0;
+
+        /// @brief Set if output is started with PAT.
+        bool started = false;
+
+        /// @brief Continuity counter of PAT packets.
+        uint8_t patCounter = 0;
+
+        /// @brief Number of written packets.
+        uint64_t packets = 0;
+
+        /// @brief Packets copied from memory and not yet written.
+        std::vector<uint8_t> batch;
+
+        /// @brief Offset of input range not yet copied.
+        uint64_t rangeOffset = 0;
+
+        /// @brief Size of input range not yet copied.
+        uint64_t rangeSize = 0;
+
+        /// @brief File descriptor, -1 if closed.
+        int descriptor = -1;
+
+        /// @brief File stream, if descriptors are not supported.
+        std::unique_ptr<std::ofstream> stream;
+    };
+
+    /// @brief Rebuild PIDs of every output.
+    void updateRoutes();
+
+    /// @brief Get output of program, it's opened if needed.
+    /// @throws Error.
+    Output& output(uint16_t program);
+
+    /// @brief Write regenerated PAT into output.
+    /// @throws Error.
+    void writePat(Output& output);
+
+    /// @brief Add TS packet to output batch or input range.
+    /// @throws Error.
+    void append(Output& output, const uint8_t* packet, uint64_t offset);
+
+    /// @brief Write batched packets and input range of output.
+    /// @throws Error.
+    void flush(Output& output);
+
+    /// @brief Open output file.
+    /// @throws Error.
+    void openFile(Output& output);
+
+    /// @brief Write data into output file.
+    /// @throws Error.
+    void writeFile(Output& output, const uint8_t* data, size_t size);
+
+    /// @brief Copy range of input into output file.
+    /// @throws Error.
+    void copyRange(Output& output, uint64_t offset, uint64_t size);
+
+    /// @brief Close output file.
+    /// @returns true if succeeded, false otherwise.
+    bool closeFile(Output& output);
+
+private:
+    /// @brief Log output stream.
+    std::ostream& log_;
+
+    /// @brief Generator of output names.
+    OutputNameGenerator nameGenerator_;
+
+    /// @brief If set, SPTS per program is written.
+    const bool perProgram_;
+
+    /// @brief Filter of read PIDs.
+    const PidFilter& pidFilter_;
+
+    /// @brief Detected streams.
+    const std::map<uint16_t, PayloadParser::StreamInfo>& streams_;
+
+    /// @brief Detected programs.
+    const std::map<uint16_t, PayloadParser::ProgramInfo>& programs_;
+
+    /// @brief Input file descriptor to copy packets from, -1 if packets are copied from memory.
+    int inputDescriptor_ = -1;
+
+    /// @brief Transport stream id of input PAT.
+    uint16_t transportStreamId_ = 0;
+
+    /// @brief Version of input PAT.
+    uint8_t patVersion_ = 0;
+
+    /// @brief Outputs by program number.
+    std::map<uint16_t, Output> outputs_;
+
+    /// @brief Outputs of every PID.
+    std::vector<std::vector<Output*>> routes_;
+};
@@ -0,0 +1,310 @@
+#include "error.hpp"
+#include "udp_receiver.hpp"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#endif // __linux__
+
+
+namespace
+{
+    const std::string urlPrefix = "udp://";
+
+#ifdef __linux__
+    const uint8_t tsSyncByte = 0x47;
+
+    /// @brief Number of datagrams received by one recvmmsg call.
+    const size_t datagramsPerBatch = 64;
+
+    /// @brief Size of datagram slot, enough for 7 TS packets with RTP header and Ethernet MTU.
+    const size_t datagramSlotSize = 2048;
+
+    /// @brief Size of control message slot, enough for kernel timestamp.
+    const size_t controlSlotSize = CMSG_SPACE(sizeof(timespec));
+
+    /// @brief Requested socket receive buffer size, a second of 60 Mbit/s stream.
+    const int receiveBufferSize = 8 * 1024 * 1024;
+
+    /// @brief Minimal size of RTP header.
+    const size_t rtpHeaderSize = 12;
+
+    /// @brief Parse port number.
+    /// @returns Port number or -1 if string is not a port number.
+    int parsePort(const std::string& str)
+    {
+        if (str.empty() || str.size() > 5 || str.find_first_not_of("0123456789") != std::string::npos)
+            return -1;
+        const int port = std::stoi(str);
+        return port <= 0xFFFF ? port : -1;
+    }
+#endif // __linux__
+}
+
+bool UdpReceiver::isUrl(const std::string& name)
+{
+    return name.compare(0, urlPrefix.size(), urlPrefix) == 0;
+}
+
+#ifdef __linux__
+
+UdpReceiver::UdpReceiver(std::ostream& log, const std::string& url, int idleTimeout, OnDatagram handler)
+    : log_(log)
+    , idleTimeout_(idleTimeout)
+    , handler_(handler)
+    , buffer_(datagramsPerBatch * datagramSlotSize)
+    , control_(datagramsPerBatch * controlSlotSize)
+{
+    if (!log_.good())
+        throw Error(Error::CONSTRUCTION_ERROR, "UdpReceiver, bad log output");
+    if (!handler_)
+        throw Error(Error::CONSTRUCTION_ERROR, "UdpReceiver, empty handler");
+    if (!isUrl(url))
+        throw Error(Error::CONSTRUCTION_ERROR, "UdpReceiver, wrong URL '" + url + "'");
+
+    // udp://[@]address:port, empty address means any interface
+    std::string address = url.substr(urlPrefix.size());
+    if (!address.empty() && address[0] == '@')
+        address.erase(0, 1);
+    const size_t colon = address.rfind(':');
+    const int port = colon != std::string::npos ? parsePort(address.substr(colon + 1)) : -1;
+    if (port < 0)
+        throw Error(Error::CONSTRUCTION_ERROR, "UdpReceiver, wrong port in URL '" + url + "'");
+    address.erase(colon);
+
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(static_cast<uint16_t>(port));
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (!address.empty() && inet_pton(AF_INET, address.c_str(), &local.sin_addr) != 1)
+        throw Error(Error::CONSTRUCTION_ERROR, "UdpReceiver, wrong address in URL '" + url + "'");
+
+    socket_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (socket_ < 0)
+        throw Error(Error::CONSTRUCTION_ERROR, "UdpReceiver, failed to create socket: " + std::string(std::strerror(errno)));
+
+    try
+    {
+        const int on = 1;
+        setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        // forced size ignores system limit but needs privileges, so ordinary one is the fallback
+        if (setsockopt(socket_, SOL_SOCKET, SO_RCVBUFFORCE, &receiveBufferSize, sizeof(receiveBufferSize)) != 0)
+            setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, sizeof(receiveBufferSize));
+        int actualSize = 0;
+        socklen_t length = sizeof(actualSize);
+        // kernel reports doubled size including its bookkeeping
+        if (getsockopt(socket_, SOL_SOCKET, SO_RCVBUF, &actualSize, &length) == 0 && actualSize / 2 < receiveBufferSize)
+        {
+            log_ << "Warning: UdpReceiver, socket receive buffer is limited to " << actualSize / 2
+                 << " bytes, datagrams may be lost, see net.core.rmem_max" << std::endl;
+        }
+
+        if (setsockopt(socket_, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) != 0)
+            log_ << "Warning: UdpReceiver, kernel timestamps are not available" << std::endl;
+
+        if (::bind(socket_, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0)
+            throw Error(Error::CONSTRUCTION_ERROR, "UdpReceiver, failed to bind socket: " + std::string(std::strerror(errno)));
+
+        if (IN_MULTICAST(ntohl(local.sin_addr.s_addr)))
+        {
+            ip_mreq membership{};
+            membership.imr_multiaddr = local.sin_addr;
+            membership.imr_interface.s_addr = htonl(INADDR_ANY);
+            if (setsockopt(socket_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0)
+            {
+                throw Error(Error::CONSTRUCTION_ERROR, "UdpReceiver, failed to join multicast group: " +
+                                                       std::string(std::strerror(errno)));
+            }
+        }
+
+        sockaddr_in bound{};
+        length = sizeof(bound);
+        if (getsockname(socket_, reinterpret_cast<sockaddr*>(&bound), &length) != 0)
+            throw Error(Error::CONSTRUCTION_ERROR, "UdpReceiver, failed to get socket name: " + std::string(std::strerror(errno)));
+        port_ = ntohs(bound.sin_port);
+    }
+    catch (...)
+    {
+        ::close(socket_);
+        throw;
+    }
+}
+
+UdpReceiver::~UdpReceiver()
+{
+    ::close(socket_);
+}
+
+void UdpReceiver::receiveAll()
+{
+    mmsghdr messages[datagramsPerBatch];
+    iovec vectors[datagramsPerBatch];
+
+    // time in milliseconds without datagrams, counted by poll timeouts
+    int idle = 0;
+
+    while (!stopped_)
+    {
+        const int timeout = tickHandler_ ? std::min(tickInterval_, idleTimeout_ - idle) : idleTimeout_;
+        pollfd descriptor{ socket_, POLLIN, 0 };
+        const int ready = ::poll(&descriptor, 1, timeout);
+        if (ready < 0 && errno == EINTR)
+            continue;
+        if (ready < 0)
+            throw Error(Error::CORRUPTED_INPUT, "UdpReceiver, failed to poll socket: " + std::string(std::strerror(errno)));
+        if (ready == 0)
+        {
+            idle += timeout;
+            if (idle < idleTimeout_)
+            {
+                tickHandler_(true);
+                continue;
+            }
+            log_ << "Notice: UdpReceiver, no datagrams for " << idleTimeout_ << " ms, receiving stopped" << std::endl;
+            break;
+        }
+        idle = 0;
+
+        std::memset(messages, 0, sizeof(messages));
+        for (size_t i = 0; i < datagramsPerBatch; ++i)
+        {
+            vectors[i].iov_base = buffer_.data() + i * datagramSlotSize;
+            vectors[i].iov_len = datagramSlotSize;
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_control = control_.data() + i * controlSlotSize;
+            messages[i].msg_hdr.msg_controllen = controlSlotSize;
+        }
+
+        const int received = ::recvmmsg(socket_, messages, datagramsPerBatch, MSG_DONTWAIT, nullptr);
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            continue;
+        if (received < 0)
+            throw Error(Error::CORRUPTED_INPUT, "UdpReceiver, failed to receive datagrams: " + std::string(std::strerror(errno)));
+        ++statistics_.batches;
+
+        for (int i = 0; i < received && !stopped_; ++i)
+        {
+            msghdr& header = messages[i].msg_hdr;
+            for (cmsghdr* control = CMSG_FIRSTHDR(&header); control; control = CMSG_NXTHDR(&header, control))
+            {
+                if (control->cmsg_level != SOL_SOCKET || control->cmsg_type != SCM_TIMESTAMPNS)
+                    continue;
+                timespec arrival;
+                std::memcpy(&arrival, CMSG_DATA(control), sizeof(arrival));
+                statistics_.lastArrival = int64_t(arrival.tv_sec) * 1000000000 + arrival.tv_nsec;
+                if (!statistics_.firstArrival)
+                    statistics_.firstArrival = statistics_.lastArrival;
+            }
+
+            ++statistics_.datagrams;
+            if (header.msg_flags & MSG_TRUNC)
+            {
+                ++statistics_.dropped;
+                continue;
+            }
+            handleDatagram(static_cast<const uint8_t*>(vectors[i].iov_base), messages[i].msg_len);
+        }
+        if (tickHandler_ && !stopped_)
+            tickHandler_(false);
+    }
+
+    log_ << "Notice: UdpReceiver, " << statistics_.datagrams << " datagrams, " << statistics_.bytes << " bytes in "
+         << statistics_.batches << " batches";
+    if (statistics_.rtpDatagrams)
+        log_ << ", " << statistics_.rtpDatagrams << " with RTP header, " << statistics_.rtpLost << " lost";
+    if (statistics_.dropped)
+        log_ << ", " << statistics_.dropped << " dropped";
+    if (statistics_.firstArrival)
+        log_ << ", received during " << (statistics_.lastArrival - statistics_.firstArrival) / 1000000 << " ms";
+    log_ << std::endl;
+}
+
+void UdpReceiver::handleDatagram(const uint8_t* data, size_t size)
+{
+    // RTP version 2 header, TS packet always starts with sync byte
+    if (size >= rtpHeaderSize && data[0] != tsSyncByte && (data[0] & 0xC0) == 0x80)
+    {
+        size_t headerSize = rtpHeaderSize + 4 * (data[0] & 0x0F);
+        if ((data[0] & 0x10) && headerSize + 4 <= size)
+            headerSize += 4 + 4 * ((data[headerSize + 2] << 8) + data[headerSize + 3]);
+        const size_t padding = (data[0] & 0x20) ? data[size - 1] : 0;
+        if (headerSize + padding > size)
+        {
+            ++statistics_.dropped;
+            return;
+        }
+
+        // late datagrams don't move expected sequence number back
+        const uint16_t sequence = (data[2] << 8) + data[3];
+        const uint16_t gap = static_cast<uint16_t>(sequence - rtpSequence_);
+        if (!rtpSequenceKnown_ || gap < 0x8000)
+        {
+            if (rtpSequenceKnown_)
+                statistics_.rtpLost += gap;
+            rtpSequence_ = static_cast<uint16_t>(sequence + 1);
+            rtpSequenceKnown_ = true;
+        }
+        ++statistics_.rtpDatagrams;
+
+        data += headerSize;
+        size -= headerSize + padding;
+    }
+
+    statistics_.bytes += size;
+    handler_(data, size);
+}
+
+#else
+
+UdpReceiver::UdpReceiver(std::ostream& log, const std::string&, int idleTimeout, OnDatagram handler)
+    : log_(log)
+    , idleTimeout_(idleTimeout)
+    , handler_(handler)
+{
+    throw Error(Error::CONSTRUCTION_ERROR, "UdpReceiver, UDP input is supported on Linux only");
+}
+
+UdpReceiver::~UdpReceiver()
+{
+}
+
+void UdpReceiver::receiveAll()
+{
+}
+
+void UdpReceiver::handleDatagram(const uint8_t*, size_t)
+{
+}
+
+#endif // __linux__
+
+void UdpReceiver::setTickHandler(int interval, OnTick handler)
+{
+    tickInterval_ = std::max(1, std::min(interval, idleTimeout_));
+    tickHandler_ = handler;
+}
+
+void UdpReceiver::stop()
+{
+    stopped_ = true;
+}
+
+uint16_t UdpReceiver::port() const
+{
+    return port_;
+}
+
+const UdpReceiver::Statistics& UdpReceiver::statistics() const
+{
+    return statistics_;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+/// @class UdpReceiver.
+/// @brief Receives TS datagrams from UDP socket, unicast or multicast.
+/// @details Datagrams are received in batches by recvmmsg. RTP header is detected by its version
+///          and stripped, so both plain UDP and RTP streams are supported. Receiving ends when no
+///          datagram arrives within idle timeout. Supported on Linux only.
+class UdpReceiver
+{
+public:
+    /// @brief Type of datagram handler, gets TS data of one datagram.
+    using OnDatagram = std::function<void(const uint8_t* data, size_t size)>;
+
+    /// @brief Type of tick handler, gets flag of idle socket.
+    using OnTick = std::function<void(bool idle)>;
+
+    /// @brief Statistics of received datagrams.
+    struct Statistics
+    {
+        /// @brief Number of received datagrams.
+        uint64_t datagrams = 0;
+
+        /// @brief Number of TS bytes passed to handler.
+        uint64_t bytes = 0;
+
+        /// @brief Number of recvmmsg calls returned datagrams.
+        uint64_t batches = 0;
+
+        /// @brief Number of datagrams with RTP header.
+        uint64_t rtpDatagrams = 0;
+
+        /// @brief Number of RTP datagrams lost according to sequence numbers.
+        uint64_t rtpLost = 0;
+
+        /// @brief Number of datagrams truncated or with broken RTP header.
+        uint64_t dropped = 0;
+
+        /// @brief Kernel arrival time of the first datagram in nanoseconds or 0.
+        int64_t firstArrival = 0;
+
+        /// @brief Kernel arrival time of the last datagram in nanoseconds or 0.
+        int64_t lastArrival = 0;
+    };
+
+    /// @brief Check if input name is UDP URL.
+    /// @param[in] name - Input name.
+    static bool isUrl(const std::string& name);
+
+    /// @brief Constructor, opens socket and joins multicast group if needed.
+    /// @param[out] log - Stream for log messages.
+    /// @param[in] url - URL in format udp://[@]address:port, port 0 binds to any free one.
+    /// @param[in] idleTimeout - Time in milliseconds without datagrams to stop receiving after.
+    /// @param[in] handler - Datagram handler.
+    /// @throws Error.
+    UdpReceiver(std::ostream& log, const std::string& url, int idleTimeout, OnDatagram handler);
+
+    /// @brief Destructor, closes socket.
+    ~UdpReceiver();
+
+    UdpReceiver(const UdpReceiver&) = delete;
+    UdpReceiver& operator=(const UdpReceiver&) = delete;
+
+    /// @brief Set handler called after every batch of datagrams, and every interval while no datagrams arrive.
+    /// @param[in] interval - Interval in milliseconds, not longer than idle timeout.
+    /// @param[in] handler - Tick handler.
+    void setTickHandler(int interval, OnTick handler);
+
+    /// @brief Receive datagrams till idle timeout or stop and log statistics.
+    /// @details Calls handler, which may throws exceptions.
+    /// @throws Error.
+    void receiveAll();
+
+    /// @brief Stop receiving, no more datagrams are passed after the current one.
+    void stop();
+
+    /// @brief Get local port of socket.
+    uint16_t port() const;
+
+    /// @brief Get statistics of received datagrams.
+    const Statistics& statistics() const;
+
+private:
+    /// @brief Strip RTP header if any and pass datagram to handler.
+    /// @param[in] data - Start of datagram.
+    /// @param[in] size - Size of datagram.
+    void handleDatagram(const uint8_t* data, size_t size);
+
+private:
+    /// @brief Log output stream.
+    std::ostream& log_;
+
+    /// @brief Time in milliseconds without datagrams to stop receiving after.
+    int idleTimeout_;
+
+    /// @brief Datagram handler.
+    OnDatagram handler_;
+
+    /// @brief Interval in milliseconds to call tick handler at while no datagrams arrive.
+    int tickInterval_ = 0;
+
+    /// @brief Tick handler, may be empty.
+    OnTick tickHandler_;
+
+    /// @brief Socket descriptor.
+    int socket_ = -1;
+
+    /// @brief Local port of socket.
+    uint16_t port_ = 0;
+
+    /// @brief Set if receiving is stopped.
+    bool stopped_ = false;
+
+    /// @brief Slots for datagrams of one batch.
+    std::vector<uint8_t> buffer_;
+
+    /// @brief Slots for control messages of one batch.
+    std::vector<uint8_t> control_;
+
+    /// @brief Set if sequence number of the next RTP datagram is known.
+    bool rtpSequenceKnown_ = false;
+
+    /// @brief Expected sequence number of the next RTP datagram.
+    uint16_t rtpSequence_ = 0;
+
+    /// @brief Statistics of received datagrams.
+    Statistics statistics_;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+
+/// @brief Levels of input validation.
+enum class Validation
+{
+    /// @brief Continuity counters and CRC of PSI tables are checked.
+    DEFAULT,
+
+    /// @brief Input is trusted, no checks are done, anomalies are not logged.
+    TRUSTED,
+
+    /// @brief Also PES packet length, order of timestamps and consistency of PSI tables are checked.
+    PARANOID,
+};
+
+/// @struct TrustedValidation.
+/// @brief Compile-time policy of Validation::TRUSTED.
+struct TrustedValidation
+{
+    /// @brief Check continuity counters of TS packets.
+    static const bool continuity = false;
+
+    /// @brief Check CRC of PSI tables.
+    static const bool crc = false;
+
+    /// @brief Log corrupted TS packets.
+    static const bool logging = false;
+
+    /// @brief Check PES packet length, order of timestamps and consistency of PSI tables.
+    static const bool strict = false;
+};
+
+/// @struct DefaultValidation.
+/// @brief Compile-time policy of Validation::DEFAULT.
+struct DefaultValidation
+{
+    static const bool continuity = true;
+    static const bool crc = true;
+    static const bool logging = true;
+    static const bool strict = false;
+};
+
+/// @struct ParanoidValidation.
+/// @brief Compile-time policy of Validation::PARANOID.
+struct ParanoidValidation
+{
+    static const bool continuity = true;
+    static const bool crc = true;
+    static const bool logging = true;
+    static const bool strict = true;
+};
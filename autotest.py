@@ -2,18 +2,24 @@
 
 import argparse
 import glob
+import json
+import multiprocessing
 import os
 import shutil
 import subprocess
 import sys
 import tempfile
+from multiprocessing.pool import ThreadPool
 
 
 def parse_arguments():
-    parser = argparse.ArgumentParser(description='Auto test for ts_splitter util. FFmpeg is required.')
+    parser = argparse.ArgumentParser(description='Auto test for ts_splitter util. Outputs are checked by its built-in verifier.')
     parser.add_argument('-u', '--util', help='Path to ts_splitter util', type=str, required=True, dest='util')
     parser.add_argument('-f', '--files', help='Path to directory containing TS files', type=str, required=True, dest='files')
-    parser.add_argument('--ffmpeg', help='Path to FFmpeg util', type=str, required=False, dest='ffmpeg')
+    parser.add_argument('-j', '--jobs', help='Number of TS files checked at the same time', type=int, required=False,
+                        default=multiprocessing.cpu_count(), dest='jobs')
+    parser.add_argument('--ffmpeg', help='Path to FFmpeg util, if set every output is also decoded by FFmpeg', type=str,
+                        required=False, dest='ffmpeg')
     return parser.parse_args()
 
 
@@ -26,33 +32,28 @@ def check_settings(settings):
     if not os.path.isdir(settings.files):
         raise Exception('Directory {0} does not exist or is not a directory'.format(settings.files))
 
-    # check ffmpeg presence
-    if settings.ffmpeg:
-        if not os.path.isfile(settings.util):
-            raise Exception('File {0} does not exist or is not a file'.format(settings.ffmpeg))
-    else:
+    if settings.jobs < 1:
+        raise Exception('Number of jobs should be positive')
+
+    # check ffmpeg presence, it's optional
+    if settings.ffmpeg == 'ffmpeg':
         try:
             dev_null = open(os.devnull, 'w')
             subprocess.call(['ffmpeg', '-h'], stdout=dev_null, stderr=dev_null)
             dev_null.close()
-            settings.ffmpeg = 'ffmpeg'
-        except OSError as e:
-            if e.errno == os.errno.ENOENT:
-                raise Exception('FFmpeg is not found')
-            raise
+        except OSError:
+            raise Exception('FFmpeg is not found')
+    elif settings.ffmpeg and not os.path.isfile(settings.ffmpeg):
+        raise Exception('File {0} does not exist or is not a file'.format(settings.ffmpeg))
 
     # prepare temp dir
     settings.temp = tempfile.mkdtemp(prefix='ts_splitter_')
 
 
-def clean(settings, remove_top_dir):
+def clean(settings):
     if not hasattr(settings, 'temp'):
         return
-    if remove_top_dir:
-        shutil.rmtree(settings.temp)
-    else:
-        for f in os.listdir(settings.temp):
-            os.remove(os.path.join(settings.temp, f))
+    shutil.rmtree(settings.temp)
 
 
 def run_tests(settings):
@@ -61,9 +62,17 @@ def run_tests(settings):
     if not ts_files:
         raise Exception('No TS files found')
 
+    # every TS file is split into its own temp dir, results are printed in order
     failures = 0
-    for ts_file in ts_files:
-        failures += run_test(ts_file, settings)
+    pool = ThreadPool(settings.jobs)
+    for ts_file, result, description in pool.imap(lambda f: run_test(f, settings), ts_files):
+        sys.stdout.write('Checking file {0} ... {1}\n'.format(ts_file, 'OK' if result == 0 else 'FAIL'))
+        sys.stdout.flush()
+        if result != 0:
+            sys.stderr.write(description)
+        failures += result
+    pool.close()
+    pool.join()
 
     if failures == 0:
         sys.stdout.write('ALL TESTS PASSED\n')
@@ -72,45 +81,44 @@ def run_tests(settings):
 
 
 def run_test(ts_file, settings):
-    sys.stdout.write('Checking file {0} ... '.format(ts_file))
-    sys.stdout.flush()
-
     result = 0
     description = ''
 
-    dev_null = open(os.devnull, 'w')
-    audio_output = os.path.join(settings.temp, 'audio_1.out')
-    video_output = os.path.join(settings.temp, 'video_1.out')
-    util_args = [settings.util, '-i', ts_file, '-oa', audio_output, '-ov', video_output]
+    temp = tempfile.mkdtemp(dir=settings.temp)
+    audio_output = os.path.join(temp, 'audio_1.out')
+    video_output = os.path.join(temp, 'video_1.out')
+    util_args = [settings.util, '-i', ts_file, '-oa', audio_output, '-ov', video_output, '--verify']
 
     try:
-        # run util
-        process = subprocess.Popen(util_args, stdout=dev_null, stderr=subprocess.PIPE)
-        _, errors = process.communicate()
+        # run util, it verifies outputs and prints JSON report, exit code is 1 if some output fails
+        process = subprocess.Popen(util_args, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        output, errors = process.communicate()
+        try:
+            report = json.loads(output.decode('utf-8'))
+        except ValueError:
+            raise Exception('{0}\n{1} returned code {2}\n'.format(errors, settings.util, process.returncode))
+
+        failed = [f for f in report['files'] if not f['passed']]
+        if failed:
+            raise Exception('\n'.join('{0}: {1} errors, the first one "{2}" at offset {3}'.format(
+                f['file'], f['errors'], f['firstError'], f['firstErrorOffset']) for f in failed))
         if process.returncode != 0:
             raise Exception('{0}\n{1} returned code {2}\n'.format(errors, settings.util, process.returncode))
 
-        # run ffmpeg
-        files_to_check = glob.glob(os.path.join(settings.temp, '*.out'))
-        for f in files_to_check:
-            ffmpeg_args = [settings.ffmpeg, '-i', f, '-v', 'fatal', '-f', 'null', '-']
+        # optionally run ffmpeg, which decodes outputs and is much slower
+        for f in report['files'] if settings.ffmpeg else []:
+            ffmpeg_args = [settings.ffmpeg, '-i', f['file'], '-v', 'fatal', '-f', 'null', '-']
             process = subprocess.Popen(ffmpeg_args, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
             output, errors = process.communicate()
-            if process.returncode !=0 or output or errors:
-                raise Exception('{0} found some errors in output file {1}'.format(settings.ffmpeg, f))
+            if process.returncode != 0 or output or errors:
+                raise Exception('{0} found some errors in output file {1}'.format(settings.ffmpeg, f['file']))
 
     except Exception as e:
         result = 1
         description = str(e) + '\n'
 
-    clean(settings.temp, False)
-    if result == 0:
-        sys.stdout.write('OK\n')
-    else:
-        sys.stdout.write('FAIL\n')
-        sys.stderr.write(description)
-
-    return result
+    shutil.rmtree(temp)
+    return ts_file, result, description
 
 
 def main():
@@ -124,7 +132,7 @@ def main():
         sys.stderr.write(str(e) + '\n')
         exit_code = 1
 
-    clean(settings, True)
+    clean(settings)
     sys.exit(exit_code)
 
 